@@ -8,6 +8,7 @@
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "Common/Thread.h"
+#include "Core/ConfigManager.h"
 
 AlsaSound::AlsaSound()
     : m_thread_status(ALSAThreadStatus::STOPPED), handle(nullptr),
@@ -24,6 +25,8 @@ bool AlsaSound::Start()
     return false;
   }
 
+  m_output.SetTargetLatency(SConfig::GetInstance().iLatency);
+  m_output.StartPumpThread();
   thread = std::thread(&AlsaSound::SoundLoop, this);
   return true;
 }
@@ -36,6 +39,7 @@ void AlsaSound::Stop()
   // to realize we are stopping the emulation
   cv.notify_one();
   thread.join();
+  m_output.StopPumpThread();
 }
 
 void AlsaSound::Update()
@@ -51,7 +55,7 @@ void AlsaSound::SoundLoop()
   {
     while (m_thread_status.load() == ALSAThreadStatus::RUNNING)
     {
-      m_mixer->Mix(mix_buffer, frames_to_deliver);
+      m_output.Read(mix_buffer, frames_to_deliver);
       int rc = snd_pcm_writei(handle, mix_buffer, frames_to_deliver);
       if (rc == -EPIPE)
       {
@@ -128,7 +128,8 @@ bool SupportsDPL2Decoder(const std::string& backend)
 
 bool SupportsLatencyControl(const std::string& backend)
 {
-  return backend == BACKEND_OPENAL;
+  return backend == BACKEND_OPENAL || backend == BACKEND_ALSA || backend == BACKEND_PULSEAUDIO ||
+         backend == BACKEND_NULLSOUND;
 }
 
 bool SupportsVolumeChanges(const std::string& backend)
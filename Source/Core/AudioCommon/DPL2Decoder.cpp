@@ -11,13 +11,18 @@
 #include <cmath>
 #include <cstdlib>
 #include <functional>
-#include <string.h>
 #include <vector>
 
 #include "AudioCommon/DPL2Decoder.h"
 #include "Common/CommonTypes.h"
 #include "Common/MathUtil.h"
 
+#ifdef _M_X86
+#include "Common/Intrinsics.h"
+#elif defined(_M_ARM_64)
+#include <arm_neon.h>
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -33,58 +38,55 @@ static float l_fwr, r_fwr, lpr_fwr, lmr_fwr;
 static std::vector<float> fwrbuf_l, fwrbuf_r;
 static float adapt_l_gain, adapt_r_gain, adapt_lpr_gain, adapt_lmr_gain;
 static std::vector<float> lf, rf, lr, rr, cf, cr;
-static float LFE_buf[256];
-static unsigned int lfe_pos;
-static float* filter_coefs_lfe;
-static unsigned int len125;
 
-template <class T, class _ftype_t>
-static _ftype_t DotProduct(int count, const T* buf, const _ftype_t* coefficients)
+// The LFE channel is a 125 Hz lowpass of the decoded channels. Its input is collected for a whole
+// block behind the last LFE_TAPS - 1 samples of the previous block, so the filter can run over
+// contiguous memory afterwards.
+static constexpr unsigned int LFE_TAPS = 256;
+alignas(16) static float lfe_taps[LFE_TAPS];  // Oldest sample first
+static std::vector<float> lfe_buf;
+
+static float DotProduct(const float* buf, const float* coefficients)
 {
-  int i;
+  static_assert(LFE_TAPS % 16 == 0, "Filter length must be a multiple of the unroll width");
+#ifdef _M_X86
+  __m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+  __m128 sum2 = _mm_setzero_ps(), sum3 = _mm_setzero_ps();
+  for (unsigned int i = 0; i < LFE_TAPS; i += 16)
+  {
+    const float* b = buf + i;
+    const float* c = coefficients + i;
+    sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(b + 0), _mm_load_ps(c + 0)));
+    sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(b + 4), _mm_load_ps(c + 4)));
+    sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(b + 8), _mm_load_ps(c + 8)));
+    sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(b + 12), _mm_load_ps(c + 12)));
+  }
+  __m128 sum = _mm_add_ps(_mm_add_ps(sum0, sum1), _mm_add_ps(sum2, sum3));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+  return _mm_cvtss_f32(sum);
+#elif defined(_M_ARM_64)
+  float32x4_t sum0 = vdupq_n_f32(0.0f), sum1 = vdupq_n_f32(0.0f);
+  float32x4_t sum2 = vdupq_n_f32(0.0f), sum3 = vdupq_n_f32(0.0f);
+  for (unsigned int i = 0; i < LFE_TAPS; i += 16)
+  {
+    sum0 = vmlaq_f32(sum0, vld1q_f32(buf + i), vld1q_f32(coefficients + i));
+    sum1 = vmlaq_f32(sum1, vld1q_f32(buf + i + 4), vld1q_f32(coefficients + i + 4));
+    sum2 = vmlaq_f32(sum2, vld1q_f32(buf + i + 8), vld1q_f32(coefficients + i + 8));
+    sum3 = vmlaq_f32(sum3, vld1q_f32(buf + i + 12), vld1q_f32(coefficients + i + 12));
+  }
+  return vaddvq_f32(vaddq_f32(vaddq_f32(sum0, sum1), vaddq_f32(sum2, sum3)));
+#else
   float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
-
-  // Unrolled loop
-  for (i = 0; (i + 3) < count; i += 4)
+  for (unsigned int i = 0; i < LFE_TAPS; i += 4)
   {
     sum0 += buf[i + 0] * coefficients[i + 0];
     sum1 += buf[i + 1] * coefficients[i + 1];
     sum2 += buf[i + 2] * coefficients[i + 2];
     sum3 += buf[i + 3] * coefficients[i + 3];
   }
-
-  // Epilogue of unrolled loop
-  for (; i < count; i++)
-    sum0 += buf[i] * coefficients[i];
-
   return sum0 + sum1 + sum2 + sum3;
-}
-
-template <class T>
-static T FIRFilter(const T* buf, int pos, int len, int count, const float* coefficients)
-{
-  int count1, count2;
-
-  if (pos >= count)
-  {
-    pos -= count;
-    count1 = count;
-    count2 = 0;
-  }
-  else
-  {
-    count2 = pos;
-    count1 = count - pos;
-    pos = len - count1;
-  }
-
-  // high part of window
-  const T* ptr = &buf[pos];
-
-  float r1 = DotProduct(count1, ptr, coefficients);
-  coefficients += count1;
-  float r2 = DotProduct(count2, buf, coefficients);
-  return T(r1 + r2);
+#endif
 }
 
 /*
@@ -189,33 +191,27 @@ static void OnSeek()
   std::fill(rr.begin(), rr.end(), 0.0f);
   std::fill(cf.begin(), cf.end(), 0.0f);
   std::fill(cr.begin(), cr.end(), 0.0f);
-  lfe_pos = 0;
-  memset(LFE_buf, 0, sizeof(LFE_buf));
+  std::fill(lfe_buf.begin(), lfe_buf.end(), 0.0f);
 }
 
 static void Done()
 {
   OnSeek();
-
-  if (filter_coefs_lfe)
-  {
-    free(filter_coefs_lfe);
-  }
-
-  filter_coefs_lfe = nullptr;
 }
 
-static float* CalculateCoefficients125HzLowpass(int rate)
+static void CalculateCoefficients125HzLowpass(int rate)
 {
-  len125 = 256;
+  unsigned int len = LFE_TAPS;
   float f = 125.0f / (rate / 2);
-  float* coeffs = DesignFIR(&len125, &f, 0);
+  float* coeffs = DesignFIR(&len, &f, 0);
   static const float M3_01DB = 0.7071067812f;
-  for (unsigned int i = 0; i < len125; i++)
-  {
-    coeffs[i] *= M3_01DB;
-  }
-  return coeffs;
+  // The ring buffer implementation this replaced weighted the newest sample with coeffs[0] and the
+  // sample n steps back with coeffs[256 - n]. The lowpass is symmetric, so that is the same as
+  // coeffs[n - 1], but keep the old indexing anyway.
+  lfe_taps[LFE_TAPS - 1] = coeffs[0] * M3_01DB;
+  for (unsigned int i = 1; i < LFE_TAPS; i++)
+    lfe_taps[LFE_TAPS - 1 - i] = coeffs[LFE_TAPS - i] * M3_01DB;
+  free(coeffs);
 }
 
 static float PassiveLock(float x)
@@ -333,11 +329,14 @@ void DPL2Decode(float* samples, int numsamples, float* out)
     rr.resize(dlbuflen);
     cf.resize(dlbuflen);
     cr.resize(dlbuflen);
-    filter_coefs_lfe = CalculateCoefficients125HzLowpass(fmt_freq);
-    lfe_pos = 0;
-    memset(LFE_buf, 0, sizeof(LFE_buf));
+    CalculateCoefficients125HzLowpass(fmt_freq);
+    lfe_buf.assign(LFE_TAPS - 1, 0.0f);
   }
 
+  // Grows to the largest block size once and is reused afterwards.
+  lfe_buf.resize(LFE_TAPS - 1 + numsamples);
+  float* lfe_in = &lfe_buf[LFE_TAPS - 1];
+
   float* in = samples;                           // Input audio data
   float* end = in + numsamples * fmt_nchannels;  // Loop end
 
@@ -345,7 +344,10 @@ void DPL2Decode(float* samples, int numsamples, float* out)
   {
     const int k = cyc_pos;
 
-    const int fwr_pos = (k + FWRDURATION) % dlbuflen;
+    // dlbuflen is never shorter than FWRDURATION, so a single wrap is enough.
+    int fwr_pos = k + FWRDURATION;
+    if (fwr_pos >= static_cast<int>(dlbuflen))
+      fwr_pos -= dlbuflen;
     /* Update the full wave rectified total amplitude */
     /* Input matrix decoder */
     l_fwr += fabs(in[0]) - fabs(fwrbuf_l[fwr_pos]);
@@ -363,13 +365,7 @@ void DPL2Decode(float* samples, int numsamples, float* out)
     out[cur + 0] = lf[k];
     out[cur + 1] = rf[k];
     out[cur + 2] = cf[k];
-    LFE_buf[lfe_pos] = (lf[k] + rf[k] + 2.0f * cf[k] + lr[k] + rr[k]) / 2.0f;
-    out[cur + 3] = FIRFilter(LFE_buf, lfe_pos, len125, len125, filter_coefs_lfe);
-    lfe_pos++;
-    if (lfe_pos == len125)
-    {
-      lfe_pos = 0;
-    }
+    *lfe_in++ = (lf[k] + rf[k] + 2.0f * cf[k] + lr[k] + rr[k]) / 2.0f;
     out[cur + 4] = lr[k];
     out[cur + 5] = rr[k];
     // Next sample...
@@ -381,11 +377,15 @@ void DPL2Decode(float* samples, int numsamples, float* out)
       cyc_pos += dlbuflen;
     }
   }
+
+  // Lowpass the whole block for the LFE channel, then keep the tail as history for the next one.
+  for (int i = 0; i < numsamples; ++i)
+    out[i * 6 + 3] = DotProduct(&lfe_buf[i], lfe_taps);
+  std::copy(lfe_buf.end() - (LFE_TAPS - 1), lfe_buf.end(), lfe_buf.begin());
 }
 
 void DPL2Reset()
 {
   olddelay = -1;
   oldfreq = 0;
-  filter_coefs_lfe = nullptr;
 }
@@ -16,6 +16,8 @@
 #include <tmmintrin.h>
 #endif
 
+std::atomic<CMixer::SampleHook> CMixer::s_sample_hook{nullptr};
+
 CMixer::CMixer(unsigned int BackendSampleRate) : m_sampleRate(BackendSampleRate)
 {
   INFO_LOG(AUDIO_INTERFACE, "Mixer is initialized");
@@ -29,8 +31,6 @@ CMixer::~CMixer()
 unsigned int CMixer::MixerFifo::Mix(short* samples, unsigned int numSamples,
                                     bool consider_framelimit)
 {
-  unsigned int currentSample = 0;
-
   // Cache access in non-volatile variable
   // This is the only function changing the read value, so it's safe to
   // cache it locally although it's written here.
@@ -68,29 +68,14 @@ unsigned int CMixer::MixerFifo::Mix(short* samples, unsigned int numSamples,
   s32 lvolume = m_LVolume.load();
   s32 rvolume = m_RVolume.load();
 
-  // TODO: consider a higher-quality resampling algorithm.
-  for (; currentSample < numSamples * 2 && ((indexW - indexR) & INDEX_MASK) > 2; currentSample += 2)
-  {
-    u32 indexR2 = indexR + 2;  // next sample
-
-    s16 l1 = Common::swap16(m_buffer[indexR & INDEX_MASK]);   // current
-    s16 l2 = Common::swap16(m_buffer[indexR2 & INDEX_MASK]);  // next
-    int sampleL = ((l1 << 16) + (l2 - l1) * (u16)m_frac) >> 16;
-    sampleL = (sampleL * lvolume) >> 8;
-    sampleL += samples[currentSample + 1];
-    samples[currentSample + 1] = MathUtil::Clamp(sampleL, -32767, 32767);
-
-    s16 r1 = Common::swap16(m_buffer[(indexR + 1) & INDEX_MASK]);   // current
-    s16 r2 = Common::swap16(m_buffer[(indexR2 + 1) & INDEX_MASK]);  // next
-    int sampleR = ((r1 << 16) + (r2 - r1) * (u16)m_frac) >> 16;
-    sampleR = (sampleR * rvolume) >> 8;
-    sampleR += samples[currentSample];
-    samples[currentSample] = MathUtil::Clamp(sampleR, -32767, 32767);
-
-    m_frac += ratio;
-    indexR += 2 * (u16)(m_frac >> 16);
-    m_frac &= 0xffff;
-  }
+  const auto kernel =
+      static_cast<AudioCommon::ResamplerKernel>(SConfig::GetInstance().m_AudioResampler);
+  if (kernel != m_resampler.GetKernel())
+    m_resampler.SetKernel(kernel);
+
+  unsigned int currentSample =
+      2 * m_resampler.Mix(samples, numSamples, m_buffer.data(), INDEX_MASK, &indexR, indexW, ratio,
+                          lvolume, rvolume);
 
   // Padding
   short s[2];
@@ -136,7 +121,10 @@ void CMixer::MixerFifo::PushSamples(const short* samples, unsigned int num_sampl
   // Check if we have enough free space
   // indexW == m_indexR results in empty buffer, so indexR must always be smaller than indexW
   if (num_samples * 2 + ((indexW - m_indexR.load()) & INDEX_MASK) >= MAX_SAMPLES * 2)
+  {
+    m_overruns.fetch_add(1);
     return;
+  }
 
   // AyuanX: Actual re-sampling work has been moved to sound thread
   // to alleviate the workload on main thread
@@ -161,6 +149,8 @@ void CMixer::PushSamples(const short* samples, unsigned int num_samples)
   int sample_rate = m_dma_mixer.GetInputSampleRate();
   if (m_log_dsp_audio)
     m_wave_writer_dsp.AddStereoSamplesBE(samples, num_samples, sample_rate);
+  if (SampleHook hook = s_sample_hook.load())
+    hook(SampleSource::DSP, samples, num_samples, sample_rate);
 }
 
 void CMixer::PushStreamingSamples(const short* samples, unsigned int num_samples)
@@ -169,6 +159,13 @@ void CMixer::PushStreamingSamples(const short* samples, unsigned int num_samples
   int sample_rate = m_streaming_mixer.GetInputSampleRate();
   if (m_log_dtk_audio)
     m_wave_writer_dtk.AddStereoSamplesBE(samples, num_samples, sample_rate);
+  if (SampleHook hook = s_sample_hook.load())
+    hook(SampleSource::DTK, samples, num_samples, sample_rate);
+}
+
+void CMixer::SetSampleHook(SampleHook hook)
+{
+  s_sample_hook.store(hook);
 }
 
 void CMixer::PushWiimoteSpeakerSamples(const short* samples, unsigned int num_samples,
@@ -190,6 +187,12 @@ void CMixer::PushWiimoteSpeakerSamples(const short* samples, unsigned int num_sa
   }
 }
 
+u64 CMixer::GetOverrunCount() const
+{
+  return m_dma_mixer.GetOverrunCount() + m_streaming_mixer.GetOverrunCount() +
+         m_wiimote_speaker_mixer.GetOverrunCount();
+}
+
 void CMixer::SetDMAInputSampleRate(unsigned int rate)
 {
   m_dma_mixer.SetInputSampleRate(rate);
@@ -7,12 +7,24 @@
 #include <array>
 #include <atomic>
 
+#include "AudioCommon/Resampler.h"
 #include "AudioCommon/WaveFile.h"
 #include "Common/CommonTypes.h"
 
 class CMixer final
 {
 public:
+  enum class SampleSource
+  {
+    DSP,
+    DTK,
+  };
+
+  // Sees every block of DSP and DTK samples as it is pushed, as big-endian R/L pairs. Called on
+  // the CPU thread; used to add audio to frame dumps.
+  using SampleHook = void (*)(SampleSource source, const short* samples, unsigned int num_samples,
+                              unsigned int sample_rate);
+
   explicit CMixer(unsigned int BackendSampleRate);
   ~CMixer();
 
@@ -36,6 +48,11 @@ public:
   void StartLogDSPAudio(const std::string& filename);
   void StopLogDSPAudio();
 
+  static void SetSampleHook(SampleHook hook);
+
+  // Number of pushes dropped because an input FIFO was full.
+  u64 GetOverrunCount() const;
+
   float GetCurrentSpeed() const { return m_speed.load(); }
   void UpdateSpeed(float val) { m_speed.store(val); }
 private:
@@ -57,6 +74,7 @@ private:
     void SetInputSampleRate(unsigned int rate);
     unsigned int GetInputSampleRate() const;
     void SetVolume(unsigned int lvolume, unsigned int rvolume);
+    u64 GetOverrunCount() const { return m_overruns.load(); }
 
   private:
     CMixer* m_mixer;
@@ -67,8 +85,9 @@ private:
     // Volume ranges from 0-256
     std::atomic<s32> m_LVolume{256};
     std::atomic<s32> m_RVolume{256};
+    std::atomic<u64> m_overruns{0};
     float m_numLeftI = 0.0f;
-    u32 m_frac = 0;
+    AudioCommon::Resampler m_resampler;
   };
   MixerFifo m_dma_mixer{this, 32000};
   MixerFifo m_streaming_mixer{this, 48000};
@@ -83,4 +102,6 @@ private:
 
   // Current rate of emulation (1.0 = 100% speed)
   std::atomic<float> m_speed{0.0f};
+
+  static std::atomic<SampleHook> s_sample_hook;
 };
@@ -2,8 +2,11 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "AudioCommon/NullSoundStream.h"
 #include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
 #include "Core/HW/AudioInterface.h"
 #include "Core/HW/SystemTimers.h"
 
@@ -13,6 +16,7 @@ void NullSound::SoundLoop()
 
 bool NullSound::Start()
 {
+  m_output.SetTargetLatency(SConfig::GetInstance().iLatency);
   return true;
 }
 
@@ -22,17 +26,30 @@ void NullSound::SetVolume(int volume)
 
 void NullSound::Update()
 {
-  // num_samples_to_render in this update - depends on SystemTimers::AUDIO_DMA_PERIOD.
+  // One AI DMA period of output - depends on SystemTimers::AUDIO_DMA_PERIOD.
   constexpr u32 stereo_16_bit_size = 4;
   constexpr u32 dma_length = 32;
   const u64 audio_dma_period =
       SystemTimers::GetTicksPerSecond() /
       (AudioInterface::GetAIDSampleRate() * stereo_16_bit_size / dma_length);
-  const u64 ais_samples_per_second = 48000 * stereo_16_bit_size;
-  const u64 num_samples_to_render =
-      (audio_dma_period * ais_samples_per_second) / SystemTimers::GetTicksPerSecond();
 
-  m_mixer->Mix(m_realtime_buffer.data(), (unsigned int)num_samples_to_render);
+  AdvanceTime(audio_dma_period, SystemTimers::GetTicksPerSecond());
+}
+
+void NullSound::AdvanceTime(u64 elapsed_ticks, u64 ticks_per_second)
+{
+  const u64 elapsed = elapsed_ticks * m_mixer->GetSampleRate() + m_elapsed_remainder;
+  m_elapsed_remainder = elapsed % ticks_per_second;
+
+  // There is no device thread, so produce and consume in lockstep.
+  const u32 max_frames = static_cast<u32>(m_realtime_buffer.size() / 2);
+  for (u64 frames = elapsed / ticks_per_second; frames > 0;)
+  {
+    const u32 chunk = static_cast<u32>(std::min<u64>(frames, max_frames));
+    m_output.Pump();
+    m_output.Read(m_realtime_buffer.data(), chunk);
+    frames -= chunk;
+  }
 }
 
 void NullSound::Clear(bool mute)
@@ -17,10 +17,16 @@ public:
   void Clear(bool mute) override;
   void Update() override;
 
+  // Plays back as many frames as a real device would have consumed in the elapsed time.
+  // Update() drives this from emulated time; it can also be driven by a synthetic clock.
+  void AdvanceTime(u64 elapsed_ticks, u64 ticks_per_second);
+
   static bool isValid() { return true; }
 private:
   static constexpr size_t BUFFER_SIZE = 48000 * 4 / 32;
 
   // Playback position
   std::array<short, BUFFER_SIZE / sizeof(short)> m_realtime_buffer;
+  // Fraction of a frame left over from the previous AdvanceTime, in frames * ticks_per_second
+  u64 m_elapsed_remainder = 0;
 };
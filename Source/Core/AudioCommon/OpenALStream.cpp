@@ -49,6 +49,11 @@ bool OpenALStream::Start()
         // period_size_in_millisec = 1000 / refresh;
 
         alcMakeContextCurrent(pContext);
+
+        // SoundTouch stretches the output itself, so the mixer must not follow the framelimit.
+        m_output.SetConsiderFramelimit(false);
+        m_output.SetTargetLatency(SConfig::GetInstance().iLatency);
+        m_output.StartPumpThread();
         thread = std::thread(&OpenALStream::SoundLoop, this);
         bReturn = true;
       }
@@ -84,6 +89,7 @@ void OpenALStream::Stop()
   soundTouch.clear();
 
   thread.join();
+  m_output.StopPumpThread();
 
   alSourceStop(uiSource);
   alSourcei(uiSource, AL_BUFFER, 0);
@@ -257,7 +263,7 @@ void OpenALStream::SoundLoop()
         surround_capable ? 240 : 0;  // DPL2 accepts 240 samples minimum (FWRDURATION)
 
     numSamples = (numSamples > OAL_MAX_SAMPLES) ? OAL_MAX_SAMPLES : numSamples;
-    numSamples = m_mixer->Mix(realtimeBuffer, numSamples, false);
+    m_output.Read(realtimeBuffer, numSamples);
 
     // Convert the samples from short to float
     float dest[OAL_MAX_SAMPLES * STEREO_CHANNELS];
@@ -0,0 +1,140 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+
+#include "AudioCommon/Mixer.h"
+#include "AudioCommon/OutputBuffer.h"
+#include "Common/Logging/Log.h"
+#include "Common/Thread.h"
+
+namespace AudioCommon
+{
+constexpr u32 OutputBuffer::CAPACITY;
+constexpr u32 OutputBuffer::MIN_TARGET_STEP;
+
+OutputBuffer::OutputBuffer(CMixer* mixer, u32 sample_rate)
+    : m_mixer(mixer), m_sample_rate(sample_rate)
+{
+  SetTargetLatency(0);
+}
+
+OutputBuffer::~OutputBuffer()
+{
+  StopPumpThread();
+}
+
+void OutputBuffer::SetTargetLatency(u32 latency_ms)
+{
+  const u32 frames = std::min(std::max(latency_ms * m_sample_rate / 1000, MIN_TARGET_STEP),
+                              CAPACITY / 4);
+  m_base_target.store(frames);
+  m_target.store(frames);
+}
+
+void OutputBuffer::StartPumpThread()
+{
+  if (m_pump_running.TestAndSet())
+    m_pump_thread = std::thread(&OutputBuffer::PumpLoop, this);
+}
+
+void OutputBuffer::StopPumpThread()
+{
+  if (!m_pump_running.TestAndClear())
+    return;
+
+  m_need_data.Set();
+  m_pump_thread.join();
+
+  const Stats stats = GetStats();
+  INFO_LOG(AUDIO, "Output buffer stopped: %llu underruns, %llu overruns, target %u frames",
+           static_cast<unsigned long long>(stats.underruns),
+           static_cast<unsigned long long>(stats.overruns), stats.target_frames);
+}
+
+void OutputBuffer::PumpLoop()
+{
+  Common::SetCurrentThreadName("Audio mixer");
+
+  while (m_pump_running.IsSet())
+  {
+    Pump();
+    m_need_data.Wait();
+  }
+}
+
+u32 OutputBuffer::Pump()
+{
+  const u32 write = m_write_pos.load(std::memory_order_relaxed);
+  const u32 read = m_read_pos.load(std::memory_order_acquire);
+  const u32 buffered = write - read;
+  const u32 target = std::min(std::max(m_target.load(), m_period.load()), CAPACITY);
+  if (buffered >= target)
+    return 0;
+
+  // Mix straight into the ring, in two pieces if it wraps around.
+  const u32 to_mix = target - buffered;
+  const u32 start = write & POSITION_MASK;
+  const u32 first = std::min(to_mix, CAPACITY - start);
+  m_mixer->Mix(&m_buffer[start * 2], first, m_consider_framelimit);
+  if (to_mix > first)
+    m_mixer->Mix(&m_buffer[0], to_mix - first, m_consider_framelimit);
+
+  m_write_pos.store(write + to_mix, std::memory_order_release);
+  return to_mix;
+}
+
+u32 OutputBuffer::Read(s16* samples, u32 num_frames)
+{
+  const u32 read = m_read_pos.load(std::memory_order_relaxed);
+  const u32 write = m_write_pos.load(std::memory_order_acquire);
+  const u32 available = std::min(write - read, num_frames);
+
+  const u32 start = read & POSITION_MASK;
+  const u32 first = std::min(available, CAPACITY - start);
+  memcpy(samples, &m_buffer[start * 2], first * 2 * sizeof(s16));
+  if (available > first)
+    memcpy(samples + first * 2, &m_buffer[0], (available - first) * 2 * sizeof(s16));
+
+  m_read_pos.store(read + available, std::memory_order_release);
+
+  if (num_frames > m_period.load(std::memory_order_relaxed))
+    m_period.store(std::min(num_frames, CAPACITY), std::memory_order_relaxed);
+
+  const u32 base = m_base_target.load(std::memory_order_relaxed);
+  const u32 step = std::max(base / 4, MIN_TARGET_STEP);
+  const u32 target = m_target.load(std::memory_order_relaxed);
+  if (available < num_frames)
+  {
+    memset(samples + available * 2, 0, (num_frames - available) * 2 * sizeof(s16));
+    m_underruns.fetch_add(1, std::memory_order_relaxed);
+    m_frames_since_underrun = 0;
+    m_target.store(std::min(target + step, std::min(base * 4, CAPACITY)),
+                   std::memory_order_relaxed);
+  }
+  else
+  {
+    m_frames_since_underrun += num_frames;
+    if (m_frames_since_underrun >= m_sample_rate && target > base)
+    {
+      m_frames_since_underrun = 0;
+      m_target.store(std::max(target - std::min(target, step), base), std::memory_order_relaxed);
+    }
+  }
+
+  m_need_data.Set();
+  return available;
+}
+
+OutputBuffer::Stats OutputBuffer::GetStats() const
+{
+  Stats stats;
+  stats.underruns = m_underruns.load();
+  stats.overruns = m_mixer->GetOverrunCount();
+  stats.buffered_frames = m_write_pos.load() - m_read_pos.load();
+  stats.target_frames = m_target.load();
+  return stats;
+}
+}
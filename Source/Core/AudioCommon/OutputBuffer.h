@@ -0,0 +1,86 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/Flag.h"
+
+class CMixer;
+
+namespace AudioCommon
+{
+// Single-producer/single-consumer ring of mixed stereo frames that sits between CMixer and a
+// sound backend.
+//
+// The producer (Pump, normally run on a dedicated thread) mixes just enough frames to keep the
+// ring at the target latency. The consumer (the backend's device thread or callback) only copies
+// frames out with Read, so no resampling happens on the device's schedule. When the consumer
+// finds the ring short, it plays silence, counts an underrun and raises the target; after a
+// second of clean playback the target decays back towards the configured latency.
+class OutputBuffer final
+{
+public:
+  struct Stats
+  {
+    u64 underruns;
+    u64 overruns;
+    u32 buffered_frames;
+    u32 target_frames;
+  };
+
+  OutputBuffer(CMixer* mixer, u32 sample_rate);
+  ~OutputBuffer();
+
+  // Must be called before the pump thread is started.
+  void SetConsiderFramelimit(bool consider_framelimit)
+  {
+    m_consider_framelimit = consider_framelimit;
+  }
+  void SetTargetLatency(u32 latency_ms);
+
+  void StartPumpThread();
+  void StopPumpThread();
+
+  // Producer side. Mixes frames until the ring holds the current target. Returns frames mixed.
+  u32 Pump();
+
+  // Consumer side. Always writes num_frames interleaved frames to samples, padding with silence.
+  // Returns the number of frames that came from the mixer.
+  u32 Read(s16* samples, u32 num_frames);
+
+  Stats GetStats() const;
+
+private:
+  static constexpr u32 CAPACITY = 8192;  // In frames, ~170 ms at 48 kHz
+  static constexpr u32 POSITION_MASK = CAPACITY - 1;
+  static constexpr u32 MIN_TARGET_STEP = 32;
+
+  void PumpLoop();
+
+  CMixer* m_mixer;
+  u32 m_sample_rate;
+  bool m_consider_framelimit = true;
+
+  std::array<s16, CAPACITY * 2> m_buffer{};
+  // Free-running frame counters; the difference is the number of buffered frames.
+  std::atomic<u32> m_write_pos{0};
+  std::atomic<u32> m_read_pos{0};
+
+  std::atomic<u32> m_base_target{0};
+  std::atomic<u32> m_target{0};
+  std::atomic<u32> m_period{0};
+  std::atomic<u64> m_underruns{0};
+  u32 m_frames_since_underrun = 0;
+
+  std::thread m_pump_thread;
+  Common::Flag m_pump_running;
+  Common::Event m_need_data;
+};
+}
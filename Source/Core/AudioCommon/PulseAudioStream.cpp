@@ -27,6 +27,9 @@ bool PulseAudio::Start()
 
   NOTICE_LOG(AUDIO, "PulseAudio backend using %d channels", m_channels);
 
+  m_output.SetTargetLatency(SConfig::GetInstance().iLatency);
+  m_output.StartPumpThread();
+
   m_run_thread.Set();
   m_thread = std::thread(&PulseAudio::SoundLoop, this);
 
@@ -40,6 +43,7 @@ void PulseAudio::Stop()
 {
   m_run_thread.Clear();
   m_thread.join();
+  m_output.StopPumpThread();
 }
 
 void PulseAudio::Update()
@@ -190,13 +194,13 @@ void PulseAudio::WriteCallback(pa_stream* s, size_t length)
   if (m_stereo)
   {
     // use the raw s16 stereo mix
-    m_mixer->Mix((s16*)buffer, frames);
+    m_output.Read((s16*)buffer, frames);
   }
   else
   {
     // get a floating point mix
     s16 s16buffer_stereo[frames * 2];
-    m_mixer->Mix(s16buffer_stereo, frames);  // implicitly mixes to 16-bit stereo
+    m_output.Read(s16buffer_stereo, frames);  // implicitly mixes to 16-bit stereo
 
     float floatbuffer_stereo[frames * 2];
     // s16 to float
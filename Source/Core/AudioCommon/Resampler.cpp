@@ -0,0 +1,317 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+
+#include "AudioCommon/Resampler.h"
+#include "Common/CommonFuncs.h"
+#include "Common/MathUtil.h"
+
+#ifdef _M_X86
+#include "Common/Intrinsics.h"
+#elif defined(_M_ARM_64)
+#include <arm_neon.h>
+#endif
+
+namespace AudioCommon
+{
+namespace
+{
+constexpr double PI = 3.14159265358979323846;
+
+// Polyphase table for the windowed sinc kernel. Row p holds the taps for a fractional position
+// of p / SINC_PHASES; the extra last row lets us interpolate between adjacent phases.
+struct SincTable
+{
+  SincTable();
+
+  alignas(16) float taps[Resampler::SINC_PHASES + 1][Resampler::SINC_TAPS];
+};
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window.
+double BesselI0(double x)
+{
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 32; ++k)
+  {
+    const double half_x_over_k = x / (2.0 * k);
+    term *= half_x_over_k * half_x_over_k;
+    sum += term;
+    if (term < sum * 1e-12)
+      break;
+  }
+  return sum;
+}
+
+SincTable::SincTable()
+{
+  // Cut off slightly below the input Nyquist frequency to leave room for the transition band.
+  constexpr double CUTOFF = 0.46;
+  constexpr double KAISER_BETA = 8.0;
+  constexpr double HALF_WIDTH = Resampler::SINC_TAPS / 2;
+  const double i0_beta = BesselI0(KAISER_BETA);
+
+  for (u32 phase = 0; phase <= Resampler::SINC_PHASES; ++phase)
+  {
+    const double frac = static_cast<double>(phase) / Resampler::SINC_PHASES;
+    double sum = 0.0;
+    double row[Resampler::SINC_TAPS];
+    for (u32 tap = 0; tap < Resampler::SINC_TAPS; ++tap)
+    {
+      // Tap 0 is the oldest history frame; tap SINC_TAPS / 2 - 1 is the current frame.
+      const double t = static_cast<double>(tap) - (HALF_WIDTH - 1) - frac;
+      const double x = 2.0 * CUTOFF * t;
+      const double sinc = x == 0.0 ? 1.0 : std::sin(PI * x) / (PI * x);
+      const double w = t / HALF_WIDTH;
+      const double window = std::abs(w) >= 1.0 ?
+                                0.0 :
+                                BesselI0(KAISER_BETA * std::sqrt(1.0 - w * w)) / i0_beta;
+      row[tap] = sinc * window;
+      sum += row[tap];
+    }
+    // Normalize every phase to unity gain at DC.
+    for (u32 tap = 0; tap < Resampler::SINC_TAPS; ++tap)
+      taps[phase][tap] = static_cast<float>(row[tap] / sum);
+  }
+}
+
+const SincTable& GetSincTable()
+{
+  static const SincTable table;
+  return table;
+}
+
+template <u32 count>
+inline float DotProduct(const float* samples, const float* coeffs)
+{
+  static_assert(count % 4 == 0, "Taps must be a multiple of the vector width");
+#ifdef _M_X86
+  __m128 acc = _mm_mul_ps(_mm_loadu_ps(samples), _mm_load_ps(coeffs));
+  for (u32 i = 4; i < count; i += 4)
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_load_ps(coeffs + i)));
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 0x55));
+  return _mm_cvtss_f32(acc);
+#elif defined(_M_ARM_64)
+  float32x4_t acc = vmulq_f32(vld1q_f32(samples), vld1q_f32(coeffs));
+  for (u32 i = 4; i < count; i += 4)
+    acc = vmlaq_f32(acc, vld1q_f32(samples + i), vld1q_f32(coeffs + i));
+  return vaddvq_f32(acc);
+#else
+  float acc = 0.0f;
+  for (u32 i = 0; i < count; ++i)
+    acc += samples[i] * coeffs[i];
+  return acc;
+#endif
+}
+
+template <ResamplerKernel kernel>
+struct KernelTraits;
+
+template <>
+struct KernelTraits<ResamplerKernel::Linear>
+{
+  static constexpr u32 HISTORY = 0;
+  static constexpr u32 LOOKAHEAD = 1;
+
+  static void Interpolate(const float* left, const float* right, u32 frac, float* out_l,
+                          float* out_r)
+  {
+    const float t = frac * (1.0f / 65536.0f);
+    *out_l = left[0] + (left[1] - left[0]) * t;
+    *out_r = right[0] + (right[1] - right[0]) * t;
+  }
+};
+
+template <>
+struct KernelTraits<ResamplerKernel::Cubic>
+{
+  static constexpr u32 HISTORY = 1;
+  static constexpr u32 LOOKAHEAD = 2;
+
+  // Catmull-Rom spline through the frames at -1, 0, 1 and 2.
+  static void Interpolate(const float* left, const float* right, u32 frac, float* out_l,
+                          float* out_r)
+  {
+    const float t = frac * (1.0f / 65536.0f);
+    const float t2 = t * t;
+    const float t3 = t2 * t;
+    alignas(16) const float coeffs[4] = {
+        0.5f * (-t3 + 2.0f * t2 - t), 0.5f * (3.0f * t3 - 5.0f * t2 + 2.0f),
+        0.5f * (-3.0f * t3 + 4.0f * t2 + t), 0.5f * (t3 - t2),
+    };
+    *out_l = DotProduct<4>(left - 1, coeffs);
+    *out_r = DotProduct<4>(right - 1, coeffs);
+  }
+};
+
+template <>
+struct KernelTraits<ResamplerKernel::WindowedSinc>
+{
+  static constexpr u32 HISTORY = Resampler::SINC_TAPS / 2 - 1;
+  static constexpr u32 LOOKAHEAD = Resampler::SINC_TAPS / 2;
+
+  static void Interpolate(const float* left, const float* right, u32 frac, float* out_l,
+                          float* out_r)
+  {
+    constexpr u32 PHASE_SHIFT = 8;
+    static_assert(Resampler::SINC_PHASES << PHASE_SHIFT == 0x10000, "Phases must cover the frac");
+    const SincTable& table = GetSincTable();
+    const u32 phase = frac >> PHASE_SHIFT;
+    const float t = (frac & ((1 << PHASE_SHIFT) - 1)) * (1.0f / (1 << PHASE_SHIFT));
+    const float* row0 = table.taps[phase];
+    const float* row1 = table.taps[phase + 1];
+
+    alignas(16) float coeffs[Resampler::SINC_TAPS];
+    for (u32 i = 0; i < Resampler::SINC_TAPS; ++i)
+      coeffs[i] = row0[i] + (row1[i] - row0[i]) * t;
+
+    *out_l = DotProduct<Resampler::SINC_TAPS>(left - HISTORY, coeffs);
+    *out_r = DotProduct<Resampler::SINC_TAPS>(right - HISTORY, coeffs);
+  }
+};
+}
+
+Resampler::Resampler(ResamplerKernel kernel) : m_kernel(kernel)
+{
+  if (kernel == ResamplerKernel::WindowedSinc)
+    GetSincTable();
+}
+
+void Resampler::SetKernel(ResamplerKernel kernel)
+{
+  m_kernel = kernel;
+  m_frac = 0;
+  m_skip = 0;
+  m_left.fill(0.0f);
+  m_right.fill(0.0f);
+}
+
+u32 Resampler::GetLookahead() const
+{
+  switch (m_kernel)
+  {
+  case ResamplerKernel::Cubic:
+    return KernelTraits<ResamplerKernel::Cubic>::LOOKAHEAD;
+  case ResamplerKernel::WindowedSinc:
+    return KernelTraits<ResamplerKernel::WindowedSinc>::LOOKAHEAD;
+  case ResamplerKernel::Linear:
+  default:
+    return KernelTraits<ResamplerKernel::Linear>::LOOKAHEAD;
+  }
+}
+
+u32 Resampler::Mix(s16* out, u32 num_frames, const s16* ring, u32 index_mask, u32* index_r,
+                   u32 index_w, u32 ratio, s32 lvolume, s32 rvolume)
+{
+  switch (m_kernel)
+  {
+  case ResamplerKernel::Cubic:
+    return MixWithKernel<ResamplerKernel::Cubic>(out, num_frames, ring, index_mask, index_r,
+                                                 index_w, ratio, lvolume, rvolume);
+  case ResamplerKernel::WindowedSinc:
+    return MixWithKernel<ResamplerKernel::WindowedSinc>(out, num_frames, ring, index_mask, index_r,
+                                                        index_w, ratio, lvolume, rvolume);
+  case ResamplerKernel::Linear:
+  default:
+    return MixWithKernel<ResamplerKernel::Linear>(out, num_frames, ring, index_mask, index_r,
+                                                  index_w, ratio, lvolume, rvolume);
+  }
+}
+
+template <ResamplerKernel kernel>
+u32 Resampler::MixWithKernel(s16* out, u32 num_frames, const s16* ring, u32 index_mask,
+                             u32* index_r, u32 index_w, u32 ratio, s32 lvolume, s32 rvolume)
+{
+  using Traits = KernelTraits<kernel>;
+  static_assert(Traits::HISTORY <= MAX_HISTORY && Traits::LOOKAHEAD <= MAX_LOOKAHEAD,
+                "Staging area is too small for this kernel");
+
+  u32 read = *index_r;
+  u32 produced = 0;
+
+  while (produced < num_frames)
+  {
+    u32 available = ((index_w - read) & index_mask) / 2;
+
+    // With a ratio above 1 the last step of a block can land past the frames that were
+    // available at the time; skip over them as they come in instead of dropping the step.
+    if (m_skip != 0)
+    {
+      const u32 skipped = std::min(m_skip, available);
+      read += skipped * 2;
+      available -= skipped;
+      m_skip -= skipped;
+      if (m_skip != 0)
+        break;
+    }
+
+    if (available <= Traits::LOOKAHEAD)
+      break;
+
+    // Stage a block of frames after the history carried over from the previous block.
+    const u32 staged = std::min(available, BLOCK_FRAMES + Traits::LOOKAHEAD);
+    for (u32 i = 0; i < staged; ++i)
+    {
+      const u32 index = read + i * 2;
+      m_left[Traits::HISTORY + i] = static_cast<s16>(Common::swap16(ring[index & index_mask]));
+      m_right[Traits::HISTORY + i] =
+          static_cast<s16>(Common::swap16(ring[(index + 1) & index_mask]));
+    }
+
+    const u32 usable = staged - Traits::LOOKAHEAD;
+    u32 position = 0;
+    for (; produced < num_frames && position < usable; ++produced)
+    {
+      float l, r;
+      Traits::Interpolate(&m_left[Traits::HISTORY + position],
+                          &m_right[Traits::HISTORY + position], m_frac, &l, &r);
+
+      s32 sample_l = (static_cast<s32>(l) * lvolume) >> 8;
+      sample_l += out[produced * 2 + 1];
+      out[produced * 2 + 1] = MathUtil::Clamp(sample_l, -32767, 32767);
+
+      s32 sample_r = (static_cast<s32>(r) * rvolume) >> 8;
+      sample_r += out[produced * 2];
+      out[produced * 2] = MathUtil::Clamp(sample_r, -32767, 32767);
+
+      m_frac += ratio;
+      position += m_frac >> 16;
+      m_frac &= 0xffff;
+    }
+
+    // Carry the frames right before the new read position over as history for the next block.
+    // Frames past the staging area are still unread in the ring as long as they are available.
+    for (u32 i = 0; i < Traits::HISTORY; ++i)
+    {
+      const u32 frame = position + i;
+      if (frame < Traits::HISTORY + staged)
+      {
+        m_left[i] = m_left[frame];
+        m_right[i] = m_right[frame];
+      }
+      else if (frame - Traits::HISTORY < available)
+      {
+        const u32 index = read + (frame - Traits::HISTORY) * 2;
+        m_left[i] = static_cast<s16>(Common::swap16(ring[index & index_mask]));
+        m_right[i] = static_cast<s16>(Common::swap16(ring[(index + 1) & index_mask]));
+      }
+      else
+      {
+        m_left[i] = 0.0f;
+        m_right[i] = 0.0f;
+      }
+    }
+
+    const u32 consumed = std::min(position, available);
+    m_skip = position - consumed;
+    read += consumed * 2;
+  }
+
+  *index_r = read;
+  return produced;
+}
+}
@@ -0,0 +1,64 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+
+#include "Common/CommonTypes.h"
+
+namespace AudioCommon
+{
+enum class ResamplerKernel
+{
+  Linear = 0,
+  Cubic = 1,
+  WindowedSinc = 2,
+};
+
+// Converts the big-endian stereo samples stored in a mixer FIFO to the backend sample rate.
+//
+// Input is consumed in blocks: a run of frames is byteswapped and deinterleaved into a float
+// staging area once, and the interpolation kernel then runs over contiguous memory. The ring
+// buffer itself is only ever read; the caller owns the read index and publishes it afterwards.
+class Resampler final
+{
+public:
+  static constexpr u32 SINC_TAPS = 16;
+  static constexpr u32 SINC_PHASES = 256;
+  static constexpr u32 BLOCK_FRAMES = 256;
+
+  explicit Resampler(ResamplerKernel kernel = ResamplerKernel::Linear);
+
+  ResamplerKernel GetKernel() const { return m_kernel; }
+  // Switching kernels discards the filter history and the fractional position.
+  void SetKernel(ResamplerKernel kernel);
+
+  // Number of frames after the current read position the kernel needs to produce a sample.
+  u32 GetLookahead() const;
+
+  // Resamples from ring (interleaved L/R, big-endian) and adds up to num_frames frames to out
+  // (interleaved R/L, host-endian), applying the 0-256 volumes and clamping.
+  // ratio is the number of input frames per output frame in 16.16 fixed point.
+  // index_r is advanced past the consumed input. Returns the number of frames written.
+  u32 Mix(s16* out, u32 num_frames, const s16* ring, u32 index_mask, u32* index_r, u32 index_w,
+          u32 ratio, s32 lvolume, s32 rvolume);
+
+private:
+  static constexpr u32 MAX_HISTORY = SINC_TAPS / 2 - 1;
+  static constexpr u32 MAX_LOOKAHEAD = SINC_TAPS / 2;
+  static constexpr u32 STAGING_SIZE = MAX_HISTORY + BLOCK_FRAMES + MAX_LOOKAHEAD;
+
+  template <ResamplerKernel kernel>
+  u32 MixWithKernel(s16* out, u32 num_frames, const s16* ring, u32 index_mask, u32* index_r,
+                    u32 index_w, u32 ratio, s32 lvolume, s32 rvolume);
+
+  ResamplerKernel m_kernel;
+  u32 m_frac = 0;
+  // Input frames the last step advanced past that were not in the ring yet.
+  u32 m_skip = 0;
+  alignas(16) std::array<float, STAGING_SIZE> m_left{};
+  alignas(16) std::array<float, STAGING_SIZE> m_right{};
+};
+}
@@ -7,12 +7,15 @@
 #include <memory>
 
 #include "AudioCommon/Mixer.h"
+#include "AudioCommon/OutputBuffer.h"
 #include "Common/CommonTypes.h"
 
 class SoundStream
 {
 protected:
   std::unique_ptr<CMixer> m_mixer;
+  // Backends that pull through the common output layer read from this instead of the mixer.
+  AudioCommon::OutputBuffer m_output{m_mixer.get(), m_mixer->GetSampleRate()};
   bool m_muted;
 
 public:
@@ -20,6 +23,7 @@ public:
   virtual ~SoundStream() {}
   static bool isValid() { return false; }
   CMixer* GetMixer() const { return m_mixer.get(); }
+  AudioCommon::OutputBuffer& GetOutputBuffer() { return m_output; }
   virtual bool Start() { return false; }
   virtual void SetVolume(int) {}
   virtual void SoundLoop() {}
@@ -0,0 +1,234 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+
+#include "Common/CPUDetect.h"
+#include "Common/Crypto/AES.h"
+
+// The hardware paths are only compiled when the compiler lets us emit the instructions (see the
+// per-file flags in CMakeLists.txt), and only taken when the host CPU reports support for them.
+#if defined(_M_X86) && (defined(_MSC_VER) || defined(__AES__))
+#define HAVE_AES_NI 1
+#include "Common/Intrinsics.h"
+#elif defined(_M_ARM_64) && defined(__ARM_FEATURE_CRYPTO)
+#define HAVE_ARMV8_CRYPTO 1
+#include <arm_neon.h>
+#endif
+
+namespace Common
+{
+namespace AES
+{
+namespace
+{
+#ifdef HAVE_AES_NI
+using Block = __m128i;
+
+inline Block Load(const u8* data)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+inline void Store(u8* data, Block block)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(data), block);
+}
+
+inline Block Xor(Block a, Block b)
+{
+  return _mm_xor_si128(a, b);
+}
+
+inline u32 SubWord(u32 word)
+{
+  // The low dword of the result is SubWord of the second source dword.
+  return static_cast<u32>(_mm_cvtsi128_si32(_mm_aeskeygenassist_si128(_mm_set1_epi32(word), 0)));
+}
+
+inline Block InverseMixColumns(Block block)
+{
+  return _mm_aesimc_si128(block);
+}
+
+template <size_t num_rounds>
+inline void DecryptBlocks(const Block* keys, Block* blocks, size_t count)
+{
+  for (size_t i = 0; i < count; ++i)
+    blocks[i] = _mm_xor_si128(blocks[i], keys[0]);
+  for (size_t round = 1; round < num_rounds; ++round)
+  {
+    for (size_t i = 0; i < count; ++i)
+      blocks[i] = _mm_aesdec_si128(blocks[i], keys[round]);
+  }
+  for (size_t i = 0; i < count; ++i)
+    blocks[i] = _mm_aesdeclast_si128(blocks[i], keys[num_rounds]);
+}
+#elif defined(HAVE_ARMV8_CRYPTO)
+using Block = uint8x16_t;
+
+inline Block Load(const u8* data)
+{
+  return vld1q_u8(data);
+}
+
+inline void Store(u8* data, Block block)
+{
+  vst1q_u8(data, block);
+}
+
+inline Block Xor(Block a, Block b)
+{
+  return veorq_u8(a, b);
+}
+
+inline u32 SubWord(u32 word)
+{
+  // With the word in every column, ShiftRows has no effect and AESE is just SubBytes.
+  const Block block = vaeseq_u8(vreinterpretq_u8_u32(vdupq_n_u32(word)), vdupq_n_u8(0));
+  return vgetq_lane_u32(vreinterpretq_u32_u8(block), 0);
+}
+
+inline Block InverseMixColumns(Block block)
+{
+  return vaesimcq_u8(block);
+}
+
+template <size_t num_rounds>
+inline void DecryptBlocks(const Block* keys, Block* blocks, size_t count)
+{
+  // AESD adds the round key before the inverse substitution rather than after it, so the key
+  // additions shift by one round compared to the x86 instructions.
+  for (size_t round = 0; round < num_rounds - 1; ++round)
+  {
+    for (size_t i = 0; i < count; ++i)
+      blocks[i] = vaesimcq_u8(vaesdq_u8(blocks[i], keys[round]));
+  }
+  for (size_t i = 0; i < count; ++i)
+    blocks[i] = veorq_u8(vaesdq_u8(blocks[i], keys[num_rounds - 1]), keys[num_rounds]);
+}
+#endif
+
+#if defined(HAVE_AES_NI) || defined(HAVE_ARMV8_CRYPTO)
+// Number of blocks decrypted at once. CBC decryption has no dependency between blocks, so
+// interleaving them hides the latency of the AES instructions.
+constexpr size_t PARALLEL_BLOCKS = 4;
+
+template <size_t num_rounds>
+void ExpandKey(const u8* key, std::array<std::array<u8, BLOCK_SIZE>, num_rounds + 1>* round_keys)
+{
+  static_assert(num_rounds == 10, "Only AES-128 is supported");
+
+  // FIPS-197 key expansion, with words stored little-endian so that byte order is preserved.
+  u32 words[4 * (num_rounds + 1)];
+  std::memcpy(words, key, BLOCK_SIZE);
+  u32 rcon = 1;
+  for (size_t i = 4; i < 4 * (num_rounds + 1); ++i)
+  {
+    u32 temp = words[i - 1];
+    if (i % 4 == 0)
+    {
+      temp = SubWord((temp >> 8) | (temp << 24)) ^ rcon;
+      rcon = (rcon << 1) ^ ((rcon >> 7) * 0x11b);
+    }
+    words[i] = words[i - 4] ^ temp;
+  }
+
+  // The equivalent inverse cipher runs through the keys backwards, with InvMixColumns applied
+  // to all of them except the first and last.
+  for (size_t round = 0; round <= num_rounds; ++round)
+  {
+    Block block = Load(reinterpret_cast<const u8*>(&words[4 * (num_rounds - round)]));
+    if (round != 0 && round != num_rounds)
+      block = InverseMixColumns(block);
+    Store((*round_keys)[round].data(), block);
+  }
+}
+
+template <size_t num_rounds>
+void DecryptCBCHardware(const std::array<std::array<u8, BLOCK_SIZE>, num_rounds + 1>& round_keys,
+                        u8* iv, const u8* in, u8* out, size_t size)
+{
+  Block keys[num_rounds + 1];
+  for (size_t round = 0; round <= num_rounds; ++round)
+    keys[round] = Load(round_keys[round].data());
+
+  Block chain = Load(iv);
+  size_t offset = 0;
+  for (; offset + PARALLEL_BLOCKS * BLOCK_SIZE <= size; offset += PARALLEL_BLOCKS * BLOCK_SIZE)
+  {
+    // All ciphertext blocks are loaded before anything is stored so that in-place works.
+    Block cipher[PARALLEL_BLOCKS];
+    Block plain[PARALLEL_BLOCKS];
+    for (size_t i = 0; i < PARALLEL_BLOCKS; ++i)
+      cipher[i] = plain[i] = Load(in + offset + i * BLOCK_SIZE);
+
+    DecryptBlocks<num_rounds>(keys, plain, PARALLEL_BLOCKS);
+
+    for (size_t i = 0; i < PARALLEL_BLOCKS; ++i)
+    {
+      Store(out + offset + i * BLOCK_SIZE, Xor(plain[i], chain));
+      chain = cipher[i];
+    }
+  }
+
+  for (; offset < size; offset += BLOCK_SIZE)
+  {
+    const Block cipher = Load(in + offset);
+    Block plain = cipher;
+    DecryptBlocks<num_rounds>(keys, &plain, 1);
+    Store(out + offset, Xor(plain, chain));
+    chain = cipher;
+  }
+
+  Store(iv, chain);
+}
+#endif
+}  // Anonymous namespace
+
+DecryptionContext::DecryptionContext() : m_round_keys(), m_use_hardware(false)
+{
+  mbedtls_aes_init(&m_mbedtls_context);
+}
+
+DecryptionContext::DecryptionContext(const u8* key) : DecryptionContext()
+{
+  SetKey(key);
+}
+
+DecryptionContext::~DecryptionContext()
+{
+  mbedtls_aes_free(&m_mbedtls_context);
+}
+
+void DecryptionContext::SetKey(const u8* key)
+{
+#if defined(HAVE_AES_NI) || defined(HAVE_ARMV8_CRYPTO)
+  m_use_hardware = cpu_info.bAES;
+  if (m_use_hardware)
+  {
+    ExpandKey<NUM_ROUNDS>(key, &m_round_keys);
+    return;
+  }
+#endif
+
+  mbedtls_aes_setkey_dec(&m_mbedtls_context, key, 128);
+}
+
+void DecryptionContext::DecryptCBC(u8* iv, const u8* in, u8* out, size_t size) const
+{
+#if defined(HAVE_AES_NI) || defined(HAVE_ARMV8_CRYPTO)
+  if (m_use_hardware)
+  {
+    DecryptCBCHardware<NUM_ROUNDS>(m_round_keys, iv, in, out, size);
+    return;
+  }
+#endif
+
+  // mbed TLS does not modify the context when crypting; its API just isn't const-correct.
+  mbedtls_aes_crypt_cbc(const_cast<mbedtls_aes_context*>(&m_mbedtls_context),
+                        MBEDTLS_AES_DECRYPT, size, iv, in, out);
+}
+}  // namespace AES
+}  // namespace Common
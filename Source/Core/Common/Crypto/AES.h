@@ -0,0 +1,47 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mbedtls/aes.h>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+namespace AES
+{
+constexpr size_t BLOCK_SIZE = 16;
+
+// AES-128 decryption context. Uses AES-NI or the ARMv8 crypto extensions when the host CPU
+// supports them, and mbed TLS otherwise.
+class DecryptionContext final
+{
+public:
+  DecryptionContext();
+  explicit DecryptionContext(const u8* key);
+  ~DecryptionContext();
+
+  DecryptionContext(const DecryptionContext&) = delete;
+  DecryptionContext& operator=(const DecryptionContext&) = delete;
+
+  void SetKey(const u8* key);
+
+  // Decrypts size bytes, which must be a multiple of BLOCK_SIZE, in CBC mode. Like
+  // mbedtls_aes_crypt_cbc, iv is updated so that consecutive calls chain, and in and out may
+  // point to the same buffer.
+  void DecryptCBC(u8* iv, const u8* in, u8* out, size_t size) const;
+
+private:
+  static constexpr size_t NUM_ROUNDS = 10;
+
+  // Round keys for the equivalent inverse cipher, used by the hardware paths.
+  alignas(16) std::array<std::array<u8, BLOCK_SIZE>, NUM_ROUNDS + 1> m_round_keys;
+  bool m_use_hardware;
+  mbedtls_aes_context m_mbedtls_context;
+};
+}  // namespace AES
+}  // namespace Common
@@ -0,0 +1,185 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <mbedtls/sha1.h>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonFuncs.h"
+#include "Common/Crypto/SHA1.h"
+
+// As with the AES code, the hardware paths need per-file compiler flags (see CMakeLists.txt) and
+// are only taken when the host CPU reports support for them.
+#if defined(_M_X86) && (defined(_MSC_VER) || defined(__SHA__))
+#define HAVE_SHA_NI 1
+#include "Common/Intrinsics.h"
+#elif defined(_M_ARM_64) && defined(__ARM_FEATURE_CRYPTO)
+#define HAVE_ARMV8_SHA1 1
+#include <arm_neon.h>
+#endif
+
+namespace Common
+{
+namespace SHA1
+{
+namespace
+{
+constexpr size_t BLOCK_SIZE = 64;
+
+#ifdef HAVE_SHA_NI
+// Loads four big-endian message words, with the first one in the highest lane as the SHA
+// instructions expect. Only uses SSE2 so that -msha is the only extra flag this file needs.
+inline __m128i LoadMessage(const u8* data)
+{
+  __m128i message = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  message = _mm_shuffle_epi32(message, 0x1B);
+  message = _mm_shufflehi_epi16(_mm_shufflelo_epi16(message, 0xB1), 0xB1);
+  return _mm_or_si128(_mm_slli_epi16(message, 8), _mm_srli_epi16(message, 8));
+}
+
+// Runs the groups of four rounds in [first_group, end_group), which all use the same function.
+template <int function>
+inline void Rounds(int first_group, int end_group, __m128i* messages, __m128i* abcd,
+                   __m128i* abcd_prev)
+{
+  for (int group = first_group; group < end_group; ++group)
+  {
+    __m128i& message = messages[group % 4];
+    if (group >= 4)
+    {
+      // W[t] = rol(W[t-3] ^ W[t-8] ^ W[t-14] ^ W[t-16], 1), four words at a time.
+      message = _mm_sha1msg1_epu32(message, messages[(group + 1) % 4]);
+      message = _mm_xor_si128(message, messages[(group + 2) % 4]);
+      message = _mm_sha1msg2_epu32(message, messages[(group + 3) % 4]);
+    }
+
+    const __m128i e = _mm_sha1nexte_epu32(*abcd_prev, message);
+    *abcd_prev = *abcd;
+    *abcd = _mm_sha1rnds4_epu32(*abcd, e, function);
+  }
+}
+
+void ProcessBlocks(u32* state, const u8* data, size_t num_blocks)
+{
+  __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i*>(state)), 0x1B);
+  __m128i e = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+  for (size_t block = 0; block < num_blocks; ++block, data += BLOCK_SIZE)
+  {
+    const __m128i abcd_saved = abcd;
+    const __m128i e_saved = e;
+
+    __m128i messages[4];
+    for (int i = 0; i < 4; ++i)
+      messages[i] = LoadMessage(data + i * 16);
+
+    // The first group adds E directly; later ones derive it from A as it was two groups earlier.
+    __m128i abcd_prev = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, _mm_add_epi32(e, messages[0]), 0);
+    Rounds<0>(1, 5, messages, &abcd, &abcd_prev);
+    Rounds<1>(5, 10, messages, &abcd, &abcd_prev);
+    Rounds<2>(10, 15, messages, &abcd, &abcd_prev);
+    Rounds<3>(15, 20, messages, &abcd, &abcd_prev);
+
+    e = _mm_sha1nexte_epu32(abcd_prev, e_saved);
+    abcd = _mm_add_epi32(abcd, abcd_saved);
+  }
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1B));
+  state[4] = static_cast<u32>(_mm_cvtsi128_si32(_mm_shuffle_epi32(e, 0xFF)));
+}
+#elif defined(HAVE_ARMV8_SHA1)
+inline uint32x4_t LoadMessage(const u8* data)
+{
+  return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data)));
+}
+
+void ProcessBlocks(u32* state, const u8* data, size_t num_blocks)
+{
+  static const u32 constants[4] = {0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6};
+
+  uint32x4_t abcd = vld1q_u32(state);
+  u32 e = state[4];
+
+  for (size_t block = 0; block < num_blocks; ++block, data += BLOCK_SIZE)
+  {
+    const uint32x4_t abcd_saved = abcd;
+    const u32 e_saved = e;
+
+    uint32x4_t messages[4];
+    for (int i = 0; i < 4; ++i)
+      messages[i] = LoadMessage(data + i * 16);
+
+    for (int group = 0; group < 20; ++group)
+    {
+      uint32x4_t& message = messages[group % 4];
+      if (group >= 4)
+      {
+        message = vsha1su0q_u32(message, messages[(group + 1) % 4], messages[(group + 2) % 4]);
+        message = vsha1su1q_u32(message, messages[(group + 3) % 4]);
+      }
+
+      const uint32x4_t w = vaddq_u32(message, vdupq_n_u32(constants[group / 5]));
+      const u32 next_e = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+      if (group < 5)
+        abcd = vsha1cq_u32(abcd, e, w);
+      else if (group >= 10 && group < 15)
+        abcd = vsha1mq_u32(abcd, e, w);
+      else
+        abcd = vsha1pq_u32(abcd, e, w);
+      e = next_e;
+    }
+
+    abcd = vaddq_u32(abcd, abcd_saved);
+    e += e_saved;
+  }
+
+  vst1q_u32(state, abcd);
+  state[4] = e;
+}
+#endif
+
+#if defined(HAVE_SHA_NI) || defined(HAVE_ARMV8_SHA1)
+Digest CalculateDigestHardware(const u8* data, size_t size)
+{
+  u32 state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+  const size_t full_blocks = size / BLOCK_SIZE;
+  ProcessBlocks(state, data, full_blocks);
+
+  // Pad the remainder with a 1 bit and the big-endian length in bits, which takes one more
+  // block, or two if there isn't room for the length after the remainder.
+  u8 tail[BLOCK_SIZE * 2] = {};
+  const size_t remainder = size % BLOCK_SIZE;
+  std::memcpy(tail, data + full_blocks * BLOCK_SIZE, remainder);
+  tail[remainder] = 0x80;
+  const size_t tail_blocks = remainder + 1 + sizeof(u64) > BLOCK_SIZE ? 2 : 1;
+  const u64 length_bits = Common::swap64(static_cast<u64>(size) * 8);
+  std::memcpy(&tail[tail_blocks * BLOCK_SIZE - sizeof(u64)], &length_bits, sizeof(u64));
+  ProcessBlocks(state, tail, tail_blocks);
+
+  Digest digest;
+  for (size_t i = 0; i < 5; ++i)
+  {
+    const u32 word = Common::swap32(state[i]);
+    std::memcpy(&digest[i * sizeof(u32)], &word, sizeof(u32));
+  }
+  return digest;
+}
+#endif
+}  // Anonymous namespace
+
+Digest CalculateDigest(const u8* data, size_t size)
+{
+#if defined(HAVE_SHA_NI) || defined(HAVE_ARMV8_SHA1)
+  if (cpu_info.bSHA1)
+    return CalculateDigestHardware(data, size);
+#endif
+
+  Digest digest;
+  mbedtls_sha1(data, size, digest.data());
+  return digest;
+}
+}  // namespace SHA1
+}  // namespace Common
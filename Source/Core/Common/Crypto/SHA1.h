@@ -0,0 +1,23 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+namespace SHA1
+{
+constexpr size_t DIGEST_SIZE = 20;
+using Digest = std::array<u8, DIGEST_SIZE>;
+
+// Uses the SHA extensions on x86 or the ARMv8 crypto extensions when the host CPU supports them,
+// and mbed TLS otherwise.
+Digest CalculateDigest(const u8* data, size_t size);
+}  // namespace SHA1
+}  // namespace Common
@@ -32,6 +32,7 @@
 #include <libgen.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <utime.h>
 #endif
 
 #if defined(__APPLE__)
@@ -391,6 +392,67 @@ u64 GetSize(const std::string& filename)
   return 0;
 }
 
+// Returns the last modification time of filename in seconds since the epoch
+u64 GetModifiedTime(const std::string& filename)
+{
+  struct stat buf;
+#ifdef _WIN32
+  if (_tstat64(UTF8ToTStr(filename).c_str(), &buf) == 0)
+#else
+  if (stat(filename.c_str(), &buf) == 0)
+#endif
+    return static_cast<u64>(buf.st_mtime);
+
+  WARN_LOG(COMMON, "GetModifiedTime: stat failed %s: %s", filename.c_str(),
+           GetLastErrorMsg().c_str());
+  return 0;
+}
+
+bool SetModifiedTime(const std::string& path, u64 time)
+{
+#ifdef _WIN32
+  // Directories can only be opened with FILE_FLAG_BACKUP_SEMANTICS
+  const HANDLE handle =
+      CreateFile(UTF8ToTStr(path).c_str(), FILE_WRITE_ATTRIBUTES,
+                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                 FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+  if (handle == INVALID_HANDLE_VALUE)
+    return false;
+
+  // FILETIME counts 100 ns intervals since 1601
+  const u64 file_time = (time + 11644473600ULL) * 10000000ULL;
+  FILETIME modified_time;
+  modified_time.dwLowDateTime = static_cast<DWORD>(file_time);
+  modified_time.dwHighDateTime = static_cast<DWORD>(file_time >> 32);
+  const bool success = SetFileTime(handle, nullptr, nullptr, &modified_time) != 0;
+  CloseHandle(handle);
+  return success;
+#else
+  utimbuf times;
+  times.actime = static_cast<time_t>(time);
+  times.modtime = static_cast<time_t>(time);
+  return utime(path.c_str(), &times) == 0;
+#endif
+}
+
+bool GetFileInfo(const std::string& filename, FileInfo* info)
+{
+  struct stat buf;
+#ifdef _WIN32
+  if (_tstat64(UTF8ToTStr(filename).c_str(), &buf) != 0)
+#else
+  if (stat(filename.c_str(), &buf) != 0)
+#endif
+    return false;
+
+  if (S_ISDIR(buf.st_mode))
+    return false;
+
+  info->size = static_cast<u64>(buf.st_size);
+  info->modified_time = static_cast<u64>(buf.st_mtime);
+  return true;
+}
+
 // Overloaded GetSize, accepts file descriptor
 u64 GetSize(const int fd)
 {
@@ -979,6 +1041,39 @@ u64 IOFile::Tell() const
     return -1;
 }
 
+bool IOFile::ReadAt(void* data, size_t length, u64 offset) const
+{
+  if (!IsOpen())
+    return false;
+
+  u8* out = static_cast<u8*>(data);
+  while (length > 0)
+  {
+#ifdef _WIN32
+    const HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file)));
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD read_bytes = 0;
+    const DWORD chunk_size = static_cast<DWORD>(std::min<size_t>(length, 0x40000000));
+    if (!ReadFile(handle, out, chunk_size, &read_bytes, &overlapped) || read_bytes == 0)
+      return false;
+#else
+    const ssize_t read_bytes = pread(fileno(m_file), out, length, static_cast<off_t>(offset));
+    if (read_bytes < 0 && errno == EINTR)
+      continue;
+    if (read_bytes <= 0)
+      return false;
+#endif
+
+    out += read_bytes;
+    length -= read_bytes;
+    offset += read_bytes;
+  }
+
+  return true;
+}
+
 bool IOFile::Flush()
 {
   if (!IsOpen() || 0 != std::fflush(m_file))
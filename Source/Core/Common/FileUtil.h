@@ -88,6 +88,23 @@ u64 GetSize(const int fd);
 // Overloaded GetSize, accepts FILE*
 u64 GetSize(FILE* f);
 
+// Returns the last modification time of filename in seconds since the epoch, or 0 on failure
+u64 GetModifiedTime(const std::string& filename);
+
+// Sets the modification time of a file or directory, in seconds since the epoch
+bool SetModifiedTime(const std::string& path, u64 time);
+
+struct FileInfo
+{
+  u64 size = 0;
+  // In seconds since the epoch
+  u64 modified_time = 0;
+};
+
+// Gets the size and modification time of filename with a single stat.
+// Returns false if filename doesn't exist or is a directory.
+bool GetFileInfo(const std::string& filename, FileInfo* info);
+
 // Returns true if successful, or path already exists.
 bool CreateDir(const std::string& filename);
 
@@ -209,6 +226,11 @@ public:
     return WriteArray(reinterpret_cast<const char*>(data), length);
   }
 
+  // Reads from the given offset without using the stdio buffer or the file position, so that
+  // several threads can read from one file at once. Leaves m_good alone for the same reason.
+  // On Windows, the file position does move, so don't mix this with ReadArray on one file.
+  bool ReadAt(void* data, size_t length, u64 offset) const;
+
   bool IsOpen() const { return nullptr != m_file; }
   // m_good is set to false when a read, write or other function fails
   bool IsGood() const { return m_good; }
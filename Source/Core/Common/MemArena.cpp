@@ -116,6 +116,21 @@ void* MemArena::CreateView(s64 offset, size_t size, void* base)
 
 void MemArena::ReleaseView(void* view, size_t size)
 {
+#ifdef _WIN32
+  UnmapViewOfFile(view);
+#else
+  // CreateView maps with MAP_FIXED, which would silently replace anything that had been put in a
+  // hole here in the meantime.
+  if (mmap(view, size, PROT_NONE, MAP_FIXED | MAP_PRIVATE | MAP_ANON, -1, 0) == MAP_FAILED)
+  {
+    NOTICE_LOG(MEMMAP, "mmap failed");
+    munmap(view, size);
+  }
+#endif
+}
+
+void MemArena::FreeView(void* view, size_t size)
+{
 #ifdef _WIN32
   UnmapViewOfFile(view);
 #else
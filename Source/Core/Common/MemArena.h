@@ -23,7 +23,11 @@ public:
   void GrabSHMSegment(size_t size);
   void ReleaseSHMSegment();
   void* CreateView(s64 offset, size_t size, void* base = nullptr);
+  // Leaves the address range of the view reserved, so that nothing else gets put in the hole
+  // before a view is created there again.
   void ReleaseView(void* view, size_t size);
+  // Gives up the address range of the view as well.
+  void FreeView(void* view, size_t size);
 
   // This finds 1 GB in 32-bit, 16 GB in 64-bit.
   static u8* FindMemoryBase();
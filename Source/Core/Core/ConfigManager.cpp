@@ -6,11 +6,13 @@
 #include <climits>
 #include <memory>
 
+#include "AudioCommon/Resampler.h"
 #include "Common/CDUtils.h"
 #include "Common/CommonPaths.h"
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
 #include "Common/Logging/Log.h"
+#include "Common/MathUtil.h"
 #include "Common/MsgHandler.h"
 #include "Common/NandPaths.h"
 #include "Common/StringUtil.h"
@@ -294,6 +296,7 @@ void SConfig::SaveDSPSettings(IniFile& ini)
   dsp->Set("DumpUCode", m_DumpUCode);
   dsp->Set("Backend", sBackend);
   dsp->Set("Volume", m_Volume);
+  dsp->Set("Resampler", m_AudioResampler);
   dsp->Set("CaptureLog", m_DSPCaptureLog);
 }
 
@@ -625,6 +628,11 @@ void SConfig::LoadDSPSettings(IniFile& ini)
   dsp->Get("Backend", &sBackend, BACKEND_NULLSOUND);
 #endif
   dsp->Get("Volume", &m_Volume, 100);
+  dsp->Get("Resampler", &m_AudioResampler, 0);
+  // The mixer and the audio config pane expect one of the kernels that exist
+  m_AudioResampler =
+      MathUtil::Clamp(m_AudioResampler, static_cast<int>(AudioCommon::ResamplerKernel::Linear),
+                      static_cast<int>(AudioCommon::ResamplerKernel::WindowedSinc));
   dsp->Get("CaptureLog", &m_DSPCaptureLog, false);
 
   m_IsMuted = false;
@@ -824,7 +832,7 @@ bool SConfig::AutoSetup(EBootBS2 _BootBS2)
     if (!strcasecmp(Extension.c_str(), ".gcm") || !strcasecmp(Extension.c_str(), ".iso") ||
         !strcasecmp(Extension.c_str(), ".tgc") || !strcasecmp(Extension.c_str(), ".wbfs") ||
         !strcasecmp(Extension.c_str(), ".ciso") || !strcasecmp(Extension.c_str(), ".gcz") ||
-        bootDrive)
+        !strcasecmp(Extension.c_str(), ".wcz") || bootDrive)
     {
       m_BootType = BOOT_ISO;
       std::unique_ptr<DiscIO::IVolume> pVolume(DiscIO::CreateVolumeFromFilename(m_strFilename));
@@ -306,6 +306,7 @@ struct SConfig : NonCopyable
   bool m_IsMuted;
   bool m_DumpUCode;
   int m_Volume;
+  int m_AudioResampler;
   std::string sBackend;
 
   // Input settings
@@ -4,6 +4,8 @@
 
 #include "Core/DSP/DSPAccelerator.h"
 
+#include <array>
+
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "Common/MathUtil.h"
@@ -13,48 +15,164 @@
 
 namespace DSP
 {
+namespace
+{
+// The parts of the accelerator state that change with every read.
+struct AcceleratorState
+{
+  u32 address;
+  u16 pred_scale;
+  u16 yn1;
+  u16 yn2;
+
+  bool operator==(const AcceleratorState& other) const
+  {
+    return address == other.address && pred_scale == other.pred_scale && yn1 == other.yn1 &&
+           yn2 == other.yn2;
+  }
+};
+
+// ADPCM samples decoded ahead of the ucode, up to the end of the current 8-byte frame. Every
+// sample is stored together with the state the scalar decoder would leave behind after it, so a
+// read can be served from here as long as the registers still hold exactly what the previous read
+// left in them. Anything that could change the outcome otherwise (writes to the other accelerator
+// registers, ARAM and DMA writes, leaving DSPCore_RunCycles) resets the prefetch.
+struct PrefetchedSample
+{
+  u16 value;
+  bool loop;
+  AcceleratorState state;
+};
+
+constexpr u32 ADPCM_FRAME_SAMPLES = 14;
+
+std::array<PrefetchedSample, ADPCM_FRAME_SAMPLES> s_prefetch;
+u32 s_prefetch_count = 0;
+u32 s_prefetch_next = 0;
+
+AcceleratorState LoadState()
+{
+  AcceleratorState state;
+  state.address = (g_dsp.ifx_regs[DSP_ACCAH] << 16) | g_dsp.ifx_regs[DSP_ACCAL];
+  state.pred_scale = g_dsp.ifx_regs[DSP_PRED_SCALE];
+  state.yn1 = g_dsp.ifx_regs[DSP_YN1];
+  state.yn2 = g_dsp.ifx_regs[DSP_YN2];
+  return state;
+}
+
+void StoreState(const AcceleratorState& state)
+{
+  g_dsp.ifx_regs[DSP_ACCAH] = state.address >> 16;
+  g_dsp.ifx_regs[DSP_ACCAL] = state.address & 0xffff;
+  g_dsp.ifx_regs[DSP_PRED_SCALE] = state.pred_scale;
+  g_dsp.ifx_regs[DSP_YN1] = state.yn1;
+  g_dsp.ifx_regs[DSP_YN2] = state.yn2;
+}
+}
+
 // The hardware adpcm decoder :)
-static s16 ADPCM_Step(u32& _rSamplePos)
+static s16 ADPCM_Step(AcceleratorState* state)
 {
   const s16* pCoefTable = (const s16*)&g_dsp.ifx_regs[DSP_COEF_A1_0];
 
-  if ((_rSamplePos & 15) == 0)
+  if ((state->address & 15) == 0)
   {
-    g_dsp.ifx_regs[DSP_PRED_SCALE] = Host::ReadHostMemory((_rSamplePos & ~15) >> 1);
-    _rSamplePos += 2;
+    state->pred_scale = Host::ReadHostMemory((state->address & ~15) >> 1);
+    state->address += 2;
   }
 
-  int scale = 1 << (g_dsp.ifx_regs[DSP_PRED_SCALE] & 0xF);
-  int coef_idx = (g_dsp.ifx_regs[DSP_PRED_SCALE] >> 4) & 0x7;
+  int scale = 1 << (state->pred_scale & 0xF);
+  int coef_idx = (state->pred_scale >> 4) & 0x7;
 
   s32 coef1 = pCoefTable[coef_idx * 2 + 0];
   s32 coef2 = pCoefTable[coef_idx * 2 + 1];
 
-  int temp = (_rSamplePos & 1) ? (Host::ReadHostMemory(_rSamplePos >> 1) & 0xF) :
-                                 (Host::ReadHostMemory(_rSamplePos >> 1) >> 4);
+  int temp = (state->address & 1) ? (Host::ReadHostMemory(state->address >> 1) & 0xF) :
+                                    (Host::ReadHostMemory(state->address >> 1) >> 4);
 
   if (temp >= 8)
     temp -= 16;
 
   // 0x400 = 0.5  in 11-bit fixed point
-  int val =
-      (scale * temp) +
-      ((0x400 + coef1 * (s16)g_dsp.ifx_regs[DSP_YN1] + coef2 * (s16)g_dsp.ifx_regs[DSP_YN2]) >> 11);
+  int val = (scale * temp) + ((0x400 + coef1 * (s16)state->yn1 + coef2 * (s16)state->yn2) >> 11);
   val = MathUtil::Clamp(val, -0x7FFF, 0x7FFF);
 
-  g_dsp.ifx_regs[DSP_YN2] = g_dsp.ifx_regs[DSP_YN1];
-  g_dsp.ifx_regs[DSP_YN1] = val;
+  state->yn2 = state->yn1;
+  state->yn1 = val;
 
-  _rSamplePos++;
+  state->address++;
 
   // The advanced interpolation (linear, polyphase,...) is done by the ucode,
   // so we don't need to bother with it here.
   return val;
 }
 
+// Returns true and sets the address back to the loop start when the end address was reached.
+static bool CheckLoop(u32* address, u32 end_address, u8 step_size_bytes)
+{
+  // Somehow, YN1 and YN2 must be initialized with their "loop" values,
+  // so yeah, it seems likely that we should raise an exception to let
+  // the DSP program do that, at least if DSP_FORMAT == 0x0A.
+  if (*address != end_address + step_size_bytes - 1)
+    return false;
+
+  // Set address back to start address.
+  *address = (g_dsp.ifx_regs[DSP_ACSAH] << 16) | g_dsp.ifx_regs[DSP_ACSAL];
+  return true;
+}
+
+static u8 GetADPCMStepSize(u32 end_address)
+{
+  switch (end_address & 15)
+  {
+  case 0:  // Tom and Jerry
+    return 1;
+  case 1:  // Blazing Angels
+    return 0;
+  default:
+    return 2;
+  }
+}
+
+// Decodes the rest of the current ADPCM frame, stopping early when the loop end is reached since
+// the ucode is likely to reprogram the accelerator when that happens.
+static void PrefetchADPCMFrame(u32 end_address)
+{
+  const u8 step_size_bytes = GetADPCMStepSize(end_address);
+  AcceleratorState state = LoadState();
+
+  s_prefetch_count = 0;
+  s_prefetch_next = 0;
+  do
+  {
+    PrefetchedSample& sample = s_prefetch[s_prefetch_count++];
+    sample.value = ADPCM_Step(&state);
+    sample.loop = CheckLoop(&state.address, end_address, step_size_bytes);
+    sample.state = state;
+    if (sample.loop)
+      break;
+  } while ((state.address & 15) != 0 && s_prefetch_count < s_prefetch.size());
+}
+
+static u16 ReadPrefetchedSample()
+{
+  const PrefetchedSample& sample = s_prefetch[s_prefetch_next++];
+  StoreState(sample.state);
+  if (sample.loop)
+    DSPCore_SetException(EXP_ACCOV);
+  return sample.value;
+}
+
+void dsp_reset_accelerator_prefetch()
+{
+  s_prefetch_count = 0;
+  s_prefetch_next = 0;
+}
+
 u16 dsp_read_aram_d3()
 {
   // Zelda ucode reads ARAM through 0xffd3.
+  dsp_reset_accelerator_prefetch();
   const u32 EndAddress = (g_dsp.ifx_regs[DSP_ACEAH] << 16) | g_dsp.ifx_regs[DSP_ACEAL];
   u32 Address = (g_dsp.ifx_regs[DSP_ACCAH] << 16) | g_dsp.ifx_regs[DSP_ACCAL];
   u16 val = 0;
@@ -91,6 +209,7 @@ void dsp_write_aram_d3(u16 value)
   // initialization.  Don't know if it ever does it later, too.
   // Pikmin 2 Wii writes non-stop to 0x10008000-0x1000801f (non-zero values too)
   // Zelda TP Wii writes non-stop to 0x10000000-0x1000001f (non-zero values too)
+  dsp_reset_accelerator_prefetch();
   u32 Address = (g_dsp.ifx_regs[DSP_ACCAH] << 16) | g_dsp.ifx_regs[DSP_ACCAL];
 
   switch (g_dsp.ifx_regs[DSP_FORMAT])
@@ -111,6 +230,13 @@ void dsp_write_aram_d3(u16 value)
 
 u16 dsp_read_accelerator()
 {
+  // Sequential ADPCM reads are served from the prefetched frame.
+  if (s_prefetch_next < s_prefetch_count && g_dsp.ifx_regs[DSP_FORMAT] == 0x00 &&
+      LoadState() == s_prefetch[s_prefetch_next - 1].state)
+  {
+    return ReadPrefetchedSample();
+  }
+
   const u32 EndAddress = (g_dsp.ifx_regs[DSP_ACEAH] << 16) | g_dsp.ifx_regs[DSP_ACEAL];
   u32 Address = (g_dsp.ifx_regs[DSP_ACCAH] << 16) | g_dsp.ifx_regs[DSP_ACCAL];
   u16 val;
@@ -125,20 +251,8 @@ u16 dsp_read_accelerator()
   switch (g_dsp.ifx_regs[DSP_FORMAT])
   {
   case 0x00:  // ADPCM audio
-    switch (EndAddress & 15)
-    {
-    case 0:  // Tom and Jerry
-      step_size_bytes = 1;
-      break;
-    case 1:  // Blazing Angels
-      step_size_bytes = 0;
-      break;
-    default:
-      step_size_bytes = 2;
-      break;
-    }
-    val = ADPCM_Step(Address);
-    break;
+    PrefetchADPCMFrame(EndAddress);
+    return ReadPrefetchedSample();
   case 0x0A:  // 16-bit PCM audio
     val = (Host::ReadHostMemory(Address * 2) << 8) | Host::ReadHostMemory(Address * 2 + 1);
     g_dsp.ifx_regs[DSP_YN2] = g_dsp.ifx_regs[DSP_YN1];
@@ -167,15 +281,8 @@ u16 dsp_read_accelerator()
   // games using pcm16: GC Sega games, ...
 
   // Check for loop.
-  // Somehow, YN1 and YN2 must be initialized with their "loop" values,
-  // so yeah, it seems likely that we should raise an exception to let
-  // the DSP program do that, at least if DSP_FORMAT == 0x0A.
-  if (Address == (EndAddress + step_size_bytes - 1))
-  {
-    // Set address back to start address.
-    Address = (g_dsp.ifx_regs[DSP_ACSAH] << 16) | g_dsp.ifx_regs[DSP_ACSAL];
+  if (CheckLoop(&Address, EndAddress, step_size_bytes))
     DSPCore_SetException(EXP_ACCOV);
-  }
 
   g_dsp.ifx_regs[DSP_ACCAH] = Address >> 16;
   g_dsp.ifx_regs[DSP_ACCAL] = Address & 0xffff;
@@ -9,6 +9,9 @@
 namespace DSP
 {
 u16 dsp_read_accelerator();
+// Drops ADPCM samples that were decoded ahead. Must be called whenever the accelerator registers,
+// ARAM or the memory the accelerator reads from may have changed behind its back.
+void dsp_reset_accelerator_prefetch();
 
 u16 dsp_read_aram_d3();
 void dsp_write_aram_d3(u16 value);
@@ -17,6 +17,7 @@
 #include "Common/MemoryUtil.h"
 #include "Common/MsgHandler.h"
 
+#include "Core/DSP/DSPAccelerator.h"
 #include "Core/DSP/DSPAnalyzer.h"
 #include "Core/DSP/DSPHWInterface.h"
 #include "Core/DSP/DSPHost.h"
@@ -243,6 +244,9 @@ void DSPCore_CheckExceptions()
 // Handle state changes and stepping.
 int DSPCore_RunCycles(int cycles)
 {
+  // ARAM may have been written while the DSP wasn't running.
+  dsp_reset_accelerator_prefetch();
+
   if (g_dsp_jit)
   {
     return g_dsp_jit->RunCycles(static_cast<u16>(cycles));
@@ -266,6 +270,7 @@ int DSPCore_RunCycles(int cycles)
       if (core_state != DSPCORE_STEPPING)
         continue;
 
+      dsp_reset_accelerator_prefetch();
       Interpreter::Step();
       cycles--;
 
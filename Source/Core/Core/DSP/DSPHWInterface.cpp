@@ -96,6 +96,9 @@ void gdsp_ifx_write(u32 addr, u32 val)
 {
   g_dsp_cap->LogIFXWrite(addr, val);
 
+  if ((addr & 0xff) >= DSP_COEF_A1_0 && (addr & 0xff) <= DSP_ACUNK2)
+    dsp_reset_accelerator_prefetch();
+
   switch (addr & 0xff)
   {
   case DSP_DIRQ:
@@ -318,6 +321,9 @@ static const u8* gdsp_ddma_out(u16 dsp_addr, u32 addr, u32 size)
 
 static void gdsp_do_dma()
 {
+  // On the Wii, the accelerator can read from main memory.
+  dsp_reset_accelerator_prefetch();
+
   u32 addr = (g_dsp.ifx_regs[DSP_DSMAH] << 16) | g_dsp.ifx_regs[DSP_DSMAL];
   u16 ctl = g_dsp.ifx_regs[DSP_DSCR];
   u16 dsp_addr = g_dsp.ifx_regs[DSP_DSPA] * 2;
@@ -63,8 +63,8 @@ private:
   };
   DSPState m_dsp_state;
 
-  UCodeInterface* m_ucode;
-  UCodeInterface* m_last_ucode;
+  UCodeInterface* m_ucode = nullptr;
+  UCodeInterface* m_last_ucode = nullptr;
 
   DSP::UDSPControl m_dsp_control;
   CMailHandler m_mail_handler;
@@ -2,7 +2,10 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cinttypes>
+#include <cstring>
 #include <map>
 #include <mutex>
 #include <thread>
@@ -61,6 +64,13 @@ static void StopDVDThread();
 
 static void DVDThread();
 
+static void ResetReadAhead();
+static void UpdateReadAheadStream(const DiscIO::IVolume& volume, u64 offset, u32 length,
+                                  bool decrypt);
+static bool ReadWithReadAhead(const DiscIO::IVolume& volume, u64 offset, u32 length, u8* out_ptr,
+                              bool decrypt);
+static bool ReadAhead(const DiscIO::IVolume& volume);
+
 static void StartReadInternal(bool copy_to_ram, u32 output_address, u64 dvd_offset, u32 length,
                               bool decrypt, DVDInterface::ReplyType reply_type,
                               s64 ticks_until_completion);
@@ -79,6 +89,47 @@ static Common::FifoQueue<ReadRequest, false> s_request_queue;
 static Common::FifoQueue<ReadResult, false> s_result_queue;
 static std::map<u64, ReadResult> s_result_map;
 
+// Games stream things like movies, music and level data with long runs of back-to-back reads.
+// Once such a run is seen, the DVD thread spends the time it would otherwise wait for the next
+// request reading further ahead into a small cache, so that following requests don't have to
+// wait for the disc image (which can be slow to decompress). This only affects how soon the host
+// has the data ready; the emulated timing is decided by DVDInterface before a request reaches us.
+//
+// Everything here is only used by the DVD thread and is reset whenever it starts, which is the
+// case after every disc or partition change since those call WaitUntilIdle.
+constexpr u32 READ_AHEAD_BLOCK_SIZE = 0x20000;
+constexpr u64 READ_AHEAD_DISTANCE = 8 * READ_AHEAD_BLOCK_SIZE;
+constexpr size_t READ_AHEAD_CACHE_BLOCKS = 24;
+// How many reads must each start where the previous one ended before we begin reading ahead.
+constexpr u32 READ_AHEAD_MIN_SEQUENTIAL_READS = 2;
+
+struct ReadAheadBlock
+{
+  u64 block_index;
+  bool decrypt;
+  // Set to 0 once a request has read up to the end of the block, since a sequential reader
+  // won't be coming back for it.
+  u64 last_use;
+  std::vector<u8> data;
+};
+
+// Access patterns are tracked separately for partition data (decrypted reads) and for raw reads,
+// as games interleave both.
+struct ReadAheadStream
+{
+  u64 next_offset = 0;
+  u32 sequential_reads = 0;
+  // Set when reading ahead failed (usually at the end of the disc) and cleared on the next seek.
+  bool failed = false;
+  // Set when the disc image can prefetch by itself (e.g. into the OS page cache), in which case
+  // it doesn't need our cache.
+  bool prefetched = false;
+};
+
+static std::vector<ReadAheadBlock> s_read_ahead_cache;
+static std::array<ReadAheadStream, 2> s_read_ahead_streams;
+static u64 s_read_ahead_tick;
+
 void Start()
 {
   s_finish_read = CoreTiming::RegisterEvent("FinishReadDVDThread", FinishRead);
@@ -87,6 +138,7 @@ void Start()
   s_result_queue_expanded.Reset();
   s_request_queue.Clear();
   s_result_queue.Clear();
+  s_result_map.clear();
 
   // This is reset on every launch for determinism, but it doesn't matter
   // much, because this will never get exposed to the emulated game.
@@ -123,18 +175,9 @@ static void StopDVDThread()
 void DoState(PointerWrap& p)
 {
   // By waiting for the DVD thread to be done working, we ensure that
-  // there are no pending requests. The DVD thread won't be touching
-  // s_result_queue, and everything we need to save will be in either
-  // s_result_queue or s_result_map (other than s_next_id).
+  // there are no pending requests.
   WaitUntilIdle();
 
-  // Move everything from s_result_queue to s_result_map because
-  // PointerWrap::Do supports std::map but not Common::FifoQueue.
-  // This won't affect the behavior of FinishRead.
-  ReadResult result;
-  while (s_result_queue.Pop(result))
-    s_result_map.emplace(result.first.id, std::move(result));
-
   // Everything is now in s_result_map, so we simply savestate that.
   // We also savestate s_next_id to avoid ID collisions.
   p.Do(s_result_map);
@@ -159,6 +202,14 @@ void WaitUntilIdle()
     s_result_queue_expanded.Wait();
 
   StopDVDThread();
+
+  // Move everything from s_result_queue to s_result_map because
+  // PointerWrap::Do supports std::map but not Common::FifoQueue.
+  // This won't affect the behavior of FinishRead.
+  ReadResult result;
+  while (s_result_queue.Pop(result))
+    s_result_map.emplace(result.first.id, std::move(result));
+
   StartDVDThread();
 }
 
@@ -267,6 +318,8 @@ static void DVDThread()
 {
   Common::SetCurrentThreadName("DVD thread");
 
+  ResetReadAhead();
+
   while (true)
   {
     s_request_queue_expanded.Wait();
@@ -277,10 +330,15 @@ static void DVDThread()
     ReadRequest request;
     while (s_request_queue.Pop(request))
     {
-      std::vector<u8> buffer(request.length);
       const DiscIO::IVolume& volume = DVDInterface::GetVolume();
-      if (!volume.Read(request.dvd_offset, request.length, buffer.data(), request.decrypt))
+      UpdateReadAheadStream(volume, request.dvd_offset, request.length, request.decrypt);
+
+      std::vector<u8> buffer(request.length);
+      if (!ReadWithReadAhead(volume, request.dvd_offset, request.length, buffer.data(),
+                             request.decrypt))
+      {
         buffer.resize(0);
+      }
 
       request.realtime_done_us = Common::Timer::GetTimeUs();
 
@@ -290,6 +348,124 @@ static void DVDThread()
       if (s_dvd_thread_exiting.IsSet())
         return;
     }
+
+    // Read ahead one block at a time until there is nothing left to do or a request comes in,
+    // so that a new request never has to wait for more than one block.
+    while (s_request_queue.Empty() && !s_dvd_thread_exiting.IsSet() &&
+           ReadAhead(DVDInterface::GetVolume()))
+    {
+    }
   }
 }
+
+static void ResetReadAhead()
+{
+  s_read_ahead_cache.clear();
+  s_read_ahead_cache.reserve(READ_AHEAD_CACHE_BLOCKS);
+  s_read_ahead_streams = {};
+  s_read_ahead_tick = 0;
+}
+
+static ReadAheadBlock* FindReadAheadBlock(u64 block_index, bool decrypt)
+{
+  auto it = std::find_if(s_read_ahead_cache.begin(), s_read_ahead_cache.end(),
+                         [&](const ReadAheadBlock& block) {
+                           return block.block_index == block_index && block.decrypt == decrypt;
+                         });
+  return it != s_read_ahead_cache.end() ? &*it : nullptr;
+}
+
+static void UpdateReadAheadStream(const DiscIO::IVolume& volume, u64 offset, u32 length,
+                                  bool decrypt)
+{
+  ReadAheadStream& stream = s_read_ahead_streams[decrypt];
+  if (offset == stream.next_offset)
+  {
+    ++stream.sequential_reads;
+  }
+  else
+  {
+    stream.sequential_reads = 0;
+    stream.failed = false;
+  }
+  stream.next_offset = offset + length;
+
+  stream.prefetched = stream.sequential_reads >= READ_AHEAD_MIN_SEQUENTIAL_READS &&
+                      volume.Prefetch(stream.next_offset, READ_AHEAD_DISTANCE, decrypt);
+}
+
+static bool ReadWithReadAhead(const DiscIO::IVolume& volume, u64 offset, u32 length, u8* out_ptr,
+                              bool decrypt)
+{
+  // Read ahead always starts where the last request ended, so anything we have cached is at
+  // the start of the request. Whatever isn't cached is read from the disc as usual.
+  while (length > 0)
+  {
+    ReadAheadBlock* block = FindReadAheadBlock(offset / READ_AHEAD_BLOCK_SIZE, decrypt);
+    if (!block)
+      break;
+
+    const u32 offset_in_block = static_cast<u32>(offset % READ_AHEAD_BLOCK_SIZE);
+    const u32 copy_size = std::min(length, READ_AHEAD_BLOCK_SIZE - offset_in_block);
+    std::memcpy(out_ptr, &block->data[offset_in_block], copy_size);
+    const bool consumed = offset_in_block + copy_size == READ_AHEAD_BLOCK_SIZE;
+    block->last_use = consumed ? 0 : ++s_read_ahead_tick;
+
+    offset += copy_size;
+    out_ptr += copy_size;
+    length -= copy_size;
+  }
+
+  return length == 0 || volume.Read(offset, length, out_ptr, decrypt);
+}
+
+static bool ReadAhead(const DiscIO::IVolume& volume)
+{
+  for (size_t i = 0; i < s_read_ahead_streams.size(); ++i)
+  {
+    ReadAheadStream& stream = s_read_ahead_streams[i];
+    const bool decrypt = i != 0;
+    if (stream.failed || stream.prefetched ||
+        stream.sequential_reads < READ_AHEAD_MIN_SEQUENTIAL_READS)
+      continue;
+
+    const u64 first_block = stream.next_offset / READ_AHEAD_BLOCK_SIZE;
+    const u64 last_block = (stream.next_offset + READ_AHEAD_DISTANCE - 1) / READ_AHEAD_BLOCK_SIZE;
+    for (u64 block_index = first_block; block_index <= last_block; ++block_index)
+    {
+      if (FindReadAheadBlock(block_index, decrypt))
+        continue;
+
+      ReadAheadBlock* block;
+      if (s_read_ahead_cache.size() < READ_AHEAD_CACHE_BLOCKS)
+      {
+        s_read_ahead_cache.emplace_back();
+        block = &s_read_ahead_cache.back();
+        block->data.resize(READ_AHEAD_BLOCK_SIZE);
+      }
+      else
+      {
+        block = &*std::min_element(s_read_ahead_cache.begin(), s_read_ahead_cache.end(),
+                                   [](const ReadAheadBlock& a, const ReadAheadBlock& b) {
+                                     return a.last_use < b.last_use;
+                                   });
+      }
+
+      block->block_index = block_index;
+      block->decrypt = decrypt;
+      block->last_use = ++s_read_ahead_tick;
+      if (!volume.Read(block_index * READ_AHEAD_BLOCK_SIZE, READ_AHEAD_BLOCK_SIZE,
+                       block->data.data(), decrypt))
+      {
+        // Don't leave a block with bad data behind, and stop reading ahead until the game seeks.
+        block->last_use = 0;
+        block->block_index = UINT64_MAX;
+        stream.failed = true;
+      }
+      return true;
+    }
+  }
+
+  return false;
+}
 }
@@ -8,8 +8,13 @@
 // may be redirected here (for example to Read_U32()).
 
 #include <cstring>
+#include <map>
 #include <memory>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 #include "Common/ChunkFile.h"
 #include "Common/CommonFuncs.h"
 #include "Common/CommonTypes.h"
@@ -162,6 +167,12 @@ static PhysicalMemoryRegion physical_regions[] = {
 
 static std::vector<LogicalMemoryView> logical_mapped_entries;
 
+// Pages of the logical view that are mapped according to the page table rather than the BATs,
+// from logical to physical address.
+static constexpr u32 PAGE_TABLE_PAGE_SIZE = 0x1000;
+static std::map<u32, u32> page_table_mapped_entries;
+static bool page_table_mappings_supported = false;
+
 void Init()
 {
   bool wii = SConfig::GetInstance().bWii;
@@ -207,6 +218,10 @@ void Init()
 
 #ifndef _ARCH_32
   logical_base = physical_base + 0x200000000;
+#ifndef _WIN32
+  // Windows can only map views at 64 KiB boundaries.
+  page_table_mappings_supported = sysconf(_SC_PAGESIZE) == PAGE_TABLE_PAGE_SIZE;
+#endif
 #endif
 
   if (wii)
@@ -222,6 +237,20 @@ void Init()
 
 void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table)
 {
+  // The BATs take priority over the page table, and their views must not overlap pages
+  for (auto it = page_table_mapped_entries.begin(); it != page_table_mapped_entries.end();)
+  {
+    if (dbat_table[it->first >> PowerPC::BAT_INDEX_SHIFT] & 1)
+    {
+      g_arena.ReleaseView(logical_base + it->first, PAGE_TABLE_PAGE_SIZE);
+      it = page_table_mapped_entries.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
   for (auto& entry : logical_mapped_entries)
   {
     g_arena.ReleaseView(entry.mapped_pointer, entry.mapped_size);
@@ -261,6 +290,69 @@ void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table)
   }
 }
 
+void AddPageTableMapping(u32 logical_address, u32 translated_address)
+{
+  if (!page_table_mappings_supported)
+    return;
+
+  logical_address &= ~(PAGE_TABLE_PAGE_SIZE - 1);
+  translated_address &= ~(PAGE_TABLE_PAGE_SIZE - 1);
+  const auto it = page_table_mapped_entries.find(logical_address);
+  if (it != page_table_mapped_entries.end())
+  {
+    if (it->second == translated_address)
+      return;
+    RemovePageTableMapping(logical_address);
+  }
+
+  for (const auto& physical_region : physical_regions)
+  {
+    if (!*physical_region.out_pointer || translated_address < physical_region.physical_address ||
+        translated_address - physical_region.physical_address >= physical_region.size)
+    {
+      continue;
+    }
+
+    u32 position = physical_region.shm_position + translated_address -
+                   physical_region.physical_address;
+    if (g_arena.CreateView(position, PAGE_TABLE_PAGE_SIZE, logical_base + logical_address))
+      page_table_mapped_entries.emplace(logical_address, translated_address);
+    return;
+  }
+}
+
+void RemovePageTableMapping(u32 logical_address)
+{
+  logical_address &= ~(PAGE_TABLE_PAGE_SIZE - 1);
+  const auto it = page_table_mapped_entries.find(logical_address);
+  if (it == page_table_mapped_entries.end())
+    return;
+
+  g_arena.ReleaseView(logical_base + logical_address, PAGE_TABLE_PAGE_SIZE);
+  page_table_mapped_entries.erase(it);
+}
+
+void RemovePageTableMappings(u32 first_address, u32 last_address)
+{
+  const auto begin = page_table_mapped_entries.lower_bound(first_address);
+  const auto end = page_table_mapped_entries.upper_bound(last_address);
+  for (auto it = begin; it != end; ++it)
+    g_arena.ReleaseView(logical_base + it->first, PAGE_TABLE_PAGE_SIZE);
+  page_table_mapped_entries.erase(begin, end);
+}
+
+bool IsPageTableMapped(u32 logical_address)
+{
+  return page_table_mapped_entries.count(logical_address & ~(PAGE_TABLE_PAGE_SIZE - 1)) != 0;
+}
+
+void ClearPageTableMappings()
+{
+  for (const auto& entry : page_table_mapped_entries)
+    g_arena.ReleaseView(logical_base + entry.first, PAGE_TABLE_PAGE_SIZE);
+  page_table_mapped_entries.clear();
+}
+
 void DoState(PointerWrap& p)
 {
   bool wii = SConfig::GetInstance().bWii;
@@ -287,12 +379,15 @@ void Shutdown()
   {
     if ((flags & region.flags) != region.flags)
       continue;
-    g_arena.ReleaseView(*region.out_pointer, region.size);
+    g_arena.FreeView(*region.out_pointer, region.size);
     *region.out_pointer = 0;
   }
+  for (const auto& entry : page_table_mapped_entries)
+    g_arena.FreeView(logical_base + entry.first, PAGE_TABLE_PAGE_SIZE);
+  page_table_mapped_entries.clear();
   for (auto& entry : logical_mapped_entries)
   {
-    g_arena.ReleaseView(entry.mapped_pointer, entry.mapped_size);
+    g_arena.FreeView(entry.mapped_pointer, entry.mapped_size);
   }
   logical_mapped_entries.clear();
   g_arena.ReleaseSHMSegment();
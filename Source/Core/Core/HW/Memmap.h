@@ -65,6 +65,17 @@ void DoState(PointerWrap& p);
 
 void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table);
 
+// The logical view can also mirror single pages that the page table maps, so that accesses to
+// them don't have to go through the MMU code. Adding a page that isn't backed by memory does
+// nothing, as does adding pages on hosts which can't map memory with 4 KiB granularity.
+// UpdateLogicalMemory removes the ones that the BATs cover.
+void AddPageTableMapping(u32 logical_address, u32 translated_address);
+void RemovePageTableMapping(u32 logical_address);
+// Removes every page from first_address up to and including last_address
+void RemovePageTableMappings(u32 first_address, u32 last_address);
+bool IsPageTableMapped(u32 logical_address);
+void ClearPageTableMappings();
+
 void Clear();
 
 // Routines to access physically addressed memory, designed for use by
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "Core/PowerPC/CachedInterpreter/CachedInterpreter.h"
+#include "Common/CommonFuncs.h"
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "Core/ConfigManager.h"
@@ -20,6 +21,9 @@ void CachedInterpreter::Init()
 
   jo.enableBlocklink = false;
 
+  // Unconditional branches, calls and returns are followed into superblocks
+  analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW);
+
   m_block_cache.Init();
   UpdateMemoryOptions();
 
@@ -57,6 +61,10 @@ void CachedInterpreter::ExecuteOneBlock()
         return;
       break;
 
+    case Instruction::INSTRUCTION_TYPE_PREDECODED:
+      code->predecoded_callback(code->operands);
+      break;
+
     default:
       ERROR_LOG(POWERPC, "Unknown CachedInterpreter Instruction: %d", code->type);
       break;
@@ -103,6 +111,17 @@ static void WriteBrokenBlockNPC(UGeckoInstruction data)
   NPC = data.hex;
 }
 
+static void WriteLR(UGeckoInstruction data)
+{
+  LR = data.hex;
+}
+
+static void CheckIdle(UGeckoInstruction data)
+{
+  if (NPC == data.hex)
+    CoreTiming::Idle();
+}
+
 static bool CheckFPU(u32 data)
 {
   UReg_MSR& msr = (UReg_MSR&)MSR;
@@ -127,6 +146,159 @@ static bool CheckDSI(u32 data)
   return false;
 }
 
+// The most common integer instructions, with their operands already decoded. Where the
+// interpreter would check a field at runtime (rA == 0, the rotation mask...), the check is made
+// when the block is built instead.
+
+static void LoadImmediate(const CachedInterpreter::Operands& o)
+{
+  rGPR[o.d] = o.imm;
+}
+
+static void AddImmediate(const CachedInterpreter::Operands& o)
+{
+  rGPR[o.d] = rGPR[o.a] + o.imm;
+}
+
+static void OrImmediate(const CachedInterpreter::Operands& o)
+{
+  rGPR[o.d] = rGPR[o.a] | o.imm;
+}
+
+static void MoveRegister(const CachedInterpreter::Operands& o)
+{
+  rGPR[o.d] = rGPR[o.a];
+}
+
+static void RotateAndMask(const CachedInterpreter::Operands& o)
+{
+  rGPR[o.d] = _rotl(rGPR[o.a], o.b) & o.imm;
+}
+
+static void CompareImmediate(const CachedInterpreter::Operands& o)
+{
+  // The same as Interpreter::Helper_UpdateCRx
+  u64 cr_val = (u64)(s64)(s32)(rGPR[o.a] - o.imm);
+  cr_val = (cr_val & ~(1ull << 61)) | ((u64)GetXER_SO() << 61);
+  PowerPC::ppcState.cr_val[o.d] = cr_val;
+}
+
+static void CompareLogicalImmediate(const CachedInterpreter::Operands& o)
+{
+  const u32 a = rGPR[o.a];
+  int f = a < o.imm ? 0x8 : a > o.imm ? 0x4 : 0x2;
+  if (GetXER_SO())
+    f |= 0x1;
+  SetCRField(o.d, f);
+}
+
+static void LoadWord(const CachedInterpreter::Operands& o)
+{
+  const u32 temp = PowerPC::Read_U32(rGPR[o.a] + o.imm);
+  if (!(PowerPC::ppcState.Exceptions & EXCEPTION_DSI))
+    rGPR[o.d] = temp;
+}
+
+static void StoreWord(const CachedInterpreter::Operands& o)
+{
+  PowerPC::Write_U32(rGPR[o.d], rGPR[o.a] + o.imm);
+}
+
+// Register fields are at most 5 bits wide, so they fit the u8 fields.
+static CachedInterpreter::Operands MakeOperands(u32 d, u32 a, u32 b, u32 imm)
+{
+  return {static_cast<u8>(d), static_cast<u8>(a), static_cast<u8>(b), imm};
+}
+
+u32 CachedInterpreter::EmitPredecoded(const PPCAnalyst::CodeOp& op, const PPCAnalyst::CodeOp* next)
+{
+  const UGeckoInstruction inst = op.inst;
+  switch (inst.OPCD)
+  {
+  case 10:  // cmpli
+    m_code.emplace_back(CompareLogicalImmediate, MakeOperands(inst.CRFD, inst.RA, 0, inst.UIMM));
+    return 1;
+
+  case 11:  // cmpi
+    m_code.emplace_back(CompareImmediate, MakeOperands(inst.CRFD, inst.RA, 0, (u32)inst.SIMM_16));
+    return 1;
+
+  case 14:  // addi
+    if (inst.RA)
+      m_code.emplace_back(AddImmediate, MakeOperands(inst.RD, inst.RA, 0, (u32)inst.SIMM_16));
+    else
+      m_code.emplace_back(LoadImmediate, MakeOperands(inst.RD, 0, 0, (u32)inst.SIMM_16));
+    return 1;
+
+  case 15:  // addis
+  {
+    const u32 imm = (u32)inst.SIMM_16 << 16;
+    if (inst.RA)
+    {
+      m_code.emplace_back(AddImmediate, MakeOperands(inst.RD, inst.RA, 0, imm));
+      return 1;
+    }
+
+    // lis followed by an addi or ori that completes the constant
+    if (next)
+    {
+      const UGeckoInstruction low = next->inst;
+      // addi with rA = 0 is li, which doesn't add to the upper half
+      if (low.OPCD == 14 && inst.RD != 0 && low.RD == inst.RD && low.RA == inst.RD)
+      {
+        m_code.emplace_back(LoadImmediate, MakeOperands(inst.RD, 0, 0, imm + (u32)low.SIMM_16));
+        return 2;
+      }
+      if (low.OPCD == 24 && low.RA == inst.RD && low.RS == inst.RD)
+      {
+        m_code.emplace_back(LoadImmediate, MakeOperands(inst.RD, 0, 0, imm | low.UIMM));
+        return 2;
+      }
+    }
+    m_code.emplace_back(LoadImmediate, MakeOperands(inst.RD, 0, 0, imm));
+    return 1;
+  }
+
+  case 21:  // rlwinmx
+    if (inst.Rc)
+      return 0;
+    m_code.emplace_back(RotateAndMask,
+                        MakeOperands(inst.RA, inst.RS, inst.SH, Helper_Mask(inst.MB, inst.ME)));
+    return 1;
+
+  case 24:  // ori
+    // nop doesn't need anything
+    if (inst.RA || inst.RS || inst.UIMM)
+      m_code.emplace_back(OrImmediate, MakeOperands(inst.RA, inst.RS, 0, inst.UIMM));
+    return 1;
+
+  case 25:  // oris
+    m_code.emplace_back(OrImmediate, MakeOperands(inst.RA, inst.RS, 0, (u32)inst.UIMM << 16));
+    return 1;
+
+  case 31:
+    // mr
+    if (inst.SUBOP10 != 444 || inst.RS != inst.RB || inst.Rc)
+      return 0;
+    m_code.emplace_back(MoveRegister, MakeOperands(inst.RA, inst.RS, 0, 0));
+    return 1;
+
+  case 32:  // lwz
+    if (!inst.RA)
+      return 0;
+    m_code.emplace_back(LoadWord, MakeOperands(inst.RD, inst.RA, 0, (u32)inst.SIMM_16));
+    return 1;
+
+  case 36:  // stw
+    if (!inst.RA)
+      return 0;
+    m_code.emplace_back(StoreWord, MakeOperands(inst.RS, inst.RA, 0, (u32)inst.SIMM_16));
+    return 1;
+  }
+
+  return 0;
+}
+
 void CachedInterpreter::Jit(u32 address)
 {
   if (m_code.size() >= CODE_SIZE / sizeof(Instruction) - 0x1000 ||
@@ -191,6 +363,15 @@ void CachedInterpreter::Jit(u32 address)
       bool endblock = (ops[i].opinfo->flags & FL_ENDBLOCK) != 0;
       bool memcheck = (ops[i].opinfo->flags & FL_LOADSTORE) && jo.memcheck;
 
+      // A branch that the analyzer followed only has to leave the return address behind. When
+      // the block ends because it got too long, the last instruction is one of those too.
+      if (endblock && (i + 1 < code_block.m_num_instructions || code_block.m_broken))
+      {
+        if (ops[i].inst.LK)
+          m_code.emplace_back(WriteLR, ops[i].address + 4);
+        continue;
+      }
+
       if (check_fpu)
       {
         m_code.emplace_back(WritePC, ops[i].address);
@@ -200,9 +381,19 @@ void CachedInterpreter::Jit(u32 address)
 
       if (endblock || memcheck)
         m_code.emplace_back(WritePC, ops[i].address);
-      m_code.emplace_back(GetInterpreterOp(ops[i].inst), ops[i].inst);
+
+      // Only instructions that nothing can interrupt in between are fused
+      const bool can_fuse = i + 1 < code_block.m_num_instructions && !ops[i + 1].skip &&
+                            !HLE::GetFunctionIndex(ops[i + 1].address);
+      const u32 predecoded = EmitPredecoded(ops[i], can_fuse ? &ops[i + 1] : nullptr);
+      if (predecoded == 0)
+        m_code.emplace_back(GetInterpreterOp(ops[i].inst), ops[i].inst);
+      if (predecoded == 2)
+        js.downcountAmount += ops[++i].opinfo->numCycles;
       if (memcheck)
         m_code.emplace_back(CheckDSI, js.downcountAmount);
+      if (ops[i].branchIsIdleLoop)
+        m_code.emplace_back(CheckIdle, js.blockStart);
       if (endblock)
         m_code.emplace_back(EndBlock, js.downcountAmount);
     }
@@ -30,34 +30,56 @@ public:
   JitBaseBlockCache* GetBlockCache() override { return &m_block_cache; }
   const char* GetName() override { return "Cached Interpreter"; }
   const CommonAsmRoutinesBase* GetAsmRoutines() override { return nullptr; }
+
+  // The fields of an instruction, decoded when the block is built instead of every time it runs
+  struct Operands
+  {
+    u8 d;
+    u8 a;
+    u8 b;
+    u32 imm;
+  };
+
 private:
   struct Instruction
   {
     typedef void (*CommonCallback)(UGeckoInstruction);
     typedef bool (*ConditionalCallback)(u32 data);
+    typedef void (*PredecodedCallback)(const Operands& operands);
 
     Instruction() : type(INSTRUCTION_ABORT){};
     Instruction(const CommonCallback c, UGeckoInstruction i)
         : common_callback(c), data(i.hex), type(INSTRUCTION_TYPE_COMMON){};
     Instruction(const ConditionalCallback c, u32 d)
         : conditional_callback(c), data(d), type(INSTRUCTION_TYPE_CONDITIONAL){};
+    Instruction(const PredecodedCallback c, Operands o)
+        : predecoded_callback(c), operands(o), type(INSTRUCTION_TYPE_PREDECODED){};
 
     union
     {
       const CommonCallback common_callback;
       const ConditionalCallback conditional_callback;
+      const PredecodedCallback predecoded_callback;
+    };
+    union
+    {
+      u32 data;
+      Operands operands;
     };
-    u32 data;
     enum
     {
       INSTRUCTION_ABORT,
       INSTRUCTION_TYPE_COMMON,
       INSTRUCTION_TYPE_CONDITIONAL,
+      INSTRUCTION_TYPE_PREDECODED,
     } type;
   };
 
   const u8* GetCodePtr() { return (u8*)(m_code.data() + m_code.size()); }
   void ExecuteOneBlock();
+  // Emits a predecoded version of op, or of op and next together. Returns how many instructions
+  // were handled, which is 0 if the caller has to emit op as usual. next may be null.
+  u32 EmitPredecoded(const PPCAnalyst::CodeOp& op, const PPCAnalyst::CodeOp* next);
 
   BlockCache m_block_cache{*this};
   std::vector<Instruction> m_code;
@@ -4,6 +4,7 @@
 
 #include "Core/PowerPC/Jit64/FPURegCache.h"
 
+#include "Common/x64ABI.h"
 #include "Core/PowerPC/Jit64/Jit.h"
 #include "Core/PowerPC/Jit64Common/Jit64Base.h"
 #include "Core/PowerPC/Jit64Common/Jit64PowerPCState.h"
@@ -39,20 +40,23 @@ OpArg FPURegCache::GetDefaultLocation(size_t reg) const
 
 BitSet32 FPURegCache::GetRegUtilization()
 {
-  return m_jit.js.op->gprInReg;
+  return m_jit.js.op->fprInXmm;
 }
 
-BitSet32 FPURegCache::CountRegsIn(size_t preg, u32 lookahead)
+BitSet32 FPURegCache::GetRegsIn(const PPCAnalyst::CodeOp& op) const
 {
-  BitSet32 regs_used;
+  return op.fregsIn;
+}
 
-  for (u32 i = 1; i < lookahead; i++)
-  {
-    BitSet32 regs_in = m_jit.js.op[i].fregsIn;
-    regs_used |= regs_in;
-    if (regs_in[preg])
-      return regs_used;
-  }
+BitSet32 FPURegCache::GetRegsOut(const PPCAnalyst::CodeOp& op) const
+{
+  BitSet32 regs_out;
+  if (op.fregOut >= 0)
+    regs_out[op.fregOut] = true;
+  return regs_out;
+}
 
-  return regs_used;
+bool FPURegCache::IsCalleeSaved(X64Reg xreg) const
+{
+  return !ABI_ALL_CALLER_SAVED[16 + xreg];
 }
@@ -4,6 +4,7 @@
 
 #include "Core/PowerPC/Jit64/GPRRegCache.h"
 
+#include "Common/x64ABI.h"
 #include "Core/PowerPC/Jit64/Jit.h"
 #include "Core/PowerPC/Jit64Common/Jit64Base.h"
 #include "Core/PowerPC/Jit64Common/Jit64PowerPCState.h"
@@ -60,17 +61,17 @@ BitSet32 GPRRegCache::GetRegUtilization()
   return m_jit.js.op->gprInReg;
 }
 
-BitSet32 GPRRegCache::CountRegsIn(size_t preg, u32 lookahead)
+BitSet32 GPRRegCache::GetRegsIn(const PPCAnalyst::CodeOp& op) const
 {
-  BitSet32 regs_used;
+  return op.regsIn;
+}
 
-  for (u32 i = 1; i < lookahead; i++)
-  {
-    BitSet32 regs_in = m_jit.js.op[i].regsIn;
-    regs_used |= regs_in;
-    if (regs_in[preg])
-      return regs_used;
-  }
+BitSet32 GPRRegCache::GetRegsOut(const PPCAnalyst::CodeOp& op) const
+{
+  return op.regsOut;
+}
 
-  return regs_used;
+bool GPRRegCache::IsCalleeSaved(X64Reg xreg) const
+{
+  return !ABI_ALL_CALLER_SAVED[xreg];
 }
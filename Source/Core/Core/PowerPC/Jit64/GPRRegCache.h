@@ -19,5 +19,7 @@ public:
   const Gen::X64Reg* GetAllocationOrder(size_t* count) override;
   void SetImmediate32(size_t preg, u32 imm_value, bool dirty = true);
   BitSet32 GetRegUtilization() override;
-  BitSet32 CountRegsIn(size_t preg, u32 lookahead) override;
+  BitSet32 GetRegsIn(const PPCAnalyst::CodeOp& op) const override;
+  BitSet32 GetRegsOut(const PPCAnalyst::CodeOp& op) const override;
+  bool IsCalleeSaved(Gen::X64Reg xreg) const override;
 };
@@ -2,8 +2,12 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
 #include <map>
 #include <string>
+#include <vector>
 
 // for the PROFILER stuff
 #ifdef _WIN32
@@ -13,6 +17,7 @@
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "Common/MemoryUtil.h"
+#include "Common/MsgHandler.h"
 #include "Common/StringUtil.h"
 #include "Common/x64ABI.h"
 #include "Core/Core.h"
@@ -240,6 +245,7 @@ void Jit64::Init()
   if (m_enable_blr_optimization)
     AllocStack();
 
+  blocks.EnablePageVersioning();
   blocks.Init();
   asm_routines.Init(m_stack ? (m_stack + STACK_SIZE) : nullptr);
 
@@ -248,6 +254,7 @@ void Jit64::Init()
   // it'll crash because the farcode functions get cleared on JIT clears.
   m_far_code.Init(jo.memcheck ? FARCODE_SIZE_MMU : FARCODE_SIZE);
   Clear();
+  InitGenerations();
 
   code_block.m_stats = &js.st;
   code_block.m_gpa = &js.gpa;
@@ -263,6 +270,196 @@ void Jit64::ClearCache()
   ClearCodeSpace();
   Clear();
   UpdateMemoryOptions();
+  ResetGenerations();
+}
+
+void Jit64::InitGenerations()
+{
+  // Nothing has been emitted yet, so all code pointers are still at the start of their space.
+  u8* near_code = GetWritableCodePtr();
+  u8* far_code = m_far_code.GetWritableCodePtr();
+  u8* trampoline_code = trampolines.GetWritableCodePtr();
+  m_near_generation_size = CODE_SIZE / NUM_CODE_GENERATIONS;
+  m_far_generation_size = (jo.memcheck ? FARCODE_SIZE_MMU : FARCODE_SIZE) / NUM_CODE_GENERATIONS;
+  m_trampoline_generation_size =
+      ((jo.memcheck ? TRAMPOLINE_CODE_SIZE_MMU : TRAMPOLINE_CODE_SIZE) - TRAMPOLINE_OVERFLOW_SIZE) /
+      NUM_CODE_GENERATIONS;
+  m_trampoline_overflow = trampoline_code + NUM_CODE_GENERATIONS * m_trampoline_generation_size;
+
+  for (size_t i = 0; i < NUM_CODE_GENERATIONS; i++)
+  {
+    m_generations[i].near_code = near_code + i * m_near_generation_size;
+    m_generations[i].far_code = far_code + i * m_far_generation_size;
+    m_generations[i].trampolines = trampoline_code + i * m_trampoline_generation_size;
+  }
+
+  m_num_evictions = 0;
+  m_num_evicted_blocks = 0;
+  m_num_recompiled_blocks = 0;
+  m_num_recompiled_instructions = 0;
+  ResetGenerations();
+}
+
+void Jit64::ResetGenerations()
+{
+  for (CodeGeneration& gen : m_generations)
+  {
+    gen.trampolines_ptr = gen.trampolines;
+    gen.timing_samples = 0;
+    gen.serial = 0;
+  }
+  m_trampoline_overflow_ptr = m_trampoline_overflow;
+  m_evicted_addresses.clear();
+
+  m_generation_serial = 0;
+  m_current_generation = 0;
+  m_generations[0].serial = ++m_generation_serial;
+  SetCodePtr(m_generations[0].near_code);
+  m_far_code.SetCodePtr(m_generations[0].far_code);
+}
+
+size_t Jit64::GetGenerationIndex(const u8* near_code) const
+{
+  return static_cast<size_t>(near_code - m_generations[0].near_code) / m_near_generation_size;
+}
+
+bool Jit64::IsGenerationAlmostFull(size_t index) const
+{
+  // This should be bigger than the biggest block ever, as in CodeBlock::IsAlmostFull(). It also
+  // covers the trampolines that can be generated for a generation between two calls to Jit().
+  constexpr ptrdiff_t MIN_SPACE_LEFT = 0x10000;
+
+  const CodeGeneration& gen = m_generations[index];
+  if (gen.trampolines + m_trampoline_generation_size - gen.trampolines_ptr < MIN_SPACE_LEFT)
+    return true;
+
+  // Only the current generation gets new blocks.
+  if (index != m_current_generation)
+    return false;
+
+  return gen.near_code + m_near_generation_size - GetCodePtr() < MIN_SPACE_LEFT ||
+         gen.far_code + m_far_generation_size - m_far_code.GetCodePtr() < MIN_SPACE_LEFT;
+}
+
+size_t Jit64::PickGenerationToEvict()
+{
+  std::array<u64, NUM_CODE_GENERATIONS> samples{};
+  blocks.RunOnBlocks([&](const JitBlock& block) {
+    samples[GetGenerationIndex(block.checkedEntry)] += block.timingSamples;
+  });
+
+  size_t victim = m_current_generation;
+  u64 victim_samples = 0;
+  for (size_t i = 0; i < NUM_CODE_GENERATIONS; i++)
+  {
+    // Only count the samples taken since the last comparison, so that code which was hot a long
+    // time ago can still be evicted.
+    CodeGeneration& gen = m_generations[i];
+    const u64 recent_samples = samples[i] - std::min(samples[i], gen.timing_samples);
+    gen.timing_samples = samples[i];
+
+    if (i == m_current_generation)
+      continue;
+
+    // Empty generations have neither samples nor a serial, so they are always picked first.
+    // Otherwise, evict the coldest generation, and the oldest one of those.
+    if (victim == m_current_generation || recent_samples < victim_samples ||
+        (recent_samples == victim_samples && gen.serial < m_generations[victim].serial))
+    {
+      victim = i;
+      victim_samples = recent_samples;
+    }
+  }
+
+  return victim;
+}
+
+void Jit64::EvictGeneration(size_t index)
+{
+  CodeGeneration& gen = m_generations[index];
+  const u8* near_end = gen.near_code + m_near_generation_size;
+  const u8* far_end = gen.far_code + m_far_generation_size;
+  const auto in_generation = [&](const u8* ptr) {
+    return (ptr >= gen.near_code && ptr < near_end) || (ptr >= gen.far_code && ptr < far_end);
+  };
+
+  // Destroying the blocks also relinks the exits of other blocks that jump here to the
+  // dispatcher. None of the evicted code can be running: the dispatcher resets the stack before
+  // calling Jit(), which also drops any return addresses the BLR optimization pushed.
+  const size_t num_blocks = blocks.EraseBlocks([&](const JitBlock& block) {
+    if (!in_generation(block.checkedEntry))
+      return false;
+    m_evicted_addresses.insert(block.effectiveAddress);
+    return true;
+  });
+
+  for (auto it = m_back_patch_info.begin(); it != m_back_patch_info.end();)
+  {
+    if (in_generation(it->first))
+      it = m_back_patch_info.erase(it);
+    else
+      ++it;
+  }
+  for (auto it = m_exception_handler_at_loc.begin(); it != m_exception_handler_at_loc.end();)
+  {
+    if (in_generation(it->first))
+      it = m_exception_handler_at_loc.erase(it);
+    else
+      ++it;
+  }
+
+  // Poison the freed space with breakpoints, like ClearCodeSpace() does.
+  memset(gen.near_code, 0xCC, m_near_generation_size);
+  memset(gen.far_code, 0xCC, m_far_generation_size);
+  memset(gen.trampolines, 0xCC, m_trampoline_generation_size);
+  gen.trampolines_ptr = gen.trampolines;
+  gen.timing_samples = 0;
+  gen.serial = 0;
+
+  m_num_evictions++;
+  m_num_evicted_blocks += num_blocks;
+  INFO_LOG(DYNA_REC, "Evicted JIT code generation %zu with %zu blocks. %" PRIu64
+                     " evictions so far, %" PRIu64 " blocks evicted, %" PRIu64
+                     " of them recompiled (%" PRIu64 " instructions)",
+           index, num_blocks, m_num_evictions, m_num_evicted_blocks, m_num_recompiled_blocks,
+           m_num_recompiled_instructions);
+}
+
+void Jit64::StartNewGeneration()
+{
+  const size_t index = PickGenerationToEvict();
+  CodeGeneration& gen = m_generations[index];
+  if (gen.serial != 0)
+    EvictGeneration(index);
+
+  m_current_generation = index;
+  gen.serial = ++m_generation_serial;
+  SetCodePtr(gen.near_code);
+  m_far_code.SetCodePtr(gen.far_code);
+}
+
+const u8* Jit64::GenerateTrampoline(const TrampolineInfo& info, const u8* location)
+{
+  // Keep the trampoline in the generation of the block it belongs to, so that both are evicted
+  // together.
+  CodeGeneration& gen = m_generations[GetGenerationIndex(location)];
+  u8** code_ptr = &gen.trampolines_ptr;
+  if (gen.trampolines + m_trampoline_generation_size - gen.trampolines_ptr <
+      static_cast<ptrdiff_t>(MAX_TRAMPOLINE_SIZE))
+  {
+    code_ptr = &m_trampoline_overflow_ptr;
+    if (m_trampoline_overflow + TRAMPOLINE_OVERFLOW_SIZE - m_trampoline_overflow_ptr <
+        static_cast<ptrdiff_t>(MAX_TRAMPOLINE_SIZE))
+    {
+      PanicAlert("Trampoline cache full");
+      return nullptr;
+    }
+  }
+
+  trampolines.SetCodePtr(*code_ptr);
+  const u8* trampoline = trampolines.GenerateTrampoline(info);
+  *code_ptr = trampolines.GetWritableCodePtr();
+  return trampoline;
 }
 
 void Jit64::Shutdown()
@@ -278,6 +475,7 @@ void Jit64::Shutdown()
 
 void Jit64::FallBackToInterpreter(UGeckoInstruction inst)
 {
+  js.numFallbackInst++;
   gpr.Flush();
   fpr.Flush();
   if (js.op->opinfo->flags & FL_ENDBLOCK)
@@ -347,6 +545,11 @@ static void ImHere()
   been_here[PC] = 1;
 }
 
+static bool RevalidateBlock(JitBaseBlockCache* block_cache, JitBlock* block)
+{
+  return block_cache->RevalidateBlock(*block);
+}
+
 bool Jit64::Cleanup()
 {
   bool did_something = false;
@@ -557,11 +760,21 @@ void Jit64::Jit(u32 em_address)
 #endif
   }
 
-  if (IsAlmostFull() || m_far_code.IsAlmostFull() || trampolines.IsAlmostFull() ||
-      SConfig::GetInstance().bJITNoBlockCache)
+  if (SConfig::GetInstance().bJITNoBlockCache || m_trampoline_overflow_ptr != m_trampoline_overflow)
   {
     ClearCache();
   }
+  else
+  {
+    // Trampolines are also added to older generations, so any of them can run out of space.
+    for (size_t i = 0; i < NUM_CODE_GENERATIONS; i++)
+    {
+      if (i != m_current_generation && IsGenerationAlmostFull(i))
+        EvictGeneration(i);
+    }
+    if (IsGenerationAlmostFull(m_current_generation))
+      StartNewGeneration();
+  }
 
   int blockSize = code_buffer.GetSize();
 
@@ -605,8 +818,15 @@ void Jit64::Jit(u32 em_address)
     return;
   }
 
+  if (m_evicted_addresses.erase(em_address))
+  {
+    m_num_recompiled_blocks++;
+    m_num_recompiled_instructions += code_block.m_num_instructions;
+  }
+
   JitBlock* b = blocks.AllocateBlock(em_address);
   DoJit(em_address, &code_buffer, b, nextPC);
+  blocks.SetBlockCode(*b, code_buffer, code_block.m_num_instructions);
   blocks.FinalizeBlock(*b, jo.enableBlocklink, code_block.m_physical_addresses);
 }
 
@@ -620,6 +840,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
   js.curBlock = b;
   js.numLoadStoreInst = 0;
   js.numFloatingPointInst = 0;
+  js.numFallbackInst = 0;
 
   PPCAnalyst::CodeOp* ops = code_buf->codebuffer;
 
@@ -631,6 +852,10 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
   // Downcount flag check. The last block decremented downcounter, and the flag should still be
   // available.
   FixupBranch skip = J_CC(CC_G);
+  // Counting the blocks at which the downcount runs out samples how hot they are, without
+  // slowing down the normal entry.
+  MOV(64, R(RSCRATCH), ImmPtr(&b->timingSamples));
+  ADD(32, MatR(RSCRATCH), Imm8(1));
   MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
   JMP(asm_routines.doTiming, true);  // downcount hit zero - go doTiming.
   SetJumpTarget(skip);
@@ -646,6 +871,39 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
     ABI_PopRegistersAndAdjustStack({}, 0);
   }
 
+  // Check that the code pages this block was compiled from weren't invalidated since. If they
+  // were but the code is unchanged, the expected versions are rewritten and the block runs again.
+  std::vector<FixupBranch> stale_code;
+  for (u32 address : code_block.m_physical_addresses)
+  {
+    const u32 page = address >> JitBaseBlockCache::PAGE_VERSION_SHIFT;
+    if (!b->pageVersionChecks.empty() && b->pageVersionChecks.back().page == page)
+      continue;
+
+    const u32* version = blocks.GetPageVersion(address);
+    MOV(32, R(RSCRATCH2), Imm32(*version));
+    b->pageVersionChecks.push_back({GetWritableCodePtr() - sizeof(u32), page});
+    MOV(64, R(RSCRATCH), ImmPtr(version));
+    CMP(32, MatR(RSCRATCH), R(RSCRATCH2));
+    stale_code.push_back(J_CC(CC_NE, true));
+  }
+  if (!stale_code.empty())
+  {
+    SwitchToFarCode();
+    for (FixupBranch& branch : stale_code)
+      SetJumpTarget(branch);
+    MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
+    ABI_PushRegistersAndAdjustStack({}, 0);
+    ABI_CallFunctionPP(RevalidateBlock, &blocks, b);
+    ABI_PopRegistersAndAdjustStack({}, 0);
+    TEST(8, R(ABI_RETURN), R(ABI_RETURN));
+    J_CC(CC_NZ, normalEntry);
+    // The code changed and the block was destroyed, so compile it again.
+    asm_routines.ResetStack(*this);
+    JMP(asm_routines.dispatcherNoCheck, true);
+    SwitchToNearCode();
+  }
+
   // Conditionally add profiling code.
   if (Profiler::g_ProfileBlocks)
   {
@@ -663,9 +921,9 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
 #endif
 
   // Start up the register allocators
-  // They use the information in gpa/fpa to preload commonly used registers.
-  gpr.Start();
-  fpr.Start();
+  // They use the register usage found by the analyzer to plan allocation for the whole block.
+  gpr.Start(ops, code_block.m_num_instructions);
+  fpr.Start(ops, code_block.m_num_instructions);
 
   js.downcountAmount = 0;
   if (!SConfig::GetInstance().bEnableDebugging)
@@ -852,6 +1110,17 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
         SetJumpTarget(noBreakpoint);
       }
 
+      // Loads and stores can use immediate addresses when the analyzer knows what their address
+      // registers hold, even if the register cache has lost track of it.
+      if (opinfo->flags & FL_LOADSTORE)
+      {
+        for (int reg : ops[i].regsIn & ops[i].gprIsConstant)
+        {
+          if (!gpr.R(reg).IsImm())
+            gpr.SetImmediate32(reg, code_block.m_gpr_constants[i][reg], gpr.IsBound(reg));
+        }
+      }
+
       // If we have an input register that is going to be used again, load it pre-emptively,
       // even if the instruction doesn't strictly need it in a register, to avoid redundant
       // loads later. Of course, don't do this if we're already out of registers.
@@ -950,6 +1219,13 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
 
   b->codeSize = (u32)(GetCodePtr() - start);
   b->originalSize = code_block.m_num_instructions;
+  b->spillCount = gpr.GetSpillCount() + fpr.GetSpillCount();
+
+  if (js.numFallbackInst)
+  {
+    INFO_LOG(DYNA_REC, "Block %08x: %u of %u instructions fall back to the interpreter",
+             em_address, js.numFallbackInst, code_block.m_num_instructions);
+  }
 
 #ifdef JIT_LOG_X86
   LogGeneratedX86(code_block.m_num_instructions, code_buf, start, b);
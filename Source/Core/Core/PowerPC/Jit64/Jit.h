@@ -18,6 +18,10 @@
 // ----------
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <unordered_set>
+
 #include "Common/CommonTypes.h"
 #include "Common/x64ABI.h"
 #include "Common/x64Emitter.h"
@@ -47,6 +51,53 @@ private:
   bool m_cleanup_after_stackfault;
   u8* m_stack;
 
+  // The near code, far code and trampoline spaces are each split into NUM_CODE_GENERATIONS equal
+  // parts, and a generation owns one part of each. Blocks are only compiled into the current
+  // generation. When it fills up, the generation whose blocks ran least since the last time this
+  // happened is evicted and becomes the current one, instead of the whole cache being cleared.
+  static constexpr size_t NUM_CODE_GENERATIONS = 4;
+  struct CodeGeneration
+  {
+    u8* near_code;
+    u8* far_code;
+    u8* trampolines;
+    // Where the next trampoline for a block of this generation goes.
+    u8* trampolines_ptr;
+    // The timing samples of this generation's blocks when the generations were last compared.
+    u64 timing_samples;
+    // When this generation was last made the current one; 0 if it holds no code.
+    u64 serial;
+  };
+  std::array<CodeGeneration, NUM_CODE_GENERATIONS> m_generations;
+  size_t m_near_generation_size;
+  size_t m_far_generation_size;
+  size_t m_trampoline_generation_size;
+  // Trampolines are generated while their block runs, so a generation that is out of trampoline
+  // space can't be evicted then. They go here instead, and the cache is cleared before the next
+  // block is compiled.
+  static constexpr size_t TRAMPOLINE_OVERFLOW_SIZE = 0x10000;
+  u8* m_trampoline_overflow;
+  u8* m_trampoline_overflow_ptr;
+  size_t m_current_generation;
+  u64 m_generation_serial;
+
+  // Eviction statistics, to judge what evicting instead of clearing costs in recompilation.
+  u64 m_num_evictions;
+  u64 m_num_evicted_blocks;
+  u64 m_num_recompiled_blocks;
+  u64 m_num_recompiled_instructions;
+  std::unordered_set<u32> m_evicted_addresses;
+
+  void InitGenerations();
+  void ResetGenerations();
+  size_t GetGenerationIndex(const u8* near_code) const;
+  bool IsGenerationAlmostFull(size_t index) const;
+  size_t PickGenerationToEvict();
+  void EvictGeneration(size_t index);
+  void StartNewGeneration();
+
+  const u8* GenerateTrampoline(const TrampolineInfo& info, const u8* location) override;
+
 public:
   Jit64() : code_buffer(32000) {}
   ~Jit64() {}
@@ -138,6 +189,7 @@ public:
                         bool preserve_inputs, bool roundRHS = false);
   void FloatCompare(UGeckoInstruction inst, bool upper = false);
   void UpdateMXCSR();
+  void UpdateCR1();
 
   // OPCODES
   using Instruction = void (Jit64::*)(UGeckoInstruction instCode);
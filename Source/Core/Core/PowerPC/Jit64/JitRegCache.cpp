@@ -6,6 +6,7 @@
 #include <cinttypes>
 #include <cmath>
 #include <limits>
+#include <vector>
 
 #include "Common/Assert.h"
 #include "Common/BitSet.h"
@@ -23,7 +24,7 @@ RegCache::RegCache(Jit64& jit) : m_jit{jit}
 {
 }
 
-void RegCache::Start()
+void RegCache::Start(const PPCAnalyst::CodeOp* ops, u32 num_ops)
 {
   for (auto& xreg : m_xregs)
   {
@@ -38,22 +39,115 @@ void RegCache::Start()
     m_regs[i].away = false;
     m_regs[i].locked = false;
   }
+  m_spill_count = 0;
 
-  // todo: sort to find the most popular regs
-  /*
-  int maxPreload = 2;
-  for (int i = 0; i < 32; i++)
+  AssignRegisters(ops, num_ops);
+}
+
+// A linear scan over the live ranges of the guest registers. The assignments are only
+// preferences: BindToRegister uses the assigned host register when it's free, and GetFreeXReg
+// avoids handing out registers that are assigned to a live guest register. Registers that are
+// live across a load or store prefer callee-saved host registers, so that the slow paths and
+// trampolines in far code don't have to save them around their calls.
+void RegCache::AssignRegisters(const PPCAnalyst::CodeOp* ops, u32 num_ops)
+{
+  struct LiveRange
+  {
+    size_t preg;
+    u32 start;
+    u32 end;
+    bool crosses_call;
+  };
+
+  for (auto& uses : m_uses)
+    uses.clear();
+  m_assigned_xregs.fill(INVALID_REG);
+  m_reserved_xregs.assign(num_ops, BitSet32());
+
+  std::array<LiveRange, 32> ranges;
+  BitSet32 used;
+  // calls_before[i] is the number of instructions before i that can call out of the block
+  std::vector<u32> calls_before(num_ops + 1, 0);
+  for (u32 i = 0; i < num_ops; i++)
+  {
+    calls_before[i + 1] = calls_before[i];
+    if (ops[i].skip)
+      continue;
+    if (ops[i].opinfo->flags & FL_LOADSTORE)
+      calls_before[i + 1]++;
+
+    const BitSet32 regs_in = GetRegsIn(ops[i]);
+    for (int preg : regs_in)
+      m_uses[preg].push_back(i);
+    for (int preg : regs_in | GetRegsOut(ops[i]))
+    {
+      if (!used[preg])
+        ranges[preg] = {static_cast<size_t>(preg), i, i, false};
+      ranges[preg].end = i;
+      used[preg] = true;
+    }
+  }
+
+  std::vector<LiveRange*> sorted;
+  for (int preg : used)
+  {
+    LiveRange& range = ranges[preg];
+    range.crosses_call = calls_before[range.end] > calls_before[range.start + 1];
+    sorted.push_back(&range);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const LiveRange* a, const LiveRange* b) { return a->start < b->start; });
+
+  size_t count;
+  const X64Reg* order = GetAllocationOrder(&count);
+  std::vector<LiveRange*> active;
+  for (LiveRange* range : sorted)
   {
-    if (stats.numReads[i] > 2 || stats.numWrites[i] >= 2)
+    active.erase(std::remove_if(active.begin(), active.end(),
+                                [range](const LiveRange* a) { return a->end < range->start; }),
+                 active.end());
+
+    BitSet32 taken;
+    for (const LiveRange* a : active)
+      taken[m_assigned_xregs[a->preg]] = true;
+
+    X64Reg xr = INVALID_REG;
+    for (size_t i = 0; i < count && xr == INVALID_REG; i++)
+    {
+      if (!taken[order[i]] && IsCalleeSaved(order[i]) == range->crosses_call)
+        xr = order[i];
+    }
+    for (size_t i = 0; i < count && xr == INVALID_REG; i++)
     {
-      LoadToX64(i, true, false); //stats.firstRead[i] <= stats.firstWrite[i], false);
-      maxPreload--;
-      if (!maxPreload)
-        break;
+      if (!taken[order[i]])
+        xr = order[i];
     }
-  }*/
-  // Find top regs - preload them (load bursts ain't bad)
-  // But only preload IF written OR reads >= 3
+
+    if (xr == INVALID_REG)
+    {
+      // Out of registers: the range that ends last goes without one.
+      auto last = std::max_element(
+          active.begin(), active.end(),
+          [](const LiveRange* a, const LiveRange* b) { return a->end < b->end; });
+      if (last == active.end() || (*last)->end <= range->end)
+        continue;
+      xr = m_assigned_xregs[(*last)->preg];
+      m_assigned_xregs[(*last)->preg] = INVALID_REG;
+      active.erase(last);
+    }
+
+    m_assigned_xregs[range->preg] = xr;
+    active.push_back(range);
+  }
+
+  for (const LiveRange* range : sorted)
+  {
+    const X64Reg xr = m_assigned_xregs[range->preg];
+    if (xr == INVALID_REG)
+      continue;
+    for (u32 i = range->start; i <= range->end; i++)
+      m_reserved_xregs[i][xr] = true;
+  }
 }
 
 void RegCache::DiscardRegContentsIfCached(size_t preg)
@@ -110,6 +204,7 @@ void RegCache::FlushR(X64Reg reg)
   if (!m_xregs[reg].free)
   {
     StoreFromRegister(m_xregs[reg].ppcReg);
+    m_spill_count++;
   }
 }
 
@@ -171,7 +266,9 @@ void RegCache::BindToRegister(size_t i, bool doLoad, bool makeDirty)
 {
   if (!m_regs[i].away || m_regs[i].location.IsImm())
   {
-    X64Reg xr = GetFreeXReg();
+    X64Reg xr = m_assigned_xregs[i];
+    if (xr == INVALID_REG || !IsFreeX(xr))
+      xr = GetFreeXReg();
     if (m_xregs[xr].dirty)
       PanicAlert("Xreg already dirty");
     if (m_xregs[xr].locked)
@@ -276,6 +373,19 @@ X64Reg RegCache::GetFreeXReg()
 {
   size_t aCount;
   const X64Reg* aOrder = GetAllocationOrder(&aCount);
+
+  // Prefer registers that no live guest register has been assigned
+  const size_t instruction = static_cast<size_t>(m_jit.js.instructionNumber);
+  if (instruction < m_reserved_xregs.size())
+  {
+    for (size_t i = 0; i < aCount; i++)
+    {
+      X64Reg xr = aOrder[i];
+      if (!m_xregs[xr].locked && m_xregs[xr].free && !m_reserved_xregs[instruction][xr])
+        return xr;
+    }
+  }
+
   for (size_t i = 0; i < aCount; i++)
   {
     X64Reg xr = aOrder[i];
@@ -308,6 +418,7 @@ X64Reg RegCache::GetFreeXReg()
   if (best_xreg != INVALID_REG)
   {
     StoreFromRegister(best_preg);
+    m_spill_count++;
     return best_xreg;
   }
 
@@ -327,6 +438,16 @@ int RegCache::NumFreeRegisters()
   return count;
 }
 
+u32 RegCache::NextUse(size_t preg) const
+{
+  const u32 instruction = static_cast<u32>(m_jit.js.instructionNumber);
+  const std::vector<u32>& uses = m_uses[preg];
+  auto next = std::upper_bound(uses.begin(), uses.end(), instruction);
+  if (next == uses.end())
+    return std::numeric_limits<u32>::max();
+  return *next - instruction;
+}
+
 // Estimate roughly how bad it would be to de-allocate this register. Higher score
 // means more bad.
 float RegCache::ScoreRegister(X64Reg xr)
@@ -345,15 +466,10 @@ float RegCache::ScoreRegister(X64Reg xr)
   // writing it back to the register file isn't quite as bad.
   if (GetRegUtilization()[preg])
   {
-    // Don't look too far ahead; we don't want to have quadratic compilation times for
-    // enormous block sizes!
-    // This actually improves register allocation a tiny bit; I'm not sure why.
-    u32 lookahead = std::min(m_jit.js.instructionsLeft, 64);
-    // Count how many other registers are going to be used before we need this one again.
-    u32 regs_in_count = CountRegsIn(preg, lookahead).Count();
-    // Totally ad-hoc heuristic to bias based on how many other registers we'll need
-    // before this one gets used again.
-    score += 1 + 2 * (5 - log2f(1 + (float)regs_in_count));
+    // Evicting the register that is needed again furthest in the future is cheapest; that's
+    // the register linear scan spills too. Past 64 instructions, it doesn't matter much.
+    u32 distance = std::min<u32>(NextUse(preg), 64);
+    score += 1 + 2 * (6 - log2f((float)distance));
   }
 
   return score;
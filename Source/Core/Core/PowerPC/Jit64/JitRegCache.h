@@ -6,6 +6,7 @@
 
 #include <array>
 #include <cinttypes>
+#include <vector>
 
 #include "Common/x64Emitter.h"
 #include "Core/PowerPC/PPCAnalyst.h"
@@ -45,7 +46,9 @@ public:
   virtual void LoadRegister(size_t preg, Gen::X64Reg new_loc) = 0;
   virtual Gen::OpArg GetDefaultLocation(size_t reg) const = 0;
 
-  void Start();
+  // Computes the live ranges of the guest registers in the block and assigns a host register to
+  // as many of them as possible up front.
+  void Start(const PPCAnalyst::CodeOp* ops, u32 num_ops);
 
   void DiscardRegContentsIfCached(size_t preg);
   void SetEmitter(Gen::XEmitter* emitter);
@@ -122,16 +125,34 @@ public:
   Gen::X64Reg GetFreeXReg();
   int NumFreeRegisters();
 
+  // The number of times since Start that a guest register had to be written back to make room
+  // for another one.
+  u32 GetSpillCount() const { return m_spill_count; }
+
 protected:
   virtual const Gen::X64Reg* GetAllocationOrder(size_t* count) = 0;
 
   virtual BitSet32 GetRegUtilization() = 0;
-  virtual BitSet32 CountRegsIn(size_t preg, u32 lookahead) = 0;
-
+  virtual BitSet32 GetRegsIn(const PPCAnalyst::CodeOp& op) const = 0;
+  virtual BitSet32 GetRegsOut(const PPCAnalyst::CodeOp& op) const = 0;
+  virtual bool IsCalleeSaved(Gen::X64Reg xreg) const = 0;
+
+  void AssignRegisters(const PPCAnalyst::CodeOp* ops, u32 num_ops);
+  // Returns how many instructions from the current one preg is read next, or UINT32_MAX if it
+  // isn't read again in the block.
+  u32 NextUse(size_t preg) const;
   float ScoreRegister(Gen::X64Reg xreg);
 
   Jit64& m_jit;
   std::array<PPCCachedReg, 32> m_regs;
   std::array<X64CachedReg, NUM_XREGS> m_xregs;
   Gen::XEmitter* m_emitter = nullptr;
+
+  // For each guest register, the indices of the instructions in the block that read it
+  std::array<std::vector<u32>, 32> m_uses;
+  // The host register each guest register was assigned for the block, or INVALID_REG
+  std::array<Gen::X64Reg, 32> m_assigned_xregs;
+  // For each instruction, the host registers assigned to guest registers that are live there
+  std::vector<BitSet32> m_reserved_xregs;
+  u32 m_spill_count = 0;
 };
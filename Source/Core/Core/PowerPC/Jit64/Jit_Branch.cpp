@@ -96,7 +96,7 @@ void Jit64::bx(UGeckoInstruction inst)
   if (inst.LK)
     AND(32, PPCSTATE(cr), Imm32(~(0xFF000000)));
 #endif
-  if (destination == js.compilerPC)
+  if (destination == js.compilerPC || js.op->branchIsIdleLoop)
   {
     ABI_PushRegistersAndAdjustStack({}, 0);
     ABI_CallFunction(CoreTiming::Idle);
@@ -162,7 +162,19 @@ void Jit64::bcx(UGeckoInstruction inst)
 
   gpr.Flush(RegCache::FlushMode::MaintainState);
   fpr.Flush(RegCache::FlushMode::MaintainState);
-  WriteExit(destination, inst.LK, js.compilerPC + 4);
+  if (js.op->branchIsIdleLoop)
+  {
+    // Going around the loop again would only read the same values, so wait for the next event
+    ABI_PushRegistersAndAdjustStack({}, 0);
+    ABI_CallFunction(CoreTiming::Idle);
+    ABI_PopRegistersAndAdjustStack({}, 0);
+    MOV(32, PPCSTATE(pc), Imm32(destination));
+    WriteExceptionExit();
+  }
+  else
+  {
+    WriteExit(destination, inst.LK, js.compilerPC + 4);
+  }
 
   if ((inst.BO & BO_DONT_CHECK_CONDITION) == 0)
     SetJumpTarget(pConditionDontBranch);
@@ -118,6 +118,28 @@ void Jit64::HandleNaNs(UGeckoInstruction inst, X64Reg xmm_out, X64Reg xmm, X64Re
   else
   {
     // paired-single
+    // ps_muls0/1 and ps_madds0/1 use one half of c for both halves of the result, so c is
+    // checked separately unless it's also passed as a or b.
+    X64Reg c_half = INVALID_REG;
+    if (inst.SUBOP5 >= 12 && inst.SUBOP5 <= 15)
+    {
+      if (c != a && (c != b || inst.SUBOP5 < 14))
+        inputs.erase(std::remove(inputs.begin(), inputs.end(), c), inputs.end());
+      c_half = fpr.GetFreeXReg();
+      fpr.FlushLockX(c_half);
+    }
+    const auto load_c_half = [&] {
+      if (inst.SUBOP5 & 1)
+      {
+        MOVAPD(c_half, fpr.R(c));
+        UNPCKHPD(c_half, R(c_half));
+      }
+      else
+      {
+        MOVDDUP(c_half, fpr.R(c));
+      }
+    };
+
     std::reverse(inputs.begin(), inputs.end());
     if (cpu_info.bSSE4_1)
     {
@@ -128,6 +150,12 @@ void Jit64::HandleNaNs(UGeckoInstruction inst, X64Reg xmm_out, X64Reg xmm, X64Re
       SetJumpTarget(handle_nan);
       _assert_msg_(DYNA_REC, clobber == XMM0, "BLENDVPD implicitly uses XMM0");
       BLENDVPD(xmm, M(psGeneratedQNaN));
+      if (c_half != INVALID_REG)
+      {
+        load_c_half();
+        avx_op(&XEmitter::VCMPPD, &XEmitter::CMPPD, clobber, R(c_half), R(c_half), CMP_UNORD);
+        BLENDVPD(xmm, R(c_half));
+      }
       for (u32 x : inputs)
       {
         avx_op(&XEmitter::VCMPPD, &XEmitter::CMPPD, clobber, fpr.R(x), fpr.R(x), CMP_UNORD);
@@ -154,6 +182,16 @@ void Jit64::HandleNaNs(UGeckoInstruction inst, X64Reg xmm_out, X64Reg xmm, X64Re
       ANDPD(tmp, M(psGeneratedQNaN));
       ORPD(tmp, R(clobber));
       MOVAPD(xmm, R(tmp));
+      if (c_half != INVALID_REG)
+      {
+        load_c_half();
+        MOVAPD(clobber, R(c_half));
+        CMPPD(clobber, R(clobber), CMP_ORD);
+        MOVAPD(tmp, R(clobber));
+        ANDNPD(clobber, R(c_half));
+        ANDPD(xmm, R(tmp));
+        ORPD(xmm, R(clobber));
+      }
       for (u32 x : inputs)
       {
         MOVAPD(clobber, fpr.R(x));
@@ -168,6 +206,8 @@ void Jit64::HandleNaNs(UGeckoInstruction inst, X64Reg xmm_out, X64Reg xmm, X64Re
       SetJumpTarget(done);
       fpr.UnlockX(tmp);
     }
+    if (c_half != INVALID_REG)
+      fpr.UnlockX(c_half);
   }
   if (xmm_out != xmm)
     MOVAPD(xmm_out, R(xmm));
@@ -198,7 +238,8 @@ void Jit64::fp_arith(UGeckoInstruction inst)
     packed = false;
 
   bool round_input = single && !js.op->fprIsSingle[inst.FC];
-  bool preserve_inputs = SConfig::GetInstance().bAccurateNaNs;
+  // Double precision results only replace ps0, so they have to be computed elsewhere first
+  bool preserve_inputs = SConfig::GetInstance().bAccurateNaNs || !single;
 
   X64Reg dest = INVALID_REG;
   switch (inst.SUBOP5)
@@ -223,9 +264,16 @@ void Jit64::fp_arith(UGeckoInstruction inst)
   default:
     _assert_msg_(DYNA_REC, 0, "fp_arith WTF!!!");
   }
-  HandleNaNs(inst, fpr.RX(d), dest);
   if (single)
+  {
+    HandleNaNs(inst, fpr.RX(d), dest);
     ForceSinglePrecision(fpr.RX(d), fpr.R(d), packed, true);
+  }
+  else
+  {
+    HandleNaNs(inst, dest, dest);
+    MOVSD(fpr.RX(d), R(dest));
+  }
   SetFPRFIfNeeded(fpr.RX(d));
   fpr.UnlockAll();
 }
@@ -260,13 +308,10 @@ void Jit64::fmaddXX(UGeckoInstruction inst)
       Force25BitPrecision(XMM1, R(XMM1), XMM0);
     break;
   default:
-    bool special = inst.SUBOP5 == 30 && (!cpu_info.bFMA || Core::g_want_determinism);
-    X64Reg tmp1 = special ? XMM0 : XMM1;
-    X64Reg tmp2 = special ? XMM1 : XMM0;
     if (single && round_input)
-      Force25BitPrecision(tmp1, fpr.R(c), tmp2);
+      Force25BitPrecision(XMM1, fpr.R(c), XMM0);
     else
-      MOVAPD(tmp1, fpr.R(c));
+      MOVAPD(XMM1, fpr.R(c));
     break;
   }
 
@@ -315,28 +360,12 @@ void Jit64::fmaddXX(UGeckoInstruction inst)
       break;
     }
   }
-  else if (inst.SUBOP5 == 30)  // nmsub
-  {
-    // We implement nmsub a little differently ((b - a*c) instead of -(a*c - b)), so handle it
-    // separately.
-    MOVAPD(XMM1, fpr.R(b));
-    if (packed)
-    {
-      MULPD(XMM0, fpr.R(a));
-      SUBPD(XMM1, R(XMM0));
-    }
-    else
-    {
-      MULSD(XMM0, fpr.R(a));
-      SUBSD(XMM1, R(XMM0));
-    }
-  }
   else
   {
     if (packed)
     {
       MULPD(XMM1, fpr.R(a));
-      if (inst.SUBOP5 == 28)  // msub
+      if (inst.SUBOP5 == 28 || inst.SUBOP5 == 30)  // (n)msub
         SUBPD(XMM1, fpr.R(b));
       else  //(n)madd(s[01])
         ADDPD(XMM1, fpr.R(b));
@@ -344,15 +373,17 @@ void Jit64::fmaddXX(UGeckoInstruction inst)
     else
     {
       MULSD(XMM1, fpr.R(a));
-      if (inst.SUBOP5 == 28)
+      if (inst.SUBOP5 == 28 || inst.SUBOP5 == 30)
         SUBSD(XMM1, fpr.R(b));
       else
         ADDSD(XMM1, fpr.R(b));
     }
-    if (inst.SUBOP5 == 31)  // nmadd
+    // Negating a * c - b rather than computing b - a * c keeps the sign of a zero result
+    if (inst.SUBOP5 == 30 || inst.SUBOP5 == 31)  // nmsub, nmadd
       XORPD(XMM1, M(packed ? psSignBits2 : psSignBits));
   }
-  fpr.BindToRegister(d, !single);
+  // HandleNaNs reads the inputs from their registers, and d might be one of them
+  fpr.BindToRegister(d, !single || d == a || d == b || d == c);
   if (single)
   {
     HandleNaNs(inst, fpr.RX(d), XMM1);
@@ -371,7 +402,8 @@ void Jit64::fsign(UGeckoInstruction inst)
 {
   INSTRUCTION_START
   JITDISABLE(bJITFloatingPointOff);
-  FALLBACK_IF(inst.Rc);
+  if (inst.Rc)
+    UpdateCR1();
 
   int d = inst.FD;
   int b = inst.FB;
@@ -379,26 +411,30 @@ void Jit64::fsign(UGeckoInstruction inst)
 
   fpr.Lock(b, d);
   OpArg src = fpr.R(b);
-  fpr.BindToRegister(d, false);
+  // The double precision forms leave ps1 alone
+  fpr.BindToRegister(d, !packed);
+  X64Reg dest = packed ? fpr.RX(d) : XMM0;
 
   switch (inst.SUBOP10)
   {
   case 40:  // neg
-    avx_op(&XEmitter::VXORPD, &XEmitter::XORPD, fpr.RX(d), src,
-           M(packed ? psSignBits2 : psSignBits), packed);
+    avx_op(&XEmitter::VXORPD, &XEmitter::XORPD, dest, src, M(packed ? psSignBits2 : psSignBits),
+           packed);
     break;
   case 136:  // nabs
-    avx_op(&XEmitter::VORPD, &XEmitter::ORPD, fpr.RX(d), src, M(packed ? psSignBits2 : psSignBits),
+    avx_op(&XEmitter::VORPD, &XEmitter::ORPD, dest, src, M(packed ? psSignBits2 : psSignBits),
            packed);
     break;
   case 264:  // abs
-    avx_op(&XEmitter::VANDPD, &XEmitter::ANDPD, fpr.RX(d), src, M(packed ? psAbsMask2 : psAbsMask),
+    avx_op(&XEmitter::VANDPD, &XEmitter::ANDPD, dest, src, M(packed ? psAbsMask2 : psAbsMask),
            packed);
     break;
   default:
     PanicAlert("fsign bleh");
     break;
   }
+  if (!packed)
+    MOVSD(fpr.RX(d), R(dest));
   fpr.UnlockAll();
 }
 
@@ -406,7 +442,8 @@ void Jit64::fselx(UGeckoInstruction inst)
 {
   INSTRUCTION_START
   JITDISABLE(bJITFloatingPointOff);
-  FALLBACK_IF(inst.Rc);
+  if (inst.Rc)
+    UpdateCR1();
 
   int d = inst.FD;
   int a = inst.FA;
@@ -450,7 +487,8 @@ void Jit64::fmrx(UGeckoInstruction inst)
 {
   INSTRUCTION_START
   JITDISABLE(bJITFloatingPointOff);
-  FALLBACK_IF(inst.Rc);
+  if (inst.Rc)
+    UpdateCR1();
 
   int d = inst.FD;
   int b = inst.FB;
@@ -606,7 +644,7 @@ void Jit64::fctiwx(UGeckoInstruction inst)
   // any NaN     | 0x80000000   | 0x80000000
   //
   // The upper 32 bits of the result are set to 0xfff80000,
-  // except for -0.0 where they are set to 0xfff80001 (TODO).
+  // except for -0.0 and negative numbers that round to 0 where they are set to 0xfff80001.
 
   MOVAPD(XMM0, M(half_qnan_and_s32_max));
   MINSD(XMM0, fpr.R(b));
@@ -622,6 +660,17 @@ void Jit64::fctiwx(UGeckoInstruction inst)
     CVTTPD2DQ(XMM0, R(XMM0));
     break;
   }
+  if (fpr.R(b).IsSimpleReg())
+    MOVQ_xmm(R(RSCRATCH2), fpr.RX(b));
+  else
+    MOV(64, R(RSCRATCH2), fpr.R(b));
+  SHR(64, R(RSCRATCH2), Imm8(63));
+  SHL(64, R(RSCRATCH2), Imm8(32));
+  MOVQ_xmm(R(RSCRATCH), XMM0);
+  OR(64, R(RSCRATCH2), R(RSCRATCH));
+  TEST(32, R(RSCRATCH), R(RSCRATCH));
+  CMOVcc(64, RSCRATCH, R(RSCRATCH2), CC_Z);
+  MOVQ_xmm(XMM0, R(RSCRATCH));
   // d[64+] must not be modified
   MOVSD(fpr.R(d), XMM0);
   fpr.UnlockAll();
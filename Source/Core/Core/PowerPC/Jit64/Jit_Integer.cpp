@@ -9,7 +9,9 @@
 #include "Common/CPUDetect.h"
 #include "Common/CommonTypes.h"
 #include "Common/MathUtil.h"
+#include "Common/x64ABI.h"
 #include "Common/x64Emitter.h"
+#include "Core/CoreTiming.h"
 #include "Core/PowerPC/Jit64/Jit.h"
 #include "Core/PowerPC/Jit64/JitRegCache.h"
 #include "Core/PowerPC/Jit64Common/Jit64PowerPCState.h"
@@ -142,18 +144,22 @@ void Jit64::FinalizeCarryOverflow(bool oe, bool inv)
 void Jit64::ComputeRC(const OpArg& arg, bool needs_test, bool needs_sext)
 {
   _assert_msg_(DYNA_REC, arg.IsSimpleReg() || arg.IsImm(), "Invalid ComputeRC operand");
-  if (arg.IsImm())
+  // Skip the update if nothing reads CR0 before it's overwritten
+  if (js.op->wantsCR0)
   {
-    MOV(64, PPCSTATE(cr_val[0]), Imm32(arg.SImm32()));
-  }
-  else if (needs_sext)
-  {
-    MOVSX(64, 32, RSCRATCH, arg);
-    MOV(64, PPCSTATE(cr_val[0]), R(RSCRATCH));
-  }
-  else
-  {
-    MOV(64, PPCSTATE(cr_val[0]), arg);
+    if (arg.IsImm())
+    {
+      MOV(64, PPCSTATE(cr_val[0]), Imm32(arg.SImm32()));
+    }
+    else if (needs_sext)
+    {
+      MOVSX(64, 32, RSCRATCH, arg);
+      MOV(64, PPCSTATE(cr_val[0]), R(RSCRATCH));
+    }
+    else
+    {
+      MOV(64, PPCSTATE(cr_val[0]), arg);
+    }
   }
   if (CheckMergedBranch(0))
   {
@@ -369,7 +375,19 @@ void Jit64::DoMergedBranch()
       destination = SignExt16(next.BD << 2);
     else
       destination = nextPC + SignExt16(next.BD << 2);
-    WriteExit(destination, next.LK, nextPC + 4);
+    if (js.op[1].branchIsIdleLoop)
+    {
+      // The same as in bcx
+      ABI_PushRegistersAndAdjustStack({}, 0);
+      ABI_CallFunction(CoreTiming::Idle);
+      ABI_PopRegistersAndAdjustStack({}, 0);
+      MOV(32, PPCSTATE(pc), Imm32(destination));
+      WriteExceptionExit();
+    }
+    else
+    {
+      WriteExit(destination, next.LK, nextPC + 4);
+    }
   }
   else if ((next.OPCD == 19) && (next.SUBOP10 == 528))  // bcctrx
   {
@@ -1489,7 +1507,8 @@ void Jit64::rlwinmx(UGeckoInstruction inst)
             AND(32, gpr.R(a), Imm32(mask));
           else
             AndWithMask(gpr.RX(a), mask);
-          needs_sext = inst.MB == 0;
+          // The mask wraps around when MB > ME, so check its high bit rather than MB
+          needs_sext = (mask & 0x80000000) != 0;
           needs_test = false;
         }
       }
@@ -1521,6 +1540,9 @@ void Jit64::rlwimix(UGeckoInstruction inst)
     bool needs_test = false;
     if (mask == 0 || (a == s && inst.SH == 0))
     {
+      // rA doesn't change, but ComputeRC still needs it in a register
+      if (inst.Rc)
+        gpr.BindToRegister(a, true, false);
       needs_test = true;
     }
     else if (mask == 0xFFFFFFFF)
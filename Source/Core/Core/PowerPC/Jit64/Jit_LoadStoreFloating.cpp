@@ -28,12 +28,13 @@ void Jit64::lfXXX(UGeckoInstruction inst)
   int a = inst.RA;
   int b = inst.RB;
 
-  FALLBACK_IF(!indexed && !a);
+  FALLBACK_IF(update && !a);
 
-  gpr.BindToRegister(a, true, update);
+  if (a)
+    gpr.BindToRegister(a, true, update);
 
   s32 offset = 0;
-  OpArg addr = gpr.R(a);
+  OpArg addr = a ? gpr.R(a) : Imm32(0);
   if (update && jo.memcheck)
   {
     addr = R(RSCRATCH2);
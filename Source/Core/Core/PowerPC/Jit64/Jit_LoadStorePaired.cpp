@@ -34,7 +34,7 @@ void Jit64::psq_stXX(UGeckoInstruction inst)
   int s = inst.FS;
   int i = indexed ? inst.Ix : inst.I;
   int w = indexed ? inst.Wx : inst.W;
-  FALLBACK_IF(!a);
+  FALLBACK_IF(update && !a);
 
   auto it = js.constantGqr.find(i);
   bool gqrIsConstant = it != js.constantGqr.end();
@@ -45,20 +45,28 @@ void Jit64::psq_stXX(UGeckoInstruction inst)
   if (update)
     gpr.BindToRegister(a, true, true);
 
-  MOV_sum(32, RSCRATCH_EXTRA, gpr.R(a), indexed ? gpr.R(b) : Imm32((u32)offset));
+  MOV_sum(32, RSCRATCH_EXTRA, a ? gpr.R(a) : Imm32(0), indexed ? gpr.R(b) : Imm32((u32)offset));
 
   // In memcheck mode, don't update the address until the exception check
   if (update && !jo.memcheck)
     MOV(32, gpr.R(a), R(RSCRATCH_EXTRA));
 
-  if (w)
-    CVTSD2SS(XMM0, fpr.R(s));  // one
-  else
-    CVTPD2PS(XMM0, fpr.R(s));  // pair
+  // Floats are stored like the hardware does, which flushes denormals and truncates the doubles
+  // that don't fit, but the quantized types are converted with rounding first
+  const auto convert_quantized = [&] {
+    if (w)
+      CVTSD2SS(XMM0, fpr.R(s));  // one
+    else
+      CVTPD2PS(XMM0, fpr.R(s));  // pair
+  };
 
   if (gqrIsConstant)
   {
     int type = gqrValue & 0x7;
+    if (type == QUANTIZE_FLOAT)
+      ConvertDoubleToSingleFTZ(XMM0, fpr.R(s), !w);
+    else
+      convert_quantized();
 
     // Paired stores (other than w/type zero) don't yield any real change in
     // performance right now, but if we can improve fastmem support this might change
@@ -91,6 +99,14 @@ void Jit64::psq_stXX(UGeckoInstruction inst)
     AND(32, R(RSCRATCH2), PPCSTATE(spr[SPR_GQR0 + i]));
     MOVZX(32, 8, RSCRATCH, R(RSCRATCH2));
 
+    TEST(32, R(RSCRATCH), R(RSCRATCH));
+    FixupBranch quantized = J_CC(CC_NZ);
+    ConvertDoubleToSingleFTZ(XMM0, fpr.R(s), !w);
+    FixupBranch converted = J();
+    SetJumpTarget(quantized);
+    convert_quantized();
+    SetJumpTarget(converted);
+
     if (w)
       CALLptr(MScaled(RSCRATCH, SCALE_8, PtrOffset(asm_routines.singleStoreQuantized)));
     else
@@ -124,7 +140,7 @@ void Jit64::psq_lXX(UGeckoInstruction inst)
   int s = inst.FS;
   int i = indexed ? inst.Ix : inst.I;
   int w = indexed ? inst.Wx : inst.W;
-  FALLBACK_IF(!a);
+  FALLBACK_IF(update && !a);
 
   auto it = js.constantGqr.find(i);
   bool gqrIsConstant = it != js.constantGqr.end();
@@ -136,7 +152,7 @@ void Jit64::psq_lXX(UGeckoInstruction inst)
   gpr.BindToRegister(a, true, update);
   fpr.BindToRegister(s, false, true);
 
-  MOV_sum(32, RSCRATCH_EXTRA, gpr.R(a), indexed ? gpr.R(b) : Imm32((u32)offset));
+  MOV_sum(32, RSCRATCH_EXTRA, a ? gpr.R(a) : Imm32(0), indexed ? gpr.R(b) : Imm32((u32)offset));
 
   // In memcheck mode, don't update the address until the exception check
   if (update && !jo.memcheck)
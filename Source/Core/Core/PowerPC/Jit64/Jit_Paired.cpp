@@ -7,15 +7,19 @@
 #include "Common/CommonTypes.h"
 #include "Common/MsgHandler.h"
 #include "Common/x64Emitter.h"
+#include "Core/ConfigManager.h"
 #include "Core/PowerPC/Jit64/JitRegCache.h"
 
 using namespace Gen;
 
+alignas(16) static const u64 psGeneratedQNaN[2] = {0x7FF8000000000000ULL, 0x7FF8000000000000ULL};
+
 void Jit64::ps_mr(UGeckoInstruction inst)
 {
   INSTRUCTION_START
   JITDISABLE(bJITPairedOff);
-  FALLBACK_IF(inst.Rc);
+  if (inst.Rc)
+    UpdateCR1();
 
   int d = inst.FD;
   int b = inst.FB;
@@ -42,6 +46,30 @@ void Jit64::ps_sum(UGeckoInstruction inst)
   X64Reg tmp = XMM1;
   MOVDDUP(tmp, op_a);    // {a.ps0, a.ps0}
   ADDPD(tmp, fpr.R(b));  // {a.ps0 + b.ps0, a.ps0 + b.ps1}
+  if (SConfig::GetInstance().bAccurateNaNs)
+  {
+    // HandleNaNs takes each half's NaN inputs from the same half, but the sum comes from a.ps0
+    // and b.ps1, and the other half is just moved, so this is done by hand
+    MOVHLPS(XMM0, tmp);
+    UCOMISD(XMM0, R(XMM0));
+    FixupBranch handle_nan = J_CC(CC_P, true);
+    SwitchToFarCode();
+    SetJumpTarget(handle_nan);
+    MOVDDUP(XMM0, op_a);
+    UCOMISD(XMM0, R(XMM0));
+    FixupBranch a_is_nan = J_CC(CC_P);
+    MOVAPD(XMM0, fpr.R(b));
+    UNPCKHPD(XMM0, R(XMM0));
+    UCOMISD(XMM0, R(XMM0));
+    FixupBranch b_is_nan = J_CC(CC_P);
+    MOVDDUP(XMM0, M(psGeneratedQNaN));
+    SetJumpTarget(a_is_nan);
+    SetJumpTarget(b_is_nan);
+    UNPCKLPD(tmp, R(XMM0));
+    FixupBranch done = J(true);
+    SwitchToNearCode();
+    SetJumpTarget(done);
+  }
   switch (inst.SUBOP5)
   {
   case 10:  // ps_sum0: {a.ps0 + b.ps1, c.ps1}
@@ -69,9 +97,18 @@ void Jit64::ps_sum(UGeckoInstruction inst)
   default:
     PanicAlert("ps_sum WTF!!!");
   }
-  HandleNaNs(inst, fpr.RX(d), tmp, tmp == XMM1 ? XMM0 : XMM1);
+  MOVAPD(fpr.RX(d), R(tmp));
   ForceSinglePrecision(fpr.RX(d), fpr.R(d));
-  SetFPRFIfNeeded(fpr.RX(d));
+  // FPRF describes the sum, which ps_sum1 puts into ps1
+  if (inst.SUBOP5 == 11)
+  {
+    MOVHLPS(XMM0, fpr.RX(d));
+    SetFPRFIfNeeded(XMM0);
+  }
+  else
+  {
+    SetFPRFIfNeeded(fpr.RX(d));
+  }
   fpr.UnlockAll();
 }
 
@@ -100,7 +137,7 @@ void Jit64::ps_muls(UGeckoInstruction inst)
   if (round_input)
     Force25BitPrecision(XMM1, R(XMM1), XMM0);
   MULPD(XMM1, fpr.R(a));
-  fpr.BindToRegister(d, false);
+  fpr.BindToRegister(d, d == a || d == c);
   HandleNaNs(inst, fpr.RX(d), XMM1);
   ForceSinglePrecision(fpr.RX(d), fpr.R(d));
   SetFPRFIfNeeded(fpr.RX(d));
@@ -111,7 +148,8 @@ void Jit64::ps_mergeXX(UGeckoInstruction inst)
 {
   INSTRUCTION_START
   JITDISABLE(bJITPairedOff);
-  FALLBACK_IF(inst.Rc);
+  if (inst.Rc)
+    UpdateCR1();
 
   int d = inst.FD;
   int a = inst.FA;
@@ -187,7 +225,7 @@ void Jit64::ps_res(UGeckoInstruction inst)
   CALL(asm_routines.fres);
   MOVLHPS(fpr.RX(d), XMM0);
 
-  ForceSinglePrecision(fpr.RX(d), fpr.R(d));
+  // fres already gives single precision results, and NaNs are passed through unchanged
   SetFPRFIfNeeded(fpr.RX(d));
   fpr.UnlockAll();
   gpr.UnlockAllX();
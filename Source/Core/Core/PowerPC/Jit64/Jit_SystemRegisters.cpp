@@ -632,7 +632,6 @@ void Jit64::mffsx(UGeckoInstruction inst)
 {
   INSTRUCTION_START
   JITDISABLE(bJITSystemRegistersOff);
-  FALLBACK_IF(inst.Rc);
 
   MOV(32, R(RSCRATCH), PPCSTATE(fpscr));
 
@@ -654,6 +653,9 @@ void Jit64::mffsx(UGeckoInstruction inst)
   OR(64, R(RSCRATCH), R(RSCRATCH2));
   MOVQ_xmm(XMM0, R(RSCRATCH));
   MOVSD(fpr.RX(d), R(XMM0));
+
+  if (inst.Rc)
+    UpdateCR1();
 }
 
 // MXCSR = s_fpscr_to_mxcsr[FPSCR & 7]
@@ -669,11 +671,25 @@ void Jit64::UpdateMXCSR()
   LDMXCSR(MComplex(RSCRATCH2, RSCRATCH, SCALE_4, 0));
 }
 
+// CR1 = FPSCR[FX, FEX, VX, OX], for the record forms of floating point instructions. It only reads
+// FPSCR, so instructions that don't change FPSCR (moves, sign changes) can set CR1 before anything
+// else.
+void Jit64::UpdateCR1()
+{
+  if (!js.op->wantsCR1)
+    return;
+
+  MOV(32, R(RSCRATCH), PPCSTATE(fpscr));
+  SHR(32, R(RSCRATCH), Imm8(28));
+  LEA(64, RSCRATCH2, M(m_crTable.data()));
+  MOV(64, R(RSCRATCH), MComplex(RSCRATCH2, RSCRATCH, SCALE_8, 0));
+  MOV(64, PPCSTATE(cr_val[1]), R(RSCRATCH));
+}
+
 void Jit64::mtfsb0x(UGeckoInstruction inst)
 {
   INSTRUCTION_START
   JITDISABLE(bJITSystemRegistersOff);
-  FALLBACK_IF(inst.Rc);
 
   u32 mask = ~(0x80000000 >> inst.CRBD);
   if (inst.CRBD < 29)
@@ -687,13 +703,15 @@ void Jit64::mtfsb0x(UGeckoInstruction inst)
     MOV(32, PPCSTATE(fpscr), R(RSCRATCH));
     UpdateMXCSR();
   }
+
+  if (inst.Rc)
+    UpdateCR1();
 }
 
 void Jit64::mtfsb1x(UGeckoInstruction inst)
 {
   INSTRUCTION_START
   JITDISABLE(bJITSystemRegistersOff);
-  FALLBACK_IF(inst.Rc);
 
   u32 mask = 0x80000000 >> inst.CRBD;
   MOV(32, R(RSCRATCH), PPCSTATE(fpscr));
@@ -711,13 +729,15 @@ void Jit64::mtfsb1x(UGeckoInstruction inst)
   MOV(32, PPCSTATE(fpscr), R(RSCRATCH));
   if (inst.CRBD >= 29)
     UpdateMXCSR();
+
+  if (inst.Rc)
+    UpdateCR1();
 }
 
 void Jit64::mtfsfix(UGeckoInstruction inst)
 {
   INSTRUCTION_START
   JITDISABLE(bJITSystemRegistersOff);
-  FALLBACK_IF(inst.Rc);
 
   u8 imm = (inst.hex >> (31 - 19)) & 0xF;
   u32 or_mask = imm << (28 - 4 * inst.CRFD);
@@ -731,13 +751,15 @@ void Jit64::mtfsfix(UGeckoInstruction inst)
   // Field 7 contains NI and RN.
   if (inst.CRFD == 7)
     LDMXCSR(M(&s_fpscr_to_mxcsr[imm & 7]));
+
+  if (inst.Rc)
+    UpdateCR1();
 }
 
 void Jit64::mtfsfx(UGeckoInstruction inst)
 {
   INSTRUCTION_START
   JITDISABLE(bJITSystemRegistersOff);
-  FALLBACK_IF(inst.Rc);
 
   u32 mask = 0;
   for (int i = 0; i < 8; i++)
@@ -760,4 +782,7 @@ void Jit64::mtfsfx(UGeckoInstruction inst)
 
   if (inst.FM & 1)
     UpdateMXCSR();
+
+  if (inst.Rc)
+    UpdateCR1();
 }
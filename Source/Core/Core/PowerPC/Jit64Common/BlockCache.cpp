@@ -4,6 +4,8 @@
 
 #include "Core/PowerPC/Jit64Common/BlockCache.h"
 
+#include <cstring>
+
 #include "Common/CommonTypes.h"
 #include "Common/x64Emitter.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
@@ -42,3 +44,9 @@ void JitBlockCache::WriteDestroyBlock(const JitBlock& block)
   Gen::XEmitter emit2(const_cast<u8*>(block.normalEntry));
   emit2.INT3();
 }
+
+void JitBlockCache::WritePageVersionCheck(const JitBlock::PageVersionCheck& check, u32 version)
+{
+  // The location is the immediate of the MOV which loads the expected version.
+  std::memcpy(check.location, &version, sizeof(version));
+}
@@ -16,4 +16,5 @@ public:
 private:
   void WriteLinkBlock(const JitBlock::LinkData& source, const JitBlock* dest) override;
   void WriteDestroyBlock(const JitBlock& block) override;
+  void WritePageVersionCheck(const JitBlock::PageVersionCheck& check, u32 version) override;
 };
@@ -8,6 +8,7 @@
 #include "Common/CPUDetect.h"
 #include "Common/Intrinsics.h"
 #include "Common/MathUtil.h"
+#include "Core/ConfigManager.h"
 #include "Core/HW/MMIO.h"
 #include "Core/HW/Memmap.h"
 #include "Core/PowerPC/Gekko.h"
@@ -113,6 +114,50 @@ FixupBranch EmuCodeBlock::CheckIfSafeAddress(const OpArg& reg_value, X64Reg reg_
   return J_CC(CC_Z, m_far_code.Enabled());
 }
 
+bool EmuCodeBlock::ShadowTLBLookup(X64Reg reg_addr, int accessSize, bool write,
+                                   BitSet32 registers_in_use, X64Reg extra_scratch,
+                                   OpArg* host_address, FixupBranch* miss)
+{
+  static_assert(sizeof(PowerPC::ShadowTLBEntry) == 16, "The lookup scales the index by 16");
+
+  registers_in_use[reg_addr] = true;
+  X64Reg scratch[2];
+  size_t num_scratch = 0;
+  for (X64Reg reg : {RSCRATCH, RSCRATCH2, RSCRATCH_EXTRA, extra_scratch})
+  {
+    if (num_scratch < 2 && reg != INVALID_REG && !registers_in_use[reg])
+    {
+      registers_in_use[reg] = true;
+      scratch[num_scratch++] = reg;
+    }
+  }
+  if (num_scratch < 2)
+    return false;
+
+  const X64Reg entry = scratch[0];
+  const X64Reg tag = scratch[1];
+  const u32 page_mask = (1 << HW_PAGE_INDEX_SHIFT) - 1;
+  const PowerPC::ShadowTLBEntry* table = &PowerPC::shadow_dtlb[0];
+
+  MOV(32, R(entry), R(reg_addr));
+  SHR(32, R(entry), Imm8(HW_PAGE_INDEX_SHIFT - 4));
+  AND(32, R(entry), Imm32((PowerPC::SHADOW_TLB_SIZE - 1) << 4));
+
+  // Keeping the low bits of the address makes unaligned accesses, which might cross into the
+  // next page, miss.
+  MOV(32, R(tag), R(reg_addr));
+  AND(32, R(tag), Imm32(~page_mask | (accessSize / 8 - 1)));
+  CMP(32, R(tag), MDisp(entry, PtrOffset(write ? &table->write_tag : &table->read_tag)));
+  *miss = J_CC(CC_NE);
+
+  MOV(32, R(tag), R(reg_addr));
+  AND(32, R(tag), Imm32(page_mask));
+  OR(32, R(tag), MDisp(entry, PtrOffset(&table->paddr)));
+  MOV(64, R(entry), ImmPtr(Memory::physical_base));
+  *host_address = MRegSum(entry, tag);
+  return true;
+}
+
 void EmuCodeBlock::UnsafeLoadRegToReg(X64Reg reg_addr, X64Reg reg_value, int accessSize, s32 offset,
                                       bool signExtend)
 {
@@ -131,6 +176,19 @@ void EmuCodeBlock::UnsafeLoadRegToRegNoSwap(X64Reg reg_addr, X64Reg reg_value, i
 
 void EmuCodeBlock::UnsafeWriteRegToReg(OpArg reg_value, X64Reg reg_addr, int accessSize, s32 offset,
                                        bool swap, MovInfo* info)
+{
+  UnsafeWriteRegToMem(reg_value, MComplex(RMEM, reg_addr, SCALE_1, offset), accessSize, swap,
+                      info);
+}
+
+void EmuCodeBlock::UnsafeWriteRegToReg(Gen::X64Reg reg_value, Gen::X64Reg reg_addr, int accessSize,
+                                       s32 offset, bool swap, Gen::MovInfo* info)
+{
+  UnsafeWriteRegToReg(R(reg_value), reg_addr, accessSize, offset, swap, info);
+}
+
+void EmuCodeBlock::UnsafeWriteRegToMem(OpArg reg_value, const OpArg& dest, int accessSize,
+                                       bool swap, MovInfo* info)
 {
   if (info)
   {
@@ -138,7 +196,6 @@ void EmuCodeBlock::UnsafeWriteRegToReg(OpArg reg_value, X64Reg reg_addr, int acc
     info->nonAtomicSwapStore = false;
   }
 
-  OpArg dest = MComplex(RMEM, reg_addr, SCALE_1, offset);
   if (reg_value.IsImm())
   {
     if (swap)
@@ -155,12 +212,6 @@ void EmuCodeBlock::UnsafeWriteRegToReg(OpArg reg_value, X64Reg reg_addr, int acc
   }
 }
 
-void EmuCodeBlock::UnsafeWriteRegToReg(Gen::X64Reg reg_value, Gen::X64Reg reg_addr, int accessSize,
-                                       s32 offset, bool swap, Gen::MovInfo* info)
-{
-  UnsafeWriteRegToReg(R(reg_value), reg_addr, accessSize, offset, swap, info);
-}
-
 bool EmuCodeBlock::UnsafeLoadToReg(X64Reg reg_value, OpArg opAddress, int accessSize, s32 offset,
                                    bool signExtend, MovInfo* info)
 {
@@ -397,6 +448,20 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg& opAddress,
       exit = J(true);
     SetJumpTarget(slow);
   }
+
+  // This is also how trampolines avoid calling into the MMU code for most page table accesses
+  FixupBranch shadow_tlb_miss, shadow_tlb_exit;
+  OpArg shadow_tlb_address;
+  bool shadow_tlb = dr_set && !g_jit->jo.alwaysUseMemFuncs && SConfig::GetInstance().bMMU &&
+                    ShadowTLBLookup(reg_addr, accessSize, false, registersInUse, reg_value,
+                                    &shadow_tlb_address, &shadow_tlb_miss);
+  if (shadow_tlb)
+  {
+    LoadAndSwap(accessSize, reg_value, shadow_tlb_address, signExtend);
+    shadow_tlb_exit = J(true);
+    SetJumpTarget(shadow_tlb_miss);
+  }
+
   size_t rsp_alignment = (flags & SAFE_LOADSTORE_NO_PROLOG) ? 8 : 0;
   ABI_PushRegistersAndAdjustStack(registersInUse, rsp_alignment);
   switch (accessSize)
@@ -436,6 +501,8 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg& opAddress,
     }
     SetJumpTarget(exit);
   }
+  if (shadow_tlb)
+    SetJumpTarget(shadow_tlb_exit);
 }
 
 void EmuCodeBlock::SafeLoadToRegImmediate(X64Reg reg_value, u32 address, int accessSize,
@@ -553,6 +620,21 @@ void EmuCodeBlock::SafeWriteRegToReg(OpArg reg_value, X64Reg reg_addr, int acces
     SetJumpTarget(slow);
   }
 
+  FixupBranch shadow_tlb_miss, shadow_tlb_exit;
+  OpArg shadow_tlb_address;
+  BitSet32 shadow_tlb_registers = registersInUse;
+  if (reg_value.IsSimpleReg())
+    shadow_tlb_registers[reg_value.GetSimpleReg()] = true;
+  bool shadow_tlb = dr_set && !g_jit->jo.alwaysUseMemFuncs && SConfig::GetInstance().bMMU &&
+                    ShadowTLBLookup(reg_addr, accessSize, true, shadow_tlb_registers, INVALID_REG,
+                                    &shadow_tlb_address, &shadow_tlb_miss);
+  if (shadow_tlb)
+  {
+    UnsafeWriteRegToMem(reg_value, shadow_tlb_address, accessSize, swap);
+    shadow_tlb_exit = J(true);
+    SetJumpTarget(shadow_tlb_miss);
+  }
+
   // PC is used by memory watchpoints (if enabled) or to print accurate PC locations in debug logs
   MOV(32, PPCSTATE(pc), Imm32(g_jit->js.compilerPC));
 
@@ -599,6 +681,8 @@ void EmuCodeBlock::SafeWriteRegToReg(OpArg reg_value, X64Reg reg_addr, int acces
     }
     SetJumpTarget(exit);
   }
+  if (shadow_tlb)
+    SetJumpTarget(shadow_tlb_exit);
 }
 
 void EmuCodeBlock::SafeWriteRegToReg(Gen::X64Reg reg_value, Gen::X64Reg reg_addr, int accessSize,
@@ -854,152 +938,96 @@ void EmuCodeBlock::Force25BitPrecision(X64Reg output, const OpArg& input, X64Reg
   }
 }
 
-alignas(16) static u32 temp32;
-alignas(16) static u64 temp64;
-
 // Since the following float conversion functions are used in non-arithmetic PPC float instructions,
 // they must convert floats bitexact and never flush denormals to zero or turn SNaNs into QNaNs.
 // This means we can't use CVTSS2SD/CVTSD2SS :(
-// The x87 FPU doesn't even support flush-to-zero so we can use FLD+FSTP even on denormals.
 // If the number is a NaN, make sure to set the QNaN bit back to its original value.
 
-// Another problem is that officially, converting doubles to single format results in undefined
-// behavior.
-// Relying on undefined behavior is a bug so no software should ever do this.
-// In case it does happen, phire's more accurate implementation of ConvertDoubleToSingle() is
-// reproduced below.
-
-//#define MORE_ACCURATE_DOUBLETOSINGLE
-#ifdef MORE_ACCURATE_DOUBLETOSINGLE
-
-alignas(16) static const __m128i double_exponent = _mm_set_epi64x(0, 0x7ff0000000000000);
-alignas(16) static const __m128i double_fraction = _mm_set_epi64x(0, 0x000fffffffffffff);
-alignas(16) static const __m128i double_sign_bit = _mm_set_epi64x(0, 0x8000000000000000);
-alignas(16) static const __m128i double_explicit_top_bit = _mm_set_epi64x(0, 0x0010000000000000);
-alignas(16) static const __m128i double_top_two_bits = _mm_set_epi64x(0, 0xc000000000000000);
-alignas(16) static const __m128i double_bottom_bits = _mm_set_epi64x(0, 0x07ffffffe0000000);
-
-// This is the same algorithm used in the interpreter (and actual hardware)
-// The documentation states that the conversion of a double with an outside the
-// valid range for a single (or a single denormal) is undefined.
-// But testing on actual hardware shows it always picks bits 0..1 and 5..34
-// unless the exponent is in the range of 874 to 896.
-void EmuCodeBlock::ConvertDoubleToSingle(X64Reg dst, X64Reg src)
-{
-  MOVSD(XMM1, R(src));
-
-  // Grab Exponent
-  PAND(XMM1, M(&double_exponent));
-  PSRLQ(XMM1, 52);
-  MOVD_xmm(R(RSCRATCH), XMM1);
-
-  // Check if the double is in the range of valid single subnormal
-  CMP(16, R(RSCRATCH), Imm16(896));
-  FixupBranch NoDenormalize = J_CC(CC_G);
-  CMP(16, R(RSCRATCH), Imm16(874));
-  FixupBranch NoDenormalize2 = J_CC(CC_L);
-
-  // Denormalise
-
-  // shift = (905 - Exponent) plus the 21 bit double to single shift
-  MOV(16, R(RSCRATCH), Imm16(905 + 21));
-  MOVD_xmm(XMM0, R(RSCRATCH));
-  PSUBQ(XMM0, R(XMM1));
-
-  // xmm1 = fraction | 0x0010000000000000
-  MOVSD(XMM1, R(src));
-  PAND(XMM1, M(&double_fraction));
-  POR(XMM1, M(&double_explicit_top_bit));
-
-  // fraction >> shift
-  PSRLQ(XMM1, R(XMM0));
-
-  // OR the sign bit in.
-  MOVSD(XMM0, R(src));
-  PAND(XMM0, M(&double_sign_bit));
-  PSRLQ(XMM0, 32);
-  POR(XMM1, R(XMM0));
-
-  FixupBranch end = J(false);  // Goto end
-
-  SetJumpTarget(NoDenormalize);
-  SetJumpTarget(NoDenormalize2);
-
-  // Don't Denormalize
-
-  // We want bits 0, 1
-  MOVSD(XMM1, R(src));
-  PAND(XMM1, M(&double_top_two_bits));
-  PSRLQ(XMM1, 32);
-
-  // And 5 through to 34
-  MOVSD(XMM0, R(src));
-  PAND(XMM0, M(&double_bottom_bits));
-  PSRLQ(XMM0, 29);
-
-  // OR them togther
-  POR(XMM1, R(XMM0));
-
-  // End
-  SetJumpTarget(end);
-  MOVDDUP(dst, R(XMM1));
-}
-
-#else   // MORE_ACCURATE_DOUBLETOSINGLE
-
-alignas(16) static const __m128i double_sign_bit = _mm_set_epi64x(0xffffffffffffffff,
-                                                                  0x7fffffffffffffff);
-alignas(16) static const __m128i single_qnan_bit = _mm_set_epi64x(0xffffffffffffffff,
-                                                                  0xffffffffffbfffff);
+// Officially, converting doubles that don't fit in a single results in undefined behavior, but
+// testing on actual hardware shows it always picks bits 0..1 and 5..34 unless the exponent is in
+// the range of single denormals (874 to 896). This is what the interpreter's ConvertToSingle and
+// ConvertToSingleFTZ do, so the conversions below are bit exact with them.
+
+alignas(16) static const u64 double_top_two_bits[2] = {0xC000000000000000ULL,
+                                                       0xC000000000000000ULL};
+alignas(16) static const u64 double_bottom_bits[2] = {0x07FFFFFFE0000000ULL,
+                                                      0x07FFFFFFE0000000ULL};
+alignas(16) static const u64 double_fraction[2] = {0x000FFFFFFFFFFFFFULL, 0};
+alignas(16) static const u64 double_explicit_top_bit[2] = {0x0010000000000000ULL, 0};
+alignas(16) static const u64 double_sign_bits[2] = {0x8000000000000000ULL,
+                                                    0x8000000000000000ULL};
+alignas(16) static const u64 double_abs_mask[2] = {0x7FFFFFFFFFFFFFFFULL,
+                                                   0x7FFFFFFFFFFFFFFFULL};
 alignas(16) static const __m128i double_qnan_bit = _mm_set_epi64x(0xffffffffffffffff,
                                                                   0xfff7ffffffffffff);
 
 // Smallest positive double that results in a normalized single.
-alignas(16) static const double min_norm_single = std::numeric_limits<float>::min();
+alignas(16) static const double min_norm_single[2] = {std::numeric_limits<float>::min(),
+                                                      std::numeric_limits<float>::min()};
 
 void EmuCodeBlock::ConvertDoubleToSingle(X64Reg dst, X64Reg src)
 {
-  // Most games have flush-to-zero enabled, which causes the single -> double -> single process here
-  // to be lossy.
-  // This is a problem when games use float operations to copy non-float data.
-  // Changing the FPU mode is very expensive, so we can't do that.
-  // Here, check to see if the source is small enough that it will result in a denormal, and pass it
-  // to the x87 unit
-  // if it is.
-  avx_op(&XEmitter::VPAND, &XEmitter::PAND, XMM0, R(src), M(&double_sign_bit), true, true);
-  UCOMISD(XMM0, M(&min_norm_single));
-  FixupBranch nanConversion = J_CC(CC_P, true);
-  FixupBranch denormalConversion = J_CC(CC_B, true);
-  CVTSD2SS(dst, R(src));
-
-  SwitchToFarCode();
-  SetJumpTarget(nanConversion);
+  // Single denormals are rare, so they're shifted into place in far code.
   MOVQ_xmm(R(RSCRATCH), src);
-  // Put the quiet bit into CF.
-  BT(64, R(RSCRATCH), Imm8(51));
-  CVTSD2SS(dst, R(src));
-  FixupBranch continue1 = J_CC(CC_C, true);
-  // Clear the quiet bit of the SNaN, which was 0 (signalling) but got set to 1 (quiet) by
-  // conversion.
-  ANDPS(dst, M(&single_qnan_bit));
-  FixupBranch continue2 = J(true);
+  SHR(64, R(RSCRATCH), Imm8(52));
+  AND(32, R(RSCRATCH), Imm32(0x7FF));
+  SUB(32, R(RSCRATCH), Imm32(874));
+  CMP(32, R(RSCRATCH), Imm32(896 - 874));
+  FixupBranch denormal = J_CC(CC_BE, true);
+
+  MOVAPD(XMM0, R(src));
+  PAND(XMM0, M(double_top_two_bits));
+  PSRLQ(XMM0, 32);
+  MOVAPD(XMM1, R(src));
+  PAND(XMM1, M(double_bottom_bits));
+  PSRLQ(XMM1, 29);
+  POR(XMM0, R(XMM1));
 
-  SetJumpTarget(denormalConversion);
-  MOVSD(M(&temp64), src);
-  FLD(64, M(&temp64));
-  FSTP(32, M(&temp32));
-  MOVSS(dst, M(&temp32));
-  FixupBranch continue3 = J(true);
+  SwitchToFarCode();
+  SetJumpTarget(denormal);
+  // fraction | 0x0010000000000000, shifted right by (905 - exponent) plus the 21 bit double to
+  // single shift, which is 52 - (exponent - 874)
+  NEG(32, R(RSCRATCH));
+  ADD(32, R(RSCRATCH), Imm8(52));
+  MOVD_xmm(XMM1, R(RSCRATCH));
+  MOVAPD(XMM0, R(src));
+  PAND(XMM0, M(double_fraction));
+  POR(XMM0, M(double_explicit_top_bit));
+  PSRLQ(XMM0, R(XMM1));
+  // OR the sign bit in.
+  MOVAPD(XMM1, R(src));
+  PAND(XMM1, M(double_sign_bits));
+  PSRLQ(XMM1, 32);
+  POR(XMM0, R(XMM1));
+  FixupBranch done = J(true);
   SwitchToNearCode();
 
-  SetJumpTarget(continue1);
-  SetJumpTarget(continue2);
-  SetJumpTarget(continue3);
+  SetJumpTarget(done);
+  if (dst != XMM0)
+    MOVAPD(dst, R(XMM0));
   // We'd normally need to MOVDDUP here to put the single in the top half of the output register
-  // too, but
-  // this function is only used to go directly to a following store, so we omit the MOVDDUP here.
+  // too, but this function is only used to go directly to a following store, so we omit the
+  // MOVDDUP here.
+}
+
+void EmuCodeBlock::ConvertDoubleToSingleFTZ(X64Reg dst, const OpArg& src, bool pair)
+{
+  // Everything below the smallest normal single keeps just its sign. NaNs compare as not less.
+  MOVAPD(XMM1, src);
+  PAND(XMM1, M(double_abs_mask));
+  CMPPD(XMM1, M(min_norm_single), CMP_NLT);
+  POR(XMM1, M(double_sign_bits));
+  PAND(XMM1, src);
+
+  MOVAPD(dst, R(XMM1));
+  PAND(dst, M(double_top_two_bits));
+  PSRLQ(dst, 32);
+  PAND(XMM1, M(double_bottom_bits));
+  PSRLQ(XMM1, 29);
+  POR(dst, R(XMM1));
+  if (pair)
+    PSHUFD(dst, R(dst), 0x08);
 }
-#endif  // MORE_ACCURATE_DOUBLETOSINGLE
 
 // Converting single->double is a bit easier because all single denormals are double normals.
 void EmuCodeBlock::ConvertSingleToDouble(X64Reg dst, X64Reg src, bool src_is_gpr)
@@ -1080,7 +1108,8 @@ void EmuCodeBlock::SetFPRF(Gen::X64Reg xmm)
     continue3 = J();
 
     SetJumpTarget(zeroExponent);
-    PTEST(xmm, R(xmm));
+    // Only look at the fraction, the sign and ps1 don't tell zeroes from denormals
+    PTEST(xmm, M(psDoubleFrac));
     FixupBranch zero = J_CC(CC_Z);
 
     // No exponent + mantissa: sign ? PPC_FPCLASS_ND : PPC_FPCLASS_PD;
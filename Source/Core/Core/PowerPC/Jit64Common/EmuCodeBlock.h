@@ -30,6 +30,13 @@ public:
 
   Gen::FixupBranch CheckIfSafeAddress(const Gen::OpArg& reg_value, Gen::X64Reg reg_addr,
                                       BitSet32 registers_in_use);
+  // Looks reg_addr up in the shadow TLB, which caches page table translations. On a hit,
+  // execution falls through with *host_address pointing to the data; the returned branch is
+  // taken on a miss. Two of RSCRATCH, RSCRATCH2, RSCRATCH_EXTRA and extra_scratch that aren't in
+  // registers_in_use get clobbered. If there aren't two, nothing is emitted and false returned.
+  bool ShadowTLBLookup(Gen::X64Reg reg_addr, int accessSize, bool write,
+                       BitSet32 registers_in_use, Gen::X64Reg extra_scratch,
+                       Gen::OpArg* host_address, Gen::FixupBranch* miss);
   void UnsafeLoadRegToReg(Gen::X64Reg reg_addr, Gen::X64Reg reg_value, int accessSize,
                           s32 offset = 0, bool signExtend = false);
   void UnsafeLoadRegToRegNoSwap(Gen::X64Reg reg_addr, Gen::X64Reg reg_value, int accessSize,
@@ -39,6 +46,8 @@ public:
                            s32 offset = 0, bool swap = true, Gen::MovInfo* info = nullptr);
   void UnsafeWriteRegToReg(Gen::X64Reg reg_value, Gen::X64Reg reg_addr, int accessSize,
                            s32 offset = 0, bool swap = true, Gen::MovInfo* info = nullptr);
+  void UnsafeWriteRegToMem(Gen::OpArg reg_value, const Gen::OpArg& dest, int accessSize,
+                           bool swap = true, Gen::MovInfo* info = nullptr);
 
   bool UnsafeLoadToReg(Gen::X64Reg reg_value, Gen::OpArg opAddress, int accessSize, s32 offset,
                        bool signExtend, Gen::MovInfo* info = nullptr);
@@ -100,7 +109,10 @@ public:
 
   // RSCRATCH might get trashed
   void ConvertSingleToDouble(Gen::X64Reg dst, Gen::X64Reg src, bool src_is_gpr = false);
+  // Both of these trash XMM1, ConvertDoubleToSingle also RSCRATCH and XMM0
   void ConvertDoubleToSingle(Gen::X64Reg dst, Gen::X64Reg src);
+  // Converts ps0, or both halves if pair is set, flushing single denormals to zero
+  void ConvertDoubleToSingleFTZ(Gen::X64Reg dst, const Gen::OpArg& src, bool pair);
   void SetFPRF(Gen::X64Reg xmm);
   void Clear();
 
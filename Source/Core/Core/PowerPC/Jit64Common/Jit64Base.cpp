@@ -72,9 +72,11 @@ bool Jitx86Base::BackPatch(u32 emAddress, SContext* ctx)
   js.trampolineExceptionHandler = exceptionHandler;
 
   // Generate the trampoline.
-  const u8* trampoline = trampolines.GenerateTrampoline(info);
+  const u8* trampoline = GenerateTrampoline(info, codePtr);
   js.generatingTrampoline = false;
   js.trampolineExceptionHandler = nullptr;
+  if (!trampoline)
+    return false;
 
   u8* start = info.start;
 
@@ -126,6 +128,11 @@ bool Jitx86Base::BackPatch(u32 emAddress, SContext* ctx)
   return true;
 }
 
+const u8* Jitx86Base::GenerateTrampoline(const TrampolineInfo& info, const u8* location)
+{
+  return trampolines.GenerateTrampoline(info);
+}
+
 void LogGeneratedX86(size_t size, const PPCAnalyst::CodeBuffer* code_buffer, const u8* normalEntry,
                      const JitBlock* b)
 {
@@ -39,6 +39,10 @@ class Jitx86Base : public JitBase, public QuantizedMemoryRoutines
 {
 protected:
   bool BackPatch(u32 emAddress, SContext* ctx);
+  // Generates the slowmem trampoline for the fastmem access at location. JITs which evict parts
+  // of their code space override this to keep the trampoline with the code that uses it. Returns
+  // null if there is no space left for it.
+  virtual const u8* GenerateTrampoline(const TrampolineInfo& info, const u8* location);
   JitBlockCache blocks{*this};
   TrampolineCache trampolines;
 
@@ -50,7 +50,7 @@ const u8* TrampolineCache::GenerateTrampoline(const TrampolineInfo& info)
 
 const u8* TrampolineCache::GenerateReadTrampoline(const TrampolineInfo& info)
 {
-  if (GetSpaceLeft() < 1024)
+  if (GetSpaceLeft() < MAX_TRAMPOLINE_SIZE)
     PanicAlert("Trampoline cache full");
 
   const u8* trampoline = GetCodePtr();
@@ -66,7 +66,7 @@ const u8* TrampolineCache::GenerateReadTrampoline(const TrampolineInfo& info)
 
 const u8* TrampolineCache::GenerateWriteTrampoline(const TrampolineInfo& info)
 {
-  if (GetSpaceLeft() < 1024)
+  if (GetSpaceLeft() < MAX_TRAMPOLINE_SIZE)
     PanicAlert("Trampoline cache full");
 
   const u8* trampoline = GetCodePtr();
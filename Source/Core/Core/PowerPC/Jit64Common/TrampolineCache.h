@@ -18,6 +18,9 @@ constexpr size_t TRAMPOLINE_CODE_SIZE_MMU = 1024 * 1024 * 32;
 // We need at least this many bytes for backpatching.
 constexpr int BACKPATCH_SIZE = 5;
 
+// No trampoline is bigger than this.
+constexpr size_t MAX_TRAMPOLINE_SIZE = 1024;
+
 class TrampolineCache : public EmuCodeBlock
 {
   const u8* GenerateReadTrampoline(const TrampolineInfo& info);
@@ -741,6 +741,17 @@ void JitArm64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBlock*
         js.firstFPInstructionFound = true;
       }
 
+      // Loads and stores can use immediate addresses when the analyzer knows what their address
+      // registers hold, even if the register cache has lost track of it.
+      if (opinfo->flags & FL_LOADSTORE)
+      {
+        for (int reg : ops[i].regsIn & ops[i].gprIsConstant)
+        {
+          if (!gpr.IsImm(reg))
+            gpr.SetImmediate(reg, code_block.m_gpr_constants[i][reg]);
+        }
+      }
+
       JitArm64Tables::CompileInstruction(ops[i]);
       if (!MergeAllowedNextInstructions(1) || js.op[1].opinfo->type != OPTYPE_INTEGER)
         FlushCarry();
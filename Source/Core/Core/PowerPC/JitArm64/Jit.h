@@ -105,9 +105,7 @@ public:
   void mcrf(UGeckoInstruction inst);
   void mcrxr(UGeckoInstruction inst);
   void mfsr(UGeckoInstruction inst);
-  void mtsr(UGeckoInstruction inst);
   void mfsrin(UGeckoInstruction inst);
-  void mtsrin(UGeckoInstruction inst);
   void twx(UGeckoInstruction inst);
   void mfspr(UGeckoInstruction inst);
   void mftb(UGeckoInstruction inst);
@@ -158,11 +156,12 @@ private:
     BitSet32 gprs;
     BitSet32 fprs;
     u32 flags;
+    bool shadow_tlb;
 
     bool operator<(const SlowmemHandler& rhs) const
     {
-      return std::tie(dest_reg, addr_reg, gprs, fprs, flags) <
-             std::tie(rhs.dest_reg, rhs.addr_reg, rhs.gprs, rhs.fprs, rhs.flags);
+      return std::tie(dest_reg, addr_reg, gprs, fprs, flags, shadow_tlb) <
+             std::tie(rhs.dest_reg, rhs.addr_reg, rhs.gprs, rhs.fprs, rhs.flags, rhs.shadow_tlb);
     }
   };
 
@@ -217,6 +216,12 @@ private:
   void EmitBackpatchRoutine(u32 flags, bool fastmem, bool do_farcode, Arm64Gen::ARM64Reg RS,
                             Arm64Gen::ARM64Reg addr, BitSet32 gprs_to_push = BitSet32(0),
                             BitSet32 fprs_to_push = BitSet32(0));
+  // Emits the access itself, at base + addr
+  void EmitMemoryAccess(u32 flags, Arm64Gen::ARM64Reg RS, Arm64Gen::ARM64Reg addr,
+                        Arm64Gen::ARM64Reg base);
+  bool ShadowTLBLookup(u32 flags, Arm64Gen::ARM64Reg RS, Arm64Gen::ARM64Reg addr,
+                       BitSet32 gprs_in_use, Arm64Gen::ARM64Reg* base,
+                       Arm64Gen::FixupBranch* miss);
   // Loadstore routines
   void SafeLoadToReg(u32 dest, s32 addr, s32 offsetReg, u32 flags, s32 offset, bool update);
   void SafeStoreFromReg(s32 dest, u32 value, s32 regOffset, u32 flags, s32 offset);
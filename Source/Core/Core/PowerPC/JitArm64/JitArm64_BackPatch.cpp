@@ -2,6 +2,7 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <cstddef>
 #include <string>
 
 #include "Common/BitSet.h"
@@ -10,6 +11,7 @@
 #include "Common/Logging/Log.h"
 #include "Common/StringUtil.h"
 
+#include "Core/ConfigManager.h"
 #include "Core/HW/Memmap.h"
 #include "Core/PowerPC/JitArm64/Jit.h"
 #include "Core/PowerPC/JitArmCommon/BackPatch.h"
@@ -44,100 +46,168 @@ static void DoBacktrace(uintptr_t access_address, SContext* ctx)
   ERROR_LOG(DYNA_REC, "Full block: %s", pc_memory.c_str());
 }
 
-void JitArm64::EmitBackpatchRoutine(u32 flags, bool fastmem, bool do_farcode, ARM64Reg RS,
-                                    ARM64Reg addr, BitSet32 gprs_to_push, BitSet32 fprs_to_push)
+void JitArm64::EmitMemoryAccess(u32 flags, ARM64Reg RS, ARM64Reg addr, ARM64Reg base)
 {
-  bool in_far_code = false;
-  const u8* fastmem_start = GetCodePtr();
-
-  if (fastmem)
+  if (flags & BackPatchInfo::FLAG_STORE && flags & BackPatchInfo::FLAG_MASK_FLOAT)
   {
-    if (flags & BackPatchInfo::FLAG_STORE && flags & BackPatchInfo::FLAG_MASK_FLOAT)
+    if (flags & BackPatchInfo::FLAG_SIZE_F32)
     {
-      if (flags & BackPatchInfo::FLAG_SIZE_F32)
-      {
-        m_float_emit.FCVT(32, 64, D0, RS);
-        m_float_emit.REV32(8, D0, D0);
-        m_float_emit.STR(32, D0, MEM_REG, addr);
-      }
-      else if (flags & BackPatchInfo::FLAG_SIZE_F32I)
-      {
-        m_float_emit.REV32(8, D0, RS);
-        m_float_emit.STR(32, D0, MEM_REG, addr);
-      }
-      else if (flags & BackPatchInfo::FLAG_SIZE_F32X2)
-      {
-        m_float_emit.FCVTN(32, D0, RS);
-        m_float_emit.REV32(8, D0, D0);
-        m_float_emit.STR(64, Q0, MEM_REG, addr);
-      }
-      else if (flags & BackPatchInfo::FLAG_SIZE_F32X2I)
-      {
-        m_float_emit.REV32(8, D0, RS);
-        m_float_emit.STR(64, Q0, MEM_REG, addr);
-      }
-      else
-      {
-        m_float_emit.REV64(8, Q0, RS);
-        m_float_emit.STR(64, Q0, MEM_REG, addr);
-      }
+      m_float_emit.FCVT(32, 64, D0, RS);
+      m_float_emit.REV32(8, D0, D0);
+      m_float_emit.STR(32, D0, base, addr);
     }
-    else if (flags & BackPatchInfo::FLAG_LOAD && flags & BackPatchInfo::FLAG_MASK_FLOAT)
+    else if (flags & BackPatchInfo::FLAG_SIZE_F32I)
     {
-      if (flags & BackPatchInfo::FLAG_SIZE_F32)
-      {
-        m_float_emit.LDR(32, EncodeRegToDouble(RS), MEM_REG, addr);
-        m_float_emit.REV32(8, EncodeRegToDouble(RS), EncodeRegToDouble(RS));
-      }
-      else
-      {
-        m_float_emit.LDR(64, EncodeRegToDouble(RS), MEM_REG, addr);
-        m_float_emit.REV64(8, EncodeRegToDouble(RS), EncodeRegToDouble(RS));
-      }
+      m_float_emit.REV32(8, D0, RS);
+      m_float_emit.STR(32, D0, base, addr);
     }
-    else if (flags & BackPatchInfo::FLAG_STORE)
+    else if (flags & BackPatchInfo::FLAG_SIZE_F32X2)
     {
-      ARM64Reg temp = W0;
-      if (flags & BackPatchInfo::FLAG_SIZE_32)
-        REV32(temp, RS);
-      else if (flags & BackPatchInfo::FLAG_SIZE_16)
-        REV16(temp, RS);
-
-      if (flags & BackPatchInfo::FLAG_SIZE_32)
-        STR(temp, MEM_REG, addr);
-      else if (flags & BackPatchInfo::FLAG_SIZE_16)
-        STRH(temp, MEM_REG, addr);
-      else
-        STRB(RS, MEM_REG, addr);
+      m_float_emit.FCVTN(32, D0, RS);
+      m_float_emit.REV32(8, D0, D0);
+      m_float_emit.STR(64, Q0, base, addr);
     }
-    else if (flags & BackPatchInfo::FLAG_ZERO_256)
+    else if (flags & BackPatchInfo::FLAG_SIZE_F32X2I)
     {
-      // This literally only stores 32bytes of zeros to the target address
-      ADD(addr, addr, MEM_REG);
-      STP(INDEX_SIGNED, ZR, ZR, addr, 0);
-      STP(INDEX_SIGNED, ZR, ZR, addr, 16);
+      m_float_emit.REV32(8, D0, RS);
+      m_float_emit.STR(64, Q0, base, addr);
     }
     else
+    {
+      m_float_emit.REV64(8, Q0, RS);
+      m_float_emit.STR(64, Q0, base, addr);
+    }
+  }
+  else if (flags & BackPatchInfo::FLAG_LOAD && flags & BackPatchInfo::FLAG_MASK_FLOAT)
+  {
+    if (flags & BackPatchInfo::FLAG_SIZE_F32)
+    {
+      m_float_emit.LDR(32, EncodeRegToDouble(RS), base, addr);
+      m_float_emit.REV32(8, EncodeRegToDouble(RS), EncodeRegToDouble(RS));
+    }
+    else
+    {
+      m_float_emit.LDR(64, EncodeRegToDouble(RS), base, addr);
+      m_float_emit.REV64(8, EncodeRegToDouble(RS), EncodeRegToDouble(RS));
+    }
+  }
+  else if (flags & BackPatchInfo::FLAG_STORE)
+  {
+    ARM64Reg temp = W0;
+    if (flags & BackPatchInfo::FLAG_SIZE_32)
+      REV32(temp, RS);
+    else if (flags & BackPatchInfo::FLAG_SIZE_16)
+      REV16(temp, RS);
+
+    if (flags & BackPatchInfo::FLAG_SIZE_32)
+      STR(temp, base, addr);
+    else if (flags & BackPatchInfo::FLAG_SIZE_16)
+      STRH(temp, base, addr);
+    else
+      STRB(RS, base, addr);
+  }
+  else if (flags & BackPatchInfo::FLAG_ZERO_256)
+  {
+    // This literally only stores 32bytes of zeros to the target address
+    ADD(addr, addr, base);
+    STP(INDEX_SIGNED, ZR, ZR, addr, 0);
+    STP(INDEX_SIGNED, ZR, ZR, addr, 16);
+  }
+  else
+  {
+    if (flags & BackPatchInfo::FLAG_SIZE_32)
+      LDR(RS, base, addr);
+    else if (flags & BackPatchInfo::FLAG_SIZE_16)
+      LDRH(RS, base, addr);
+    else if (flags & BackPatchInfo::FLAG_SIZE_8)
+      LDRB(RS, base, addr);
+
+    if (!(flags & BackPatchInfo::FLAG_REVERSE))
     {
       if (flags & BackPatchInfo::FLAG_SIZE_32)
-        LDR(RS, MEM_REG, addr);
+        REV32(RS, RS);
       else if (flags & BackPatchInfo::FLAG_SIZE_16)
-        LDRH(RS, MEM_REG, addr);
-      else if (flags & BackPatchInfo::FLAG_SIZE_8)
-        LDRB(RS, MEM_REG, addr);
+        REV16(RS, RS);
+    }
 
-      if (!(flags & BackPatchInfo::FLAG_REVERSE))
-      {
-        if (flags & BackPatchInfo::FLAG_SIZE_32)
-          REV32(RS, RS);
-        else if (flags & BackPatchInfo::FLAG_SIZE_16)
-          REV16(RS, RS);
-      }
+    if (flags & BackPatchInfo::FLAG_EXTEND)
+      SXTH(RS, RS);
+  }
+}
 
-      if (flags & BackPatchInfo::FLAG_EXTEND)
-        SXTH(RS, RS);
+// Looks the address up in the data shadow TLB. On a hit, this falls through with *base set so
+// that base + addr is the host address to access, and otherwise branches to *miss.
+bool JitArm64::ShadowTLBLookup(u32 flags, ARM64Reg RS, ARM64Reg addr, BitSet32 gprs_in_use,
+                               ARM64Reg* base, FixupBranch* miss)
+{
+  static_assert(sizeof(PowerPC::ShadowTLBEntry) == 16, "The lookup scales the index by 16");
+  constexpr int INDEX_BITS = 12;
+  static_assert(PowerPC::SHADOW_TLB_SIZE == 1 << INDEX_BITS, "The lookup extracts 12 index bits");
+
+  if (flags & BackPatchInfo::FLAG_ZERO_256)
+    return false;
+  u32 access_bytes = BackPatchInfo::GetFlagSize(flags) / 8;
+  if (flags & (BackPatchInfo::FLAG_SIZE_F32X2 | BackPatchInfo::FLAG_SIZE_F32X2I))
+    access_bytes = 8;
+  if (access_bytes == 0)
+    return false;
+
+  // The slow path clobbers every caller saved register that isn't pushed, so those are free.
+  // W0 is left alone since stores use it as a temporary.
+  ARM64Reg scratch[3];
+  size_t num_scratch = 0;
+  for (int i = 1; i < 18 && num_scratch < 3; ++i)
+  {
+    const ARM64Reg reg = static_cast<ARM64Reg>(W0 + i);
+    if (!gprs_in_use[i] && reg != DecodeReg(addr) &&
+        ((flags & BackPatchInfo::FLAG_MASK_FLOAT) || reg != DecodeReg(RS)))
+    {
+      scratch[num_scratch++] = reg;
     }
   }
+  if (num_scratch < 3)
+    return false;
+
+  const ARM64Reg entry = EncodeRegTo64(scratch[0]);
+  const ARM64Reg tag = scratch[1];
+  const ARM64Reg entry_value = scratch[2];
+  const u32 page_mask = (1 << HW_PAGE_INDEX_SHIFT) - 1;
+  const u32 tag_offset = (flags & BackPatchInfo::FLAG_STORE) ?
+                             offsetof(PowerPC::ShadowTLBEntry, write_tag) :
+                             offsetof(PowerPC::ShadowTLBEntry, read_tag);
+
+  UBFX(tag, DecodeReg(addr), HW_PAGE_INDEX_SHIFT, INDEX_BITS);
+  MOVP2R(entry, &PowerPC::shadow_dtlb[0]);
+  ADD(entry, entry, EncodeRegTo64(tag), ArithOption(EncodeRegTo64(tag), ST_LSL, 4));
+  LDR(INDEX_UNSIGNED, entry_value, entry, tag_offset);
+
+  // Keeping the low bits of the address makes unaligned accesses, which might cross into the
+  // next page, miss.
+  ANDI2R(tag, DecodeReg(addr), ~page_mask | (access_bytes - 1));
+  CMP(tag, entry_value);
+  *miss = B(CC_NEQ);
+
+  // On a hit, tag is the address of the page
+  LDR(INDEX_UNSIGNED, entry_value, entry, offsetof(PowerPC::ShadowTLBEntry, paddr));
+  MOVP2R(entry, Memory::physical_base);
+  ADD(entry, entry, EncodeRegTo64(entry_value));
+  SUB(entry, entry, EncodeRegTo64(tag));
+  *base = entry;
+  return true;
+}
+
+void JitArm64::EmitBackpatchRoutine(u32 flags, bool fastmem, bool do_farcode, ARM64Reg RS,
+                                    ARM64Reg addr, BitSet32 gprs_to_push, BitSet32 fprs_to_push)
+{
+  bool in_far_code = false;
+  const u8* fastmem_start = GetCodePtr();
+  // Like in Jit64, this is also how the slow path avoids calling into the MMU code for most page
+  // table accesses
+  const bool use_shadow_tlb =
+      UReg_MSR(MSR).DR && SConfig::GetInstance().bMMU && !jo.alwaysUseMemFuncs;
+
+  if (fastmem)
+    EmitMemoryAccess(flags, RS, addr, MEM_REG);
   const u8* fastmem_end = GetCodePtr();
 
   if (!fastmem || do_farcode)
@@ -150,6 +220,7 @@ void JitArm64::EmitBackpatchRoutine(u32 flags, bool fastmem, bool do_farcode, AR
       handler.gprs = gprs_to_push;
       handler.fprs = fprs_to_push;
       handler.flags = flags;
+      handler.shadow_tlb = use_shadow_tlb;
 
       FastmemArea* fastmem_area = &m_fault_to_handler[fastmem_start];
       auto handler_loc_iter = m_handler_to_loc.find(handler);
@@ -172,6 +243,18 @@ void JitArm64::EmitBackpatchRoutine(u32 flags, bool fastmem, bool do_farcode, AR
       }
     }
 
+    FixupBranch shadow_tlb_miss, shadow_tlb_exit;
+    ARM64Reg shadow_tlb_base;
+    const bool shadow_tlb =
+        use_shadow_tlb &&
+        ShadowTLBLookup(flags, RS, addr, gprs_to_push, &shadow_tlb_base, &shadow_tlb_miss);
+    if (shadow_tlb)
+    {
+      EmitMemoryAccess(flags, RS, addr, shadow_tlb_base);
+      shadow_tlb_exit = B();
+      SetJumpTarget(shadow_tlb_miss);
+    }
+
     ABI_PushRegisters(gprs_to_push);
     m_float_emit.ABI_PushRegisters(fprs_to_push, X30);
 
@@ -274,6 +357,9 @@ void JitArm64::EmitBackpatchRoutine(u32 flags, bool fastmem, bool do_farcode, AR
 
     m_float_emit.ABI_PopRegisters(fprs_to_push, X30);
     ABI_PopRegisters(gprs_to_push);
+
+    if (shadow_tlb)
+      SetJumpTarget(shadow_tlb_exit);
   }
 
   if (in_far_code)
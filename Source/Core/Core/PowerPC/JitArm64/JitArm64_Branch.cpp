@@ -105,7 +105,7 @@ void JitArm64::bx(UGeckoInstruction inst)
   gpr.Flush(FlushMode::FLUSH_ALL);
   fpr.Flush(FlushMode::FLUSH_ALL);
 
-  if (destination == js.compilerPC)
+  if (destination == js.compilerPC || js.op->branchIsIdleLoop)
   {
     // make idle loops go faster
     ARM64Reg WA = gpr.GetReg();
@@ -115,7 +115,7 @@ void JitArm64::bx(UGeckoInstruction inst)
     BLR(XA);
     gpr.Unlock(WA);
 
-    WriteExceptionExit(js.compilerPC);
+    WriteExceptionExit(destination);
     return;
   }
 
@@ -169,7 +169,21 @@ void JitArm64::bcx(UGeckoInstruction inst)
   gpr.Flush(FlushMode::FLUSH_MAINTAIN_STATE);
   fpr.Flush(FlushMode::FLUSH_MAINTAIN_STATE);
 
-  WriteExit(destination, inst.LK, js.compilerPC + 4);
+  if (js.op->branchIsIdleLoop)
+  {
+    // Going around the loop again would only read the same values, so wait for the next event
+    ARM64Reg WB = gpr.GetReg();
+    ARM64Reg XB = EncodeRegTo64(WB);
+    MOVP2R(XB, &CoreTiming::Idle);
+    BLR(XB);
+    gpr.Unlock(WB);
+
+    WriteExceptionExit(destination);
+  }
+  else
+  {
+    WriteExit(destination, inst.LK, js.compilerPC + 4);
+  }
 
   SwitchToNearCode();
 
@@ -17,6 +17,10 @@ using namespace Arm64Gen;
 
 void JitArm64::ComputeRC(ARM64Reg reg, int crf, bool needs_sext)
 {
+  // Skip the update if nothing reads the field before it's overwritten
+  if ((crf == 0 && !js.op->wantsCR0) || (crf == 1 && !js.op->wantsCR1))
+    return;
+
   if (needs_sext)
   {
     ARM64Reg WA = gpr.GetReg();
@@ -35,6 +39,9 @@ void JitArm64::ComputeRC(ARM64Reg reg, int crf, bool needs_sext)
 
 void JitArm64::ComputeRC(u64 imm, int crf, bool needs_sext)
 {
+  if ((crf == 0 && !js.op->wantsCR0) || (crf == 1 && !js.op->wantsCR1))
+    return;
+
   ARM64Reg WA = gpr.GetReg();
   ARM64Reg XA = EncodeRegTo64(WA);
 
@@ -63,6 +63,8 @@ protected:
     int downcountAmount;
     u32 numLoadStoreInst;
     u32 numFloatingPointInst;
+    // Instructions that are compiled as calls to the interpreter
+    u32 numFallbackInst;
     // If this is set, we need to generate an exception handler for the fastmem load.
     u8* fastmemLoadStore;
     // If this is set, a load or store already prepared a jump to the exception handler for us,
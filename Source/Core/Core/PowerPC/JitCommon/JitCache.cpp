@@ -10,17 +10,20 @@
 // locating performance issues.
 
 #include <algorithm>
+#include <cinttypes>
 #include <cstring>
 #include <map>
 #include <utility>
 
 #include "Common/CommonTypes.h"
 #include "Common/JitRegister.h"
+#include "Common/Logging/Log.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
 #include "Core/PowerPC/JitInterface.h"
+#include "Core/PowerPC/PPCAnalyst.h"
 #include "Core/PowerPC/PowerPC.h"
 
 #ifdef _WIN32
@@ -36,6 +39,15 @@ static void ClearCacheThreadSafe(u64 userdata, s64 cyclesdata)
   JitInterface::ClearCache();
 }
 
+// FNV-1a over the addresses and instructions of a block.
+constexpr u64 CODE_HASH_INITIAL = 0xcbf29ce484222325;
+
+static u64 HashInstruction(u64 hash, u32 address, u32 inst)
+{
+  hash = (hash ^ address) * 0x100000001b3;
+  return (hash ^ inst) * 0x100000001b3;
+}
+
 bool JitBlock::OverlapsPhysicalRange(u32 address, u32 length) const
 {
   return physical_addresses.lower_bound(address) !=
@@ -58,6 +70,13 @@ void JitBaseBlockCache::Init()
 
 void JitBaseBlockCache::Shutdown()
 {
+  if (page_versions)
+  {
+    INFO_LOG(DYNA_REC, "Page versioning: %" PRIu64 " page invalidations, %" PRIu64
+                       " blocks reused unchanged, %" PRIu64 " blocks recompiled",
+             m_num_page_invalidations, m_num_revalidated_blocks, m_num_stale_blocks);
+  }
+
   JitRegister::Shutdown();
 }
 
@@ -146,6 +165,19 @@ void JitBaseBlockCache::FinalizeBlock(JitBlock& block, bool block_link,
   JitRegister::Register(block.checkedEntry, block.codeSize, "JIT_PPC_%08x", block.physicalAddress);
 }
 
+void JitBaseBlockCache::SetBlockCode(JitBlock& block, const PPCAnalyst::CodeBuffer& code_buffer,
+                                     u32 num_instructions)
+{
+  block.instructionAddresses.clear();
+  block.codeHash = CODE_HASH_INITIAL;
+  for (u32 i = 0; i < num_instructions; i++)
+  {
+    const PPCAnalyst::CodeOp& op = code_buffer.codebuffer[i];
+    block.instructionAddresses.push_back(op.address);
+    block.codeHash = HashInstruction(block.codeHash, op.address, op.inst.hex);
+  }
+}
+
 JitBlock* JitBaseBlockCache::GetBlockFromStartAddress(u32 addr, u32 msr)
 {
   u32 translated_addr = addr;
@@ -190,20 +222,38 @@ void JitBaseBlockCache::InvalidateICache(u32 address, u32 length, bool forced)
     return;
   u32 pAddr = translated.address;
 
+  // Forced invalidations don't change the code, but how it has to be compiled (e.g. breakpoints),
+  // so they can't rely on the code hash and always destroy the blocks.
+  const bool bump_page_versions = page_versions && !forced;
+
   // Optimize the common case of length == 32 which is used by Interpreter::dcb*
   bool destroy_block = true;
   if (length == 32)
   {
     if (!valid_block.Test(pAddr / 32))
       destroy_block = false;
-    else
+    else if (!bump_page_versions)
       valid_block.Clear(pAddr / 32);
   }
 
   if (destroy_block)
   {
-    // destroy JIT blocks
-    ErasePhysicalRange(pAddr, length);
+    if (bump_page_versions)
+    {
+      // The blocks notice this on their next entry and are only recompiled if their code
+      // actually changed.
+      const u64 end = static_cast<u64>(pAddr) + std::max<u32>(length, 1) - 1;
+      for (u64 page = pAddr >> PAGE_VERSION_SHIFT; page <= end >> PAGE_VERSION_SHIFT; page++)
+      {
+        page_versions[page]++;
+        m_num_page_invalidations++;
+      }
+    }
+    else
+    {
+      // destroy JIT blocks
+      ErasePhysicalRange(pAddr, length);
+    }
 
     // If the code was actually modified, we need to clear the relevant entries from the
     // FIFO write address cache, so we don't end up with FIFO checks in places they shouldn't
@@ -260,15 +310,94 @@ void JitBaseBlockCache::ErasePhysicalRange(u32 address, u32 length)
   }
 }
 
+size_t JitBaseBlockCache::EraseBlocks(std::function<bool(const JitBlock&)> predicate)
+{
+  size_t erased = 0;
+  auto iter = block_map.begin();
+  while (iter != block_map.end())
+  {
+    JitBlock& block = iter->second;
+    if (!predicate(block))
+    {
+      iter++;
+      continue;
+    }
+
+    // The valid_block bits are kept, they only cause a spurious lookup on the next invalidation
+    // of these addresses.
+    RemoveBlockFromRangeMap(block);
+    DestroyBlock(block);
+    iter = block_map.erase(iter);
+    erased++;
+  }
+
+  return erased;
+}
+
 u32* JitBaseBlockCache::GetBlockBitSet() const
 {
   return valid_block.m_valid_block.get();
 }
 
+void JitBaseBlockCache::EnablePageVersioning()
+{
+  if (!page_versions)
+    page_versions.reset(new u32[PAGE_VERSION_ELEMENTS]());
+}
+
+u32* JitBaseBlockCache::GetPageVersion(u32 physical_address) const
+{
+  return &page_versions[physical_address >> PAGE_VERSION_SHIFT];
+}
+
+bool JitBaseBlockCache::RevalidateBlock(JitBlock& block)
+{
+  // Read the instructions like the analyzer did, so that they come from the instruction cache if
+  // it is enabled. That is what the CPU would run, even if memory changed behind its back.
+  u64 hash = CODE_HASH_INITIAL;
+  bool valid = true;
+  for (u32 address : block.instructionAddresses)
+  {
+    const PowerPC::TryReadInstResult result = PowerPC::TryReadInstruction(address);
+    if (!result.valid)
+    {
+      valid = false;
+      break;
+    }
+    hash = HashInstruction(hash, address, result.hex);
+  }
+
+  if (valid && hash == block.codeHash)
+  {
+    for (const auto& check : block.pageVersionChecks)
+      WritePageVersionCheck(check, page_versions[check.page]);
+    m_num_revalidated_blocks++;
+    return true;
+  }
+
+  m_num_stale_blocks++;
+  RemoveBlockFromRangeMap(block);
+  DestroyBlock(block);
+  auto range = block_map.equal_range(block.physicalAddress);
+  for (auto iter = range.first; iter != range.second; ++iter)
+  {
+    if (&iter->second == &block)
+    {
+      block_map.erase(iter);
+      break;
+    }
+  }
+  return false;
+}
+
 void JitBaseBlockCache::WriteDestroyBlock(const JitBlock& block)
 {
 }
 
+void JitBaseBlockCache::WritePageVersionCheck(const JitBlock::PageVersionCheck& check, u32 version)
+{
+}
+
 // Block linker
 // Make sure to have as many blocks as possible compiled before calling this
 // It's O(N), so it's fast :)
@@ -349,6 +478,20 @@ void JitBaseBlockCache::DestroyBlock(JitBlock& block)
   WriteDestroyBlock(block);
 }
 
+void JitBaseBlockCache::RemoveBlockFromRangeMap(JitBlock& block)
+{
+  u32 range_mask = ~(BLOCK_RANGE_MAP_ELEMENTS - 1);
+  for (u32 addr : block.physical_addresses)
+  {
+    auto range = block_range_map.find(addr & range_mask);
+    if (range == block_range_map.end())
+      continue;
+    range->second.erase(&block);
+    if (range->second.empty())
+      block_range_map.erase(range);
+  }
+}
+
 JitBlock* JitBaseBlockCache::MoveBlockIntoFastCache(u32 addr, u32 msr)
 {
   JitBlock* block = GetBlockFromStartAddress(addr, msr);
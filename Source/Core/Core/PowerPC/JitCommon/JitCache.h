@@ -17,6 +17,11 @@
 
 class JitBase;
 
+namespace PPCAnalyst
+{
+class CodeBuffer;
+}
+
 // A JitBlock is block of compiled code which corresponds to the PowerPC
 // code at a given address.
 //
@@ -50,6 +55,12 @@ struct JitBlock
   // useful for logging.
   u32 originalSize;
   int runCount;  // for profiling.
+  // The number of guest registers the register allocator had to write back to make room for
+  // others while compiling this block. Only Jit64 counts these.
+  u32 spillCount;
+  // How often the downcount ran out on entry to this block. This is a cheap sample of how much
+  // time is spent in the block; Jit64 uses it to pick the code to evict when its cache is full.
+  u32 timingSamples;
 
   // Information about exits to a known address from this block.
   // This is used to implement block linking.
@@ -62,6 +73,20 @@ struct JitBlock
   };
   std::vector<LinkData> linkData;
 
+  // Checks of the versions of the code pages this block was compiled from, emitted at its entry
+  // if the block cache uses page versioning.
+  struct PageVersionCheck
+  {
+    u8* location;  // to be able to rewrite the expected version
+    u32 page;
+  };
+  std::vector<PageVersionCheck> pageVersionChecks;
+  // The addresses and a hash of the instructions the block was compiled from. If reading them
+  // again gives the same hash after the pages were invalidated, the block is kept instead of being
+  // recompiled.
+  std::vector<u32> instructionAddresses;
+  u64 codeHash;
+
   // This set stores all physical addresses of all occupied instructions.
   std::set<u32> physical_addresses;
 
@@ -118,6 +143,10 @@ public:
   static constexpr u32 FAST_BLOCK_MAP_ELEMENTS = 0x10000;
   static constexpr u32 FAST_BLOCK_MAP_MASK = FAST_BLOCK_MAP_ELEMENTS - 1;
 
+  // Page versioning tracks invalidations per 4 KiB physical page.
+  static constexpr u32 PAGE_VERSION_SHIFT = 12;
+  static constexpr u32 PAGE_VERSION_ELEMENTS = 1u << (32 - PAGE_VERSION_SHIFT);
+
   explicit JitBaseBlockCache(JitBase& jit);
   virtual ~JitBaseBlockCache();
 
@@ -133,6 +162,9 @@ public:
 
   JitBlock* AllocateBlock(u32 em_address);
   void FinalizeBlock(JitBlock& block, bool block_link, const std::set<u32>& physical_addresses);
+  // Remembers the instructions a block was compiled from, for RevalidateBlock.
+  void SetBlockCode(JitBlock& block, const PPCAnalyst::CodeBuffer& code_buffer,
+                    u32 num_instructions);
 
   // Look for the block in the slow but accurate way.
   // This function shall be used if FastLookupIndexForAddress() failed.
@@ -147,20 +179,33 @@ public:
 
   void InvalidateICache(u32 address, u32 length, bool forced);
   void ErasePhysicalRange(u32 address, u32 length);
+  // Destroys and unlinks all blocks for which the predicate returns true, e.g. to evict a part of
+  // the code space. Returns the number of blocks erased.
+  size_t EraseBlocks(std::function<bool(const JitBlock&)> predicate);
 
   u32* GetBlockBitSet() const;
 
+  // With page versioning, invalidating code only bumps the versions of its pages, and blocks
+  // compare the versions of their pages on entry. This is for JITs which emit these checks.
+  void EnablePageVersioning();
+  u32* GetPageVersion(u32 physical_address) const;
+  // Called by a block whose page versions didn't match. Returns true if its code is unchanged
+  // and it can keep running; otherwise the block is destroyed.
+  bool RevalidateBlock(JitBlock& block);
+
 protected:
   JitBase& m_jit;
 
 private:
   virtual void WriteLinkBlock(const JitBlock::LinkData& source, const JitBlock* dest) = 0;
   virtual void WriteDestroyBlock(const JitBlock& block);
+  virtual void WritePageVersionCheck(const JitBlock::PageVersionCheck& check, u32 version);
 
   void LinkBlockExits(JitBlock& block);
   void LinkBlock(JitBlock& block);
   void UnlinkBlock(const JitBlock& block);
   void DestroyBlock(JitBlock& block);
+  void RemoveBlockFromRangeMap(JitBlock& block);
 
   JitBlock* MoveBlockIntoFastCache(u32 em_address, u32 msr);
 
@@ -188,4 +233,10 @@ private:
   // This array is indexed with the masked PC and likely holds the correct block id.
   // This is used as a fast cache of block_map used in the assembly dispatcher.
   std::array<JitBlock*, FAST_BLOCK_MAP_ELEMENTS> fast_block_map;  // start_addr & mask -> number
+
+  // The number of invalidations of each physical page, if page versioning is enabled.
+  std::unique_ptr<u32[]> page_versions;
+  u64 m_num_page_invalidations = 0;
+  u64 m_num_revalidated_blocks = 0;
+  u64 m_num_stale_blocks = 0;
 };
@@ -106,6 +106,13 @@ struct TranslateAddressResult
 };
 template <const XCheckTLBFlag flag>
 static TranslateAddressResult TranslateAddress(const u32 address);
+static void ScanPageTable();
+static void UpdatePageTableMappingsAfterTLBIE(u32 address);
+
+#ifndef _ARCH_32
+// Set when pages might have to be mirrored that the last scan of the page table didn't mirror
+static bool s_page_table_scan_pending = false;
+#endif
 
 // Nasty but necessary. Super Mario Galaxy pointer relies on this stuff.
 static u32 EFB_Read(const u32 addr)
@@ -159,6 +166,8 @@ static void EFB_Write(u32 data, u32 addr)
 
 BatTable ibat_table;
 BatTable dbat_table;
+ShadowTLB shadow_dtlb;
+ShadowTLB shadow_itlb;
 
 static void GenerateDSIException(u32 _EffectiveAddress, bool _bWrite);
 
@@ -935,6 +944,9 @@ static void GenerateISIException(u32 _EffectiveAddress)
 
 void SDRUpdated()
 {
+  shadow_dtlb = {};
+  shadow_itlb = {};
+
   u32 htabmask = SDR1_HTABMASK(PowerPC::ppcState.spr[SPR_SDR]);
   u32 x = 1;
   u32 xx = 0;
@@ -954,8 +966,54 @@ void SDRUpdated()
   {
     return;
   }
-  PowerPC::ppcState.pagetable_base = htaborg << 16;
-  PowerPC::ppcState.pagetable_hashmask = ((xx << 10) | 0x3ff);
+  const u32 pagetable_base = htaborg << 16;
+  const u32 pagetable_hashmask = ((xx << 10) | 0x3ff);
+  if (pagetable_base == PowerPC::ppcState.pagetable_base &&
+      pagetable_hashmask == PowerPC::ppcState.pagetable_hashmask)
+  {
+    return;
+  }
+  PowerPC::ppcState.pagetable_base = pagetable_base;
+  PowerPC::ppcState.pagetable_hashmask = pagetable_hashmask;
+
+#ifndef _ARCH_32
+  // Every mirrored page came from the old table
+  Memory::ClearPageTableMappings();
+  s_page_table_scan_pending = true;
+#endif
+}
+
+void SRUpdated(int index)
+{
+  // The shadow TLBs are only tagged with the effective address
+  shadow_dtlb = {};
+  shadow_itlb = {};
+
+#ifndef _ARCH_32
+  // Only the pages in this segment can be mapped differently now
+  const u32 segment_start = static_cast<u32>(index) << 28;
+  Memory::RemovePageTableMappings(segment_start, segment_start | 0x0FFFFFFF);
+  s_page_table_scan_pending = true;
+#endif
+}
+
+void PageTableMappingsInvalidated()
+{
+#ifndef _ARCH_32
+  Memory::ClearPageTableMappings();
+  s_page_table_scan_pending = true;
+#endif
+}
+
+void ScanPageTableIfChanged()
+{
+#ifndef _ARCH_32
+  if (!s_page_table_scan_pending)
+    return;
+
+  s_page_table_scan_pending = false;
+  ScanPageTable();
+#endif
 }
 
 enum TLBLookupResult
@@ -965,6 +1023,33 @@ enum TLBLookupResult
   TLB_UPDATE_C
 };
 
+// Whether the JITs can access a physical page through Memory::physical_base
+static bool IsPageInPhysicalBase(u32 paddr)
+{
+  if (paddr < Memory::RAM_SIZE)
+    return true;
+  if (Memory::m_pEXRAM && (paddr >> 28) == 0x1 && (paddr & 0x0FFFFFFF) < Memory::EXRAM_SIZE)
+    return true;
+  return (paddr >> 28) == 0xE && paddr < 0xE0000000 + Memory::L1_CACHE_SIZE;
+}
+
+static void UpdateShadowTLBEntry(const XCheckTLBFlag flag, UPTE2 PTE2, const u32 address)
+{
+  if (IsNoExceptionFlag(flag) || !PTE2.R)
+    return;
+
+  const u32 paddr = PTE2.RPN << HW_PAGE_INDEX_SHIFT;
+  if (!IsOpcodeFlag(flag) && !IsPageInPhysicalBase(paddr))
+    return;
+
+  const u32 page = address & ~(HW_PAGE_SIZE - 1);
+  ShadowTLBEntry& entry = (IsOpcodeFlag(flag) ? shadow_itlb : shadow_dtlb)[(
+      address >> HW_PAGE_INDEX_SHIFT) & (SHADOW_TLB_SIZE - 1)];
+  entry.read_tag = page;
+  entry.write_tag = !IsOpcodeFlag(flag) && PTE2.C ? page : SHADOW_TLB_TAG_INVALID;
+  entry.paddr = paddr;
+}
+
 static TLBLookupResult LookupTLBPageAddress(const XCheckTLBFlag flag, const u32 vpa, u32* paddr)
 {
   u32 tag = vpa >> HW_PAGE_INDEX_SHIFT;
@@ -987,6 +1072,9 @@ static TLBLookupResult LookupTLBPageAddress(const XCheckTLBFlag flag, const u32
     if (!IsNoExceptionFlag(flag))
       tlbe->recent = 0;
 
+    UPTE2 PTE2;
+    PTE2.Hex = tlbe->pte[0];
+    UpdateShadowTLBEntry(flag, PTE2, vpa);
     *paddr = tlbe->paddr[0] | (vpa & 0xfff);
 
     return TLB_FOUND;
@@ -1009,6 +1097,9 @@ static TLBLookupResult LookupTLBPageAddress(const XCheckTLBFlag flag, const u32
     if (!IsNoExceptionFlag(flag))
       tlbe->recent = 1;
 
+    UPTE2 PTE2;
+    PTE2.Hex = tlbe->pte[1];
+    UpdateShadowTLBEntry(flag, PTE2, vpa);
     *paddr = tlbe->paddr[1] | (vpa & 0xfff);
 
     return TLB_FOUND;
@@ -1040,6 +1131,51 @@ void InvalidateTLBEntry(u32 address)
       &PowerPC::ppcState.tlb[1][(address >> HW_PAGE_INDEX_SHIFT) & HW_PAGE_INDEX_MASK];
   tlbe_i->tag[0] = TLB_TAG_INVALID;
   tlbe_i->tag[1] = TLB_TAG_INVALID;
+
+  // The segment isn't part of the index, so this is the page's entry in every segment
+  const u32 shadow_index = (address >> HW_PAGE_INDEX_SHIFT) & (SHADOW_TLB_SIZE - 1);
+  shadow_dtlb[shadow_index] = {};
+  shadow_itlb[shadow_index] = {};
+
+#ifndef _ARCH_32
+  UpdatePageTableMappingsAfterTLBIE(address);
+#endif
+}
+
+// Searches the page table for the entry that maps an effective address in the segment described
+// by sr, and returns the physical address of the entry.
+static bool LookupPTE(const u32 address, const u32 sr, u32* pte_addr)
+{
+  u32 page_index = EA_PageIndex(address);  // 16 bit
+  u32 VSID = SR_VSID(sr);                  // 24 bit
+  u32 api = EA_API(address);               //  6 bit (part of page_index)
+
+  // hash function no 1 "xor" .360
+  u32 hash = (VSID ^ page_index);
+  u32 pte1 = bswap((VSID << 7) | api | PTE1_V);
+
+  for (int hash_func = 0; hash_func < 2; hash_func++)
+  {
+    // hash function no 2 "not" .360
+    if (hash_func == 1)
+    {
+      hash = ~hash;
+      pte1 |= PTE1_H << 24;
+    }
+
+    u32 pteg_addr =
+        ((hash & PowerPC::ppcState.pagetable_hashmask) << 6) | PowerPC::ppcState.pagetable_base;
+
+    for (int i = 0; i < 8; i++, pteg_addr += 8)
+    {
+      if (pte1 == *(u32*)&Memory::physical_base[pteg_addr])
+      {
+        *pte_addr = pteg_addr;
+        return true;
+      }
+    }
+  }
+  return false;
 }
 
 // Page Address Translation
@@ -1065,65 +1201,146 @@ static TranslateAddressResult TranslatePageAddress(const u32 address, const XChe
   if ((flag == FLAG_OPCODE || flag == FLAG_OPCODE_NO_EXCEPTION) && (sr & 0x10000000))
     return TranslateAddressResult{TranslateAddressResult::PAGE_FAULT, 0};
 
-  u32 offset = EA_Offset(address);         // 12 bit
-  u32 page_index = EA_PageIndex(address);  // 16 bit
-  u32 VSID = SR_VSID(sr);                  // 24 bit
-  u32 api = EA_API(address);               //  6 bit (part of page_index)
+  u32 pte_addr;
+  if (!LookupPTE(address, sr, &pte_addr))
+    return TranslateAddressResult{TranslateAddressResult::PAGE_FAULT, 0};
 
-  // hash function no 1 "xor" .360
-  u32 hash = (VSID ^ page_index);
-  u32 pte1 = bswap((VSID << 7) | api | PTE1_V);
+  UPTE2 PTE2;
+  PTE2.Hex = bswap((*(u32*)&Memory::physical_base[pte_addr + 4]));
 
-  for (int hash_func = 0; hash_func < 2; hash_func++)
+  // set the access bits
+  switch (flag)
   {
-    // hash function no 2 "not" .360
-    if (hash_func == 1)
+  case FLAG_NO_EXCEPTION:
+  case FLAG_OPCODE_NO_EXCEPTION:
+    break;
+  case FLAG_READ:
+    PTE2.R = 1;
+    break;
+  case FLAG_WRITE:
+    PTE2.R = 1;
+    PTE2.C = 1;
+    break;
+  case FLAG_OPCODE:
+    PTE2.R = 1;
+    break;
+  }
+
+  if (!IsNoExceptionFlag(flag))
+    *(u32*)&Memory::physical_base[pte_addr + 4] = bswap(PTE2.Hex);
+
+  // We already updated the TLB entry if this was caused by a C bit.
+  if (res != TLB_UPDATE_C)
+    UpdateTLBEntry(flag, PTE2, address);
+  UpdateShadowTLBEntry(flag, PTE2, address);
+
+  // Now that the R and C bits might be set, later accesses may be able to skip all of this.
+  if ((flag == FLAG_READ || flag == FLAG_WRITE) && PTE2.R && PTE2.C)
+    Memory::AddPageTableMapping(address, PTE2.RPN << HW_PAGE_INDEX_SHIFT);
+
+  return TranslateAddressResult{TranslateAddressResult::PAGE_TABLE_TRANSLATED,
+                                (PTE2.RPN << 12) | EA_Offset(address)};
+}
+
+// Fastmem for the page table
+//
+// Besides the BATs, the logical view in Memmap also mirrors pages that the page table maps, so
+// that fastmem accesses to them don't fault. Only pages with both their R and C bits set are
+// mirrored, since accesses that skip this file can't set them. Software has to execute tlbie after
+// changing or removing a page table entry, which is when the entries that the address hashes to
+// are checked again. Adding an entry doesn't need a tlbie, so new entries are mirrored the first
+// time they're used, or when the whole table is scanned.
+//
+// Changing SDR1, a segment register or the BATs right away removes the pages that the change can
+// affect, which only costs a syscall per mirrored page. Mirroring the pages that the new setup
+// maps waits for ScanPageTableIfChanged, which runs on the next exception or rfi. Switching
+// between address spaces writes all 16 segment registers, and only scans the table once that way.
+
+// The mirror is read straight out of memory, like TranslatePageAddress does.
+static bool IsPageTableInMemory()
+{
+  const u64 table_start = PowerPC::ppcState.pagetable_base;
+  const u64 table_end = table_start + ((u64{PowerPC::ppcState.pagetable_hashmask} + 1) << 6);
+  if (Memory::m_pRAM && table_end <= Memory::RAM_SIZE)
+    return true;
+  return Memory::m_pEXRAM && table_start >= 0x10000000 &&
+         table_end <= 0x10000000 + u64{Memory::EXRAM_SIZE};
+}
+
+// Mirrors the page that contains address if the page table maps it, and removes it otherwise.
+static void UpdatePageTableMapping(u32 address)
+{
+  const u32 sr = PowerPC::ppcState.sr[EA_SR(address)];
+  u32 pte_addr;
+  if (!(dbat_table[address >> BAT_INDEX_SHIFT] & 1) && !(sr & SR_T) &&
+      LookupPTE(address, sr, &pte_addr))
+  {
+    UPTE2 PTE2;
+    PTE2.Hex = bswap(*(u32*)&Memory::physical_base[pte_addr + 4]);
+    if (PTE2.R && PTE2.C)
     {
-      hash = ~hash;
-      pte1 |= PTE1_H << 24;
+      Memory::AddPageTableMapping(address, PTE2.RPN << HW_PAGE_INDEX_SHIFT);
+      return;
     }
+  }
+  Memory::RemovePageTableMapping(address);
+}
 
-    u32 pteg_addr =
+// Updates the mirror of every effective address that the entry at pte_addr can map with the
+// current segment registers. The index of its PTEG gives the low 10 bits of the page index, and
+// the API the rest.
+static void UpdatePageTableMappingsForPTE(u32 pte_addr)
+{
+  UPTE1 PTE1;
+  PTE1.Hex = bswap(*(u32*)&Memory::physical_base[pte_addr]);
+  if (!PTE1.V)
+    return;
+
+  u32 hash = (pte_addr >> 6) & PowerPC::ppcState.pagetable_hashmask;
+  if (PTE1.H)
+    hash = ~hash;
+  const u32 page_index = (PTE1.API << 10) | ((hash ^ PTE1.VSID) & 0x3ff);
+  for (u32 segment = 0; segment < 16; ++segment)
+  {
+    const u32 sr = PowerPC::ppcState.sr[segment];
+    if (!(sr & SR_T) && SR_VSID(sr) == PTE1.VSID)
+      UpdatePageTableMapping((segment << 28) | (page_index << HW_PAGE_INDEX_SHIFT));
+  }
+}
+
+// Mirrors every page that the table maps. Pages that are already mirrored are left alone.
+static void ScanPageTable()
+{
+  if (!IsPageTableInMemory())
+    return;
+
+  const u32 table_size = (PowerPC::ppcState.pagetable_hashmask + 1) << 6;
+  for (u32 offset = 0; offset < table_size; offset += 8)
+    UpdatePageTableMappingsForPTE(PowerPC::ppcState.pagetable_base | offset);
+}
+
+// Rechecks everything that the entry for address could have been changed into or out of.
+static void UpdatePageTableMappingsAfterTLBIE(u32 address)
+{
+  if (!IsPageTableInMemory())
+    return;
+
+  const u32 VSID = SR_VSID(PowerPC::ppcState.sr[EA_SR(address)]);
+  u32 hash = VSID ^ EA_PageIndex(address);
+  for (int hash_func = 0; hash_func < 2; hash_func++, hash = ~hash)
+  {
+    const u32 pteg_addr =
         ((hash & PowerPC::ppcState.pagetable_hashmask) << 6) | PowerPC::ppcState.pagetable_base;
+    for (u32 i = 0; i < 8; ++i)
+      UpdatePageTableMappingsForPTE(pteg_addr + i * 8);
+  }
 
-    for (int i = 0; i < 8; i++, pteg_addr += 8)
-    {
-      if (pte1 == *(u32*)&Memory::physical_base[pteg_addr])
-      {
-        UPTE2 PTE2;
-        PTE2.Hex = bswap((*(u32*)&Memory::physical_base[pteg_addr + 4]));
-
-        // set the access bits
-        switch (flag)
-        {
-        case FLAG_NO_EXCEPTION:
-        case FLAG_OPCODE_NO_EXCEPTION:
-          break;
-        case FLAG_READ:
-          PTE2.R = 1;
-          break;
-        case FLAG_WRITE:
-          PTE2.R = 1;
-          PTE2.C = 1;
-          break;
-        case FLAG_OPCODE:
-          PTE2.R = 1;
-          break;
-        }
-
-        if (!IsNoExceptionFlag(flag))
-          *(u32*)&Memory::physical_base[pteg_addr + 4] = bswap(PTE2.Hex);
-
-        // We already updated the TLB entry if this was caused by a C bit.
-        if (res != TLB_UPDATE_C)
-          UpdateTLBEntry(flag, PTE2, address);
-
-        return TranslateAddressResult{TranslateAddressResult::PAGE_TABLE_TRANSLATED,
-                                      (PTE2.RPN << 12) | offset};
-      }
-    }
+  // Like on hardware, the invalidation applies to the page in every segment
+  for (u32 segment = 0; segment < 16; ++segment)
+  {
+    if (SR_VSID(PowerPC::ppcState.sr[segment]) == VSID)
+      UpdatePageTableMapping((segment << 28) | (address & 0x0ffff000));
   }
-  return TranslateAddressResult{TranslateAddressResult::PAGE_FAULT, 0};
 }
 
 static void UpdateBATs(BatTable& bat_table, u32 base_spr)
@@ -1208,6 +1425,7 @@ static void UpdateFakeMMUBat(BatTable& bat_table, u32 start_addr)
 void DBATUpdated()
 {
   dbat_table = {};
+  shadow_dtlb = {};
   UpdateBATs(dbat_table, SPR_DBAT0U);
   bool extended_bats = SConfig::GetInstance().bWii && HID4.SBE;
   if (extended_bats)
@@ -1220,7 +1438,9 @@ void DBATUpdated()
   }
 
 #ifndef _ARCH_32
+  // Pages that the BATs covered before can be mirrored from the page table now
   Memory::UpdateLogicalMemory(dbat_table);
+  s_page_table_scan_pending = true;
 #endif
 
   // IsOptimizable*Address and dcbz depends on the BAT mapping, so we need a flush here.
@@ -1230,6 +1450,7 @@ void DBATUpdated()
 void IBATUpdated()
 {
   ibat_table = {};
+  shadow_itlb = {};
   UpdateBATs(ibat_table, SPR_IBAT0U);
   bool extended_bats = SConfig::GetInstance().bWii && HID4.SBE;
   if (extended_bats)
@@ -1256,6 +1477,14 @@ static TranslateAddressResult TranslateAddress(const u32 address)
     u32 result_addr = (bat_result & ~3) | (address & 0x0001FFFF);
     return TranslateAddressResult{TranslateAddressResult::BAT_TRANSLATED, result_addr};
   }
+
+  const ShadowTLBEntry& entry = (IsOpcodeFlag(flag) ? shadow_itlb : shadow_dtlb)[(
+      address >> HW_PAGE_INDEX_SHIFT) & (SHADOW_TLB_SIZE - 1)];
+  if ((flag == FLAG_WRITE ? entry.write_tag : entry.read_tag) == (address & ~(HW_PAGE_SIZE - 1)))
+  {
+    return TranslateAddressResult{TranslateAddressResult::PAGE_TABLE_TRANSLATED,
+                                  entry.paddr | (address & (HW_PAGE_SIZE - 1))};
+  }
   return TranslatePageAddress(address, flag);
 }
 
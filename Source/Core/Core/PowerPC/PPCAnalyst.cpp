@@ -10,6 +10,7 @@
 #include "Common/Logging/Log.h"
 #include "Common/StringUtil.h"
 #include "Core/ConfigManager.h"
+#include "Core/HLE/HLE.h"
 #include "Core/PowerPC/JitCommon/JitCache.h"
 #include "Core/PowerPC/PPCAnalyst.h"
 #include "Core/PowerPC/PPCSymbolDB.h"
@@ -417,6 +418,86 @@ static bool isCror(const CodeOp& a)
   return a.inst.OPCD == 19 && a.inst.SUBOP10 == 449;
 }
 
+// Works out the value of the register an instruction writes if its inputs are known. Only the
+// instructions that are commonly used to build addresses and other constants are handled; for
+// anything else, the registers the instruction writes become unknown.
+static void PropagateConstants(const CodeOp& op, BitSet32* known, std::array<u32, 32>* values)
+{
+  const UGeckoInstruction inst = op.inst;
+  const bool inputs_known = !(op.regsIn & ~*known);
+  *known &= ~op.regsOut;
+  if (!inputs_known || op.skip)
+    return;
+
+  auto& v = *values;
+  bool result_known = true;
+  u32 result = 0;
+  u32 out = inst.RA;
+  switch (inst.OPCD)
+  {
+  case 14:  // addi
+    out = inst.RD;
+    result = (inst.RA ? v[inst.RA] : 0) + inst.SIMM_16;
+    break;
+  case 15:  // addis
+    out = inst.RD;
+    result = (inst.RA ? v[inst.RA] : 0) + (static_cast<u32>(inst.SIMM_16) << 16);
+    break;
+  case 21:  // rlwinmx
+  {
+    const u32 rotated = inst.SH ? (v[inst.RS] << inst.SH) | (v[inst.RS] >> (32 - inst.SH)) :
+                                  v[inst.RS];
+    const u32 begin = 0xFFFFFFFF >> inst.MB;
+    const u32 end = inst.ME < 31 ? (0xFFFFFFFF >> (inst.ME + 1)) : 0;
+    const u32 mask = inst.MB > inst.ME ? ~(begin ^ end) : begin ^ end;
+    result = rotated & mask;
+    break;
+  }
+  case 24:  // ori
+    result = v[inst.RS] | inst.UIMM;
+    break;
+  case 25:  // oris
+    result = v[inst.RS] | (static_cast<u32>(inst.UIMM) << 16);
+    break;
+  case 26:  // xori
+    result = v[inst.RS] ^ inst.UIMM;
+    break;
+  case 27:  // xoris
+    result = v[inst.RS] ^ (static_cast<u32>(inst.UIMM) << 16);
+    break;
+  case 28:  // andi.
+    result = v[inst.RS] & inst.UIMM;
+    break;
+  case 29:  // andis.
+    result = v[inst.RS] & (static_cast<u32>(inst.UIMM) << 16);
+    break;
+  case 31:
+    switch (inst.SUBOP10)
+    {
+    case 266:  // addx
+      out = inst.RD;
+      result = v[inst.RA] + v[inst.RB];
+      break;
+    case 444:  // orx, which includes mr
+      result = v[inst.RS] | v[inst.RB];
+      break;
+    default:
+      result_known = false;
+      break;
+    }
+    break;
+  default:
+    result_known = false;
+    break;
+  }
+
+  if (result_known && op.regsOut[out])
+  {
+    (*known)[out] = true;
+    v[out] = result;
+  }
+}
+
 void PPCAnalyzer::ReorderInstructionsCore(u32 instructions, CodeOp* code, bool reverse,
                                           ReorderType type)
 {
@@ -489,8 +570,14 @@ void PPCAnalyzer::ReorderInstructions(u32 instructions, CodeOp* code)
 void PPCAnalyzer::SetInstructionStats(CodeBlock* block, CodeOp* code, GekkoOPInfo* opinfo,
                                       u32 index)
 {
-  code->wantsCR0 = false;
-  code->wantsCR1 = false;
+  // Instructions that can read CR fields are assumed to read all of them.
+  code->wantsCR0 = opinfo->type == OPTYPE_BRANCH || opinfo->type == OPTYPE_CR ||
+                   opinfo->type == OPTYPE_SYSTEM;
+  code->wantsCR1 = code->wantsCR0;
+
+  // Only the first FPU instruction in a block checks whether the FPU is enabled
+  code->canCauseException = (opinfo->flags & FL_LOADSTORE) ||
+                            ((opinfo->flags & FL_USE_FPU) && !block->m_fpa->any);
 
   if (opinfo->flags & FL_USE_FPU)
     block->m_fpa->any = true;
@@ -585,6 +672,26 @@ void PPCAnalyzer::SetInstructionStats(CodeBlock* block, CodeOp* code, GekkoOPInf
       block->m_gpa->SetInputRegister(iReg, index);
     }
   }
+  else if (code->inst.OPCD == 31 && code->inst.SUBOP10 == 597)  // lswi
+  {
+    // One register per 4 bytes, wrapping around from r31 to r0
+    const u32 num_bytes = code->inst.NB ? code->inst.NB : 32;
+    for (u32 i = 0; i < (num_bytes + 3) / 4; ++i)
+    {
+      const int iReg = (code->inst.RD + i) % 32;
+      code->regsOut[iReg] = true;
+      block->m_gpa->SetOutputRegister(iReg, index);
+    }
+  }
+  else if (code->inst.OPCD == 31 && code->inst.SUBOP10 == 533)  // lswx
+  {
+    // The number of bytes comes from XER, so any register might be written
+    for (int iReg = 0; iReg < 32; ++iReg)
+    {
+      code->regsOut[iReg] = true;
+      block->m_gpa->SetOutputRegister(iReg, index);
+    }
+  }
 
   code->fregOut = -1;
   if (opinfo->flags & FL_OUT_FLOAT_D)
@@ -627,6 +734,50 @@ void PPCAnalyzer::SetInstructionStats(CodeBlock* block, CodeOp* code, GekkoOPInf
   }
 }
 
+// A busy wait loop is a block that branches back to its own start and, unless something other
+// than the CPU changes memory in the meantime, does exactly the same thing every time around:
+// * Before the branch, there are only integer instructions and loads. No stores,
+//   no SPR or MSR accesses, and nothing that reads the carry bit, which could differ between the
+//   first and the second time around.
+// * No register is written after it has been read, so every iteration starts with the registers
+//   that the previous one started with. Loads with update write their base register, which they
+//   also read, so they're ruled out by this too.
+// Whatever the loop is waiting for can then only happen in a CoreTiming event (an interrupt, DMA
+// finishing, a hardware register changing), so the time until the next one can be skipped.
+// With OPTION_CONDITIONAL_CONTINUE, the branch doesn't have to be the last instruction of the
+// block. Returns the index of the branch, or instructions if the block isn't such a loop.
+u32 PPCAnalyzer::FindBusyWaitLoopBranch(const CodeBlock* block, const CodeOp* code,
+                                        u32 instructions) const
+{
+  BitSet32 write_disallowed_regs;
+  BitSet32 written_regs;
+  for (u32 i = 0; i < instructions; ++i)
+  {
+    const UGeckoInstruction inst = code[i].inst;
+    const bool is_bx = inst.OPCD == 18;
+    const bool is_bcx = inst.OPCD == 16 && (inst.BO & BO_DONT_DECREMENT_FLAG);
+    if ((is_bx || is_bcx) && !inst.LK && !code[i].skip)
+    {
+      const u32 offset = is_bx ? SignExt26(inst.LI << 2) : SignExt16(inst.BD << 2);
+      if (offset + (inst.AA ? 0 : code[i].address) == block->m_address)
+        return i;
+    }
+
+    const GekkoOPInfo* opinfo = code[i].opinfo;
+    if (opinfo->type != OPTYPE_INTEGER && opinfo->type != OPTYPE_LOAD)
+      return instructions;
+    if (opinfo->flags & FL_READ_CA)
+      return instructions;
+
+    write_disallowed_regs |= code[i].regsIn & ~written_regs;
+    if (code[i].regsOut & write_disallowed_regs)
+      return instructions;
+    written_regs |= code[i].regsOut;
+  }
+
+  return instructions;
+}
+
 u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32 blockSize)
 {
   // Clear block stats
@@ -699,8 +850,8 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
         // Always follow BX instructions.
         // TODO: Loop unrolling might bloat the code size too much.
         //       Enable it carefully.
-        follow = destination != block->m_address;
         destination = SignExt26(inst.LI << 2) + (inst.AA ? 0 : address);
+        follow = destination != block->m_address;
         if (inst.LK)
         {
           found_call = true;
@@ -811,24 +962,36 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
     block->m_broken = true;
   }
 
-  // Scan for flag dependencies; assume the next block (or any branch that can leave the block)
-  // wants flags, to be safe.
+  const u32 idle_loop_branch = FindBusyWaitLoopBranch(block, code, num_inst);
+  if (idle_loop_branch != num_inst)
+  {
+    code[idle_loop_branch].branchIsIdleLoop = true;
+    if (m_reported_idle_loops.insert(block->m_address).second)
+    {
+      INFO_LOG(POWERPC, "%s: idle loop at %08x (%u instructions)",
+               SConfig::GetInstance().GetGameID().c_str(), block->m_address, num_inst);
+    }
+  }
+
+  // Scan for flag dependencies; assume the next block (or any branch or exception that can leave
+  // the block) wants flags, to be safe. The JITs skip flag updates that nothing wants.
   bool wantsCR0 = true, wantsCR1 = true, wantsFPRF = true, wantsCA = true;
   BitSet32 fprInUse, gprInUse, gprInReg, fprInXmm;
   for (int i = block->m_num_instructions - 1; i >= 0; i--)
   {
+    const bool canLeaveBlock = code[i].canEndBlock || code[i].canCauseException;
     bool opWantsCR0 = code[i].wantsCR0;
     bool opWantsCR1 = code[i].wantsCR1;
     bool opWantsFPRF = code[i].wantsFPRF;
     bool opWantsCA = code[i].wantsCA;
-    code[i].wantsCR0 = wantsCR0 || code[i].canEndBlock;
-    code[i].wantsCR1 = wantsCR1 || code[i].canEndBlock;
-    code[i].wantsFPRF = wantsFPRF || code[i].canEndBlock;
-    code[i].wantsCA = wantsCA || code[i].canEndBlock;
-    wantsCR0 |= opWantsCR0 || code[i].canEndBlock;
-    wantsCR1 |= opWantsCR1 || code[i].canEndBlock;
-    wantsFPRF |= opWantsFPRF || code[i].canEndBlock;
-    wantsCA |= opWantsCA || code[i].canEndBlock;
+    code[i].wantsCR0 = wantsCR0 || canLeaveBlock;
+    code[i].wantsCR1 = wantsCR1 || canLeaveBlock;
+    code[i].wantsFPRF = wantsFPRF || canLeaveBlock;
+    code[i].wantsCA = wantsCA || canLeaveBlock;
+    wantsCR0 |= opWantsCR0 || canLeaveBlock;
+    wantsCR1 |= opWantsCR1 || canLeaveBlock;
+    wantsFPRF |= opWantsFPRF || canLeaveBlock;
+    wantsCA |= opWantsCA || canLeaveBlock;
     wantsCR0 &= !code[i].outputCR0 || opWantsCR0;
     wantsCR1 &= !code[i].outputCR1 || opWantsCR1;
     wantsFPRF &= !code[i].outputFPRF || opWantsFPRF;
@@ -855,11 +1018,21 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
   // Forward scan, for flags that need the other direction for calculation.
   BitSet32 fprIsSingle, fprIsDuplicated, fprIsStoreSafe, gprDefined, gprBlockInputs;
   BitSet8 gqrUsed, gqrModified;
+  BitSet32 gprIsConstant;
+  std::array<u32, 32> gprConstants{};
+  block->m_gpr_constants.resize(block->m_num_instructions);
   for (u32 i = 0; i < block->m_num_instructions; i++)
   {
     gprBlockInputs |= code[i].regsIn & ~gprDefined;
     gprDefined |= code[i].regsOut;
 
+    // HLE hooks run before the instruction and can change any register
+    if (HLE::GetFunctionIndex(code[i].address))
+      gprIsConstant = BitSet32(0);
+    code[i].gprIsConstant = gprIsConstant;
+    block->m_gpr_constants[i] = gprConstants;
+    PropagateConstants(code[i], &gprIsConstant, &gprConstants);
+
     code[i].fprIsSingle = fprIsSingle;
     code[i].fprIsDuplicated = fprIsDuplicated;
     code[i].fprIsStoreSafe = fprIsStoreSafe;
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cstdlib>
 #include <map>
 #include <set>
@@ -42,8 +43,13 @@ struct CodeOp  // 16B
   bool outputFPRF;
   bool outputCA;
   bool canEndBlock;
+  // whether this can raise an exception and leave the block early (a DSI, an external interrupt
+  // after a gather pipe write, or the FPU being unavailable)
+  bool canCauseException;
   bool skipLRStack;
   bool skip;  // followed BL-s for example
+  // whether this is the branch that closes a busy wait loop (see FindBusyWaitLoopBranch)
+  bool branchIsIdleLoop;
   // which registers are still needed after this instruction in this block
   BitSet32 fprInUse;
   BitSet32 gprInUse;
@@ -61,6 +67,9 @@ struct CodeOp  // 16B
   // safely
   // skip PPC_FP.
   BitSet32 fprIsStoreSafe;
+  // which gprs hold a value that is known at compile time before this instruction; the values
+  // are in CodeBlock::m_gpr_constants.
+  BitSet32 gprIsConstant;
 };
 
 struct BlockStats
@@ -160,6 +169,9 @@ struct CodeBlock
   // Which GPRs this block reads from before defining, if any.
   BitSet32 m_gpr_inputs;
 
+  // The values of the GPRs in each instruction's gprIsConstant, indexed by instruction.
+  std::vector<std::array<u32, 32>> m_gpr_constants;
+
   // Which memory locations are occupied by this block.
   std::set<u32> m_physical_addresses;
 };
@@ -177,10 +189,14 @@ private:
   void ReorderInstructionsCore(u32 instructions, CodeOp* code, bool reverse, ReorderType type);
   void ReorderInstructions(u32 instructions, CodeOp* code);
   void SetInstructionStats(CodeBlock* block, CodeOp* code, GekkoOPInfo* opinfo, u32 index);
+  u32 FindBusyWaitLoopBranch(const CodeBlock* block, const CodeOp* code, u32 instructions) const;
 
   // Options
   u32 m_options;
 
+  // Idle loops that have been logged already, so that each one is only reported once
+  std::set<u32> m_reported_idle_loops;
+
 public:
   enum AnalystOption
   {
@@ -96,6 +96,7 @@ void DoState(PointerWrap& p)
   {
     IBATUpdated();
     DBATUpdated();
+    PageTableMappingsInvalidated();
   }
 
   // SystemTimers::DecrementerSet();
@@ -354,6 +355,8 @@ void UpdatePerformanceMonitor(u32 cycles, u32 num_load_stores, u32 num_fp_inst)
 
 void CheckExceptions()
 {
+  ScanPageTableIfChanged();
+
   u32 exceptions = ppcState.Exceptions;
 
   // Example procedure:
@@ -272,6 +272,12 @@ void ClearCacheLine(const u32 address);  // Zeroes 32 bytes; address should be 3
 
 // TLB functions
 void SDRUpdated();
+void SRUpdated(int index);
+// Forgets every page that was mirrored from the page table, for when all of the MMU state changed
+void PageTableMappingsInvalidated();
+// Mirrors the pages that changes to SDR1, the segment registers or the BATs made available.
+// Called on exceptions and rfi, so that consecutive changes only need one scan of the page table.
+void ScanPageTableIfChanged();
 void InvalidateTLBEntry(u32 address);
 void DBATUpdated();
 void IBATUpdated();
@@ -303,6 +309,26 @@ inline bool TranslateBatAddess(const BatTable& bat_table, u32* address)
   *address = (bat_result & ~3) | (*address & 0x0001FFFF);
   return true;
 }
+
+// The shadow TLBs are direct-mapped caches of page table translations, much larger than the
+// emulated TLBs, which the JITs can check inline. Like a bigger TLB would be, they're only
+// invalidated by tlbie, and when the segment registers, SDR1 or the BATs change.
+static const u32 SHADOW_TLB_SIZE = 4096;
+static const u32 SHADOW_TLB_TAG_INVALID = 0xffffffff;
+struct ShadowTLBEntry
+{
+  // The effective address of the page, if it can be read or written through this entry. Writes
+  // are only allowed once the C bit of the page table entry is set.
+  u32 read_tag = SHADOW_TLB_TAG_INVALID;
+  u32 write_tag = SHADOW_TLB_TAG_INVALID;
+  // The physical address of the page. Data entries are only made for pages that are mapped at
+  // Memory::physical_base.
+  u32 paddr = 0;
+  u32 padding = 0;
+};
+using ShadowTLB = std::array<ShadowTLBEntry, SHADOW_TLB_SIZE>;  // 64 KB
+extern ShadowTLB shadow_dtlb;
+extern ShadowTLB shadow_itlb;
 }  // namespace
 
 enum CRBits
@@ -12,6 +12,7 @@
 #include "Common/CDUtils.h"
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
+#include "Common/MathUtil.h"
 
 #include "DiscIO/Blob.h"
 #include "DiscIO/CISOBlob.h"
@@ -19,6 +20,7 @@
 #include "DiscIO/DriveBlob.h"
 #include "DiscIO/FileBlob.h"
 #include "DiscIO/TGCBlob.h"
+#include "DiscIO/WCZBlob.h"
 #include "DiscIO/WbfsBlob.h"
 
 namespace DiscIO
@@ -26,11 +28,7 @@ namespace DiscIO
 void SectorReader::SetSectorSize(int blocksize)
 {
   m_block_size = std::max(blocksize, 0);
-  for (auto& cache_entry : m_cache)
-  {
-    cache_entry.Reset();
-    cache_entry.data.resize(m_chunk_blocks * m_block_size);
-  }
+  ResetCache();
 }
 
 void SectorReader::SetChunkSize(int block_cnt)
@@ -40,57 +38,106 @@ void SectorReader::SetChunkSize(int block_cnt)
   SetSectorSize(m_block_size);
 }
 
+void SectorReader::SetCacheCapacity(u32 chunks)
+{
+  m_cache_capacity = std::max(chunks, 1u);
+  m_cache_shards = MathUtil::Clamp(m_cache_capacity / MIN_LINES_PER_SHARD, 1u, MAX_CACHE_SHARDS);
+  ResetCache();
+}
+
+SectorReader::CacheStats SectorReader::GetCacheStats() const
+{
+  return {m_cache_hits.load(), m_cache_misses.load(), m_cache_evictions.load()};
+}
+
 SectorReader::~SectorReader()
 {
 }
 
-const SectorReader::Cache* SectorReader::FindCacheLine(u64 block_num)
+void SectorReader::ResetCache()
 {
-  auto itr = std::find_if(m_cache.begin(), m_cache.end(),
-                          [&](const Cache& entry) { return entry.Contains(block_num); });
-  if (itr == m_cache.end())
-    return nullptr;
+  // Lines (and their buffers) are created as the cache fills up.
+  for (CacheShard& shard : m_cache)
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.index.clear();
+    shard.lines.clear();
+    shard.clock_hand = 0;
+  }
 
-  itr->MarkUsed();
-  return &*itr;
+  std::lock_guard<std::mutex> lock(m_read_mutex);
+  m_read_buffer.resize(m_chunk_blocks * m_block_size);
 }
 
-SectorReader::Cache* SectorReader::GetEmptyCacheLine()
+bool SectorReader::CopyFromCache(u64 chunk_idx, u32 offset_in_chunk, u32 size, u8* out_ptr,
+                                 bool* valid)
 {
-  Cache* oldest = &m_cache[0];
-  // Find the Least Recently Used cache line to replace.
-  std::for_each(m_cache.begin() + 1, m_cache.end(), [&](Cache& line) {
-    if (line.IsLessRecentlyUsedThan(*oldest))
+  CacheShard& shard = GetShard(chunk_idx);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  const auto it = shard.index.find(chunk_idx);
+  if (it == shard.index.end())
+    return false;
+
+  CacheLine& line = shard.lines[it->second];
+  line.referenced = true;
+  *valid = offset_in_chunk + size <= line.size;
+  if (*valid)
+    std::copy(line.data.begin() + offset_in_chunk, line.data.begin() + offset_in_chunk + size,
+              out_ptr);
+  return true;
+}
+
+bool SectorReader::IsCached(u64 chunk_idx)
+{
+  CacheShard& shard = GetShard(chunk_idx);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  return shard.index.count(chunk_idx) != 0;
+}
+
+void SectorReader::InsertIntoCache(u64 chunk_idx, std::vector<u8>* data, u32 size)
+{
+  CacheShard& shard = GetShard(chunk_idx);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  u32 line_idx;
+  const u32 shard_capacity = (m_cache_capacity + m_cache_shards - 1) / m_cache_shards;
+  if (shard.lines.size() < shard_capacity)
+  {
+    line_idx = static_cast<u32>(shard.lines.size());
+    shard.lines.emplace_back();
+    shard.lines.back().data.resize(data->size());
+  }
+  else
+  {
+    // Sweep the clock hand, giving lines that were used since the last sweep a second chance.
+    while (shard.lines[shard.clock_hand].referenced)
     {
-      oldest->ShiftLRU();
-      oldest = &line;
-      return;
+      shard.lines[shard.clock_hand].referenced = false;
+      shard.clock_hand = (shard.clock_hand + 1) % shard_capacity;
     }
-    line.ShiftLRU();
-  });
-  oldest->Reset();
-  return oldest;
+    line_idx = shard.clock_hand;
+    shard.clock_hand = (shard.clock_hand + 1) % shard_capacity;
+    shard.index.erase(shard.lines[line_idx].chunk_idx);
+    ++m_cache_evictions;
+  }
+
+  CacheLine& line = shard.lines[line_idx];
+  line.data.swap(*data);
+  line.chunk_idx = chunk_idx;
+  line.size = size;
+  // New lines start out unreferenced, so a chunk that is only read once (such as in a long
+  // sequential read) is evicted before chunks that have been read again.
+  line.referenced = false;
+  shard.index[chunk_idx] = line_idx;
 }
 
-const SectorReader::Cache* SectorReader::GetCacheLine(u64 block_num)
+u64 SectorReader::CountUncachedBlocks(u64 block_num, u64 max_blocks)
 {
-  if (auto entry = FindCacheLine(block_num))
-    return entry;
-
-  // Cache miss. Fault in the missing entry.
-  Cache* cache = GetEmptyCacheLine();
-  // We only read aligned chunks, this avoids duplicate overlapping entries.
-  u64 chunk_idx = block_num / m_chunk_blocks;
-  u32 blocks_read = ReadChunk(cache->data.data(), chunk_idx);
-  if (!blocks_read)
-    return nullptr;
-  cache->Fill(chunk_idx * m_chunk_blocks, blocks_read);
-
-  // Secondary check for out-of-bounds read.
-  // If we got less than m_chunk_blocks, we may still have missed.
-  // We do this after the cache fill since the cache line itself is
-  // fine, the problem is being asked to read past the end of the disk.
-  return cache->Contains(block_num) ? cache : nullptr;
+  u64 count = 0;
+  while (count < max_blocks && !IsCached((block_num + count) / m_chunk_blocks))
+    ++count;
+  return count;
 }
 
 bool SectorReader::Read(u64 offset, u64 size, u8* out_ptr)
@@ -98,22 +145,69 @@ bool SectorReader::Read(u64 offset, u64 size, u8* out_ptr)
   u64 remain = size;
   u64 block = 0;
   u32 position_in_block = static_cast<u32>(offset % m_block_size);
+  const u32 chunk_size = m_chunk_blocks * m_block_size;
 
   while (remain > 0)
   {
     block = offset / m_block_size;
 
-    const Cache* cache = GetCacheLine(block);
-    if (!cache)
-      return false;
+    // Large reads (such as the DVD thread's read-ahead) go straight to the output when they
+    // cover at least a whole chunk of uncached blocks. Besides skipping a copy, this lets
+    // readers that override ReadMultipleAlignedBlocks work on many blocks at once. If it fails,
+    // the cached path below retries and reports the error as usual.
+    if (position_in_block == 0 && remain / m_block_size >= std::max<u32>(m_chunk_blocks, 2))
+    {
+      const u64 uncached = CountUncachedBlocks(block, remain / m_block_size);
+      if (uncached >= std::max<u32>(m_chunk_blocks, 2))
+      {
+        std::unique_lock<std::mutex> lock(m_read_mutex);
+        if (ReadMultipleAlignedBlocks(block, uncached, out_ptr))
+        {
+          offset += uncached * m_block_size;
+          out_ptr += uncached * m_block_size;
+          remain -= uncached * m_block_size;
+          continue;
+        }
+      }
+    }
 
     // Cache entries are aligned chunks, we may not want to read from the start
-    u32 read_offset = static_cast<u32>(block - cache->block_idx) * m_block_size + position_in_block;
-    u32 can_read = m_block_size * cache->num_blocks - read_offset;
-    u32 was_read = static_cast<u32>(std::min<u64>(can_read, remain));
+    const u64 chunk_idx = block / m_chunk_blocks;
+    const u32 offset_in_chunk =
+        static_cast<u32>(block - chunk_idx * m_chunk_blocks) * m_block_size + position_in_block;
+    const u32 was_read = static_cast<u32>(std::min<u64>(chunk_size - offset_in_chunk, remain));
 
-    std::copy(cache->data.begin() + read_offset, cache->data.begin() + read_offset + was_read,
-              out_ptr);
+    bool valid;
+    if (CopyFromCache(chunk_idx, offset_in_chunk, was_read, out_ptr, &valid))
+    {
+      ++m_cache_hits;
+    }
+    else
+    {
+      std::lock_guard<std::mutex> lock(m_read_mutex);
+
+      // Another thread may have read the chunk while we were waiting for the lock.
+      if (!CopyFromCache(chunk_idx, offset_in_chunk, was_read, out_ptr, &valid))
+      {
+        ++m_cache_misses;
+        const u32 blocks_read = ReadChunk(m_read_buffer.data(), chunk_idx);
+        if (!blocks_read)
+          return false;
+
+        // Secondary check for out-of-bounds read.
+        // If we got less than m_chunk_blocks, we may still have missed.
+        // We do this after the cache fill since the cache line itself is
+        // fine, the problem is being asked to read past the end of the disk.
+        const u32 bytes_read = blocks_read * m_block_size;
+        valid = offset_in_chunk + was_read <= bytes_read;
+        if (valid)
+          std::copy_n(m_read_buffer.begin() + offset_in_chunk, was_read, out_ptr);
+        InsertIntoCache(chunk_idx, &m_read_buffer, bytes_read);
+        m_read_buffer.resize(chunk_size);
+      }
+    }
+    if (!valid)
+      return false;
 
     offset += was_read;
     out_ptr += was_read;
@@ -195,11 +289,14 @@ std::unique_ptr<IBlobReader> CreateBlobReader(const std::string& filename)
   case CISO_MAGIC:
     return CISOFileReader::Create(std::move(file));
   case GCZ_MAGIC:
+  case GCZ_MAGIC_WITH_JUNK:
     return CompressedBlobReader::Create(std::move(file), filename);
   case TGC_MAGIC:
     return TGCFileReader::Create(std::move(file));
   case WBFS_MAGIC:
     return WbfsFileReader::Create(std::move(file), filename);
+  case WCZ_MAGIC:
+    return WCZFileReader::Create(std::move(file), filename);
   default:
     return PlainFileReader::Create(std::move(file));
   }
@@ -15,8 +15,12 @@
 // automatically do the right thing.
 
 #include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "Common/CommonFuncs.h"
 #include "Common/CommonTypes.h"
 
@@ -31,7 +35,8 @@ enum class BlobType
   GCZ,
   CISO,
   WBFS,
-  TGC
+  TGC,
+  WCZ
 };
 
 class IBlobReader
@@ -44,20 +49,49 @@ public:
   // NOT thread-safe - can't call this from multiple threads.
   virtual bool Read(u64 offset, u64 size, u8* out_ptr) = 0;
 
+  // Hints that the given range is about to be read, so that it can be fetched in the background.
+  // Returns false if the reader can't do that, in which case callers may read ahead themselves.
+  virtual bool Prefetch(u64 offset, u64 size) { return false; }
+
+  // Readers that store Wii partition data decrypted can serve decrypted reads directly, which
+  // saves encrypting it only for the volume to decrypt it again. partition_data_offset is where
+  // the encrypted data of the partition starts, and offset is relative to the decrypted data.
+  virtual bool SupportsReadWiiDecrypted(u64 partition_data_offset) const { return false; }
+  virtual bool ReadWiiDecrypted(u64 offset, u64 size, u8* out_ptr, u64 partition_data_offset)
+  {
+    return false;
+  }
+
 protected:
   IBlobReader() {}
 };
 
 // Provides caching and byte-operation-to-block-operations facilities.
 // Used for compressed blob and direct drive reading.
+// Unlike other readers, Read can be called from several threads at once. Cache hits are served
+// concurrently; misses are read one at a time, so derived classes don't need any locking.
 // NOTE: GetDataSize() is expected to be evenly divisible by the sector size.
 class SectorReader : public IBlobReader
 {
 public:
+  struct CacheStats
+  {
+    u64 hits;
+    u64 misses;
+    u64 evictions;
+  };
+
   virtual ~SectorReader() = 0;
 
   bool Read(u64 offset, u64 size, u8* out_ptr) override;
 
+  // Sets how many chunks the cache holds, and clears it. Defaults to DEFAULT_CACHE_CHUNKS.
+  // Must not be called while another thread is reading.
+  void SetCacheCapacity(u32 chunks);
+  CacheStats GetCacheStats() const;
+
+  static constexpr u32 DEFAULT_CACHE_CHUNKS = 32;
+
 protected:
   void SetSectorSize(int blocksize);
   int GetSectorSize() const { return m_block_size; }
@@ -77,52 +111,41 @@ protected:
   virtual bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr);
 
 private:
-  struct Cache
+  // The cache is split into shards by chunk number, each with its own lock, hash index and
+  // CLOCK replacement (an approximation of LRU which only needs a bit per line).
+  // Small caches use fewer shards, so that a few chunks which happen to land in the same shard
+  // don't evict each other while the rest of the cache is empty.
+  static constexpr u32 MAX_CACHE_SHARDS = 8;
+  static constexpr u32 MIN_LINES_PER_SHARD = 8;
+
+  struct CacheLine
   {
     std::vector<u8> data;
-    u64 block_idx = 0;
-    u32 num_blocks = 0;
-
-    // [Pseudo-] Least Recently Used Shift Register
-    // When an empty cache line is needed, the line with the lowest value
-    // is taken and reset; the LRU register is then shifted down 1 place
-    // on all lines (low bit discarded). When a line is used, the high bit
-    // is set marking it as most recently used.
-    u32 lru_sreg = 0;
-
-    void Reset()
-    {
-      block_idx = 0;
-      num_blocks = 0;
-      lru_sreg = 0;
-    }
-    void Fill(u64 block, u32 count)
-    {
-      block_idx = block;
-      num_blocks = count;
-      // NOTE: Setting only the high bit means the newest line will
-      //   be selected for eviction if every line in the cache was
-      //   touched. This gives MRU behavior which is probably
-      //   desirable in that case.
-      MarkUsed();
-    }
-    bool Contains(u64 block) const { return block >= block_idx && block - block_idx < num_blocks; }
-    void MarkUsed() { lru_sreg |= 0x80000000; }
-    void ShiftLRU() { lru_sreg >>= 1; }
-    bool IsLessRecentlyUsedThan(const Cache& other) const { return lru_sreg < other.lru_sreg; }
+    u64 chunk_idx = 0;
+    // Number of valid bytes. Less than a chunk at the end of the disc.
+    u32 size = 0;
+    bool referenced = false;
   };
 
-  // Gets the cache line that contains the given block, or nullptr.
-  // NOTE: The cache record only lasts until it expires (next GetEmptyCacheLine)
-  const Cache* FindCacheLine(u64 block_num);
+  struct CacheShard
+  {
+    std::mutex mutex;
+    std::unordered_map<u64, u32> index;
+    std::vector<CacheLine> lines;
+    u32 clock_hand = 0;
+  };
 
-  // Finds the least recently used cache line, resets and returns it.
-  Cache* GetEmptyCacheLine();
+  CacheShard& GetShard(u64 chunk_idx) { return m_cache[chunk_idx % m_cache_shards]; }
+  // Copies size bytes starting at offset_in_chunk out of a cached chunk. Returns false on a miss.
+  // Sets *valid to false if the chunk is cached but doesn't contain the requested bytes.
+  bool CopyFromCache(u64 chunk_idx, u32 offset_in_chunk, u32 size, u8* out_ptr, bool* valid);
+  bool IsCached(u64 chunk_idx);
+  // Stores a chunk that was read into *data, giving *data an unused buffer in return.
+  void InsertIntoCache(u64 chunk_idx, std::vector<u8>* data, u32 size);
+  void ResetCache();
 
-  // Combines FindCacheLine with GetEmptyCacheLine and ReadChunk.
-  // Always returns a valid cache line (loading the data if needed).
-  // May return nullptr only if the cache missed and the read failed.
-  const Cache* GetCacheLine(u64 block_num);
+  // Counts how many blocks starting at block_num (up to max_blocks) are not in the cache.
+  u64 CountUncachedBlocks(u64 block_num, u64 max_blocks);
 
   // Read all bytes from a chunk of blocks into a buffer.
   // Returns the number of blocks read (may be less than m_chunk_blocks
@@ -130,10 +153,19 @@ private:
   // evenly divisible into chunks). Returns zero if it fails.
   u32 ReadChunk(u8* buffer, u64 chunk_num);
 
-  static constexpr int CACHE_LINES = 32;
   u32 m_block_size = 0;    // Bytes in a sector/block
   u32 m_chunk_blocks = 1;  // Number of sectors/blocks in a chunk
-  std::array<Cache, CACHE_LINES> m_cache;
+  u32 m_cache_capacity = DEFAULT_CACHE_CHUNKS;
+  u32 m_cache_shards = DEFAULT_CACHE_CHUNKS / MIN_LINES_PER_SHARD;
+  std::array<CacheShard, MAX_CACHE_SHARDS> m_cache;
+
+  std::atomic<u64> m_cache_hits{0};
+  std::atomic<u64> m_cache_misses{0};
+  std::atomic<u64> m_cache_evictions{0};
+
+  // Serializes calls into the derived class, and guards m_read_buffer.
+  std::mutex m_read_mutex;
+  std::vector<u8> m_read_buffer;
 };
 
 class CBlobBigEndianReader
@@ -164,5 +196,7 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
                         void* arg = nullptr);
 bool DecompressBlobToFile(const std::string& infile_path, const std::string& outfile_path,
                           CompressCB callback = nullptr, void* arg = nullptr);
+bool ConvertToWCZ(const std::string& infile_path, const std::string& outfile_path,
+                  CompressCB callback = nullptr, void* arg = nullptr);
 
 }  // namespace
@@ -8,11 +8,13 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <zlib.h>
@@ -23,14 +25,54 @@
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/StringUtil.h"
+#include "Common/Thread.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/CompressedBlob.h"
 #include "DiscIO/DiscScrubber.h"
+#include "DiscIO/LaggedFibonacciGenerator.h"
+#include "DiscIO/WCZBlob.h"
 
 namespace DiscIO
 {
+static constexpr size_t JUNK_TABLE_HEADER_SIZE = 2 * sizeof(u32);
+static constexpr size_t JUNK_REGION_SIZE =
+    sizeof(u64) + sizeof(u32) + LaggedFibonacciGenerator::SEED_SIZE * sizeof(u32);
+
+// Blocks are compressed in batches of this many per thread, and then written in order.
+static constexpr u32 COMPRESS_BLOCKS_PER_THREAD = 16;
+
 bool IsGCZBlob(File::IOFile& file);
 
+static u32 ReadLE32(const u8* data)
+{
+  return data[0] | data[1] << 8 | data[2] << 16 | static_cast<u32>(data[3]) << 24;
+}
+
+static void WriteLE32(u32 value, u8* out)
+{
+  for (size_t i = 0; i < sizeof(u32); ++i)
+    out[i] = static_cast<u8>(value >> (i * 8));
+}
+
+static DiscScrubber::JunkRegion ReadJunkRegion(const u8* data)
+{
+  DiscScrubber::JunkRegion region;
+  region.offset = ReadLE32(data) | u64{ReadLE32(data + 4)} << 32;
+  region.size = ReadLE32(data + 8);
+  for (size_t i = 0; i < region.seed.size(); ++i)
+    region.seed[i] = ReadLE32(data + 12 + i * sizeof(u32));
+  return region;
+}
+
+static void WriteJunkRegion(const DiscScrubber::JunkRegion& region, u8* out)
+{
+  WriteLE32(static_cast<u32>(region.offset), out);
+  WriteLE32(static_cast<u32>(region.offset >> 32), out + 4);
+  WriteLE32(region.size, out + 8);
+  for (size_t i = 0; i < region.seed.size(); ++i)
+    WriteLE32(region.seed[i], out + 12 + i * sizeof(u32));
+}
+
 CompressedBlobReader::CompressedBlobReader(File::IOFile file, const std::string& filename)
     : m_file(std::move(file)), m_file_name(filename)
 {
@@ -60,15 +102,69 @@ CompressedBlobReader::CompressedBlobReader(File::IOFile file, const std::string&
 std::unique_ptr<CompressedBlobReader> CompressedBlobReader::Create(File::IOFile file,
                                                                    const std::string& filename)
 {
-  if (IsGCZBlob(file))
-    return std::unique_ptr<CompressedBlobReader>(
-        new CompressedBlobReader(std::move(file), filename));
+  if (!IsGCZBlob(file))
+    return nullptr;
+
+  std::unique_ptr<CompressedBlobReader> reader(
+      new CompressedBlobReader(std::move(file), filename));
+  if (!reader->ReadJunkTable())
+    return nullptr;
+  return reader;
+}
+
+bool CompressedBlobReader::ReadJunkTable()
+{
+  if (m_header.magic_cookie != GCZ_MAGIC_WITH_JUNK)
+    return true;
+
+  const u64 junk_table_offset = m_data_offset + m_header.compressed_data_size;
+  u8 table_header[JUNK_TABLE_HEADER_SIZE];
+  if (!m_file.Seek(junk_table_offset, SEEK_SET) ||
+      !m_file.ReadBytes(table_header, sizeof(table_header)) ||
+      ReadLE32(table_header) != GCZ_JUNK_MAGIC)
+  {
+    ERROR_LOG(DISCIO, "%s has no junk table", m_file_name.c_str());
+    return false;
+  }
 
-  return nullptr;
+  const u32 num_regions = ReadLE32(table_header + 4);
+  if (m_file_size < m_file.Tell() + u64{num_regions} * JUNK_REGION_SIZE)
+  {
+    ERROR_LOG(DISCIO, "The junk table of %s is truncated", m_file_name.c_str());
+    return false;
+  }
+  std::vector<u8> table(num_regions * JUNK_REGION_SIZE);
+  if (!m_file.ReadBytes(table.data(), table.size()))
+    return false;
+
+  // RegenerateJunk relies on this to stay within the blocks it writes to
+  m_junk.resize(num_regions);
+  u64 previous_end = 0;
+  for (u32 i = 0; i < num_regions; ++i)
+  {
+    const DiscScrubber::JunkRegion region = ReadJunkRegion(&table[i * JUNK_REGION_SIZE]);
+    if (region.size == 0 || region.offset < previous_end || region.offset > m_header.data_size ||
+        region.size > m_header.data_size - region.offset)
+    {
+      ERROR_LOG(DISCIO, "Junk region %u of %s is invalid", i, m_file_name.c_str());
+      m_junk.clear();
+      return false;
+    }
+    m_junk[i] = region;
+    previous_end = region.offset + region.size;
+  }
+  return true;
 }
 
 CompressedBlobReader::~CompressedBlobReader()
 {
+  {
+    std::lock_guard<std::mutex> lock(m_decode_mutex);
+    m_decode_quit = true;
+  }
+  m_decode_job_posted.notify_all();
+  for (std::thread& thread : m_decode_threads)
+    thread.join();
 }
 
 // IMPORTANT: Calling this function invalidates all earlier pointers gotten from this function.
@@ -84,25 +180,54 @@ u64 CompressedBlobReader::GetBlockCompressedSize(u64 block_num) const
   return 0;
 }
 
+CompressedBlobReader::BlockLocation CompressedBlobReader::GetBlockLocation(u64 block_num) const
+{
+  BlockLocation location;
+  location.size = (u32)GetBlockCompressedSize(block_num);
+  location.file_offset = m_block_pointers[block_num] + m_data_offset;
+  location.uncompressed = (location.file_offset & (1ULL << 63)) != 0;
+  location.file_offset &= ~(1ULL << 63);
+  return location;
+}
+
 bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
 {
-  bool uncompressed = false;
-  u32 comp_block_size = (u32)GetBlockCompressedSize(block_num);
-  u64 offset = m_block_pointers[block_num] + m_data_offset;
+  const BlockLocation location = GetBlockLocation(block_num);
 
-  if (offset & (1ULL << 63))
+  // clear unused part of zlib buffer. maybe this can be deleted when it works fully.
+  memset(&m_zlib_buffer[location.size], 0, m_zlib_buffer.size() - location.size);
+
+  m_file.Seek(location.file_offset, SEEK_SET);
+  if (!m_file.ReadBytes(m_zlib_buffer.data(), location.size))
   {
-    if (comp_block_size != m_header.block_size)
-      PanicAlert("Uncompressed block with wrong size");
-    uncompressed = true;
-    offset &= ~(1ULL << 63);
+    PanicAlertT("The disc image \"%s\" is truncated, some of the data is missing.",
+                m_file_name.c_str());
+    m_file.Clear();
+    return false;
   }
 
-  // clear unused part of zlib buffer. maybe this can be deleted when it works fully.
-  memset(&m_zlib_buffer[comp_block_size], 0, m_zlib_buffer.size() - comp_block_size);
+  return DecodeBlock(block_num, location, m_zlib_buffer.data(), out_ptr);
+}
+
+bool CompressedBlobReader::ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr)
+{
+  if (block_num + num_blocks > m_header.num_blocks)
+    return false;
+
+  // Blocks are stored in order, so their data can be fetched with a single read. Anything odd
+  // (which CompressFileToBlob never writes) goes through GetBlock one block at a time instead.
+  const BlockLocation first = GetBlockLocation(block_num);
+  const BlockLocation last = GetBlockLocation(block_num + num_blocks - 1);
+  const u64 data_end = last.file_offset + last.size;
+  if (num_blocks < 2 || data_end < first.file_offset ||
+      data_end - first.file_offset > num_blocks * m_header.block_size)
+  {
+    return SectorReader::ReadMultipleAlignedBlocks(block_num, num_blocks, out_ptr);
+  }
 
-  m_file.Seek(offset, SEEK_SET);
-  if (!m_file.ReadBytes(m_zlib_buffer.data(), comp_block_size))
+  m_multi_block_buffer.resize(data_end - first.file_offset);
+  m_file.Seek(first.file_offset, SEEK_SET);
+  if (!m_file.ReadBytes(m_multi_block_buffer.data(), m_multi_block_buffer.size()))
   {
     PanicAlertT("The disc image \"%s\" is truncated, some of the data is missing.",
                 m_file_name.c_str());
@@ -110,22 +235,110 @@ bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
     return false;
   }
 
+  // Inflating is what makes GCZ images slow to read, and every block is compressed on its own,
+  // so large reads are spread over several threads.
+  std::atomic<bool> success{true};
+  const auto decode_blocks = [&](u64 first_block, u64 step) {
+    for (u64 i = first_block; i < num_blocks; i += step)
+    {
+      const BlockLocation location = GetBlockLocation(block_num + i);
+      if (location.file_offset < first.file_offset ||
+          location.file_offset + location.size > data_end ||
+          !DecodeBlock(block_num + i, location,
+                       &m_multi_block_buffer[location.file_offset - first.file_offset],
+                       out_ptr + i * m_header.block_size))
+      {
+        success = false;
+      }
+    }
+  };
+
+  const u64 num_threads = std::max<u64>(
+      std::min<u64>(std::thread::hardware_concurrency(), num_blocks / MIN_BLOCKS_PER_THREAD), 1);
+  RunOnDecodeThreads(static_cast<u32>(num_threads), decode_blocks);
+
+  return success;
+}
+
+void CompressedBlobReader::RunOnDecodeThreads(u32 num_threads,
+                                              const std::function<void(u32, u32)>& job)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_decode_mutex);
+    while (m_decode_threads.size() + 1 < num_threads)
+    {
+      m_decode_threads.emplace_back(&CompressedBlobReader::DecodeThread, this,
+                                    static_cast<u32>(m_decode_threads.size() + 1),
+                                    m_decode_generation);
+    }
+
+    m_decode_job = &job;
+    m_decode_job_threads = num_threads;
+    m_decode_jobs_pending = num_threads - 1;
+    m_decode_generation++;
+  }
+  m_decode_job_posted.notify_all();
+
+  job(0, num_threads);
+
+  std::unique_lock<std::mutex> lock(m_decode_mutex);
+  m_decode_job_done.wait(lock, [this] { return m_decode_jobs_pending == 0; });
+  m_decode_job = nullptr;
+}
+
+void CompressedBlobReader::DecodeThread(u32 index, u64 generation)
+{
+  Common::SetCurrentThreadName("GCZ decoder");
+
+  std::unique_lock<std::mutex> lock(m_decode_mutex);
+  while (true)
+  {
+    m_decode_job_posted.wait(lock,
+                             [&] { return m_decode_quit || m_decode_generation != generation; });
+    if (m_decode_quit)
+      return;
+
+    generation = m_decode_generation;
+    // Smaller reads only use some of the threads.
+    if (index >= m_decode_job_threads)
+      continue;
+
+    const std::function<void(u32, u32)>& job = *m_decode_job;
+    const u32 num_threads = m_decode_job_threads;
+    lock.unlock();
+    job(index, num_threads);
+    lock.lock();
+
+    if (--m_decode_jobs_pending == 0)
+      m_decode_job_done.notify_one();
+  }
+}
+
+bool CompressedBlobReader::DecodeBlock(u64 block_num, const BlockLocation& location,
+                                       const u8* data, u8* out_ptr) const
+{
+  if (location.uncompressed && location.size != m_header.block_size)
+  {
+    PanicAlert("Uncompressed block with wrong size");
+    return false;
+  }
+
   // First, check hash.
-  u32 block_hash = HashAdler32(m_zlib_buffer.data(), comp_block_size);
+  u32 block_hash = HashAdler32(data, location.size);
   if (block_hash != m_hashes[block_num])
     PanicAlertT("The disc image \"%s\" is corrupt.\n"
                 "Hash of block %" PRIu64 " is %08x instead of %08x.",
                 m_file_name.c_str(), block_num, block_hash, m_hashes[block_num]);
 
-  if (uncompressed)
+  if (location.uncompressed)
   {
-    std::copy(m_zlib_buffer.begin(), m_zlib_buffer.begin() + comp_block_size, out_ptr);
+    std::copy(data, data + location.size, out_ptr);
   }
   else
   {
     z_stream z = {};
-    z.next_in = m_zlib_buffer.data();
-    z.avail_in = comp_block_size;
+    z.next_in = const_cast<u8*>(data);
+    z.avail_in = location.size;
     if (z.avail_in > m_header.block_size)
     {
       PanicAlert("We have a problem");
@@ -148,9 +361,34 @@ bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
       return false;
     }
   }
+
+  RegenerateJunk(block_num, out_ptr);
   return true;
 }
 
+void CompressedBlobReader::RegenerateJunk(u64 block_num, u8* out_ptr) const
+{
+  const u64 block_start = block_num * m_header.block_size;
+  const u64 block_end = block_start + m_header.block_size;
+
+  // The regions are sorted and don't overlap, so start from the first one that ends in the block
+  auto it = std::upper_bound(
+      m_junk.begin(), m_junk.end(), block_start,
+      [](u64 offset, const DiscScrubber::JunkRegion& region) {
+        return offset < region.offset + region.size;
+      });
+  for (; it != m_junk.end() && it->offset < block_end; ++it)
+  {
+    const u64 start = std::max(block_start, it->offset);
+    const u64 end = std::min(block_end, it->offset + it->size);
+
+    LaggedFibonacciGenerator lfg;
+    lfg.SetSeed(it->seed);
+    lfg.Skip(start % DiscScrubber::CLUSTER_SIZE);
+    lfg.GetBytes(end - start, out_ptr + (start - block_start));
+  }
+}
+
 bool CompressFileToBlob(const std::string& infile_path, const std::string& outfile_path,
                         u32 sub_type, int block_size, CompressCB callback, void* arg)
 {
@@ -182,20 +420,26 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
   DiscScrubber disc_scrubber;
   if (sub_type == 1)
   {
-    if (!disc_scrubber.SetupScrub(infile_path, block_size))
+    if (disc_scrubber.SetupScrub(infile_path))
+    {
+      scrubbing = true;
+    }
+    else if (disc_scrubber.IsWiiDisc())
     {
       PanicAlertT("\"%s\" failed to be scrubbed. Probably the image is corrupt.",
                   infile_path.c_str());
       return false;
     }
-
-    scrubbing = true;
+    else
+    {
+      // Nothing on GameCube discs has to be scrubbed for them to compress, so compress them as
+      // they are, like before they could be scrubbed.
+      WARN_LOG(DISCIO, "Failed to scrub %s, compressing it without scrubbing",
+               infile_path.c_str());
+      sub_type = 0;
+    }
   }
 
-  z_stream z = {};
-  if (deflateInit(&z, 9) != Z_OK)
-    return false;
-
   callback(GetStringT("Files opened, ready to compress."), 0, arg);
 
   CompressedBlobHeader header;
@@ -209,8 +453,17 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
 
   std::vector<u64> offsets(header.num_blocks);
   std::vector<u32> hashes(header.num_blocks);
-  std::vector<u8> out_buf(block_size);
-  std::vector<u8> in_buf(block_size);
+  std::vector<DiscScrubber::JunkRegion> junk;
+
+  // Deflating at level 9 is what takes the time, and every block is compressed on its own, so a
+  // batch of blocks is read and scrubbed, compressed on all cores, and then written in order.
+  const u32 num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  const u32 batch_blocks = num_threads * COMPRESS_BLOCKS_PER_THREAD;
+  std::vector<u8> in_buf(static_cast<size_t>(batch_blocks) * block_size);
+  std::vector<u8> out_buf(in_buf.size());
+  // 0 for blocks that are stored uncompressed
+  std::vector<u32> out_sizes(batch_blocks);
+  std::vector<std::vector<DiscScrubber::JunkRegion>> batch_junk(batch_blocks);
 
   // seek past the header (we will write it at the end)
   outfile.Seek(sizeof(CompressedBlobHeader), SEEK_CUR);
@@ -223,91 +476,158 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
   u64 position = 0;
   int num_compressed = 0;
   int num_stored = 0;
-  int progress_monitor = std::max<int>(1, header.num_blocks / 1000);
+  u32 progress_monitor = std::max<u32>(1, header.num_blocks / 1000);
+  u32 next_progress_block = 0;
   bool success = true;
 
-  for (u32 i = 0; i < header.num_blocks; i++)
+  for (u32 first_block = 0; success && first_block < header.num_blocks;
+       first_block += batch_blocks)
   {
-    if (i % progress_monitor == 0)
+    const u32 num_blocks = std::min(batch_blocks, header.num_blocks - first_block);
+
+    if (first_block >= next_progress_block)
     {
-      const u64 inpos = infile.Tell();
+      const u64 inpos = static_cast<u64>(first_block) * block_size;
       int ratio = 0;
       if (inpos != 0)
         ratio = (int)(100 * position / inpos);
 
       std::string temp =
-          StringFromFormat(GetStringT("%i of %i blocks. Compression ratio %i%%").c_str(), i,
-                           header.num_blocks, ratio);
-      bool was_cancelled = !callback(temp, (float)i / (float)header.num_blocks, arg);
+          StringFromFormat(GetStringT("%i of %i blocks. Compression ratio %i%%").c_str(),
+                           first_block, header.num_blocks, ratio);
+      bool was_cancelled = !callback(temp, (float)first_block / (float)header.num_blocks, arg);
       if (was_cancelled)
       {
         success = false;
         break;
       }
+      next_progress_block = first_block + progress_monitor;
     }
 
-    offsets[i] = position;
-
+    const size_t batch_size = static_cast<size_t>(num_blocks) * block_size;
     size_t read_bytes;
-    if (scrubbing)
-      read_bytes = disc_scrubber.GetNextBlock(infile, in_buf.data());
-    else
-      infile.ReadArray(in_buf.data(), header.block_size, &read_bytes);
-    if (read_bytes < header.block_size)
-      std::fill(in_buf.begin() + read_bytes, in_buf.begin() + header.block_size, 0);
+    infile.ReadArray(in_buf.data(), batch_size, &read_bytes);
+    if (read_bytes < batch_size)
+      std::fill(in_buf.begin() + read_bytes, in_buf.begin() + batch_size, 0);
+
+    std::atomic<bool> deflate_ok{true};
+    const auto compress_blocks = [&](u32 first_in_batch, u32 step) {
+      z_stream z = {};
+      if (deflateInit(&z, 9) != Z_OK)
+      {
+        deflate_ok = false;
+        return;
+      }
+
+      for (u32 i = first_in_batch; i < num_blocks; i += step)
+      {
+        u8* const in = &in_buf[static_cast<size_t>(i) * block_size];
+        u8* const out = &out_buf[static_cast<size_t>(i) * block_size];
+
+        batch_junk[i].clear();
+        if (scrubbing)
+        {
+          disc_scrubber.ScrubBlock(static_cast<u64>(first_block + i) * block_size, in,
+                                   block_size, &batch_junk[i]);
+        }
+
+        if (deflateReset(&z) != Z_OK)
+        {
+          deflate_ok = false;
+          break;
+        }
+        z.next_in = in;
+        z.avail_in = header.block_size;
+        z.next_out = out;
+        z.avail_out = block_size;
+
+        const int status = deflate(&z, Z_FINISH);
+        // Store the block uncompressed if it doesn't get any smaller
+        if ((status != Z_STREAM_END) || (z.avail_out < 10))
+          out_sizes[i] = 0;
+        else
+          out_sizes[i] = block_size - z.avail_out;
+
+        hashes[first_block + i] =
+            out_sizes[i] == 0 ? HashAdler32(in, block_size) : HashAdler32(out, out_sizes[i]);
+      }
+
+      deflateEnd(&z);
+    };
 
-    int retval = deflateReset(&z);
-    z.next_in = in_buf.data();
-    z.avail_in = header.block_size;
-    z.next_out = out_buf.data();
-    z.avail_out = block_size;
+    std::vector<std::thread> threads;
+    const u32 num_batch_threads = std::min(num_threads, num_blocks);
+    for (u32 i = 1; i < num_batch_threads; ++i)
+      threads.emplace_back(compress_blocks, i, num_batch_threads);
+    compress_blocks(0, num_batch_threads);
+    for (std::thread& thread : threads)
+      thread.join();
 
-    if (retval != Z_OK)
+    if (!deflate_ok)
     {
       ERROR_LOG(DISCIO, "Deflate failed");
       success = false;
       break;
     }
 
-    int status = deflate(&z, Z_FINISH);
-    int comp_size = block_size - z.avail_out;
-
-    u8* write_buf;
-    int write_size;
-    if ((status != Z_STREAM_END) || (z.avail_out < 10))
+    for (u32 i = 0; i < num_blocks; ++i)
     {
-      // PanicAlert("%i %i Store %i", i*block_size, position, comp_size);
-      // let's store uncompressed
-      write_buf = in_buf.data();
-      offsets[i] |= 0x8000000000000000ULL;
-      write_size = block_size;
-      num_stored++;
-    }
-    else
-    {
-      // let's store compressed
-      // PanicAlert("Comp %i to %i", block_size, comp_size);
-      write_buf = out_buf.data();
-      write_size = comp_size;
-      num_compressed++;
+      const u32 block = first_block + i;
+      offsets[block] = position;
+
+      u8* write_buf;
+      int write_size;
+      if (out_sizes[i] == 0)
+      {
+        // let's store uncompressed
+        write_buf = &in_buf[static_cast<size_t>(i) * block_size];
+        offsets[block] |= 0x8000000000000000ULL;
+        write_size = block_size;
+        num_stored++;
+      }
+      else
+      {
+        // let's store compressed
+        write_buf = &out_buf[static_cast<size_t>(i) * block_size];
+        write_size = out_sizes[i];
+        num_compressed++;
+      }
+
+      if (!outfile.WriteBytes(write_buf, write_size))
+      {
+        PanicAlertT("Failed to write the output file \"%s\".\n"
+                    "Check that you have enough space available on the target drive.",
+                    outfile_path.c_str());
+        success = false;
+        break;
+      }
+
+      position += write_size;
+
+      for (const DiscScrubber::JunkRegion& region : batch_junk[i])
+        DiscScrubber::AddJunkRegion(region, &junk);
     }
+  }
 
-    if (!outfile.WriteBytes(write_buf, write_size))
+  header.compressed_data_size = position;
+
+  if (success && !junk.empty())
+  {
+    std::vector<u8> table(JUNK_TABLE_HEADER_SIZE + junk.size() * JUNK_REGION_SIZE);
+    WriteLE32(GCZ_JUNK_MAGIC, &table[0]);
+    WriteLE32(static_cast<u32>(junk.size()), &table[4]);
+    for (size_t i = 0; i < junk.size(); ++i)
+      WriteJunkRegion(junk[i], &table[JUNK_TABLE_HEADER_SIZE + i * JUNK_REGION_SIZE]);
+    success = outfile.WriteBytes(table.data(), table.size());
+    header.magic_cookie = GCZ_MAGIC_WITH_JUNK;
+    if (!success)
     {
       PanicAlertT("Failed to write the output file \"%s\".\n"
                   "Check that you have enough space available on the target drive.",
                   outfile_path.c_str());
-      success = false;
-      break;
     }
-
-    position += write_size;
-
-    hashes[i] = HashAdler32(write_buf, write_size);
   }
 
-  header.compressed_data_size = position;
-
   if (!success)
   {
     // Remove the incomplete output file.
@@ -323,9 +643,6 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
     outfile.WriteArray(hashes.data(), header.num_blocks);
   }
 
-  // Cleanup
-  deflateEnd(&z);
-
   if (success)
   {
     callback(GetStringT("Done compressing disc image."), 1.0f, arg);
@@ -336,18 +653,16 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
 bool DecompressBlobToFile(const std::string& infile_path, const std::string& outfile_path,
                           CompressCB callback, void* arg)
 {
-  std::unique_ptr<CompressedBlobReader> reader;
   {
     File::IOFile infile(infile_path, "rb");
-    if (!IsGCZBlob(infile))
+    if (!IsGCZBlob(infile) && !IsWCZBlob(infile))
     {
       PanicAlertT("File not compressed");
       return false;
     }
-
-    reader = CompressedBlobReader::Create(std::move(infile), infile_path);
   }
 
+  std::unique_ptr<IBlobReader> reader = CreateBlobReader(infile_path);
   if (!reader)
   {
     PanicAlertT("Failed to open the input file \"%s\".", infile_path.c_str());
@@ -364,13 +679,12 @@ bool DecompressBlobToFile(const std::string& infile_path, const std::string& out
     return false;
   }
 
-  const CompressedBlobHeader& header = reader->GetHeader();
-  static const size_t BUFFER_BLOCKS = 32;
-  size_t buffer_size = header.block_size * BUFFER_BLOCKS;
-  size_t last_buffer_size = header.block_size * (header.num_blocks % BUFFER_BLOCKS);
-  std::vector<u8> buffer(buffer_size);
-  u32 num_buffers = (header.num_blocks + BUFFER_BLOCKS - 1) / BUFFER_BLOCKS;
-  int progress_monitor = std::max<int>(1, num_buffers / 100);
+  // A whole WCZ chunk, and enough GCZ blocks for them to be decompressed in parallel
+  static const u64 BUFFER_SIZE = WCZ_CHUNK_SIZE;
+  const u64 data_size = reader->GetDataSize();
+  std::vector<u8> buffer(BUFFER_SIZE);
+  const u64 num_buffers = (data_size + BUFFER_SIZE - 1) / BUFFER_SIZE;
+  const u64 progress_monitor = std::max<u64>(1, num_buffers / 100);
   bool success = true;
 
   for (u64 i = 0; i < num_buffers; i++)
@@ -384,8 +698,13 @@ bool DecompressBlobToFile(const std::string& infile_path, const std::string& out
         break;
       }
     }
-    const size_t sz = i == num_buffers - 1 ? last_buffer_size : buffer_size;
-    reader->Read(i * buffer_size, sz, buffer.data());
+    const size_t sz = static_cast<size_t>(std::min(BUFFER_SIZE, data_size - i * BUFFER_SIZE));
+    if (!reader->Read(i * BUFFER_SIZE, sz, buffer.data()))
+    {
+      ERROR_LOG(DISCIO, "Failed to read %s at 0x%" PRIx64, infile_path.c_str(), i * BUFFER_SIZE);
+      success = false;
+      break;
+    }
     if (!outfile.WriteBytes(buffer.data(), sz))
     {
       PanicAlertT("Failed to write the output file \"%s\".\n"
@@ -402,10 +721,6 @@ bool DecompressBlobToFile(const std::string& infile_path, const std::string& out
     outfile.Close();
     File::Delete(outfile_path);
   }
-  else
-  {
-    outfile.Resize(header.data_size);
-  }
 
   return success;
 }
@@ -416,7 +731,8 @@ bool IsGCZBlob(File::IOFile& file)
   if (!file.Seek(0, SEEK_SET))
     return false;
   CompressedBlobHeader header;
-  bool is_gcz = file.ReadArray(&header, 1) && header.magic_cookie == GCZ_MAGIC;
+  bool is_gcz = file.ReadArray(&header, 1) && (header.magic_cookie == GCZ_MAGIC ||
+                                                header.magic_cookie == GCZ_MAGIC_WITH_JUNK);
   file.Seek(position, SEEK_SET);
   return is_gcz;
 }
@@ -10,25 +10,40 @@
 // * Header
 // * [Block Pointers interleaved with block hashes (hash of decompressed data)]
 // * [Data]
+// * [Junk table, only written when scrubbing]
 
 #pragma once
 
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
 #include "DiscIO/Blob.h"
+#include "DiscIO/DiscScrubber.h"
 
 namespace DiscIO
 {
 static constexpr u32 GCZ_MAGIC = 0xB10BC001;
+// Used instead of GCZ_MAGIC when there is a junk table, so that older readers, which would
+// return zeroes where the junk was, refuse the image.
+static constexpr u32 GCZ_MAGIC_WITH_JUNK = 0xB10BC002;
+static constexpr u32 GCZ_JUNK_MAGIC = 0x4B4E554A;  // "JUNK"
 
 // GCZ file structure:
 // BlobHeader
 // u64 offsetsToBlocks[n], top bit specifies whether the block is compressed, or not.
+// u32 hashes[n]
 // compressed data
+// Only with GCZ_MAGIC_WITH_JUNK, all little endian:
+// u32 junk magic, u32 m, junk regions[m]: junk that was zeroed by scrubbing and is regenerated
+//   on top of the decompressed data. A region is a u64 offset, a u32 size and the 17 u32 words
+//   of a LaggedFibonacciGenerator::Seed (80 bytes). Regions are sorted and don't overlap.
 
 // Blocks that won't compress to less than 97% of the original size are stored as-is.
 struct CompressedBlobHeader  // 32 bytes
@@ -54,17 +69,59 @@ public:
   u64 GetBlockCompressedSize(u64 block_num) const;
   bool GetBlock(u64 block_num, u8* out_ptr) override;
 
+protected:
+  bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr) override;
+
 private:
+  // Reads of at least this many blocks per thread are decompressed in parallel.
+  static constexpr u64 MIN_BLOCKS_PER_THREAD = 4;
+
+  struct BlockLocation
+  {
+    u64 file_offset;
+    u32 size;
+    bool uncompressed;
+  };
+
   CompressedBlobReader(File::IOFile file, const std::string& filename);
+  // Returns false if the image has a junk table that can't be read or isn't valid.
+  bool ReadJunkTable();
+
+  BlockLocation GetBlockLocation(u64 block_num) const;
+  // Checks the hash of a block's stored data and decompresses it into out_ptr.
+  // Only reads state that is fixed at construction, so several threads may call it at once.
+  bool DecodeBlock(u64 block_num, const BlockLocation& location, const u8* data,
+                   u8* out_ptr) const;
+  void RegenerateJunk(u64 block_num, u8* out_ptr) const;
+
+  // Runs job(index, num_threads) on the calling thread with index 0, and on num_threads - 1 of
+  // the decode threads, and waits for all of them to finish.
+  void RunOnDecodeThreads(u32 num_threads, const std::function<void(u32, u32)>& job);
+  void DecodeThread(u32 index, u64 generation);
 
   CompressedBlobHeader m_header;
   std::vector<u64> m_block_pointers;
   std::vector<u32> m_hashes;
+  std::vector<DiscScrubber::JunkRegion> m_junk;
   int m_data_offset;
   File::IOFile m_file;
   u64 m_file_size;
   std::vector<u8> m_zlib_buffer;
+  std::vector<u8> m_multi_block_buffer;
   std::string m_file_name;
+
+  // Helper threads for decompressing large reads. They are started by the first read that needs
+  // them and kept until the reader is destroyed, so reads don't pay for creating threads.
+  std::vector<std::thread> m_decode_threads;
+  std::mutex m_decode_mutex;
+  std::condition_variable m_decode_job_posted;
+  std::condition_variable m_decode_job_done;
+  const std::function<void(u32, u32)>* m_decode_job = nullptr;
+  u32 m_decode_job_threads = 0;
+  u32 m_decode_jobs_pending = 0;
+  // Incremented for every job, so that the threads can tell a new one from the last one.
+  u64 m_decode_generation = 0;
+  bool m_decode_quit = false;
 };
 
 }  // namespace
@@ -5,261 +5,311 @@
 #include <algorithm>
 #include <cinttypes>
 #include <cstddef>
-#include <cstdio>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "Common/CommonTypes.h"
-#include "Common/FileUtil.h"
 #include "Common/Logging/Log.h"
 #include "DiscIO/DiscScrubber.h"
+#include "DiscIO/Enums.h"
 #include "DiscIO/Filesystem.h"
+#include "DiscIO/LaggedFibonacciGenerator.h"
 #include "DiscIO/Volume.h"
 #include "DiscIO/VolumeCreator.h"
 
 namespace DiscIO
 {
-constexpr size_t CLUSTER_SIZE = 0x8000;
+static void MarkAsUsed(std::vector<bool>* used_clusters, u64 offset, u64 size)
+{
+  DEBUG_LOG(DISCIO, "Marking 0x%016" PRIx64 " - 0x%016" PRIx64 " as used", offset,
+            offset + size);
 
-DiscScrubber::DiscScrubber() = default;
-DiscScrubber::~DiscScrubber() = default;
+  if (size == 0)
+    return;
+
+  const u64 end_cluster = (offset + size - 1) / DiscScrubber::CLUSTER_SIZE + 1;
+  for (u64 cluster = offset / DiscScrubber::CLUSTER_SIZE;
+       cluster < std::min<u64>(end_cluster, used_clusters->size()); ++cluster)
+  {
+    (*used_clusters)[cluster] = true;
+  }
+}
 
-bool DiscScrubber::SetupScrub(const std::string& filename, int block_size)
+// Compensate for 0x400 (SHA-1) per 0x8000 (cluster), and round to whole clusters
+static void MarkAsUsedE(std::vector<bool>* used_clusters, u64 partition_data_offset, u64 offset,
+                        u64 size)
 {
-  m_filename = filename;
-  m_block_size = block_size;
+  u64 first_cluster_start = offset / 0x7c00 * DiscScrubber::CLUSTER_SIZE + partition_data_offset;
 
-  if (CLUSTER_SIZE % m_block_size != 0)
+  u64 last_cluster_end;
+  if (size == 0)
   {
-    ERROR_LOG(DISCIO, "Block size %u is not a factor of 0x8000, scrubbing not possible",
-              m_block_size);
-    return false;
+    // Without this special case, a size of 0 can be rounded to 1 cluster instead of 0
+    last_cluster_end = first_cluster_start;
+  }
+  else
+  {
+    last_cluster_end =
+        ((offset + size - 1) / 0x7c00 + 1) * DiscScrubber::CLUSTER_SIZE + partition_data_offset;
   }
 
-  m_disc = CreateVolumeFromFilename(filename);
-  if (!m_disc)
+  MarkAsUsed(used_clusters, first_cluster_start, last_cluster_end - first_cluster_start);
+}
+
+// Helper functions for reading the BE volume
+static bool ReadFromVolume(const IVolume& volume, u64 offset, u32* buffer, bool decrypt)
+{
+  return volume.ReadSwapped(offset, buffer, decrypt);
+}
+
+static bool ReadFromVolume(const IVolume& volume, u64 offset, u64* buffer, bool decrypt)
+{
+  u32 temp_buffer;
+  if (!volume.ReadSwapped(offset, &temp_buffer, decrypt))
+    return false;
+  *buffer = static_cast<u64>(temp_buffer) << 2;
+  return true;
+}
+
+DiscScrubber::DiscScrubber() = default;
+DiscScrubber::~DiscScrubber() = default;
+
+bool DiscScrubber::SetupScrub(const std::string& filename)
+{
+  m_filename = filename;
+
+  std::unique_ptr<IVolume> disc = CreateVolumeFromFilename(filename);
+  if (!disc)
     return false;
 
-  m_file_size = m_disc->GetSize();
+  m_is_wii = disc->GetVolumeType() == Platform::WII_DISC;
 
-  const size_t num_clusters = static_cast<size_t>(m_file_size / CLUSTER_SIZE);
+  const size_t num_clusters = static_cast<size_t>(
+      (disc->GetSize() + CLUSTER_SIZE - 1) / CLUSTER_SIZE);
 
   // Warn if not DVD5 or DVD9 size
-  if (num_clusters != 0x23048 && num_clusters != 0x46090)
+  if (m_is_wii && num_clusters != 0x23048 && num_clusters != 0x46090)
   {
     WARN_LOG(DISCIO, "%s is not a standard sized Wii disc! (%zx blocks)", filename.c_str(),
              num_clusters);
   }
 
-  // Table of free blocks
-  m_free_table.resize(num_clusters, 1);
+  m_used_clusters.assign(num_clusters, false);
 
-  // Fill out table of free blocks
-  const bool success = ParseDisc();
+  if (m_is_wii)
+    return ParseWiiDisc(*disc);
 
-  // Done with it; need it closed for the next part
-  m_disc.reset();
-  m_block_count = 0;
-
-  m_is_scrubbing = success;
-  return success;
+  std::unique_ptr<IFileSystem> filesystem = CreateFileSystem(disc.get());
+  if (!filesystem)
+  {
+    ERROR_LOG(DISCIO, "Failed to create filesystem for %s", filename.c_str());
+    return false;
+  }
+  return ParseFileSystem(*disc, filesystem.get(), false, [this](u64 offset, u64 size) {
+    MarkAsUsed(&m_used_clusters, offset, size);
+  });
 }
 
-size_t DiscScrubber::GetNextBlock(File::IOFile& in, u8* buffer)
+bool DiscScrubber::IsClusterUsed(u64 offset) const
 {
-  const u64 current_offset = m_block_count * m_block_size;
-  const u64 i = current_offset / CLUSTER_SIZE;
+  const u64 cluster = offset / CLUSTER_SIZE;
+  return cluster >= m_used_clusters.size() || m_used_clusters[cluster];
+}
 
-  size_t read_bytes = 0;
-  if (m_is_scrubbing && m_free_table[i])
-  {
-    DEBUG_LOG(DISCIO, "Freeing 0x%016" PRIx64, current_offset);
-    std::fill(buffer, buffer + m_block_size, 0x00);
-    in.Seek(m_block_size, SEEK_CUR);
-    read_bytes = m_block_size;
-  }
-  else
+void DiscScrubber::ScrubBlock(u64 offset, u8* data, size_t size,
+                              std::vector<JunkRegion>* junk_out) const
+{
+  size_t position = 0;
+  while (position < size)
   {
-    DEBUG_LOG(DISCIO, "Used    0x%016" PRIx64, current_offset);
-    in.ReadArray(buffer, m_block_size, &read_bytes);
-  }
+    const u64 current_offset = offset + position;
+    const size_t length = static_cast<size_t>(
+        std::min<u64>(size - position, CLUSTER_SIZE - current_offset % CLUSTER_SIZE));
+    u8* const cluster_data = data + position;
+    position += length;
 
-  m_block_count++;
-  return read_bytes;
-}
+    if (IsClusterUsed(current_offset))
+      continue;
 
-void DiscScrubber::MarkAsUsed(u64 offset, u64 size)
-{
-  u64 current_offset = offset;
-  const u64 end_offset = current_offset + size;
+    LaggedFibonacciGenerator::Seed seed;
+    const size_t junk_size = LaggedFibonacciGenerator::GetSeed(
+        cluster_data, length, current_offset % CLUSTER_SIZE, &seed);
 
-  DEBUG_LOG(DISCIO, "Marking 0x%016" PRIx64 " - 0x%016" PRIx64 " as used", offset, end_offset);
+    // Zeroes are "generated" by a seed of zeroes too, but they compress fine as they are
+    if (junk_size != 0 && std::any_of(seed.begin(), seed.end(), [](u32 word) { return word; }))
+    {
+      DEBUG_LOG(DISCIO, "Junk    0x%016" PRIx64 " (0x%zx bytes)", current_offset, junk_size);
+      AddJunkRegion({current_offset, static_cast<u32>(junk_size), seed}, junk_out);
+      std::fill(cluster_data, cluster_data + junk_size, 0);
+    }
 
-  while (current_offset < end_offset && current_offset < m_file_size)
-  {
-    m_free_table[current_offset / CLUSTER_SIZE] = 0;
-    current_offset += CLUSTER_SIZE;
+    if (m_is_wii)
+    {
+      DEBUG_LOG(DISCIO, "Freeing 0x%016" PRIx64, current_offset);
+      std::fill(cluster_data, cluster_data + length, 0);
+    }
   }
 }
 
-// Compensate for 0x400 (SHA-1) per 0x8000 (cluster), and round to whole clusters
-void DiscScrubber::MarkAsUsedE(u64 partition_data_offset, u64 offset, u64 size)
+void DiscScrubber::AddJunkRegion(const JunkRegion& region, std::vector<JunkRegion>* junk)
 {
-  u64 first_cluster_start = offset / 0x7c00 * CLUSTER_SIZE + partition_data_offset;
-
-  u64 last_cluster_end;
-  if (size == 0)
+  JunkRegion* last = junk->empty() ? nullptr : &junk->back();
+  if (last && last->offset + last->size == region.offset && last->seed == region.seed &&
+      last->offset / CLUSTER_SIZE == region.offset / CLUSTER_SIZE)
   {
-    // Without this special case, a size of 0 can be rounded to 1 cluster instead of 0
-    last_cluster_end = first_cluster_start;
+    last->size += region.size;
   }
   else
   {
-    last_cluster_end = ((offset + size - 1) / 0x7c00 + 1) * CLUSTER_SIZE + partition_data_offset;
+    junk->push_back(region);
   }
-
-  MarkAsUsed(first_cluster_start, last_cluster_end - first_cluster_start);
-}
-
-// Helper functions for reading the BE volume
-bool DiscScrubber::ReadFromVolume(u64 offset, u32& buffer, bool decrypt)
-{
-  return m_disc->ReadSwapped(offset, &buffer, decrypt);
-}
-
-bool DiscScrubber::ReadFromVolume(u64 offset, u64& buffer, bool decrypt)
-{
-  u32 temp_buffer;
-  if (!m_disc->ReadSwapped(offset, &temp_buffer, decrypt))
-    return false;
-  buffer = static_cast<u64>(temp_buffer) << 2;
-  return true;
 }
 
-bool DiscScrubber::ParseDisc()
+bool DiscScrubber::ParseWiiDisc(const IVolume& disc)
 {
   // Mark the header as used - it's mostly 0s anyways
-  MarkAsUsed(0, 0x50000);
+  MarkAsUsed(&m_used_clusters, 0, 0x50000);
 
+  std::vector<Partition> partitions;
   for (u32 x = 0; x < 4; x++)
   {
-    if (!ReadFromVolume(0x40000 + (x * 8) + 0, m_partition_group[x].num_partitions, false) ||
-        !ReadFromVolume(0x40000 + (x * 8) + 4, m_partition_group[x].partitions_offset, false))
+    u32 num_partitions;
+    u64 partitions_offset;
+    if (!ReadFromVolume(disc, 0x40000 + (x * 8) + 0, &num_partitions, false) ||
+        !ReadFromVolume(disc, 0x40000 + (x * 8) + 4, &partitions_offset, false))
     {
       return false;
     }
 
     // Read all partitions
-    for (u32 i = 0; i < m_partition_group[x].num_partitions; i++)
+    for (u32 i = 0; i < num_partitions; i++)
     {
       Partition partition;
 
       partition.group_number = x;
       partition.number = i;
 
-      if (!ReadFromVolume(m_partition_group[x].partitions_offset + (i * 8) + 0, partition.offset,
-                          false) ||
-          !ReadFromVolume(m_partition_group[x].partitions_offset + (i * 8) + 4, partition.type,
-                          false) ||
-          !ReadFromVolume(partition.offset + 0x2a4, partition.header.tmd_size, false) ||
-          !ReadFromVolume(partition.offset + 0x2a8, partition.header.tmd_offset, false) ||
-          !ReadFromVolume(partition.offset + 0x2ac, partition.header.cert_chain_size, false) ||
-          !ReadFromVolume(partition.offset + 0x2b0, partition.header.cert_chain_offset, false) ||
-          !ReadFromVolume(partition.offset + 0x2b4, partition.header.h3_offset, false) ||
-          !ReadFromVolume(partition.offset + 0x2b8, partition.header.data_offset, false) ||
-          !ReadFromVolume(partition.offset + 0x2bc, partition.header.data_size, false))
+      const u64 entry_offset = partitions_offset + (i * 8);
+      PartitionHeader& header = partition.header;
+      if (!ReadFromVolume(disc, entry_offset + 0, &partition.offset, false) ||
+          !ReadFromVolume(disc, entry_offset + 4, &partition.type, false) ||
+          !ReadFromVolume(disc, partition.offset + 0x2a4, &header.tmd_size, false) ||
+          !ReadFromVolume(disc, partition.offset + 0x2a8, &header.tmd_offset, false) ||
+          !ReadFromVolume(disc, partition.offset + 0x2ac, &header.cert_chain_size, false) ||
+          !ReadFromVolume(disc, partition.offset + 0x2b0, &header.cert_chain_offset, false) ||
+          !ReadFromVolume(disc, partition.offset + 0x2b4, &header.h3_offset, false) ||
+          !ReadFromVolume(disc, partition.offset + 0x2b8, &header.data_offset, false) ||
+          !ReadFromVolume(disc, partition.offset + 0x2bc, &header.data_size, false))
       {
         return false;
       }
 
-      m_partition_group[x].partitions.push_back(partition);
-    }
+      MarkAsUsed(&m_used_clusters, partition.offset, 0x2c0);
+      MarkAsUsed(&m_used_clusters, partition.offset + header.tmd_offset, header.tmd_size);
+      MarkAsUsed(&m_used_clusters, partition.offset + header.cert_chain_offset,
+                 header.cert_chain_size);
+      MarkAsUsed(&m_used_clusters, partition.offset + header.h3_offset, 0x18000);
 
-    for (auto& partition : m_partition_group[x].partitions)
-    {
-      const PartitionHeader& header = partition.header;
+      partitions.push_back(partition);
+    }
+  }
 
-      MarkAsUsed(partition.offset, 0x2c0);
+  // Parsing the file systems is where the time goes, since everything has to be decrypted.
+  // Each partition is parsed on its own thread with its own volume and cluster table, and the
+  // tables are merged afterwards.
+  std::vector<std::vector<bool>> partition_clusters(partitions.size());
+  std::unique_ptr<bool[]> parsed_ok(new bool[partitions.size()]);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < partitions.size(); ++i)
+  {
+    partition_clusters[i].resize(m_used_clusters.size());
+    threads.emplace_back([this, &partitions, &partition_clusters, &parsed_ok, i] {
+      parsed_ok[i] = ParsePartitionData(partitions[i], &partition_clusters[i]);
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
 
-      MarkAsUsed(partition.offset + header.tmd_offset, header.tmd_size);
-      MarkAsUsed(partition.offset + header.cert_chain_offset, header.cert_chain_size);
-      MarkAsUsed(partition.offset + header.h3_offset, 0x18000);
-      // This would mark the whole (encrypted) data area
-      // we need to parse FST and other crap to find what's free within it!
-      // MarkAsUsed(partition.offset + header.data_offset, header.data_size);
+  for (size_t i = 0; i < partitions.size(); ++i)
+  {
+    if (!parsed_ok[i])
+      return false;
 
-      // Parse Data! This is where the big gain is
-      if (!ParsePartitionData(partition))
-        return false;
+    for (size_t cluster = 0; cluster < m_used_clusters.size(); ++cluster)
+    {
+      if (partition_clusters[i][cluster])
+        m_used_clusters[cluster] = true;
     }
   }
 
   return true;
 }
 
-// Operations dealing with encrypted space are done here - the volume is swapped to allow this
-bool DiscScrubber::ParsePartitionData(Partition& partition)
+bool DiscScrubber::ParsePartitionData(const Partition& partition,
+                                      std::vector<bool>* used_clusters) const
 {
-  bool parsed_ok = true;
-
-  // Switch out the main volume temporarily
-  std::unique_ptr<IVolume> old_volume;
-  m_disc.swap(old_volume);
-
-  // Ready some stuff
-  m_disc = CreateVolumeFromFilename(m_filename, partition.group_number, partition.number);
-  if (m_disc == nullptr)
+  std::unique_ptr<IVolume> volume =
+      CreateVolumeFromFilename(m_filename, partition.group_number, partition.number);
+  if (!volume)
   {
     ERROR_LOG(DISCIO, "Failed to create volume from file %s", m_filename.c_str());
-    m_disc.swap(old_volume);
     return false;
   }
 
-  std::unique_ptr<IFileSystem> filesystem(CreateFileSystem(m_disc.get()));
+  std::unique_ptr<IFileSystem> filesystem = CreateFileSystem(volume.get());
   if (!filesystem)
   {
     ERROR_LOG(DISCIO, "Failed to create filesystem for group %u partition %u",
               partition.group_number, partition.number);
-    parsed_ok = false;
+    return false;
   }
-  else
+
+  const u64 partition_data_offset = partition.offset + partition.header.data_offset;
+  return ParseFileSystem(*volume, filesystem.get(), true, [&](u64 offset, u64 size) {
+    MarkAsUsedE(used_clusters, partition_data_offset, offset, size);
+  });
+}
+
+// Marks everything a game can read through its file system. Offsets on Wii are relative to
+// the decrypted partition data.
+bool DiscScrubber::ParseFileSystem(const IVolume& volume, IFileSystem* filesystem, bool wii,
+                                   const MarkFunction& mark_as_used)
+{
+  // Mark things as used which are not in the filesystem
+  // Header, Header Information, Apploader
+  u32 apploader_size;
+  u32 apploader_trailer_size;
+  bool parsed_ok = ReadFromVolume(volume, 0x2440 + 0x14, &apploader_size, wii) &&
+                   ReadFromVolume(volume, 0x2440 + 0x18, &apploader_trailer_size, wii);
+  if (parsed_ok)
+    mark_as_used(0, 0x2440 + apploader_size + apploader_trailer_size);
+
+  // DOL
+  const u64 dol_offset = filesystem->GetBootDOLOffset();
+  const u64 dol_size = filesystem->GetBootDOLSize(dol_offset);
+  parsed_ok = parsed_ok && dol_offset && dol_size;
+  mark_as_used(dol_offset, dol_size);
+
+  // FST
+  u32 fst_offset;
+  u32 fst_size;
+  parsed_ok = parsed_ok && ReadFromVolume(volume, 0x424, &fst_offset, wii) &&
+              ReadFromVolume(volume, 0x428, &fst_size, wii);
+  if (parsed_ok)
   {
-    // Mark things as used which are not in the filesystem
-    // Header, Header Information, Apploader
-    parsed_ok = parsed_ok && ReadFromVolume(0x2440 + 0x14, partition.header.apploader_size, true);
-    parsed_ok =
-        parsed_ok && ReadFromVolume(0x2440 + 0x18, partition.header.apploader_trailer_size, true);
-    MarkAsUsedE(partition.offset + partition.header.data_offset, 0,
-                0x2440 + partition.header.apploader_size + partition.header.apploader_trailer_size);
-
-    // DOL
-    partition.header.dol_offset = filesystem->GetBootDOLOffset();
-    partition.header.dol_size = filesystem->GetBootDOLSize(partition.header.dol_offset);
-    parsed_ok = parsed_ok && partition.header.dol_offset && partition.header.dol_size;
-    MarkAsUsedE(partition.offset + partition.header.data_offset, partition.header.dol_offset,
-                partition.header.dol_size);
-
-    // FST
-    parsed_ok = parsed_ok && ReadFromVolume(0x424, partition.header.fst_offset, true);
-    parsed_ok = parsed_ok && ReadFromVolume(0x428, partition.header.fst_size, true);
-    MarkAsUsedE(partition.offset + partition.header.data_offset, partition.header.fst_offset,
-                partition.header.fst_size);
-
-    // Go through the filesystem and mark entries as used
-    for (const SFileInfo& file : filesystem->GetFileList())
-    {
-      DEBUG_LOG(DISCIO, "%s", file.m_FullPath.empty() ? "/" : file.m_FullPath.c_str());
-      if ((file.m_NameOffset & 0x1000000) == 0)
-      {
-        MarkAsUsedE(partition.offset + partition.header.data_offset, file.m_Offset,
-                    file.m_FileSize);
-      }
-    }
+    const u32 shift = wii ? 2 : 0;
+    mark_as_used(static_cast<u64>(fst_offset) << shift, static_cast<u64>(fst_size) << shift);
   }
 
-  // Swap back
-  m_disc.swap(old_volume);
+  // Go through the filesystem and mark entries as used
+  for (const SFileInfo& file : filesystem->GetFileList())
+  {
+    DEBUG_LOG(DISCIO, "%s", file.m_FullPath.empty() ? "/" : file.m_FullPath.c_str());
+    if ((file.m_NameOffset & 0x1000000) == 0)
+      mark_as_used(file.m_Offset, file.m_FileSize);
+  }
 
   return parsed_ok;
 }
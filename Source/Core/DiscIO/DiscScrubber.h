@@ -2,44 +2,69 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
-// DiscScrubber removes the garbage data from discs (currently Wii only) which
-// is on the disc due to encryption
-
-// It could be adapted to GameCube discs, but the gain is most likely negligible,
-// and having 1:1 backups of discs is always nice when they are reasonably sized
+// DiscScrubber finds out which parts of a disc hold data that a game can read, so that the
+// rest can be replaced with something that compresses well.
+//
+// On Wii discs, the unused parts of partitions are encrypted garbage that can't be recreated, so
+// they are simply zeroed. Everything else that is unused (which is all of it on GameCube discs)
+// is usually junk from Nintendo's pseudo-random generator. That is only replaced when it's
+// recognized, and reported so that it can be regenerated when reading, which keeps GameCube
+// images 1:1 backups.
 
 // Note: the technique is inspired by Wiiscrubber, but much simpler - intentionally :)
 
 #pragma once
 
-#include <array>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
-#include "Common/CommonTypes.h"
 
-namespace File
-{
-class IOFile;
-}
+#include "Common/CommonTypes.h"
+#include "DiscIO/LaggedFibonacciGenerator.h"
 
 namespace DiscIO
 {
+class IFileSystem;
 class IVolume;
 
 class DiscScrubber final
 {
 public:
+  // Used data is tracked in units of the blocks that Wii partitions are encrypted in.
+  static constexpr u64 CLUSTER_SIZE = 0x8000;
+
+  // Junk that was taken out of a block. It starts offset % CLUSTER_SIZE bytes into the stream
+  // that the seed generates, since junk restarts with a new seed at every cluster.
+  struct JunkRegion
+  {
+    u64 offset;
+    u32 size;
+    LaggedFibonacciGenerator::Seed seed;
+  };
+
   DiscScrubber();
   ~DiscScrubber();
 
-  bool SetupScrub(const std::string& filename, int block_size);
-  size_t GetNextBlock(File::IOFile& in, u8* buffer);
+  bool SetupScrub(const std::string& filename);
+  // Only valid after SetupScrub. False if the disc couldn't be opened at all.
+  bool IsWiiDisc() const { return m_is_wii; }
+
+  // One bit per cluster, set for the clusters that hold data, so any writer can use it.
+  const std::vector<bool>& GetUsedClusters() const { return m_used_clusters; }
+  bool IsClusterUsed(u64 offset) const;
+
+  // Replaces the unused data in a block of the disc. Regenerable junk gets zeroed and added to
+  // junk_out, where it extends the last region if it continues it. Safe to call from several
+  // threads at once with different outputs.
+  void ScrubBlock(u64 offset, u8* data, size_t size, std::vector<JunkRegion>* junk_out) const;
+
+  // Appends a region that follows all the others, merging it into the last one if possible.
+  static void AddJunkRegion(const JunkRegion& region, std::vector<JunkRegion>* junk);
 
 private:
   struct PartitionHeader final
   {
-    u8* ticket[0x2a4];
     u32 tmd_size;
     u64 tmd_offset;
     u32 cert_chain_size;
@@ -48,13 +73,6 @@ private:
     u64 h3_offset;
     u64 data_offset;
     u64 data_size;
-    // TMD would be here
-    u64 dol_offset;
-    u64 dol_size;
-    u64 fst_offset;
-    u64 fst_size;
-    u32 apploader_size;
-    u32 apploader_trailer_size;
   };
 
   struct Partition final
@@ -66,30 +84,16 @@ private:
     PartitionHeader header;
   };
 
-  struct PartitionGroup final
-  {
-    u32 num_partitions;
-    u64 partitions_offset;
-    std::vector<Partition> partitions;
-  };
+  using MarkFunction = std::function<void(u64 offset, u64 size)>;
 
-  void MarkAsUsed(u64 offset, u64 size);
-  void MarkAsUsedE(u64 partition_data_offset, u64 offset, u64 size);
-  bool ReadFromVolume(u64 offset, u32& buffer, bool decrypt);
-  bool ReadFromVolume(u64 offset, u64& buffer, bool decrypt);
-  bool ParseDisc();
-  bool ParsePartitionData(Partition& partition);
+  bool ParseWiiDisc(const IVolume& disc);
+  bool ParsePartitionData(const Partition& partition, std::vector<bool>* used_clusters) const;
+  static bool ParseFileSystem(const IVolume& volume, IFileSystem* filesystem, bool wii,
+                              const MarkFunction& mark_as_used);
 
   std::string m_filename;
-  std::unique_ptr<IVolume> m_disc;
-
-  std::array<PartitionGroup, 4> m_partition_group{};
-
-  std::vector<u8> m_free_table;
-  u64 m_file_size = 0;
-  u64 m_block_count = 0;
-  u32 m_block_size = 0;
-  bool m_is_scrubbing = false;
+  std::vector<bool> m_used_clusters;
+  bool m_is_wii = false;
 };
 
 }  // namespace DiscIO
@@ -2,6 +2,11 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -23,17 +28,33 @@ std::unique_ptr<PlainFileReader> PlainFileReader::Create(File::IOFile file)
   return nullptr;
 }
 
+bool PlainFileReader::IsInBounds(u64 offset, u64 size) const
+{
+  return m_size >= 0 && offset <= static_cast<u64>(m_size) &&
+         size <= static_cast<u64>(m_size) - offset;
+}
+
 bool PlainFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
 {
-  if (m_file.Seek(offset, SEEK_SET) && m_file.ReadBytes(out_ptr, nbytes))
-  {
-    return true;
-  }
-  else
-  {
-    m_file.Clear();
+  // Positional reads don't move the file position, and unlike copying out of a memory mapping,
+  // an I/O error (e.g. a disc image on a network share that went away) is reported as a failed
+  // read instead of crashing the thread.
+  return IsInBounds(offset, nbytes) && m_file.ReadAt(out_ptr, nbytes, offset);
+}
+
+bool PlainFileReader::Prefetch(u64 offset, u64 size)
+{
+#if defined(__linux__) || defined(__FreeBSD__)
+  if (!IsInBounds(offset, 0))
     return false;
-  }
+  size = std::min<u64>(size, m_size - offset);
+
+  // This starts reading the range into the page cache without waiting for it.
+  return posix_fadvise(fileno(m_file.GetHandle()), static_cast<off_t>(offset),
+                       static_cast<off_t>(size), POSIX_FADV_WILLNEED) == 0;
+#else
+  return false;
+#endif
 }
 
 }  // namespace
@@ -23,10 +23,13 @@ public:
   u64 GetDataSize() const override { return m_size; }
   u64 GetRawSize() const override { return m_size; }
   bool Read(u64 offset, u64 nbytes, u8* out_ptr) override;
+  bool Prefetch(u64 offset, u64 size) override;
 
 private:
   PlainFileReader(File::IOFile file);
 
+  bool IsInBounds(u64 offset, u64 size) const;
+
   File::IOFile m_file;
   s64 m_size;
 };
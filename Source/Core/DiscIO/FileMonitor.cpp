@@ -82,8 +82,9 @@ void ReadFileSystem(const std::string& filename)
 // Logs a file if it passes a few checks
 void CheckFile(const std::string& file, u64 size)
 {
-  // Don't do anything if the log is unselected
-  if (!LogManager::GetInstance()->IsEnabled(LogTypes::FILEMON, LogTypes::LWARNING))
+  // Don't do anything if the log is unselected (or logging hasn't been set up)
+  LogManager* const log_manager = LogManager::GetInstance();
+  if (!log_manager || !log_manager->IsEnabled(LogTypes::FILEMON, LogTypes::LWARNING))
     return;
   // Do nothing if we found the same file again
   if (CurrentFile == file)
@@ -0,0 +1,174 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "DiscIO/LaggedFibonacciGenerator.h"
+
+namespace DiscIO
+{
+void LaggedFibonacciGenerator::SetSeed(const Seed& seed)
+{
+  for (size_t i = 0; i < SEED_SIZE; ++i)
+    m_buffer[i] = Common::swap32(seed[i]);
+
+  Initialize(false);
+  m_position_bytes = 0;
+}
+
+void LaggedFibonacciGenerator::GetBytes(size_t count, u8* out)
+{
+  while (count > 0)
+  {
+    const size_t length = std::min(count, LFG_K * sizeof(u32) - m_position_bytes);
+    std::memcpy(out, reinterpret_cast<const u8*>(m_buffer.data()) + m_position_bytes, length);
+    out += length;
+    count -= length;
+    Skip(length);
+  }
+}
+
+void LaggedFibonacciGenerator::Skip(size_t count)
+{
+  m_position_bytes += count;
+  while (m_position_bytes >= LFG_K * sizeof(u32))
+  {
+    Forward();
+    m_position_bytes -= LFG_K * sizeof(u32);
+  }
+}
+
+size_t LaggedFibonacciGenerator::GetSeed(const u8* data, size_t size, size_t data_offset,
+                                         Seed* seed_out)
+{
+  // The generator works on whole words, so start from the first word that is entirely in data
+  const size_t bytes_to_skip = (sizeof(u32) - data_offset % sizeof(u32)) % sizeof(u32);
+  std::array<u32, LFG_K> words;
+  if (size < bytes_to_skip + sizeof(words))
+    return 0;
+  std::memcpy(words.data(), data + bytes_to_skip, sizeof(words));
+
+  LaggedFibonacciGenerator lfg;
+  if (!GetSeed(words.data(), (data_offset + bytes_to_skip) / sizeof(u32), &lfg, seed_out))
+    return 0;
+
+  // The seed is only known to generate the words it was reconstructed from, so check how much
+  // of the data it actually covers.
+  lfg.SetSeed(*seed_out);
+  lfg.Skip(data_offset);
+
+  std::array<u8, 0x1000> generated;
+  size_t matching = 0;
+  while (matching < size)
+  {
+    const size_t length = std::min(size - matching, generated.size());
+    lfg.GetBytes(length, generated.data());
+    const size_t equal =
+        std::mismatch(generated.begin(), generated.begin() + length, data + matching).first -
+        generated.begin();
+    matching += equal;
+    if (equal != length)
+      break;
+  }
+
+  return matching;
+}
+
+bool LaggedFibonacciGenerator::GetSeed(const u32* data, size_t data_offset,
+                                       LaggedFibonacciGenerator* lfg, Seed* seed_out)
+{
+  // Every generated word has bits 22-23 equal to bits 24-25, which rules out most data quickly
+  for (size_t i = 0; i < LFG_K; ++i)
+  {
+    const u32 word = Common::swap32(data[i]);
+    if ((word & 0x00C00000) != ((word >> 2) & 0x00C00000))
+      return false;
+  }
+
+  // The words from data_offset % LFG_K onwards in the buffer were generated one step after the
+  // ones before it, so bring everything to the same step before rewinding to the start.
+  const size_t data_offset_mod_k = data_offset % LFG_K;
+  const size_t data_offset_div_k = data_offset / LFG_K;
+
+  std::copy(data, data + LFG_K - data_offset_mod_k, lfg->m_buffer.begin() + data_offset_mod_k);
+  std::copy(data + LFG_K - data_offset_mod_k, data + LFG_K, lfg->m_buffer.begin());
+
+  lfg->Backward(0, data_offset_mod_k);
+  for (size_t i = 0; i < data_offset_div_k; ++i)
+    lfg->Backward();
+
+  return lfg->Reinitialize(seed_out);
+}
+
+bool LaggedFibonacciGenerator::Initialize(bool check_existing_data)
+{
+  for (size_t i = SEED_SIZE; i < LFG_K; ++i)
+  {
+    const u32 calculated = (m_buffer[i - 17] << 23) ^ (m_buffer[i - 16] >> 9) ^ m_buffer[i - 1];
+
+    if (check_existing_data)
+    {
+      // Bits 16 and 17 don't make it into the output, so they can't be compared
+      const u32 actual = (m_buffer[i] & 0xFF00FFFF) | ((m_buffer[i] << 2) & 0x00FC0000);
+      if ((calculated & 0xFFFCFFFF) != actual)
+        return false;
+    }
+
+    m_buffer[i] = calculated;
+  }
+
+  for (u32& word : m_buffer)
+    word = Common::swap32((word & 0xFF00FFFF) | ((word >> 2) & 0x00FF0000));
+
+  for (size_t i = 0; i < 4; ++i)
+    Forward();
+
+  return true;
+}
+
+bool LaggedFibonacciGenerator::Reinitialize(Seed* seed_out)
+{
+  for (size_t i = 0; i < 4; ++i)
+    Backward();
+
+  for (u32& word : m_buffer)
+    word = Common::swap32(word);
+
+  // Undo the output transformation of the seed words. Bits 16 and 17 can be recovered from the
+  // words that were calculated from them, except for the first word, where they never matter.
+  for (size_t i = 0; i < SEED_SIZE; ++i)
+  {
+    m_buffer[i] = (m_buffer[i] & 0xFF00FFFF) | ((m_buffer[i] << 2) & 0x00FC0000) |
+                  (((m_buffer[i + 16] ^ m_buffer[i + 15]) << 9) & 0x00030000);
+  }
+
+  for (size_t i = 0; i < SEED_SIZE; ++i)
+    (*seed_out)[i] = Common::swap32(m_buffer[i]);
+
+  return Initialize(true);
+}
+
+void LaggedFibonacciGenerator::Forward()
+{
+  for (size_t i = 0; i < LFG_J; ++i)
+    m_buffer[i] ^= m_buffer[i + LFG_K - LFG_J];
+
+  for (size_t i = LFG_J; i < LFG_K; ++i)
+    m_buffer[i] ^= m_buffer[i - LFG_J];
+}
+
+void LaggedFibonacciGenerator::Backward(size_t start_word, size_t end_word)
+{
+  const size_t loop_end = std::max(LFG_J, start_word);
+  for (size_t i = std::min(end_word, LFG_K); i > loop_end; --i)
+    m_buffer[i - 1] ^= m_buffer[i - 1 - LFG_J];
+
+  for (size_t i = std::min(end_word, LFG_J); i > start_word; --i)
+    m_buffer[i - 1] ^= m_buffer[i - 1 + LFG_K - LFG_J];
+}
+}  // namespace DiscIO
@@ -0,0 +1,50 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "Common/CommonTypes.h"
+
+namespace DiscIO
+{
+// The generator that Nintendo's mastering tools used to fill the unused parts of discs with
+// junk. Junk looks random, so it doesn't compress at all, but it only takes a 68-byte seed to
+// regenerate a whole stretch of it.
+class LaggedFibonacciGenerator final
+{
+public:
+  static constexpr size_t SEED_SIZE = 17;
+  // The seed words are stored big endian, like they are in the generated data.
+  using Seed = std::array<u32, SEED_SIZE>;
+
+  void SetSeed(const Seed& seed);
+
+  void GetBytes(size_t count, u8* out);
+  void Skip(size_t count);
+
+  // Works out which seed the given data (which starts data_offset bytes into a junk stream)
+  // was generated from. Returns how many bytes from the start of data match what the seed
+  // generates, which is 0 if the data isn't junk at all.
+  static size_t GetSeed(const u8* data, size_t size, size_t data_offset, Seed* seed_out);
+
+private:
+  static constexpr size_t LFG_K = 521;
+  static constexpr size_t LFG_J = 32;
+
+  bool Initialize(bool check_existing_data);
+  bool Reinitialize(Seed* seed_out);
+  void Forward();
+  void Backward(size_t start_word = 0, size_t end_word = LFG_K);
+
+  // Rewinds the LFG_K words that start data_offset words into a junk stream to their seed.
+  static bool GetSeed(const u32* data, size_t data_offset, LaggedFibonacciGenerator* lfg,
+                      Seed* seed_out);
+
+  std::array<u32, LFG_K> m_buffer;
+  size_t m_position_bytes = 0;
+};
+}  // namespace DiscIO
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <cstring>
+#include <functional>
 #include <map>
 #include <string>
 #include <vector>
@@ -18,6 +19,25 @@ namespace DiscIO
 {
 enum class BlobType;
 
+struct IntegrityCheckResult
+{
+  bool success = false;
+  bool cancelled = false;
+  // Index of the first cluster that could not be read or failed verification.
+  u64 first_bad_cluster = 0;
+  u64 bytes_checked = 0;
+  double seconds = 0.0;
+
+  double GetMegabytesPerSecond() const
+  {
+    return seconds > 0.0 ? bytes_checked / (1024.0 * 1024.0) / seconds : 0.0;
+  }
+};
+
+// Called from the thread running the check with the number of bytes verified so far.
+// Returning false cancels the check.
+using IntegrityCheckProgress = std::function<bool(u64 bytes_checked, u64 total_bytes)>;
+
 class IVolume
 {
 public:
@@ -25,6 +45,8 @@ public:
   virtual ~IVolume() {}
   // decrypt parameter must be false if not reading a Wii disc
   virtual bool Read(u64 _Offset, u64 _Length, u8* _pBuffer, bool decrypt) const = 0;
+  // See IBlobReader::Prefetch. Decrypted reads can't be prefetched this way.
+  virtual bool Prefetch(u64 offset, u64 length, bool decrypt) const { return false; }
   template <typename T>
   bool ReadSwapped(u64 offset, T* buffer, bool decrypt) const
   {
@@ -53,7 +75,10 @@ public:
   virtual u8 GetDiscNumber() const { return 0; }
   virtual Platform GetVolumeType() const = 0;
   virtual bool SupportsIntegrityCheck() const { return false; }
-  virtual bool CheckIntegrity() const { return false; }
+  virtual IntegrityCheckResult CheckIntegrity(const IntegrityCheckProgress& progress) const
+  {
+    return {};
+  }
   virtual bool ChangePartition(u64 offset) { return false; }
   virtual Region GetRegion() const = 0;
   virtual Country GetCountry() const = 0;
@@ -5,18 +5,24 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstring>
+#include <ctime>
 #include <locale>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Common/Align.h"
 #include "Common/Assert.h"
+#include "Common/ChunkFile.h"
 #include "Common/CommonPaths.h"
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
+#include "Common/Hash.h"
 #include "Common/Logging/Log.h"
+#include "Common/StringUtil.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/Enums.h"
 #include "DiscIO/FileMonitor.h"
@@ -27,9 +33,47 @@ namespace DiscIO
 {
 static u32 ComputeNameSize(const File::FSTEntry& parent_entry);
 static std::string ASCIIToLowercase(std::string str);
+static void GetDirectoryTimes(const File::FSTEntry& parent_entry,
+                              std::vector<std::pair<std::string, u64>>* times);
+
+static const u32 FST_CACHE_REVISION = 1;
+
+// A directory that was changed this recently might still change within the same second,
+// which wouldn't show in its modification time.
+static const u64 FST_CACHE_MIN_AGE = 2;
 
 const size_t CVolumeDirectory::MAX_NAME_LENGTH;
 const size_t CVolumeDirectory::MAX_ID_LENGTH;
+const size_t CVolumeDirectory::MAX_OPEN_FILES;
+
+struct CVolumeDirectory::FSTCache
+{
+  std::string root_directory;
+  bool is_wii = false;
+  u64 fst_address = 0;
+  // Adding, removing or renaming anything changes the modification time of its directory
+  std::vector<std::pair<std::string, u64>> directory_times;
+  std::vector<u8> fst_data;
+  u64 fst_name_offset = 0;
+  u64 data_start_address = 0;
+  std::vector<VirtualFile> files;
+
+  void DoState(PointerWrap& p)
+  {
+    p.Do(root_directory);
+    p.Do(is_wii);
+    p.Do(fst_address);
+    p.Do(directory_times);
+    p.Do(fst_data);
+    p.Do(fst_name_offset);
+    p.Do(data_start_address);
+    p.DoEachElement(files, [](PointerWrap& p_, VirtualFile& file) {
+      p_.Do(file.offset);
+      p_.Do(file.size);
+      p_.Do(file.path);
+    });
+  }
+};
 
 CVolumeDirectory::CVolumeDirectory(const std::string& directory, bool is_wii,
                                    const std::string& apploader, const std::string& dol)
@@ -111,47 +155,41 @@ bool CVolumeDirectory::Read(u64 offset, u64 length, u8* buffer, bool decrypt) co
     return true;
 
   // Determine which file the offset refers to
-  std::map<u64, std::string>::const_iterator fileIter = m_virtual_disk.lower_bound(offset);
-  if (fileIter->first > offset && fileIter != m_virtual_disk.begin())
-    --fileIter;
+  auto file_iter = std::upper_bound(
+      m_virtual_disk.begin(), m_virtual_disk.end(), offset,
+      [](u64 address, const VirtualFile& file) { return address < file.offset; });
+  if (file_iter != m_virtual_disk.begin())
+    --file_iter;
 
   // zero fill to start of file data
-  PadToAddress(fileIter->first, &offset, &length, &buffer);
+  PadToAddress(file_iter->offset, &offset, &length, &buffer);
 
-  while (fileIter != m_virtual_disk.end() && length > 0)
+  while (file_iter != m_virtual_disk.end() && length > 0)
   {
-    _dbg_assert_(DVDINTERFACE, fileIter->first <= offset);
-    u64 fileOffset = offset - fileIter->first;
-    const std::string fileName = fileIter->second;
-
-    File::IOFile file(fileName, "rb");
-    if (!file)
-      return false;
-
-    u64 fileSize = file.GetSize();
+    _dbg_assert_(DVDINTERFACE, file_iter->offset <= offset);
+    const u64 file_offset = offset - file_iter->offset;
 
-    FileMon::CheckFile(fileName, fileSize);
-
-    if (fileOffset < fileSize)
+    if (file_offset < file_iter->size)
     {
-      u64 fileBytes = std::min(fileSize - fileOffset, length);
+      const u64 file_bytes = std::min(file_iter->size - file_offset, length);
 
-      if (!file.Seek(fileOffset, SEEK_SET))
-        return false;
-      if (!file.ReadBytes(buffer, fileBytes))
+      const std::shared_ptr<File::IOFile> file = GetOpenFile(file_iter - m_virtual_disk.begin());
+      if (!file || !file->ReadAt(buffer, file_bytes, file_offset))
         return false;
 
-      length -= fileBytes;
-      buffer += fileBytes;
-      offset += fileBytes;
+      FileMon::CheckFile(file_iter->path, file_iter->size);
+
+      length -= file_bytes;
+      buffer += file_bytes;
+      offset += file_bytes;
     }
 
-    ++fileIter;
+    ++file_iter;
 
-    if (fileIter != m_virtual_disk.end())
+    if (file_iter != m_virtual_disk.end())
     {
-      _dbg_assert_(DVDINTERFACE, fileIter->first >= offset);
-      PadToAddress(fileIter->first, &offset, &length, &buffer);
+      _dbg_assert_(DVDINTERFACE, file_iter->offset >= offset);
+      PadToAddress(file_iter->offset, &offset, &length, &buffer);
     }
   }
 
@@ -350,33 +388,46 @@ void CVolumeDirectory::SetDOL(const std::string& dol)
 
 void CVolumeDirectory::BuildFST()
 {
-  m_fst_data.clear();
-
-  File::FSTEntry rootEntry = File::ScanDirectoryTree(m_root_directory, true);
-  u32 name_table_size = ComputeNameSize(rootEntry);
-
-  m_fst_name_offset = rootEntry.size * ENTRY_SIZE;  // offset of name table in FST
-  m_fst_data.resize(m_fst_name_offset + name_table_size);
+  {
+    std::lock_guard<std::mutex> lock(m_open_files_lock);
+    m_open_files.clear();
+  }
 
   // if FST hasn't been assigned (ie no apploader/dol setup), set to default
   if (m_fst_address == 0)
     m_fst_address = APPLOADER_ADDRESS + 0x2000;
 
-  // 4 byte aligned start of data on disk
-  m_data_start_address = Common::AlignUp(m_fst_address + m_fst_data.size(), 0x8000ull);
-  u64 current_data_address = m_data_start_address;
+  if (!LoadFSTCache())
+  {
+    m_fst_data.clear();
+    m_virtual_disk.clear();
+
+    File::FSTEntry rootEntry = File::ScanDirectoryTree(m_root_directory, true);
+    u32 name_table_size = ComputeNameSize(rootEntry);
+
+    // The root entry counts itself as well as everything below it
+    const u64 total_entries = rootEntry.size + 1;
+    m_fst_name_offset = total_entries * ENTRY_SIZE;  // offset of name table in FST
+    m_fst_data.resize(m_fst_name_offset + name_table_size);
 
-  u32 fst_offset = 0;   // Offset within FST data
-  u32 name_offset = 0;  // Offset within name table
-  u32 root_offset = 0;  // Offset of root of FST
+    // 4 byte aligned start of data on disk
+    m_data_start_address = Common::AlignUp(m_fst_address + m_fst_data.size(), 0x8000ull);
+    u64 current_data_address = m_data_start_address;
 
-  // write root entry
-  WriteEntryData(&fst_offset, DIRECTORY_ENTRY, 0, 0, rootEntry.size);
+    u32 fst_offset = 0;   // Offset within FST data
+    u32 name_offset = 0;  // Offset within name table
+    u32 root_offset = 0;  // Offset of root of FST
 
-  WriteDirectory(rootEntry, &fst_offset, &name_offset, &current_data_address, root_offset);
+    // write root entry
+    WriteEntryData(&fst_offset, DIRECTORY_ENTRY, 0, 0, total_entries);
 
-  // overflow check
-  _dbg_assert_(DVDINTERFACE, name_offset == name_table_size);
+    WriteDirectory(rootEntry, &fst_offset, &name_offset, &current_data_address, root_offset);
+
+    // overflow check
+    _dbg_assert_(DVDINTERFACE, name_offset == name_table_size);
+
+    SaveFSTCache(rootEntry);
+  }
 
   // write FST size and location
   Write32((u32)(m_fst_address >> m_address_shift), 0x0424, &m_disk_header);
@@ -418,6 +469,35 @@ void CVolumeDirectory::PadToAddress(u64 start_address, u64* address, u64* length
   }
 }
 
+std::shared_ptr<File::IOFile> CVolumeDirectory::GetOpenFile(size_t index) const
+{
+  std::lock_guard<std::mutex> lock(m_open_files_lock);
+
+  // The most recently used file is kept at the back
+  auto it = std::find_if(m_open_files.begin(), m_open_files.end(),
+                         [index](const OpenFile& open_file) { return open_file.index == index; });
+  if (it != m_open_files.end())
+  {
+    std::rotate(it, it + 1, m_open_files.end());
+    return m_open_files.back().file;
+  }
+
+  const VirtualFile& virtual_file = m_virtual_disk[index];
+  auto file = std::make_shared<File::IOFile>(virtual_file.path, "rb");
+  if (!*file)
+    return nullptr;
+
+  // The FST still has the old size, so the game sees the file cut off or padded with zeroes.
+  // The cache is checked against the sizes, so the next run picks up the new size.
+  if (file->GetSize() != virtual_file.size)
+    WARN_LOG(DISCIO, "%s has changed size since the FST was built", virtual_file.path.c_str());
+
+  if (m_open_files.size() >= MAX_OPEN_FILES)
+    m_open_files.erase(m_open_files.begin());
+  m_open_files.push_back({index, file});
+  return file;
+}
+
 void CVolumeDirectory::Write32(u32 data, u32 offset, std::vector<u8>* const buffer)
 {
   (*buffer)[offset++] = (data >> 24);
@@ -483,8 +563,9 @@ void CVolumeDirectory::WriteDirectory(const File::FSTEntry& parent_entry, u32* f
       WriteEntryName(name_offset, entry.virtualName);
 
       // write entry to virtual disk
-      _dbg_assert_(DVDINTERFACE, m_virtual_disk.find(*data_offset) == m_virtual_disk.end());
-      m_virtual_disk.emplace(*data_offset, entry.physicalName);
+      _dbg_assert_(DVDINTERFACE,
+                   m_virtual_disk.empty() || m_virtual_disk.back().offset < *data_offset);
+      m_virtual_disk.push_back({*data_offset, entry.size, entry.physicalName});
 
       // 4 byte aligned
       *data_offset = Common::AlignUp(*data_offset + std::max<u64>(entry.size, 1ull), 0x8000ull);
@@ -492,6 +573,108 @@ void CVolumeDirectory::WriteDirectory(const File::FSTEntry& parent_entry, u32* f
   }
 }
 
+std::string CVolumeDirectory::GetFSTCachePath() const
+{
+  const std::string& cache_directory = File::GetUserPath(D_CACHE_IDX);
+  if (cache_directory.empty())
+    return "";
+
+  // The root directory is stored in the cache too, so a collision only costs a rescan
+  const u32 hash = HashAdler32(reinterpret_cast<const u8*>(m_root_directory.data()),
+                               m_root_directory.size());
+  return cache_directory + StringFromFormat("fst_%08x.cache", hash);
+}
+
+bool CVolumeDirectory::LoadFSTCache()
+{
+  const std::string cache_path = GetFSTCachePath();
+  FSTCache cache;
+  if (cache_path.empty() ||
+      !CChunkFileReader::Load<FSTCache>(cache_path, FST_CACHE_REVISION, cache))
+  {
+    return false;
+  }
+
+  // The FST depends on where it's placed, which depends on the DOL
+  if (cache.root_directory != m_root_directory || cache.is_wii != m_is_wii ||
+      cache.fst_address != m_fst_address || cache.directory_times.empty())
+  {
+    return false;
+  }
+
+  for (const auto& directory : cache.directory_times)
+  {
+    if (File::GetModifiedTime(directory.first) != directory.second)
+    {
+      INFO_LOG(DISCIO, "%s has changed, rebuilding the FST", directory.first.c_str());
+      return false;
+    }
+  }
+
+  // Rewriting a file doesn't change the time of its directory, and the FST must have the size
+  // that the file has now, since the game can't be told about a change later.
+  for (const VirtualFile& file : cache.files)
+  {
+    File::FileInfo info;
+    if (!File::GetFileInfo(file.path, &info) || info.size != file.size)
+    {
+      INFO_LOG(DISCIO, "%s has changed size, rebuilding the FST", file.path.c_str());
+      return false;
+    }
+  }
+
+  m_fst_data = std::move(cache.fst_data);
+  m_fst_name_offset = cache.fst_name_offset;
+  m_data_start_address = cache.data_start_address;
+  m_virtual_disk = std::move(cache.files);
+  return true;
+}
+
+void CVolumeDirectory::SaveFSTCache(const File::FSTEntry& root_entry) const
+{
+  const std::string cache_path = GetFSTCachePath();
+  if (cache_path.empty())
+    return;
+
+  FSTCache cache;
+  GetDirectoryTimes(root_entry, &cache.directory_times);
+
+  const u64 now = static_cast<u64>(std::time(nullptr));
+  for (const auto& directory : cache.directory_times)
+  {
+    if (directory.second == 0 || directory.second + FST_CACHE_MIN_AGE > now)
+      return;
+  }
+
+  cache.root_directory = m_root_directory;
+  cache.is_wii = m_is_wii;
+  cache.fst_address = m_fst_address;
+  cache.fst_data = m_fst_data;
+  cache.fst_name_offset = m_fst_name_offset;
+  cache.data_start_address = m_data_start_address;
+  cache.files = m_virtual_disk;
+
+  // Write to a temporary file first, so that a crash can't leave a truncated cache behind.
+  const std::string temp_path = cache_path + ".tmp";
+  File::CreateFullPath(cache_path);
+  if (!CChunkFileReader::Save<FSTCache>(temp_path, FST_CACHE_REVISION, cache) ||
+      !File::Rename(temp_path, cache_path))
+  {
+    WARN_LOG(DISCIO, "Failed to write the FST cache for %s", m_root_directory.c_str());
+  }
+}
+
+static void GetDirectoryTimes(const File::FSTEntry& parent_entry,
+                              std::vector<std::pair<std::string, u64>>* times)
+{
+  times->emplace_back(parent_entry.physicalName, File::GetModifiedTime(parent_entry.physicalName));
+  for (const File::FSTEntry& entry : parent_entry.children)
+  {
+    if (entry.isDirectory)
+      GetDirectoryTimes(entry, times);
+  }
+}
+
 static u32 ComputeNameSize(const File::FSTEntry& parent_entry)
 {
   u32 name_size = 0;
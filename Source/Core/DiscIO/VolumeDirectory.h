@@ -6,6 +6,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -15,6 +16,7 @@
 namespace File
 {
 struct FSTEntry;
+class IOFile;
 }
 
 //
@@ -67,6 +69,23 @@ public:
   void BuildFST();
 
 private:
+  // A host file that backs a range of the disc. These are sorted by offset.
+  struct VirtualFile
+  {
+    u64 offset;
+    u64 size;
+    std::string path;
+  };
+
+  struct OpenFile
+  {
+    size_t index;
+    std::shared_ptr<File::IOFile> file;
+  };
+
+  // The result of scanning the directory, which is kept between runs
+  struct FSTCache;
+
   static std::string ExtractDirectoryName(const std::string& directory);
 
   void SetDiskTypeWii();
@@ -82,6 +101,8 @@ private:
 
   void PadToAddress(u64 start_address, u64* address, u64* length, u8** buffer) const;
 
+  std::shared_ptr<File::IOFile> GetOpenFile(size_t index) const;
+
   void Write32(u32 data, u32 offset, std::vector<u8>* const buffer);
 
   // FST creation
@@ -90,9 +111,18 @@ private:
   void WriteDirectory(const File::FSTEntry& parent_entry, u32* fst_offset, u32* name_offset,
                       u64* data_offset, u32 parent_entry_index);
 
+  std::string GetFSTCachePath() const;
+  bool LoadFSTCache();
+  void SaveFSTCache(const File::FSTEntry& root_entry) const;
+
   std::string m_root_directory;
 
-  std::map<u64, std::string> m_virtual_disk;
+  std::vector<VirtualFile> m_virtual_disk;
+
+  // Games tend to stream from a few files at a time, so the most recently used files are kept
+  // open instead of being opened for every read.
+  mutable std::mutex m_open_files_lock;
+  mutable std::vector<OpenFile> m_open_files;
 
   bool m_is_wii;
 
@@ -151,6 +181,7 @@ private:
   static constexpr u64 APPLOADER_ADDRESS = 0x2440;
   static const size_t MAX_NAME_LENGTH = 0x3df;
   static const size_t MAX_ID_LENGTH = 6;
+  static const size_t MAX_OPEN_FILES = 32;
 };
 
 }  // namespace
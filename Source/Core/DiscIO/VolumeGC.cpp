@@ -44,6 +44,11 @@ bool CVolumeGC::Read(u64 _Offset, u64 _Length, u8* _pBuffer, bool decrypt) const
   return m_pReader->Read(_Offset, _Length, _pBuffer);
 }
 
+bool CVolumeGC::Prefetch(u64 offset, u64 length, bool decrypt) const
+{
+  return !decrypt && m_pReader != nullptr && m_pReader->Prefetch(offset, length);
+}
+
 std::string CVolumeGC::GetGameID() const
 {
   static const std::string NO_UID("NO_UID");
@@ -2,20 +2,28 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
 #include <cstddef>
 #include <cstring>
+#include <deque>
 #include <map>
-#include <mbedtls/aes.h>
-#include <mbedtls/sha1.h>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "Common/CommonFuncs.h"
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/Crypto/SHA1.h"
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
+#include "Common/Thread.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/Enums.h"
 #include "DiscIO/FileMonitor.h"
@@ -29,20 +37,21 @@ namespace DiscIO
 {
 CVolumeWiiCrypted::CVolumeWiiCrypted(std::unique_ptr<IBlobReader> reader, u64 _VolumeOffset,
                                      const unsigned char* _pVolumeKey)
-    : m_pReader(std::move(reader)), m_AES_ctx(std::make_unique<mbedtls_aes_context>()),
-      m_VolumeOffset(_VolumeOffset), m_dataOffset(0x20000), m_LastDecryptedBlockOffset(-1)
+    : m_pReader(std::move(reader)),
+      m_AES_ctx(std::make_unique<Common::AES::DecryptionContext>(_pVolumeKey)),
+      m_VolumeOffset(_VolumeOffset), m_dataOffset(0x20000), m_cluster_cache_tick(0)
 {
-  mbedtls_aes_setkey_dec(m_AES_ctx.get(), _pVolumeKey, 128);
+  m_cluster_cache.reserve(s_cached_clusters);
 }
 
 bool CVolumeWiiCrypted::ChangePartition(u64 offset)
 {
   m_VolumeOffset = offset;
-  m_LastDecryptedBlockOffset = -1;
+  ClearCache();
 
   u8 volume_key[16];
   DiscIO::VolumeKeyForPartition(*m_pReader, offset, volume_key);
-  mbedtls_aes_setkey_dec(m_AES_ctx.get(), volume_key, 128);
+  m_AES_ctx->SetKey(volume_key);
   return true;
 }
 
@@ -50,6 +59,62 @@ CVolumeWiiCrypted::~CVolumeWiiCrypted()
 {
 }
 
+const u8* CVolumeWiiCrypted::FindCachedCluster(u64 cluster) const
+{
+  const auto it = m_cluster_cache_index.find(cluster);
+  if (it == m_cluster_cache_index.end())
+    return nullptr;
+
+  CachedCluster& entry = m_cluster_cache[it->second];
+  entry.last_use = ++m_cluster_cache_tick;
+  return entry.data.data();
+}
+
+u8* CVolumeWiiCrypted::AllocateCachedCluster(u64 cluster) const
+{
+  size_t slot;
+  if (m_cluster_cache.size() < s_cached_clusters)
+  {
+    slot = m_cluster_cache.size();
+    m_cluster_cache.emplace_back();
+  }
+  else
+  {
+    // Evict the least recently used cluster. The cache is small enough that a linear scan on a
+    // miss costs nothing next to reading and decrypting the replacement.
+    slot = 0;
+    for (size_t i = 1; i < m_cluster_cache.size(); ++i)
+    {
+      if (m_cluster_cache[i].last_use < m_cluster_cache[slot].last_use)
+        slot = i;
+    }
+    m_cluster_cache_index.erase(m_cluster_cache[slot].index);
+  }
+
+  CachedCluster& entry = m_cluster_cache[slot];
+  entry.index = cluster;
+  entry.last_use = ++m_cluster_cache_tick;
+  m_cluster_cache_index[cluster] = slot;
+  return entry.data.data();
+}
+
+void CVolumeWiiCrypted::ClearCache()
+{
+  m_cluster_cache.clear();
+  m_cluster_cache_index.clear();
+}
+
+void CVolumeWiiCrypted::DecryptCluster(const u8* raw_cluster, u8* out) const
+{
+  // The only thing we currently use from the 0x000 - 0x3FF part
+  // of the block is the IV (at 0x3D0), but it also contains SHA-1
+  // hashes that IOS uses to check that discs aren't tampered with.
+  // http://wiibrew.org/wiki/Wii_Disc#Encrypted
+  u8 iv[Common::AES::BLOCK_SIZE];
+  memcpy(iv, &raw_cluster[0x3D0], sizeof(iv));
+  m_AES_ctx->DecryptCBC(iv, &raw_cluster[s_block_header_size], out, s_block_data_size);
+}
+
 bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer, bool decrypt) const
 {
   if (m_pReader == nullptr)
@@ -60,49 +125,79 @@ bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer, bool de
 
   FileMon::FindFilename(_ReadOffset);
 
-  std::vector<u8> read_buffer(s_block_total_size);
+  // Some formats store the partition decrypted, and would otherwise have to encrypt it first.
+  const u64 partition_data_offset = m_VolumeOffset + m_dataOffset;
+  if (m_pReader->SupportsReadWiiDecrypted(partition_data_offset))
+    return m_pReader->ReadWiiDecrypted(_ReadOffset, _Length, _pBuffer, partition_data_offset);
+
   while (_Length > 0)
   {
     // Calculate block offset
     u64 Block = _ReadOffset / s_block_data_size;
     u64 Offset = _ReadOffset % s_block_data_size;
 
-    if (m_LastDecryptedBlockOffset != Block)
+    const u8* cached = FindCachedCluster(Block);
+    if (cached)
+    {
+      const u64 CopySize = std::min<u64>(_Length, s_block_data_size - Offset);
+      memcpy(_pBuffer, &cached[Offset], static_cast<size_t>(CopySize));
+
+      _Length -= CopySize;
+      _pBuffer += CopySize;
+      _ReadOffset += CopySize;
+      continue;
+    }
+
+    // Fetch the whole run of uncached clusters that this read covers with one blob read.
+    const u64 last_block = (_ReadOffset + _Length - 1) / s_block_data_size;
+    u64 num_blocks = 1;
+    while (num_blocks < s_max_clusters_per_read && Block + num_blocks <= last_block &&
+           m_cluster_cache_index.find(Block + num_blocks) == m_cluster_cache_index.end())
+    {
+      ++num_blocks;
+    }
+
+    m_read_buffer.resize(s_max_clusters_per_read * s_block_total_size);
+    if (!m_pReader->Read(m_VolumeOffset + m_dataOffset + Block * s_block_total_size,
+                         num_blocks * s_block_total_size, m_read_buffer.data()))
     {
-      // Read the current block
-      if (!m_pReader->Read(m_VolumeOffset + m_dataOffset + Block * s_block_total_size,
-                           s_block_total_size, read_buffer.data()))
-        return false;
-
-      // Decrypt the block's data.
-      // 0x3D0 - 0x3DF in m_pBuffer will be overwritten,
-      // but that won't affect anything, because we won't
-      // use the content of m_pBuffer anymore after this
-      mbedtls_aes_crypt_cbc(m_AES_ctx.get(), MBEDTLS_AES_DECRYPT, s_block_data_size,
-                            &read_buffer[0x3D0], &read_buffer[s_block_header_size],
-                            m_LastDecryptedBlock);
-      m_LastDecryptedBlockOffset = Block;
-
-      // The only thing we currently use from the 0x000 - 0x3FF part
-      // of the block is the IV (at 0x3D0), but it also contains SHA-1
-      // hashes that IOS uses to check that discs aren't tampered with.
-      // http://wiibrew.org/wiki/Wii_Disc#Encrypted
+      return false;
     }
 
-    // Copy the decrypted data
-    u64 MaxSizeToCopy = s_block_data_size - Offset;
-    u64 CopySize = (_Length > MaxSizeToCopy) ? MaxSizeToCopy : _Length;
-    memcpy(_pBuffer, &m_LastDecryptedBlock[Offset], (size_t)CopySize);
+    for (u64 i = 0; i < num_blocks; ++i)
+    {
+      const u8* raw_cluster = &m_read_buffer[i * s_block_total_size];
+      const u64 CopySize = std::min<u64>(_Length, s_block_data_size - Offset);
+
+      if (CopySize == s_block_data_size)
+      {
+        // Clusters that are read in full go straight to the caller. Caching them would only
+        // evict the clusters that small reads keep coming back to.
+        DecryptCluster(raw_cluster, _pBuffer);
+      }
+      else
+      {
+        u8* decrypted = AllocateCachedCluster(Block + i);
+        DecryptCluster(raw_cluster, decrypted);
+        memcpy(_pBuffer, &decrypted[Offset], static_cast<size_t>(CopySize));
+      }
 
-    // Update offsets
-    _Length -= CopySize;
-    _pBuffer += CopySize;
-    _ReadOffset += CopySize;
+      // Update offsets
+      _Length -= CopySize;
+      _pBuffer += CopySize;
+      _ReadOffset += CopySize;
+      Offset = 0;
+    }
   }
 
   return true;
 }
 
+bool CVolumeWiiCrypted::Prefetch(u64 offset, u64 length, bool decrypt) const
+{
+  return !decrypt && m_pReader != nullptr && m_pReader->Prefetch(offset, length);
+}
+
 bool CVolumeWiiCrypted::GetTitleID(u64* buffer) const
 {
   // Tik is at m_VolumeOffset size 0x2A4
@@ -302,70 +397,208 @@ u64 CVolumeWiiCrypted::GetRawSize() const
     return 0;
 }
 
-bool CVolumeWiiCrypted::CheckIntegrity() const
+bool CVolumeWiiCrypted::CheckClusterIntegrity(const u8* raw_cluster, u64 cluster,
+                                              u8* decrypted_data) const
+{
+  // The hash block is encrypted with a zero IV.
+  u8 hashes[s_block_header_size];
+  u8 IV[Common::AES::BLOCK_SIZE] = {0};
+  m_AES_ctx->DecryptCBC(IV, raw_cluster, hashes, s_block_header_size);
+
+  // Some clusters have invalid data and metadata because they aren't
+  // meant to be read by the game (for example, holes between files). To
+  // try to avoid reporting errors because of these clusters, we check
+  // the 0x00 paddings in the metadata.
+  //
+  // This may cause some false negatives though: some bad clusters may be
+  // skipped because they are *too* bad and are not even recognized as
+  // valid clusters. To be improved.
+  if (std::any_of(&hashes[0x26C], &hashes[0x280], [](u8 byte) { return byte != 0; }))
+    return true;
+
+  DecryptCluster(raw_cluster, decrypted_data);
+
+  // H0: one hash for every 0x400 bytes of data.
+  for (u32 hashID = 0; hashID < 31; ++hashID)
+  {
+    const Common::SHA1::Digest hash =
+        Common::SHA1::CalculateDigest(decrypted_data + hashID * 0x400, 0x400);
+    if (memcmp(hash.data(), &hashes[hashID * 20], hash.size()))
+    {
+      WARN_LOG(DISCIO, "Integrity Check: fail at cluster %" PRIu64 ": H0 hash %d is invalid",
+               cluster, hashID);
+      return false;
+    }
+  }
+
+  // H1: every cluster in a subgroup of 8 carries the hashes of all of the subgroup's H0 tables.
+  const Common::SHA1::Digest h1 = Common::SHA1::CalculateDigest(&hashes[0], 0x26C);
+  if (memcmp(h1.data(), &hashes[0x280 + (cluster % 8) * 20], h1.size()))
+  {
+    WARN_LOG(DISCIO, "Integrity Check: fail at cluster %" PRIu64 ": H1 hash is invalid", cluster);
+    return false;
+  }
+
+  // H2: likewise for the H1 tables of the 8 subgroups in a group of 64 clusters.
+  const Common::SHA1::Digest h2 = Common::SHA1::CalculateDigest(&hashes[0x280], 0xA0);
+  if (memcmp(h2.data(), &hashes[0x340 + (cluster / 8 % 8) * 20], h2.size()))
+  {
+    WARN_LOG(DISCIO, "Integrity Check: fail at cluster %" PRIu64 ": H2 hash is invalid", cluster);
+    return false;
+  }
+
+  return true;
+}
+
+IntegrityCheckResult CVolumeWiiCrypted::CheckIntegrity(const IntegrityCheckProgress& progress) const
 {
+  IntegrityCheckResult result;
+  const auto start_time = std::chrono::steady_clock::now();
+
   // Get partition data size
   u32 partSizeDiv4;
-  Read(m_VolumeOffset + 0x2BC, 4, (u8*)&partSizeDiv4, false);
-  u64 partDataSize = (u64)Common::swap32(partSizeDiv4) * 4;
+  if (!m_pReader->Read(m_VolumeOffset + 0x2BC, 4, (u8*)&partSizeDiv4))
+    return result;
+  const u64 partDataSize = (u64)Common::swap32(partSizeDiv4) * 4;
+  const u64 nClusters = partDataSize / s_block_total_size;
 
-  u32 nClusters = (u32)(partDataSize / 0x8000);
-  for (u32 clusterID = 0; clusterID < nClusters; ++clusterID)
-  {
-    u64 clusterOff = m_VolumeOffset + m_dataOffset + (u64)clusterID * 0x8000;
+  // The calling thread reads a batch of clusters (one H2 group) at a time from the blob, which
+  // can only be read from one thread, while workers decrypt and hash the batches read so far.
+  constexpr u64 clusters_per_batch = 64;
+  const u32 num_workers = std::max(std::thread::hardware_concurrency(), 1u);
 
-    // Read and decrypt the cluster metadata
-    u8 clusterMDCrypted[0x400];
-    u8 clusterMD[0x400];
-    u8 IV[16] = {0};
-    if (!m_pReader->Read(clusterOff, 0x400, clusterMDCrypted))
+  struct Batch
+  {
+    u64 first_cluster = 0;
+    u64 num_clusters = 0;
+    std::vector<u8> data = std::vector<u8>(clusters_per_batch * s_block_total_size);
+  };
+  std::vector<Batch> batches(num_workers + 2);
+
+  std::mutex mutex;
+  std::condition_variable work_available;
+  std::condition_variable batch_freed;
+  std::deque<Batch*> pending;
+  std::vector<Batch*> free_batches;
+  for (Batch& batch : batches)
+    free_batches.push_back(&batch);
+  bool reading_done = false;
+  // Clusters at or past the first bad one don't need to be checked.
+  u64 first_bad_cluster = nClusters;
+  u64 checked_clusters = 0;
+
+  auto worker = [&] {
+    Common::SetCurrentThreadName("Integrity check");
+    std::vector<u8> decrypted_data(s_block_data_size);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
     {
-      WARN_LOG(DISCIO, "Integrity Check: fail at cluster %d: could not read metadata", clusterID);
-      return false;
+      work_available.wait(lock, [&] { return !pending.empty() || reading_done; });
+      if (pending.empty())
+        return;
+
+      Batch* batch = pending.front();
+      pending.pop_front();
+      const u64 known_bad_cluster = first_bad_cluster;
+      lock.unlock();
+
+      u64 bad_cluster = nClusters;
+      for (u64 i = 0; i < batch->num_clusters; ++i)
+      {
+        const u64 clusterID = batch->first_cluster + i;
+        if (clusterID >= known_bad_cluster)
+          break;
+        if (!CheckClusterIntegrity(&batch->data[i * s_block_total_size], clusterID,
+                                   decrypted_data.data()))
+        {
+          bad_cluster = clusterID;
+          break;
+        }
+      }
+
+      lock.lock();
+      first_bad_cluster = std::min(first_bad_cluster, bad_cluster);
+      checked_clusters += batch->num_clusters;
+      free_batches.push_back(batch);
+      batch_freed.notify_one();
     }
-    mbedtls_aes_crypt_cbc(m_AES_ctx.get(), MBEDTLS_AES_DECRYPT, 0x400, IV, clusterMDCrypted,
-                          clusterMD);
-
-    // Some clusters have invalid data and metadata because they aren't
-    // meant to be read by the game (for example, holes between files). To
-    // try to avoid reporting errors because of these clusters, we check
-    // the 0x00 paddings in the metadata.
-    //
-    // This may cause some false negatives though: some bad clusters may be
-    // skipped because they are *too* bad and are not even recognized as
-    // valid clusters. To be improved.
-    bool meaningless = false;
-    for (u32 idx = 0x26C; idx < 0x280; ++idx)
-      if (clusterMD[idx] != 0)
-        meaningless = true;
-
-    if (meaningless)
-      continue;
+  };
+
+  std::vector<std::thread> workers;
+  for (u32 i = 0; i < num_workers; ++i)
+    workers.emplace_back(worker);
 
-    u8 clusterData[0x7C00];
-    if (!Read((u64)clusterID * 0x7C00, 0x7C00, clusterData, true))
+  for (u64 clusterID = 0; clusterID < nClusters; clusterID += clusters_per_batch)
+  {
+    Batch* batch;
+    u64 checked;
     {
-      WARN_LOG(DISCIO, "Integrity Check: fail at cluster %d: could not read data", clusterID);
-      return false;
+      std::unique_lock<std::mutex> lock(mutex);
+      batch_freed.wait(lock, [&] { return !free_batches.empty(); });
+      if (first_bad_cluster <= clusterID)
+        break;
+      batch = free_batches.back();
+      free_batches.pop_back();
+      checked = checked_clusters;
     }
 
-    for (u32 hashID = 0; hashID < 31; ++hashID)
+    if (progress && !progress(checked * s_block_data_size, nClusters * s_block_data_size))
     {
-      u8 hash[20];
-
-      mbedtls_sha1(clusterData + hashID * 0x400, 0x400, hash);
+      result.cancelled = true;
+      break;
+    }
 
-      // Note that we do not use strncmp here
-      if (memcmp(hash, clusterMD + hashID * 20, 20))
+    batch->first_cluster = clusterID;
+    batch->num_clusters = std::min(clusters_per_batch, nClusters - clusterID);
+    const u64 batch_offset = m_VolumeOffset + m_dataOffset + clusterID * s_block_total_size;
+    bool read_failed = false;
+    if (!m_pReader->Read(batch_offset, batch->num_clusters * s_block_total_size,
+                         batch->data.data()))
+    {
+      // Narrow the failure down to the first cluster that can't be read, and still check the
+      // ones before it.
+      for (u64 i = 0; i < batch->num_clusters; ++i)
       {
-        WARN_LOG(DISCIO, "Integrity Check: fail at cluster %d: hash %d is invalid", clusterID,
-                 hashID);
-        return false;
+        if (!m_pReader->Read(batch_offset + i * s_block_total_size, s_block_total_size,
+                             &batch->data[i * s_block_total_size]))
+        {
+          WARN_LOG(DISCIO, "Integrity Check: fail at cluster %" PRIu64 ": could not read data",
+                   clusterID + i);
+          batch->num_clusters = i;
+          read_failed = true;
+          break;
+        }
       }
     }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (read_failed)
+      first_bad_cluster = std::min(first_bad_cluster, clusterID + batch->num_clusters);
+    pending.push_back(batch);
+    work_available.notify_one();
+    if (read_failed)
+      break;
   }
 
-  return true;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    reading_done = true;
+  }
+  work_available.notify_all();
+  for (std::thread& thread : workers)
+    thread.join();
+
+  result.success = !result.cancelled && first_bad_cluster == nClusters;
+  result.first_bad_cluster = first_bad_cluster;
+  result.bytes_checked = std::min(checked_clusters, first_bad_cluster) * s_block_data_size;
+  result.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+  INFO_LOG(DISCIO, "Integrity check %s after %" PRIu64 " MiB at %.1f MiB/s",
+           result.success ? "passed" : "stopped", result.bytes_checked / (1024 * 1024),
+           result.GetMegabytesPerSecond());
+  return result;
 }
 
 }  // namespace
@@ -4,13 +4,15 @@
 
 #pragma once
 
+#include <array>
 #include <map>
-#include <mbedtls/aes.h>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
 #include "DiscIO/Volume.h"
 
 // --- this volume type is used for encrypted Wii images ---
@@ -30,6 +32,7 @@ public:
                     const unsigned char* _pVolumeKey);
   ~CVolumeWiiCrypted();
   bool Read(u64 _Offset, u64 _Length, u8* _pBuffer, bool decrypt) const override;
+  bool Prefetch(u64 offset, u64 length, bool decrypt) const override;
   bool GetTitleID(u64* buffer) const override;
   std::vector<u8> GetTMD() const override;
   std::string GetGameID() const override;
@@ -44,7 +47,7 @@ public:
 
   Platform GetVolumeType() const override;
   bool SupportsIntegrityCheck() const override { return true; }
-  bool CheckIntegrity() const override;
+  IntegrityCheckResult CheckIntegrity(const IntegrityCheckProgress& progress) const override;
   bool ChangePartition(u64 offset) override;
 
   Region GetRegion() const override;
@@ -58,14 +61,35 @@ private:
   static const unsigned int s_block_data_size = 0x7C00;
   static const unsigned int s_block_total_size = s_block_header_size + s_block_data_size;
 
+  // 64 clusters take up about 2 MiB.
+  static const size_t s_cached_clusters = 64;
+  // Maximum number of uncached clusters that are fetched from the blob with a single read.
+  static const size_t s_max_clusters_per_read = 16;
+
+  struct CachedCluster
+  {
+    u64 index;
+    u64 last_use;
+    std::array<u8, s_block_data_size> data;
+  };
+
+  const u8* FindCachedCluster(u64 cluster) const;
+  u8* AllocateCachedCluster(u64 cluster) const;
+  void ClearCache();
+  void DecryptCluster(const u8* raw_cluster, u8* out) const;
+  bool CheckClusterIntegrity(const u8* raw_cluster, u64 cluster, u8* decrypted_data) const;
+
   std::unique_ptr<IBlobReader> m_pReader;
-  std::unique_ptr<mbedtls_aes_context> m_AES_ctx;
+  std::unique_ptr<Common::AES::DecryptionContext> m_AES_ctx;
 
   u64 m_VolumeOffset;
   u64 m_dataOffset;
 
-  mutable u64 m_LastDecryptedBlockOffset;
-  mutable unsigned char m_LastDecryptedBlock[s_block_data_size];
+  // Least recently used cache of decrypted clusters, indexed by cluster number.
+  mutable std::vector<CachedCluster> m_cluster_cache;
+  mutable std::unordered_map<u64, size_t> m_cluster_cache_index;
+  mutable u64 m_cluster_cache_tick;
+  mutable std::vector<u8> m_read_buffer;
 };
 
 }  // namespace
@@ -0,0 +1,776 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <cstring>
+#include <mbedtls/aes.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <zlib.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/Crypto/SHA1.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "Common/Logging/Log.h"
+#include "Common/MsgHandler.h"
+#include "Common/StringUtil.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/VolumeCreator.h"
+#include "DiscIO/WCZBlob.h"
+
+namespace DiscIO
+{
+static_assert(sizeof(WCZHeader) == 32, "WCZHeader must not have padding");
+static_assert(sizeof(WCZPartition) == 24, "WCZPartition must not have padding");
+static_assert(sizeof(WCZChunk) == 32, "WCZChunk must not have padding");
+static_assert(sizeof(WCZHashException) == 24, "WCZHashException must not have padding");
+
+constexpr size_t WCZFileReader::CACHED_CHUNKS;
+
+static constexpr u64 CLUSTER_SIZE = 0x8000;
+static constexpr u64 CLUSTER_DATA_SIZE = 0x7C00;
+static constexpr u64 HASH_BLOCK_SIZE = CLUSTER_SIZE - CLUSTER_DATA_SIZE;
+static constexpr size_t CLUSTERS_PER_SUBGROUP = 8;
+static constexpr size_t CLUSTERS_PER_GROUP = 64;
+static constexpr size_t H0_HASHES = CLUSTER_DATA_SIZE / 0x400;
+static constexpr size_t H1_OFFSET = 0x280;
+static constexpr size_t H2_OFFSET = 0x340;
+static constexpr size_t HASH_SIZE = Common::SHA1::DIGEST_SIZE;
+
+// Chunks are compressed in batches of this many per thread, and then written in order.
+static constexpr u32 COMPRESS_CHUNKS_PER_THREAD = 2;
+
+void CalculateWiiHashBlocks(const u8* data, size_t num_clusters, u8* hash_blocks)
+{
+  std::fill(hash_blocks, hash_blocks + num_clusters * HASH_BLOCK_SIZE, 0);
+
+  // H0 covers 0x400 bytes of data
+  for (size_t cluster = 0; cluster < num_clusters; ++cluster)
+  {
+    for (size_t i = 0; i < H0_HASHES; ++i)
+    {
+      const Common::SHA1::Digest h0 =
+          Common::SHA1::CalculateDigest(&data[cluster * CLUSTER_DATA_SIZE + i * 0x400], 0x400);
+      std::copy(h0.begin(), h0.end(), &hash_blocks[cluster * HASH_BLOCK_SIZE + i * HASH_SIZE]);
+    }
+  }
+
+  // H1 covers the H0 table of a cluster, and every cluster in a subgroup carries all 8 of them
+  for (size_t cluster = 0; cluster < num_clusters; ++cluster)
+  {
+    const Common::SHA1::Digest h1 = Common::SHA1::CalculateDigest(
+        &hash_blocks[cluster * HASH_BLOCK_SIZE], H0_HASHES * HASH_SIZE);
+    const size_t subgroup_start = cluster / CLUSTERS_PER_SUBGROUP * CLUSTERS_PER_SUBGROUP;
+    const size_t subgroup_end = std::min(subgroup_start + CLUSTERS_PER_SUBGROUP, num_clusters);
+    for (size_t member = subgroup_start; member < subgroup_end; ++member)
+    {
+      std::copy(h1.begin(), h1.end(),
+                &hash_blocks[member * HASH_BLOCK_SIZE + H1_OFFSET +
+                             cluster % CLUSTERS_PER_SUBGROUP * HASH_SIZE]);
+    }
+  }
+
+  // H2 covers the H1 table of a subgroup, and every cluster in the group carries all 8 of them
+  const size_t num_subgroups = (num_clusters + CLUSTERS_PER_SUBGROUP - 1) / CLUSTERS_PER_SUBGROUP;
+  for (size_t subgroup = 0; subgroup < num_subgroups; ++subgroup)
+  {
+    const Common::SHA1::Digest h2 = Common::SHA1::CalculateDigest(
+        &hash_blocks[subgroup * CLUSTERS_PER_SUBGROUP * HASH_BLOCK_SIZE + H1_OFFSET],
+        CLUSTERS_PER_SUBGROUP * HASH_SIZE);
+    for (size_t member = 0; member < num_clusters; ++member)
+    {
+      std::copy(h2.begin(), h2.end(),
+                &hash_blocks[member * HASH_BLOCK_SIZE + H2_OFFSET + subgroup * HASH_SIZE]);
+    }
+  }
+}
+
+WCZFileReader::WCZFileReader(File::IOFile file, const std::string& path)
+    : m_file(std::move(file)), m_path(path)
+{
+  m_file_size = m_file.GetSize();
+  m_cache.reserve(CACHED_CHUNKS);
+}
+
+WCZFileReader::~WCZFileReader()
+{
+}
+
+std::unique_ptr<WCZFileReader> WCZFileReader::Create(File::IOFile file, const std::string& path)
+{
+  if (!IsWCZBlob(file))
+    return nullptr;
+
+  std::unique_ptr<WCZFileReader> reader(new WCZFileReader(std::move(file), path));
+  if (!reader->Initialize())
+    return nullptr;
+
+  return reader;
+}
+
+bool WCZFileReader::Initialize()
+{
+  if (!m_file.Seek(0, SEEK_SET) || !m_file.ReadArray(&m_header, 1) ||
+      m_header.version != WCZ_VERSION)
+  {
+    return false;
+  }
+
+  const u64 tables_size = sizeof(WCZPartition) * u64{m_header.num_partitions} +
+                          sizeof(WCZChunk) * u64{m_header.num_chunks};
+  if (m_file_size < sizeof(WCZHeader) + tables_size)
+    return false;
+
+  m_partitions.resize(m_header.num_partitions);
+  m_chunks.resize(m_header.num_chunks);
+  if (!m_file.ReadArray(m_partitions.data(), m_partitions.size()) ||
+      !m_file.ReadArray(m_chunks.data(), m_chunks.size()))
+  {
+    return false;
+  }
+
+  m_chunk_offsets.reserve(m_chunks.size());
+  u64 offset = 0;
+  for (const WCZChunk& chunk : m_chunks)
+  {
+    if (chunk.partition > m_partitions.size() ||
+        chunk.file_offset + chunk.stored_size > m_file_size)
+    {
+      ERROR_LOG(DISCIO, "WCZ: %s has an invalid chunk table", m_path.c_str());
+      return false;
+    }
+    m_chunk_offsets.push_back(offset);
+    offset += chunk.data_size;
+  }
+  if (offset != m_header.data_size)
+  {
+    ERROR_LOG(DISCIO, "WCZ: The chunks of %s don't cover the disc", m_path.c_str());
+    return false;
+  }
+
+  // The tickets are stored as they are, so the keys come from the image itself
+  m_partition_keys.resize(m_partitions.size());
+  for (size_t i = 0; i < m_partitions.size(); ++i)
+    VolumeKeyForPartition(*this, m_partitions[i].partition_offset, m_partition_keys[i].data());
+
+  return true;
+}
+
+size_t WCZFileReader::FindChunk(u64 offset) const
+{
+  return std::upper_bound(m_chunk_offsets.begin(), m_chunk_offsets.end(), offset) -
+         m_chunk_offsets.begin() - 1;
+}
+
+const WCZPartition* WCZFileReader::FindPartition(u64 data_start) const
+{
+  for (const WCZPartition& partition : m_partitions)
+  {
+    if (partition.data_start == data_start)
+      return &partition;
+  }
+  return nullptr;
+}
+
+WCZFileReader::CacheEntry* WCZFileReader::FindCacheEntry(size_t index)
+{
+  for (CacheEntry& entry : m_cache)
+  {
+    if (entry.index == index)
+    {
+      entry.last_use = ++m_cache_tick;
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+std::shared_ptr<const WCZFileReader::DecodedChunk> WCZFileReader::GetChunk(size_t index)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_cache_lock);
+    if (const CacheEntry* entry = FindCacheEntry(index))
+      return entry->decoded;
+  }
+
+  auto decoded = std::make_shared<DecodedChunk>();
+  if (!DecodeChunk(index, decoded.get()))
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock(m_cache_lock);
+  // Another thread may have decoded the same chunk in the meantime
+  if (const CacheEntry* entry = FindCacheEntry(index))
+    return entry->decoded;
+
+  CacheEntry* entry;
+  if (m_cache.size() < CACHED_CHUNKS)
+  {
+    m_cache.emplace_back();
+    entry = &m_cache.back();
+  }
+  else
+  {
+    entry = &*std::min_element(m_cache.begin(), m_cache.end(),
+                               [](const CacheEntry& a, const CacheEntry& b) {
+                                 return a.last_use < b.last_use;
+                               });
+  }
+
+  entry->index = index;
+  entry->last_use = ++m_cache_tick;
+  entry->decoded = std::move(decoded);
+  entry->encrypted.reset();
+  return entry->decoded;
+}
+
+std::shared_ptr<const std::vector<u8>> WCZFileReader::GetEncryptedChunk(size_t index)
+{
+  const std::shared_ptr<const DecodedChunk> decoded = GetChunk(index);
+  if (!decoded)
+    return nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(m_cache_lock);
+    const CacheEntry* entry = FindCacheEntry(index);
+    if (entry && entry->encrypted)
+      return entry->encrypted;
+  }
+
+  auto encrypted = std::make_shared<const std::vector<u8>>(EncryptChunk(index, *decoded));
+
+  std::lock_guard<std::mutex> lock(m_cache_lock);
+  CacheEntry* entry = FindCacheEntry(index);
+  if (entry && !entry->encrypted)
+    entry->encrypted = encrypted;
+  return encrypted;
+}
+
+bool WCZFileReader::DecodeChunk(size_t index, DecodedChunk* chunk) const
+{
+  const WCZChunk& info = m_chunks[index];
+
+  std::vector<u8> stored(info.stored_size);
+  if (!m_file.ReadAt(stored.data(), info.stored_size, info.file_offset))
+  {
+    PanicAlertT("The disc image \"%s\" is truncated, some of the data is missing.",
+                m_path.c_str());
+    return false;
+  }
+
+  const u32 hash = HashAdler32(stored.data(), stored.size());
+  if (hash != info.hash)
+  {
+    PanicAlertT("The disc image \"%s\" is corrupt.\n"
+                "Hash of block %" PRIu64 " is %08x instead of %08x.",
+                m_path.c_str(), static_cast<u64>(index), hash, info.hash);
+    return false;
+  }
+
+  chunk->data.resize(info.payload_size);
+  if (info.compressed)
+  {
+    uLongf size = info.payload_size;
+    if (uncompress(chunk->data.data(), &size, stored.data(), info.stored_size) != Z_OK ||
+        size != info.payload_size)
+    {
+      ERROR_LOG(DISCIO, "WCZ: Failed to decompress chunk %zu of %s", index, m_path.c_str());
+      return false;
+    }
+  }
+  else
+  {
+    if (info.stored_size != info.payload_size)
+      return false;
+    chunk->data.swap(stored);
+  }
+
+  if (info.partition == 0)
+  {
+    chunk->hash_blocks.clear();
+    return info.payload_size == info.data_size;
+  }
+
+  const size_t num_clusters = info.data_size / CLUSTER_SIZE;
+  const size_t data_bytes = num_clusters * CLUSTER_DATA_SIZE;
+  u32 num_exceptions;
+  if (info.data_size % CLUSTER_SIZE != 0 || num_clusters > CLUSTERS_PER_GROUP ||
+      info.payload_size < data_bytes + sizeof(num_exceptions))
+  {
+    ERROR_LOG(DISCIO, "WCZ: Chunk %zu of %s is invalid", index, m_path.c_str());
+    return false;
+  }
+
+  std::memcpy(&num_exceptions, &chunk->data[data_bytes], sizeof(num_exceptions));
+  if (info.payload_size !=
+      data_bytes + sizeof(num_exceptions) + u64{num_exceptions} * sizeof(WCZHashException))
+  {
+    ERROR_LOG(DISCIO, "WCZ: Chunk %zu of %s is invalid", index, m_path.c_str());
+    return false;
+  }
+
+  chunk->hash_blocks.resize(num_clusters * HASH_BLOCK_SIZE);
+  CalculateWiiHashBlocks(chunk->data.data(), num_clusters, chunk->hash_blocks.data());
+
+  const u8* exception_data = &chunk->data[data_bytes + sizeof(num_exceptions)];
+  for (u32 i = 0; i < num_exceptions; ++i)
+  {
+    WCZHashException exception;
+    std::memcpy(&exception, exception_data + i * sizeof(exception), sizeof(exception));
+    if (exception.cluster >= num_clusters ||
+        exception.offset + exception.data.size() > HASH_BLOCK_SIZE)
+    {
+      ERROR_LOG(DISCIO, "WCZ: Chunk %zu of %s is invalid", index, m_path.c_str());
+      return false;
+    }
+    std::copy(exception.data.begin(), exception.data.end(),
+              &chunk->hash_blocks[exception.cluster * HASH_BLOCK_SIZE + exception.offset]);
+  }
+
+  chunk->data.resize(data_bytes);
+  return true;
+}
+
+std::vector<u8> WCZFileReader::EncryptChunk(size_t index, const DecodedChunk& chunk) const
+{
+  const size_t num_clusters = chunk.hash_blocks.size() / HASH_BLOCK_SIZE;
+  std::vector<u8> encrypted(num_clusters * CLUSTER_SIZE);
+
+  mbedtls_aes_context aes;
+  mbedtls_aes_init(&aes);
+  mbedtls_aes_setkey_enc(&aes, m_partition_keys[m_chunks[index].partition - 1].data(), 128);
+
+  // The hash block is encrypted with an IV of zeroes, and the data with the IV that ends up at
+  // 0x3D0 in the encrypted hash block.
+  for (size_t cluster = 0; cluster < num_clusters; ++cluster)
+  {
+    u8* out = &encrypted[cluster * CLUSTER_SIZE];
+    u8 iv[Common::AES::BLOCK_SIZE] = {};
+    mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, HASH_BLOCK_SIZE, iv,
+                          &chunk.hash_blocks[cluster * HASH_BLOCK_SIZE], out);
+    std::memcpy(iv, &out[0x3D0], sizeof(iv));
+    mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, CLUSTER_DATA_SIZE, iv,
+                          &chunk.data[cluster * CLUSTER_DATA_SIZE], out + HASH_BLOCK_SIZE);
+  }
+
+  mbedtls_aes_free(&aes);
+  return encrypted;
+}
+
+bool WCZFileReader::Read(u64 offset, u64 size, u8* out_ptr)
+{
+  if (offset > m_header.data_size || size > m_header.data_size - offset)
+    return false;
+
+  while (size > 0)
+  {
+    const size_t index = FindChunk(offset);
+    std::shared_ptr<const std::vector<u8>> source;
+    if (m_chunks[index].partition != 0)
+      source = GetEncryptedChunk(index);
+    else if (const std::shared_ptr<const DecodedChunk> chunk = GetChunk(index))
+      source = std::shared_ptr<const std::vector<u8>>(chunk, &chunk->data);
+    if (!source)
+      return false;
+
+    const u64 offset_in_chunk = offset - m_chunk_offsets[index];
+    const u64 copy_size = std::min<u64>(size, m_chunks[index].data_size - offset_in_chunk);
+    std::memcpy(out_ptr, &(*source)[offset_in_chunk], static_cast<size_t>(copy_size));
+
+    offset += copy_size;
+    size -= copy_size;
+    out_ptr += copy_size;
+  }
+
+  return true;
+}
+
+bool WCZFileReader::SupportsReadWiiDecrypted(u64 partition_data_offset) const
+{
+  return FindPartition(partition_data_offset) != nullptr;
+}
+
+bool WCZFileReader::ReadWiiDecrypted(u64 offset, u64 size, u8* out_ptr,
+                                     u64 partition_data_offset)
+{
+  const WCZPartition* partition = FindPartition(partition_data_offset);
+  if (!partition)
+    return false;
+
+  while (size > 0)
+  {
+    const u64 disc_offset = partition->data_start + offset / CLUSTER_DATA_SIZE * CLUSTER_SIZE;
+    if (disc_offset >= partition->data_end)
+      return false;
+
+    const size_t index = FindChunk(disc_offset);
+    if (m_chunks[index].partition == 0)
+      return false;
+    const std::shared_ptr<const DecodedChunk> chunk = GetChunk(index);
+    if (!chunk)
+      return false;
+
+    const u64 chunk_start =
+        (m_chunk_offsets[index] - partition->data_start) / CLUSTER_SIZE * CLUSTER_DATA_SIZE;
+    const u64 offset_in_chunk = offset - chunk_start;
+    const u64 copy_size = std::min<u64>(size, chunk->data.size() - offset_in_chunk);
+    std::memcpy(out_ptr, &chunk->data[offset_in_chunk], static_cast<size_t>(copy_size));
+
+    offset += copy_size;
+    size -= copy_size;
+    out_ptr += copy_size;
+  }
+
+  return true;
+}
+
+// Finds the partitions whose data can be stored decrypted
+static std::vector<WCZPartition> FindPartitions(IBlobReader& reader)
+{
+  std::vector<WCZPartition> partitions;
+  CBlobBigEndianReader big_endian_reader(reader);
+
+  // Discs with a non-zero value at 0x60 aren't encrypted
+  u32 wii_magic;
+  u32 unencrypted;
+  if (!big_endian_reader.ReadSwapped(0x18, &wii_magic) || wii_magic != 0x5D1C9EA3 ||
+      !big_endian_reader.ReadSwapped(0x60, &unencrypted) || unencrypted != 0)
+  {
+    return partitions;
+  }
+
+  for (u32 group = 0; group < 4; ++group)
+  {
+    u32 num_partitions;
+    u32 table_offset;
+    if (!big_endian_reader.ReadSwapped(0x40000 + group * 8, &num_partitions) ||
+        !big_endian_reader.ReadSwapped(0x40000 + group * 8 + 4, &table_offset))
+    {
+      continue;
+    }
+
+    for (u32 i = 0; i < num_partitions && i < 0x100; ++i)
+    {
+      u32 offset;
+      u32 data_offset;
+      u32 data_size;
+      if (!big_endian_reader.ReadSwapped((u64{table_offset} << 2) + i * 8, &offset))
+        break;
+
+      const u64 partition_offset = u64{offset} << 2;
+      if (!big_endian_reader.ReadSwapped(partition_offset + 0x2B8, &data_offset) ||
+          !big_endian_reader.ReadSwapped(partition_offset + 0x2BC, &data_size))
+      {
+        continue;
+      }
+
+      WCZPartition partition;
+      partition.partition_offset = partition_offset;
+      partition.data_start = partition_offset + (u64{data_offset} << 2);
+      partition.data_end =
+          partition.data_start + (u64{data_size} << 2) / CLUSTER_SIZE * CLUSTER_SIZE;
+      if (partition.data_start % CLUSTER_SIZE == 0 && partition.data_end > partition.data_start &&
+          partition.data_end <= reader.GetDataSize())
+      {
+        partitions.push_back(partition);
+      }
+    }
+  }
+
+  // Anything that overlaps another partition is left encrypted
+  std::sort(partitions.begin(), partitions.end(), [](const WCZPartition& a, const WCZPartition& b) {
+    return a.data_start < b.data_start;
+  });
+  std::vector<WCZPartition> result;
+  for (const WCZPartition& partition : partitions)
+  {
+    if (result.empty() || result.back().data_end <= partition.partition_offset)
+      result.push_back(partition);
+  }
+  return result;
+}
+
+// Turns the data of a chunk into what gets compressed. For partition chunks, that's the
+// decrypted data and whatever in the hash blocks can't be calculated from it.
+static void BuildPayload(const u8* data, u32 data_size, bool in_partition,
+                         const Common::AES::DecryptionContext& aes, std::vector<u8>* payload)
+{
+  if (!in_partition)
+  {
+    payload->assign(data, data + data_size);
+    return;
+  }
+
+  const size_t num_clusters = data_size / CLUSTER_SIZE;
+  const size_t data_bytes = num_clusters * CLUSTER_DATA_SIZE;
+  payload->resize(data_bytes);
+  std::vector<u8> hash_blocks(num_clusters * HASH_BLOCK_SIZE);
+  for (size_t cluster = 0; cluster < num_clusters; ++cluster)
+  {
+    const u8* raw = &data[cluster * CLUSTER_SIZE];
+    u8 iv[Common::AES::BLOCK_SIZE] = {};
+    aes.DecryptCBC(iv, raw, &hash_blocks[cluster * HASH_BLOCK_SIZE], HASH_BLOCK_SIZE);
+    std::memcpy(iv, &raw[0x3D0], sizeof(iv));
+    aes.DecryptCBC(iv, raw + HASH_BLOCK_SIZE, &(*payload)[cluster * CLUSTER_DATA_SIZE],
+                   CLUSTER_DATA_SIZE);
+  }
+
+  std::vector<u8> calculated(hash_blocks.size());
+  CalculateWiiHashBlocks(payload->data(), num_clusters, calculated.data());
+
+  std::vector<WCZHashException> exceptions;
+  for (size_t cluster = 0; cluster < num_clusters; ++cluster)
+  {
+    const u8* actual = &hash_blocks[cluster * HASH_BLOCK_SIZE];
+    const u8* expected = &calculated[cluster * HASH_BLOCK_SIZE];
+    size_t i = 0;
+    while (i < HASH_BLOCK_SIZE)
+    {
+      if (actual[i] == expected[i])
+      {
+        ++i;
+        continue;
+      }
+
+      WCZHashException exception;
+      const size_t offset = std::min(i, HASH_BLOCK_SIZE - exception.data.size());
+      exception.cluster = static_cast<u16>(cluster);
+      exception.offset = static_cast<u16>(offset);
+      std::copy(actual + offset, actual + offset + exception.data.size(), exception.data.begin());
+      exceptions.push_back(exception);
+      i = offset + exception.data.size();
+    }
+  }
+
+  const u32 num_exceptions = static_cast<u32>(exceptions.size());
+  payload->resize(data_bytes + sizeof(num_exceptions) + exceptions.size() * sizeof(exceptions[0]));
+  std::memcpy(&(*payload)[data_bytes], &num_exceptions, sizeof(num_exceptions));
+  if (!exceptions.empty())
+  {
+    std::memcpy(&(*payload)[data_bytes + sizeof(num_exceptions)], exceptions.data(),
+                exceptions.size() * sizeof(exceptions[0]));
+  }
+}
+
+bool ConvertToWCZ(const std::string& infile_path, const std::string& outfile_path,
+                  CompressCB callback, void* arg)
+{
+  std::unique_ptr<IBlobReader> infile = CreateBlobReader(infile_path);
+  if (!infile)
+  {
+    PanicAlertT("Failed to open the input file \"%s\".", infile_path.c_str());
+    return false;
+  }
+
+  if (infile->GetBlobType() == BlobType::WCZ)
+  {
+    PanicAlertT("\"%s\" is already compressed! Cannot compress it further.", infile_path.c_str());
+    return false;
+  }
+
+  File::IOFile outfile(outfile_path, "wb");
+  if (!outfile)
+  {
+    PanicAlertT("Failed to open the output file \"%s\".\n"
+                "Check that you have permissions to write the target folder and that the media can "
+                "be written.",
+                outfile_path.c_str());
+    return false;
+  }
+
+  callback(GetStringT("Files opened, ready to compress."), 0, arg);
+
+  WCZHeader header = {};
+  header.magic = WCZ_MAGIC;
+  header.version = WCZ_VERSION;
+  header.data_size = infile->GetDataSize();
+
+  const std::vector<WCZPartition> partitions = FindPartitions(*infile);
+  std::vector<std::array<u8, 16>> keys(partitions.size());
+  for (size_t i = 0; i < partitions.size(); ++i)
+    VolumeKeyForPartition(*infile, partitions[i].partition_offset, keys[i].data());
+
+  // Partition data is split at the groups that H2 hashes cover, and everything else into
+  // chunks of the same size.
+  std::vector<WCZChunk> chunks;
+  std::vector<u64> chunk_offsets;
+  u64 position = 0;
+  const auto add_chunks = [&](u64 end, u32 partition) {
+    while (position < end)
+    {
+      WCZChunk chunk = {};
+      chunk.data_size = static_cast<u32>(std::min<u64>(WCZ_CHUNK_SIZE, end - position));
+      chunk.partition = partition;
+      chunks.push_back(chunk);
+      chunk_offsets.push_back(position);
+      position += chunk.data_size;
+    }
+  };
+  for (size_t i = 0; i < partitions.size(); ++i)
+  {
+    add_chunks(partitions[i].data_start, 0);
+    add_chunks(partitions[i].data_end, static_cast<u32>(i + 1));
+  }
+  add_chunks(header.data_size, 0);
+
+  header.num_partitions = static_cast<u32>(partitions.size());
+  header.num_chunks = static_cast<u32>(chunks.size());
+
+  // seek past the header and tables (we will write them at the end)
+  const u64 data_start = sizeof(WCZHeader) + sizeof(WCZPartition) * partitions.size() +
+                         sizeof(WCZChunk) * chunks.size();
+  outfile.Seek(data_start, SEEK_SET);
+
+  // Decrypting, hashing and deflating all take time, and every chunk is handled on its own, so a
+  // batch of chunks is read, processed on all cores, and then written in order.
+  const u32 num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  const u32 batch_chunks = num_threads * COMPRESS_CHUNKS_PER_THREAD;
+  std::vector<u8> in_buf(static_cast<size_t>(batch_chunks) * WCZ_CHUNK_SIZE);
+  std::vector<std::vector<u8>> payloads(batch_chunks);
+  std::vector<std::vector<u8>> compressed(batch_chunks);
+
+  u64 file_position = data_start;
+  u32 progress_monitor = std::max<u32>(1, header.num_chunks / 1000);
+  u32 next_progress_chunk = 0;
+  bool success = true;
+
+  for (u32 first_chunk = 0; success && first_chunk < header.num_chunks;
+       first_chunk += batch_chunks)
+  {
+    const u32 num_chunks = std::min(batch_chunks, header.num_chunks - first_chunk);
+
+    if (first_chunk >= next_progress_chunk)
+    {
+      const u64 inpos = chunk_offsets[first_chunk];
+      int ratio = 0;
+      if (inpos != 0)
+        ratio = (int)(100 * (file_position - data_start) / inpos);
+
+      std::string temp =
+          StringFromFormat(GetStringT("%i of %i blocks. Compression ratio %i%%").c_str(),
+                           first_chunk, header.num_chunks, ratio);
+      bool was_cancelled = !callback(temp, (float)first_chunk / (float)header.num_chunks, arg);
+      if (was_cancelled)
+      {
+        success = false;
+        break;
+      }
+      next_progress_chunk = first_chunk + progress_monitor;
+    }
+
+    for (u32 i = 0; i < num_chunks; ++i)
+    {
+      const WCZChunk& chunk = chunks[first_chunk + i];
+      if (!infile->Read(chunk_offsets[first_chunk + i], chunk.data_size,
+                        &in_buf[static_cast<size_t>(i) * WCZ_CHUNK_SIZE]))
+      {
+        PanicAlertT("Failed to read from the input file \"%s\".", infile_path.c_str());
+        success = false;
+        break;
+      }
+    }
+    if (!success)
+      break;
+
+    const auto compress_chunks = [&](u32 first_in_batch, u32 step) {
+      Common::AES::DecryptionContext aes;
+      u32 current_partition = 0;
+
+      for (u32 i = first_in_batch; i < num_chunks; i += step)
+      {
+        WCZChunk& chunk = chunks[first_chunk + i];
+        if (chunk.partition != 0 && chunk.partition != current_partition)
+        {
+          aes.SetKey(keys[chunk.partition - 1].data());
+          current_partition = chunk.partition;
+        }
+
+        std::vector<u8>& payload = payloads[i];
+        BuildPayload(&in_buf[static_cast<size_t>(i) * WCZ_CHUNK_SIZE], chunk.data_size,
+                     chunk.partition != 0, aes, &payload);
+        chunk.payload_size = static_cast<u32>(payload.size());
+
+        // Store the chunk uncompressed if it doesn't get any smaller
+        std::vector<u8>& out = compressed[i];
+        uLongf compressed_size = compressBound(static_cast<uLong>(payload.size()));
+        out.resize(compressed_size);
+        if (compress2(out.data(), &compressed_size, payload.data(),
+                      static_cast<uLong>(payload.size()), 9) == Z_OK &&
+            compressed_size < payload.size())
+        {
+          out.resize(compressed_size);
+          chunk.compressed = 1;
+        }
+        else
+        {
+          out.swap(payload);
+          chunk.compressed = 0;
+        }
+
+        chunk.stored_size = static_cast<u32>(out.size());
+        chunk.hash = HashAdler32(out.data(), out.size());
+      }
+    };
+
+    std::vector<std::thread> threads;
+    const u32 num_batch_threads = std::min(num_threads, num_chunks);
+    for (u32 i = 1; i < num_batch_threads; ++i)
+      threads.emplace_back(compress_chunks, i, num_batch_threads);
+    compress_chunks(0, num_batch_threads);
+    for (std::thread& thread : threads)
+      thread.join();
+
+    for (u32 i = 0; i < num_chunks; ++i)
+    {
+      WCZChunk& chunk = chunks[first_chunk + i];
+      chunk.file_offset = file_position;
+      if (!outfile.WriteBytes(compressed[i].data(), compressed[i].size()))
+      {
+        PanicAlertT("Failed to write the output file \"%s\".\n"
+                    "Check that you have enough space available on the target drive.",
+                    outfile_path.c_str());
+        success = false;
+        break;
+      }
+      file_position += compressed[i].size();
+    }
+  }
+
+  if (!success)
+  {
+    // Remove the incomplete output file.
+    outfile.Close();
+    File::Delete(outfile_path);
+    return false;
+  }
+
+  // Okay, go back and fill in headers
+  outfile.Seek(0, SEEK_SET);
+  outfile.WriteArray(&header, 1);
+  outfile.WriteArray(partitions.data(), partitions.size());
+  outfile.WriteArray(chunks.data(), chunks.size());
+
+  callback(GetStringT("Done compressing disc image."), 1.0f, arg);
+  return true;
+}
+
+bool IsWCZBlob(File::IOFile& file)
+{
+  const u64 position = file.Tell();
+  if (!file.Seek(0, SEEK_SET))
+    return false;
+  WCZHeader header;
+  bool is_wcz = file.ReadArray(&header, 1) && header.magic == WCZ_MAGIC;
+  file.Seek(position, SEEK_SET);
+  return is_wcz;
+}
+
+}  // namespace DiscIO
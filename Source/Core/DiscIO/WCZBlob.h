@@ -0,0 +1,159 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// WARNING Code not big-endian safe.
+
+// WCZ is a compressed format for Wii discs. The encrypted data in Wii partitions doesn't
+// compress, so instead of storing it as it is (like GCZ does), WCZ stores it decrypted, without
+// the hashes that can be calculated from it. When the image is read, the hashes are calculated
+// and the data encrypted again, which gives back the original disc bit for bit. Reads of
+// decrypted partition data (which is what games do) skip all of that.
+
+// To create WCZ images, use ConvertToWCZ.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Blob.h"
+
+namespace DiscIO
+{
+static constexpr u32 WCZ_MAGIC = 0x015A4357;  // "WCZ\1"
+
+// WCZ file structure:
+// WCZHeader
+// WCZPartition partitions[num_partitions]
+// WCZChunk chunks[num_chunks], which cover the whole disc in order
+// chunk data
+//
+// The data of a chunk in a partition (which is a group of up to 64 clusters, the unit that the
+// H2 hashes cover) is, before compression:
+// u8 data[num_clusters][0x7C00], the decrypted data
+// u32 n, WCZHashException exceptions[n]: the parts of the decrypted hash blocks which aren't
+//   what calculating the hashes from the data gives, such as padding that isn't zero
+// Other chunks hold up to WCZ_CHUNK_SIZE bytes of the disc as they are.
+struct WCZHeader  // 32 bytes
+{
+  u32 magic;
+  u32 version;
+  u64 data_size;
+  u32 num_partitions;
+  u32 num_chunks;
+  u64 reserved;
+};
+
+struct WCZPartition  // 24 bytes
+{
+  u64 partition_offset;
+  // Where the encrypted clusters start and end on the disc
+  u64 data_start;
+  u64 data_end;
+};
+
+struct WCZChunk  // 32 bytes
+{
+  u64 file_offset;
+  u32 stored_size;
+  // The size before compression
+  u32 payload_size;
+  // The number of bytes of the disc that the chunk covers
+  u32 data_size;
+  // 1 + the index of the partition the chunk is in, or 0 if it's stored as it is
+  u32 partition;
+  // Adler-32 of the stored data
+  u32 hash;
+  u32 compressed;
+};
+
+struct WCZHashException  // 24 bytes
+{
+  u16 cluster;
+  u16 offset;
+  std::array<u8, 20> data;
+};
+
+constexpr u32 WCZ_VERSION = 1;
+constexpr u32 WCZ_CHUNK_SIZE = 0x200000;
+
+class WCZFileReader final : public IBlobReader
+{
+public:
+  static std::unique_ptr<WCZFileReader> Create(File::IOFile file, const std::string& path);
+  ~WCZFileReader();
+
+  BlobType GetBlobType() const override { return BlobType::WCZ; }
+  u64 GetRawSize() const override { return m_file_size; }
+  u64 GetDataSize() const override { return m_header.data_size; }
+  // Unlike most readers, this can be called from several threads at once.
+  bool Read(u64 offset, u64 size, u8* out_ptr) override;
+
+  bool SupportsReadWiiDecrypted(u64 partition_data_offset) const override;
+  bool ReadWiiDecrypted(u64 offset, u64 size, u8* out_ptr, u64 partition_data_offset) override;
+
+private:
+  // Chunks are 2 MiB, so this is 16 MiB of decompressed data, plus what has been encrypted.
+  static constexpr size_t CACHED_CHUNKS = 8;
+
+  // Never changed once it's in the cache, so it can be used without holding m_cache_lock
+  struct DecodedChunk
+  {
+    // The disc data as it is for raw chunks, and the decrypted data for partition chunks
+    std::vector<u8> data;
+    std::vector<u8> hash_blocks;
+  };
+
+  struct CacheEntry
+  {
+    u64 index = UINT64_MAX;
+    u64 last_use = 0;
+    std::shared_ptr<const DecodedChunk> decoded;
+    // Filled in the first time a partition chunk is read without decryption
+    std::shared_ptr<const std::vector<u8>> encrypted;
+  };
+
+  WCZFileReader(File::IOFile file, const std::string& path);
+  bool Initialize();
+
+  // Returns the chunk that contains the given offset of the disc
+  size_t FindChunk(u64 offset) const;
+  const WCZPartition* FindPartition(u64 data_start) const;
+  // Return a chunk from the cache, decoding or encrypting it if needed. m_cache_lock is only
+  // held while looking in the cache and adding to it, so that threads don't wait on each other.
+  std::shared_ptr<const DecodedChunk> GetChunk(size_t index);
+  std::shared_ptr<const std::vector<u8>> GetEncryptedChunk(size_t index);
+  // Returns the cache entry for the chunk, or nullptr. m_cache_lock must be held.
+  CacheEntry* FindCacheEntry(size_t index);
+  bool DecodeChunk(size_t index, DecodedChunk* chunk) const;
+  std::vector<u8> EncryptChunk(size_t index, const DecodedChunk& chunk) const;
+
+  WCZHeader m_header;
+  std::vector<WCZPartition> m_partitions;
+  std::vector<std::array<u8, 16>> m_partition_keys;
+  std::vector<WCZChunk> m_chunks;
+  // Where each chunk starts on the disc
+  std::vector<u64> m_chunk_offsets;
+
+  File::IOFile m_file;
+  u64 m_file_size;
+  std::string m_path;
+
+  std::mutex m_cache_lock;
+  std::vector<CacheEntry> m_cache;
+  u64 m_cache_tick = 0;
+};
+
+// Recalculates the H0, H1 and H2 hashes of a group of clusters (a whole group, except at the end
+// of a partition) from their decrypted data. Padding is left as zeroes.
+void CalculateWiiHashBlocks(const u8* data, size_t num_clusters, u8* hash_blocks);
+
+bool IsWCZBlob(File::IOFile& file);
+
+}  // namespace DiscIO
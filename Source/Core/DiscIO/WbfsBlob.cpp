@@ -117,18 +117,29 @@ bool WbfsFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
 {
   while (nbytes)
   {
+    u64 address;
     u64 read_size;
-    File::IOFile& data_file = SeekToCluster(offset, &read_size);
-    if (read_size == 0)
+    if (!GetPhysicalAddress(offset, &address, &read_size))
+    {
+      PanicAlert("Read beyond end of disc");
       return false;
+    }
     read_size = std::min(read_size, nbytes);
 
-    if (!data_file.ReadBytes(out_ptr, read_size))
+    // WBFS tools mostly store the blocks of a disc in order, so blocks that follow each other in
+    // the file are merged into a single read.
+    u64 next_address;
+    u64 next_size;
+    while (read_size < nbytes &&
+           GetPhysicalAddress(offset + read_size, &next_address, &next_size) &&
+           next_address == address + read_size)
     {
-      data_file.Clear();
-      return false;
+      read_size += std::min(next_size, nbytes - read_size);
     }
 
+    if (!ReadPhysical(address, read_size, out_ptr))
+      return false;
+
     out_ptr += read_size;
     nbytes -= read_size;
     offset += read_size;
@@ -137,37 +148,45 @@ bool WbfsFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
   return true;
 }
 
-File::IOFile& WbfsFileReader::SeekToCluster(u64 offset, u64* available)
+bool WbfsFileReader::GetPhysicalAddress(u64 offset, u64* address, u64* available) const
 {
-  u64 base_cluster = (offset >> m_header.wbfs_sector_shift);
-  if (base_cluster < m_blocks_per_disc)
-  {
-    u64 cluster_address = m_wbfs_sector_size * m_wlba_table[base_cluster];
-    u64 cluster_offset = offset & (m_wbfs_sector_size - 1);
-    u64 final_address = cluster_address + cluster_offset;
+  const u64 base_cluster = offset >> m_header.wbfs_sector_shift;
+  if (base_cluster >= m_blocks_per_disc)
+    return false;
+
+  const u64 cluster_offset = offset & (m_wbfs_sector_size - 1);
+  *address = m_wbfs_sector_size * m_wlba_table[base_cluster] + cluster_offset;
+  *available = m_wbfs_sector_size - cluster_offset;
+  return true;
+}
 
-    for (FileEntry& file_entry : m_files)
+bool WbfsFileReader::ReadPhysical(u64 address, u64 size, u8* out_ptr) const
+{
+  while (size)
+  {
+    // The last file that starts at or before the address
+    const auto it = std::upper_bound(
+        m_files.begin(), m_files.end(), address,
+        [](u64 value, const FileEntry& file_entry) { return value < file_entry.base_address; });
+    const FileEntry& file_entry = *(it - 1);
+
+    const u64 file_offset = address - file_entry.base_address;
+    if (file_offset >= file_entry.size)
     {
-      if (final_address < (file_entry.base_address + file_entry.size))
-      {
-        file_entry.file.Seek(final_address - file_entry.base_address, SEEK_SET);
-        if (available)
-        {
-          u64 till_end_of_file = file_entry.size - (final_address - file_entry.base_address);
-          u64 till_end_of_sector = m_wbfs_sector_size - cluster_offset;
-          *available = std::min(till_end_of_file, till_end_of_sector);
-        }
-
-        return file_entry.file;
-      }
+      PanicAlert("Read beyond end of disc");
+      return false;
     }
+
+    const u64 read_size = std::min(size, file_entry.size - file_offset);
+    if (!file_entry.file.ReadAt(out_ptr, read_size, file_offset))
+      return false;
+
+    out_ptr += read_size;
+    size -= read_size;
+    address += read_size;
   }
 
-  PanicAlert("Read beyond end of disc");
-  if (available)
-    *available = 0;
-  m_files[0].file.Seek(0, SEEK_SET);
-  return m_files[0].file;
+  return true;
 }
 
 std::unique_ptr<WbfsFileReader> WbfsFileReader::Create(File::IOFile file, const std::string& path)
@@ -30,6 +30,7 @@ public:
   u64 GetDataSize() const override;
 
   u64 GetRawSize() const override { return m_size; }
+  // Only uses positional reads, so several threads may read at once.
   bool Read(u64 offset, u64 nbytes, u8* out_ptr) override;
 
 private:
@@ -39,7 +40,11 @@ private:
   bool AddFileToList(File::IOFile file);
   bool ReadHeader();
 
-  File::IOFile& SeekToCluster(u64 offset, u64* available);
+  // Translates a disc offset to an offset in the split files as if they were concatenated,
+  // and returns how much of the disc is stored contiguously from there.
+  bool GetPhysicalAddress(u64 offset, u64* address, u64* available) const;
+  bool ReadPhysical(u64 address, u64 size, u8* out_ptr) const;
+
   bool IsGood() { return m_good; }
   struct FileEntry
   {
@@ -2,8 +2,6 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
-#include <QCryptographicHash>
-#include <QDataStream>
 #include <QDir>
 #include <QImage>
 #include <QSharedPointer>
@@ -12,14 +10,10 @@
 #include "Core/ConfigManager.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/Enums.h"
-#include "DiscIO/Volume.h"
-#include "DiscIO/VolumeCreator.h"
 #include "DolphinQt2/GameList/GameFile.h"
 #include "DolphinQt2/Resources.h"
 #include "DolphinQt2/Settings.h"
-
-static const int CACHE_VERSION = 13;  // Last changed in PR #3261
-static const int DATASTREAM_VERSION = QDataStream::Qt_5_5;
+#include "UICommon/GameScanner.h"
 
 QList<DiscIO::Language> GameFile::GetAvailableLanguages() const
 {
@@ -35,54 +29,38 @@ ConvertLanguageMap(const std::map<DiscIO::Language, std::string>& map)
   return result;
 }
 
-GameFile::GameFile(const QString& path) : m_path(path)
+GameFile::GameFile(const UICommon::GameMetadata& metadata)
+    : m_path(QString::fromStdString(metadata.path))
 {
   m_valid = false;
 
-  if (!LoadFileInfo(path))
+  if (!metadata.valid || !LoadFileInfo(m_path))
     return;
 
-  if (!TryLoadCache())
+  if (metadata.platform == DiscIO::Platform::ELF_DOL)
   {
-    if (TryLoadVolume())
-    {
-      LoadState();
-    }
-    else if (!TryLoadElfDol())
-    {
-      return;
-    }
+    LoadElfDol();
+  }
+  else
+  {
+    LoadMetadata(metadata);
+    LoadState();
   }
 
   m_valid = true;
 }
 
-QString GameFile::GetCacheFileName() const
+void GameFile::ReadBanner(const UICommon::GameMetadata& metadata)
 {
-  QString folder = QString::fromStdString(File::GetUserPath(D_CACHE_IDX));
-  // Append a hash of the full path to prevent name clashes between
-  // files with the same names in different folders.
-  QString hash =
-      QString::fromUtf8(QCryptographicHash::hash(m_path.toUtf8(), QCryptographicHash::Md5).toHex());
-  return folder + m_file_name + hash;
-}
-
-void GameFile::ReadBanner(const DiscIO::IVolume& volume)
-{
-  int width, height;
-  std::vector<u32> buffer = volume.GetBanner(&width, &height);
-  QImage banner(width, height, QImage::Format_RGB888);
-  for (int i = 0; i < width * height; i++)
+  if (metadata.banner.empty())
   {
-    int x = i % width, y = i / width;
-    banner.setPixel(x, y, qRgb((buffer[i] & 0xFF0000) >> 16, (buffer[i] & 0x00FF00) >> 8,
-                               (buffer[i] & 0x0000FF) >> 0));
+    m_banner = Resources::GetMisc(Resources::BANNER_MISSING);
+    return;
   }
 
-  if (!banner.isNull())
-    m_banner = QPixmap::fromImage(banner);
-  else
-    m_banner = Resources::GetMisc(Resources::BANNER_MISSING);
+  const QImage banner(metadata.banner.data(), metadata.banner_width, metadata.banner_height,
+                      metadata.banner_width * 3, QImage::Format_RGB888);
+  m_banner = QPixmap::fromImage(banner);
 }
 
 bool GameFile::LoadFileInfo(const QString& path)
@@ -109,69 +87,31 @@ void GameFile::LoadState()
   m_issues = QString::fromStdString(issues_temp);
 }
 
-bool GameFile::IsElfOrDol()
-{
-  return m_extension == QStringLiteral("elf") || m_extension == QStringLiteral("dol");
-}
-
-bool GameFile::TryLoadCache()
+void GameFile::LoadMetadata(const UICommon::GameMetadata& metadata)
 {
-  QFile cache(GetCacheFileName());
-  if (!cache.exists())
-    return false;
-  if (!cache.open(QIODevice::ReadOnly))
-    return false;
-  if (QFileInfo(cache).lastModified() < m_last_modified)
-    return false;
-
-  QDataStream in(&cache);
-  in.setVersion(DATASTREAM_VERSION);
+  m_game_id = QString::fromStdString(metadata.game_id);
+  m_maker = QString::fromStdString(DiscIO::GetCompanyFromID(metadata.maker_id));
+  m_maker_id = QString::fromStdString(metadata.maker_id);
+  m_revision = metadata.revision;
+  m_internal_name = QString::fromStdString(metadata.internal_name);
+  m_short_names = ConvertLanguageMap(metadata.short_names);
+  m_long_names = ConvertLanguageMap(metadata.long_names);
+  m_short_makers = ConvertLanguageMap(metadata.short_makers);
+  m_long_makers = ConvertLanguageMap(metadata.long_makers);
+  m_descriptions = ConvertLanguageMap(metadata.descriptions);
+  m_disc_number = metadata.disc_number;
+  m_platform = metadata.platform;
+  m_region = metadata.region;
+  m_country = metadata.country;
+  m_blob_type = metadata.blob_type;
+  m_raw_size = metadata.raw_size;
+  m_apploader_date = QString::fromStdString(metadata.apploader_date);
 
-  int cache_version;
-  in >> cache_version;
-  if (cache_version != CACHE_VERSION)
-    return false;
-
-  return false;
+  ReadBanner(metadata);
 }
 
-bool GameFile::TryLoadVolume()
+void GameFile::LoadElfDol()
 {
-  QSharedPointer<DiscIO::IVolume> volume(
-      DiscIO::CreateVolumeFromFilename(m_path.toStdString()).release());
-  if (volume == nullptr)
-    return false;
-
-  m_game_id = QString::fromStdString(volume->GetGameID());
-  std::string maker_id = volume->GetMakerID();
-  m_maker = QString::fromStdString(DiscIO::GetCompanyFromID(maker_id));
-  m_maker_id = QString::fromStdString(maker_id);
-  m_revision = volume->GetRevision();
-  m_internal_name = QString::fromStdString(volume->GetInternalName());
-  m_short_names = ConvertLanguageMap(volume->GetShortNames());
-  m_long_names = ConvertLanguageMap(volume->GetLongNames());
-  m_short_makers = ConvertLanguageMap(volume->GetShortMakers());
-  m_long_makers = ConvertLanguageMap(volume->GetLongMakers());
-  m_descriptions = ConvertLanguageMap(volume->GetDescriptions());
-  m_disc_number = volume->GetDiscNumber();
-  m_platform = volume->GetVolumeType();
-  m_region = volume->GetRegion();
-  m_country = volume->GetCountry();
-  m_blob_type = volume->GetBlobType();
-  m_raw_size = volume->GetRawSize();
-  m_apploader_date = QString::fromStdString(volume->GetApploaderDate());
-
-  ReadBanner(*volume);
-
-  SaveCache();
-  return true;
-}
-
-bool GameFile::TryLoadElfDol()
-{
-  if (!IsElfOrDol())
-    return false;
-
   m_revision = 0;
   m_long_names[DiscIO::Language::LANGUAGE_ENGLISH] = m_file_name;
   m_platform = DiscIO::Platform::ELF_DOL;
@@ -181,13 +121,6 @@ bool GameFile::TryLoadElfDol()
   m_raw_size = m_size;
   m_banner = Resources::GetMisc(Resources::BANNER_MISSING);
   m_rating = 0;
-
-  return true;
-}
-
-void GameFile::SaveCache()
-{
-  // TODO
 }
 
 QString GameFile::GetBannerString(const QMap<DiscIO::Language, QString>& m) const
@@ -18,14 +18,18 @@ enum class Country;
 enum class Language;
 enum class Region;
 enum class Platform;
-class IVolume;
 }
 
-// TODO cache
+namespace UICommon
+{
+struct GameMetadata;
+}
+
+// A game list entry. Its metadata comes from UICommon::GameScanner, which caches it.
 class GameFile final
 {
 public:
-  explicit GameFile(const QString& path);
+  explicit GameFile(const UICommon::GameMetadata& metadata);
 
   bool IsValid() const { return m_valid; }
   // These will be properly initialized before we try to load the file.
@@ -68,15 +72,11 @@ public:
 private:
   QString GetBannerString(const QMap<DiscIO::Language, QString>& m) const;
 
-  QString GetCacheFileName() const;
-  void ReadBanner(const DiscIO::IVolume& volume);
+  void ReadBanner(const UICommon::GameMetadata& metadata);
   bool LoadFileInfo(const QString& path);
   void LoadState();
-  bool IsElfOrDol();
-  bool TryLoadElfDol();
-  bool TryLoadCache();
-  bool TryLoadVolume();
-  void SaveCache();
+  void LoadMetadata(const UICommon::GameMetadata& metadata);
+  void LoadElfDol();
 
   bool m_valid;
   QString m_path;
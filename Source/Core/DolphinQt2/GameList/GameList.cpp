@@ -15,6 +15,12 @@
 #include "DolphinQt2/GameList/ListProxyModel.h"
 #include "DolphinQt2/GameList/TableDelegate.h"
 #include "DolphinQt2/Settings.h"
+#include "UICommon/GameScanner.h"
+
+static GameFile LoadGameFile(const QString& path)
+{
+  return GameFile(UICommon::ProbeGame(path.toStdString()));
+}
 
 GameList::GameList(QWidget* parent) : QStackedWidget(parent)
 {
@@ -106,7 +112,7 @@ void GameList::MakeListView()
 void GameList::ShowContextMenu(const QPoint&)
 {
   QMenu* menu = new QMenu(this);
-  DiscIO::Platform platform = GameFile(GetSelectedGame()).GetPlatformID();
+  DiscIO::Platform platform = LoadGameFile(GetSelectedGame()).GetPlatformID();
   if (platform == DiscIO::Platform::GAMECUBE_DISC || platform == DiscIO::Platform::WII_DISC)
   {
     menu->addAction(tr("Properties"), this, SLOT(OpenProperties()));
@@ -122,13 +128,13 @@ void GameList::ShowContextMenu(const QPoint&)
 
 void GameList::OpenProperties()
 {
-  PropertiesDialog* properties = new PropertiesDialog(this, GameFile(GetSelectedGame()));
+  PropertiesDialog* properties = new PropertiesDialog(this, LoadGameFile(GetSelectedGame()));
   properties->show();
 }
 
 void GameList::OpenWiki()
 {
-  QString game_id = GameFile(GetSelectedGame()).GetGameID();
+  QString game_id = LoadGameFile(GetSelectedGame()).GetGameID();
   QString url = QStringLiteral("https://wiki.dolphin-emu.org/index.php?title=").append(game_id);
   QDesktopServices::openUrl(QUrl(url));
 }
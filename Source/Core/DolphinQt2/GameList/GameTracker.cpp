@@ -5,6 +5,8 @@
 #include <QDir>
 #include <QDirIterator>
 #include <QFile>
+#include <string>
+#include <vector>
 
 #include "DolphinQt2/GameList/GameTracker.h"
 #include "DolphinQt2/Settings.h"
@@ -12,7 +14,8 @@
 static const QStringList game_filters{
     QStringLiteral("*.gcm"),  QStringLiteral("*.iso"), QStringLiteral("*.tgc"),
     QStringLiteral("*.ciso"), QStringLiteral("*.gcz"), QStringLiteral("*.wbfs"),
-    QStringLiteral("*.wad"),  QStringLiteral("*.elf"), QStringLiteral("*.dol")};
+    QStringLiteral("*.wcz"),  QStringLiteral("*.wad"), QStringLiteral("*.elf"),
+    QStringLiteral("*.dol")};
 
 GameTracker::GameTracker(QObject* parent) : QFileSystemWatcher(parent)
 {
@@ -24,6 +27,8 @@ GameTracker::GameTracker(QObject* parent) : QFileSystemWatcher(parent)
   connect(this, &QFileSystemWatcher::directoryChanged, this, &GameTracker::UpdateDirectory);
   connect(this, &QFileSystemWatcher::fileChanged, this, &GameTracker::UpdateFile);
   connect(this, &GameTracker::PathChanged, m_loader, &GameLoader::LoadGame);
+  connect(this, &GameTracker::PathsChanged, m_loader, &GameLoader::LoadGames);
+  connect(this, &GameTracker::GameRemoved, m_loader, &GameLoader::RemoveGame);
   connect(m_loader, &GameLoader::GameLoaded, this, &GameTracker::GameLoaded);
 
   m_loader_thread.start();
@@ -68,6 +73,7 @@ void GameTracker::RemoveDirectory(const QString& dir)
 
 void GameTracker::UpdateDirectory(const QString& dir)
 {
+  QStringList new_paths;
   QDirIterator it(dir, game_filters, QDir::NoFilter, QDirIterator::Subdirectories);
   while (it.hasNext())
   {
@@ -80,9 +86,12 @@ void GameTracker::UpdateDirectory(const QString& dir)
     {
       addPath(path);
       m_tracked_files[path] = 1;
-      emit PathChanged(path);
+      new_paths.append(path);
     }
   }
+
+  if (!new_paths.isEmpty())
+    emit PathsChanged(new_paths);
 }
 
 void GameTracker::UpdateFile(const QString& file)
@@ -97,3 +106,18 @@ void GameTracker::UpdateFile(const QString& file)
     emit GameRemoved(file);
   }
 }
+
+void GameLoader::LoadGames(const QStringList& paths)
+{
+  std::vector<std::string> files;
+  for (const QString& path : paths)
+    files.push_back(path.toStdString());
+
+  for (const auto& metadata : m_scanner.Scan(files))
+  {
+    QSharedPointer<GameFile> game(new GameFile(*metadata));
+    if (game->IsValid())
+      emit GameLoaded(game);
+  }
+  m_scanner.SaveIndex();
+}
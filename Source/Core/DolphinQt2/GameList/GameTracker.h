@@ -13,14 +13,15 @@
 
 #include "DolphinQt2/GameList/GameFile.h"
 #include "DolphinQt2/GameList/GameTracker.h"
+#include "UICommon/GameScanner.h"
 
 class GameLoader;
 
 // Watches directories and loads GameFiles in a separate thread.
 // To use this, just add directories using AddDirectory, and listen for the
-// GameLoaded and GameRemoved signals. Ignore the PathChanged signal, it's
-// only there because the Qt people made fileChanged and directoryChanged
-// private.
+// GameLoaded and GameRemoved signals. Ignore the PathChanged and PathsChanged
+// signals, they're only there because the Qt people made fileChanged and
+// directoryChanged private.
 class GameTracker final : public QFileSystemWatcher
 {
   Q_OBJECT
@@ -38,6 +39,7 @@ signals:
   void GameRemoved(const QString& path);
 
   void PathChanged(const QString& path);
+  void PathsChanged(const QStringList& paths);
 
 private:
   void UpdateDirectory(const QString& dir);
@@ -54,15 +56,16 @@ class GameLoader final : public QObject
   Q_OBJECT
 
 public slots:
-  void LoadGame(const QString& path)
-  {
-    GameFile* game = new GameFile(path);
-    if (game->IsValid())
-      emit GameLoaded(QSharedPointer<GameFile>(game));
-  }
+  void LoadGame(const QString& path) { LoadGames(QStringList{path}); }
+  // Scans all of the files in one go, so that the ones that need probing are probed in parallel.
+  void LoadGames(const QStringList& paths);
+  void RemoveGame(const QString& path) { m_scanner.Remove(path.toStdString()); }
 
 signals:
   void GameLoaded(QSharedPointer<GameFile> game);
+
+private:
+  UICommon::GameScanner m_scanner;
 };
 
 Q_DECLARE_METATYPE(QSharedPointer<GameFile>)
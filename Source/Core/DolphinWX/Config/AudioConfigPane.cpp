@@ -35,6 +35,10 @@ void AudioConfigPane::InitializeGUI()
   m_dsp_engine_strings.Add(_("DSP LLE recompiler"));
   m_dsp_engine_strings.Add(_("DSP LLE interpreter (slow)"));
 
+  m_resampler_strings.Add(_("Linear (fastest)"));
+  m_resampler_strings.Add(_("Cubic"));
+  m_resampler_strings.Add(_("Windowed sinc (best quality)"));
+
   m_dsp_engine_radiobox =
       new wxRadioBox(this, wxID_ANY, _("DSP Emulator Engine"), wxDefaultPosition, wxDefaultSize,
                      m_dsp_engine_strings, 0, wxRA_SPECIFY_ROWS);
@@ -47,6 +51,8 @@ void AudioConfigPane::InitializeGUI()
   m_audio_latency_spinctrl =
       new wxSpinCtrl(this, wxID_ANY, "", wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 30);
   m_audio_latency_label = new wxStaticText(this, wxID_ANY, _("Latency:"));
+  m_resampler_choice =
+      new wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, m_resampler_strings);
 
   m_audio_backend_choice->SetToolTip(
       _("Changing this will have no effect while the emulator is running."));
@@ -54,6 +60,8 @@ void AudioConfigPane::InitializeGUI()
                                          "crackling. Certain backends only."));
   m_dpl2_decoder_checkbox->SetToolTip(
       _("Enables Dolby Pro Logic II emulation using 5.1 surround. Certain backends only."));
+  m_resampler_choice->SetToolTip(_("Selects the interpolation used to convert emulated audio to "
+                                   "the output sample rate. Higher quality costs more CPU time."));
 
   const int space5 = FromDIP(5);
 
@@ -79,6 +87,10 @@ void AudioConfigPane::InitializeGUI()
                           wxALIGN_CENTER_VERTICAL);
   backend_grid_sizer->Add(m_audio_latency_spinctrl, wxGBPosition(2, 1), wxDefaultSpan,
                           wxALIGN_CENTER_VERTICAL);
+  backend_grid_sizer->Add(new wxStaticText(this, wxID_ANY, _("Resampling:")), wxGBPosition(3, 0),
+                          wxDefaultSpan, wxALIGN_CENTER_VERTICAL);
+  backend_grid_sizer->Add(m_resampler_choice, wxGBPosition(3, 1), wxDefaultSpan,
+                          wxALIGN_CENTER_VERTICAL);
 
   wxStaticBoxSizer* const backend_static_box_sizer =
       new wxStaticBoxSizer(wxVERTICAL, this, _("Backend Settings"));
@@ -119,6 +131,7 @@ void AudioConfigPane::LoadGUIValues()
   m_volume_text->SetLabel(wxString::Format("%d %%", SConfig::GetInstance().m_Volume));
   m_dpl2_decoder_checkbox->SetValue(startup_params.bDPL2Decoder);
   m_audio_latency_spinctrl->SetValue(startup_params.iLatency);
+  m_resampler_choice->SetSelection(startup_params.m_AudioResampler);
 }
 
 void AudioConfigPane::ToggleBackendSpecificControls(const std::string& backend)
@@ -150,6 +163,8 @@ void AudioConfigPane::BindEvents()
 
   m_audio_latency_spinctrl->Bind(wxEVT_SPINCTRL, &AudioConfigPane::OnLatencySpinCtrlChanged, this);
   m_audio_latency_spinctrl->Bind(wxEVT_UPDATE_UI, &WxEventUtils::OnEnableIfCoreNotRunning);
+
+  m_resampler_choice->Bind(wxEVT_CHOICE, &AudioConfigPane::OnResamplerChoiceChanged, this);
 }
 
 void AudioConfigPane::OnDSPEngineRadioBoxChanged(wxCommandEvent& event)
@@ -186,6 +201,11 @@ void AudioConfigPane::OnLatencySpinCtrlChanged(wxCommandEvent& event)
   SConfig::GetInstance().iLatency = m_audio_latency_spinctrl->GetValue();
 }
 
+void AudioConfigPane::OnResamplerChoiceChanged(wxCommandEvent&)
+{
+  SConfig::GetInstance().m_AudioResampler = m_resampler_choice->GetSelection();
+}
+
 void AudioConfigPane::PopulateBackendChoiceBox()
 {
   for (const std::string& backend : AudioCommon::GetSoundBackends())
@@ -33,9 +33,11 @@ private:
   void OnVolumeSliderChanged(wxCommandEvent&);
   void OnAudioBackendChanged(wxCommandEvent&);
   void OnLatencySpinCtrlChanged(wxCommandEvent&);
+  void OnResamplerChoiceChanged(wxCommandEvent&);
 
   wxArrayString m_dsp_engine_strings;
   wxArrayString m_audio_backend_strings;
+  wxArrayString m_resampler_strings;
 
   wxRadioBox* m_dsp_engine_radiobox;
   wxCheckBox* m_dpl2_decoder_checkbox;
@@ -44,4 +46,5 @@ private:
   wxChoice* m_audio_backend_choice;
   wxSpinCtrl* m_audio_latency_spinctrl;
   wxStaticText* m_audio_latency_label;
+  wxChoice* m_resampler_choice;
 };
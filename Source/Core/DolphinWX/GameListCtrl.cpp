@@ -62,6 +62,7 @@
 #include "DolphinWX/Main.h"
 #include "DolphinWX/NetPlay/NetPlayLauncher.h"
 #include "DolphinWX/WxUtils.h"
+#include "UICommon/GameScanner.h"
 
 struct CompressionProgress final
 {
@@ -576,6 +577,7 @@ void CGameListCtrl::ScanForISOs()
     Extensions.push_back(".ciso");
     Extensions.push_back(".gcz");
     Extensions.push_back(".wbfs");
+    Extensions.push_back(".wcz");
   }
   if (SConfig::GetInstance().m_ListWad)
     Extensions.push_back(".wad");
@@ -591,22 +593,27 @@ void CGameListCtrl::ScanForISOs()
   if (rFilenames.size() > 0)
   {
     wxProgressDialog dialog(
-        _("Scanning for ISOs"), _("Scanning..."), (int)rFilenames.size() - 1, this,
+        _("Scanning for ISOs"), _("Scanning..."), (int)rFilenames.size(), this,
         wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME | wxPD_ESTIMATED_TIME |
             wxPD_REMAINING_TIME | wxPD_SMOOTH  // - makes updates as small as possible (down to 1px)
         );
 
-    for (u32 i = 0; i < rFilenames.size(); i++)
+    // Only files that aren't in the index yet, or have changed since, get opened.
+    UICommon::GameScanner scanner;
+    const auto games =
+        scanner.Scan(rFilenames, [&dialog](size_t done, size_t, const std::string& path) {
+          std::string file_name;
+          SplitPath(path, nullptr, &file_name, nullptr);
+          return dialog.Update(static_cast<int>(done),
+                               wxString::Format(_("Scanning %s"), StrToWxStr(file_name)));
+        });
+    // Forget files that have gone away, unless the scan was cancelled before getting to them all.
+    if (games.size() == rFilenames.size())
+      scanner.RetainOnly(rFilenames);
+
+    for (const auto& game : games)
     {
-      std::string FileName;
-      SplitPath(rFilenames[i], nullptr, &FileName, nullptr);
-
-      // Update with the progress (i) and the message
-      dialog.Update(i, wxString::Format(_("Scanning %s"), StrToWxStr(FileName)));
-      if (dialog.WasCancelled())
-        break;
-
-      auto iso_file = std::make_unique<GameListItem>(rFilenames[i], custom_title_map);
+      auto iso_file = std::make_unique<GameListItem>(*game, custom_title_map);
 
       if (iso_file->IsValid())
       {
@@ -705,7 +712,7 @@ void CGameListCtrl::ScanForISOs()
 
     for (const auto& drive : drives)
     {
-      auto gli = std::make_unique<GameListItem>(drive, custom_title_map);
+      auto gli = std::make_unique<GameListItem>(UICommon::ProbeGame(drive), custom_title_map);
 
       if (gli->IsValid())
         m_ISOFiles.push_back(std::move(gli));
@@ -1007,7 +1014,8 @@ void CGameListCtrl::OnRightClick(wxMouseEvent& event)
 
       if (platform == DiscIO::Platform::GAMECUBE_DISC || platform == DiscIO::Platform::WII_DISC)
       {
-        if (selected_iso->GetBlobType() == DiscIO::BlobType::GCZ)
+        if (selected_iso->GetBlobType() == DiscIO::BlobType::GCZ ||
+            selected_iso->GetBlobType() == DiscIO::BlobType::WCZ)
           popupMenu.Append(IDM_COMPRESS_ISO, _("Decompress ISO..."));
         else if (selected_iso->GetBlobType() == DiscIO::BlobType::PLAIN)
           popupMenu.Append(IDM_COMPRESS_ISO, _("Compress ISO..."));
@@ -1216,7 +1224,6 @@ void CGameListCtrl::OnMultiDecompressISO(wxCommandEvent& /*event*/)
 void CGameListCtrl::CompressSelection(bool _compress)
 {
   std::vector<const GameListItem*> items_to_compress;
-  bool wii_compression_warning_accepted = false;
   for (const GameListItem* iso : GetAllSelectedISOs())
   {
     // Don't include items that we can't do anything with
@@ -1224,20 +1231,10 @@ void CGameListCtrl::CompressSelection(bool _compress)
         iso->GetPlatform() != DiscIO::Platform::WII_DISC)
       continue;
     if (iso->GetBlobType() != DiscIO::BlobType::PLAIN &&
-        iso->GetBlobType() != DiscIO::BlobType::GCZ)
+        iso->GetBlobType() != DiscIO::BlobType::GCZ && iso->GetBlobType() != DiscIO::BlobType::WCZ)
       continue;
 
     items_to_compress.push_back(iso);
-
-    // Show the Wii compression warning if it's relevant and it hasn't been shown already
-    if (!wii_compression_warning_accepted && _compress && !iso->IsCompressed() &&
-        iso->GetPlatform() == DiscIO::Platform::WII_DISC)
-    {
-      if (WiiCompressWarning())
-        wii_compression_warning_accepted = true;
-      else
-        return;
-    }
   }
 
   wxString dirHome;
@@ -1263,10 +1260,12 @@ void CGameListCtrl::CompressSelection(bool _compress)
     {
       if (!iso->IsCompressed() && _compress)
       {
+        // Wii discs are stored as WCZ, which compresses them without changing anything
+        const bool wcz = iso->GetPlatform() == DiscIO::Platform::WII_DISC;
         std::string FileName;
         SplitPath(iso->GetFileName(), nullptr, &FileName, nullptr);
         progress.current_filename = FileName;
-        FileName.append(".gcz");
+        FileName.append(wcz ? ".wcz" : ".gcz");
 
         std::string OutputFileName;
         BuildCompleteFilename(OutputFileName, WxStrToStr(browseDialog.GetPath()), FileName);
@@ -1278,10 +1277,18 @@ void CGameListCtrl::CompressSelection(bool _compress)
                 _("Confirm File Overwrite"), wxYES_NO) == wxNO)
           continue;
 
-        all_good &=
-            DiscIO::CompressFileToBlob(iso->GetFileName(), OutputFileName,
-                                       (iso->GetPlatform() == DiscIO::Platform::WII_DISC) ? 1 : 0,
-                                       16384, &MultiCompressCB, &progress);
+        if (wcz)
+        {
+          all_good &=
+              DiscIO::ConvertToWCZ(iso->GetFileName(), OutputFileName, &MultiCompressCB, &progress);
+        }
+        else
+        {
+          // Scrubbing only replaces junk that can be regenerated on GameCube discs, and they get
+          // compressed without scrubbing if their filesystem can't be parsed
+          all_good &= DiscIO::CompressFileToBlob(iso->GetFileName(), OutputFileName, 1, 16384,
+                                                 &MultiCompressCB, &progress);
+        }
       }
       else if (iso->IsCompressed() && !_compress)
       {
@@ -1328,7 +1335,8 @@ void CGameListCtrl::OnCompressISO(wxCommandEvent& WXUNUSED(event))
   if (!iso)
     return;
 
-  bool is_compressed = iso->GetBlobType() == DiscIO::BlobType::GCZ;
+  bool is_compressed = iso->GetBlobType() == DiscIO::BlobType::GCZ ||
+                       iso->GetBlobType() == DiscIO::BlobType::WCZ;
   wxString path;
 
   std::string FileName, FilePath, FileExtension;
@@ -1348,11 +1356,20 @@ void CGameListCtrl::OnCompressISO(wxCommandEvent& WXUNUSED(event))
                             StrToWxStr(FileName) + FileType.After('*'), wxEmptyString,
                             FileType + "|" + wxGetTranslation(wxALL_FILES), wxFD_SAVE, this);
     }
-    else
+    else if (iso->GetPlatform() == DiscIO::Platform::WII_DISC)
     {
-      if (iso->GetPlatform() == DiscIO::Platform::WII_DISC && !WiiCompressWarning())
+      // WCZ keeps Wii discs as they are, GCZ scrubs them
+      path = wxFileSelector(_("Save compressed GCM/ISO"), StrToWxStr(FilePath),
+                            StrToWxStr(FileName) + ".wcz", wxEmptyString,
+                            _("All compressed Wii ISO files (wcz)") + "|*.wcz|" +
+                                _("All compressed GC/Wii ISO files (gcz)") +
+                                wxString::Format("|*.gcz|%s", wxGetTranslation(wxALL_FILES)),
+                            wxFD_SAVE, this);
+      if (!path.empty() && !path.Lower().EndsWith(".wcz") && !WiiCompressWarning())
         return;
-
+    }
+    else
+    {
       path = wxFileSelector(_("Save compressed GCM/ISO"), StrToWxStr(FilePath),
                             StrToWxStr(FileName) + ".gcz", wxEmptyString,
                             _("All compressed GC/Wii ISO files (gcz)") +
@@ -1378,10 +1395,11 @@ void CGameListCtrl::OnCompressISO(wxCommandEvent& WXUNUSED(event))
     if (is_compressed)
       all_good =
           DiscIO::DecompressBlobToFile(iso->GetFileName(), WxStrToStr(path), &CompressCB, &dialog);
+    else if (path.Lower().EndsWith(".wcz"))
+      all_good = DiscIO::ConvertToWCZ(iso->GetFileName(), WxStrToStr(path), &CompressCB, &dialog);
     else
-      all_good = DiscIO::CompressFileToBlob(
-          iso->GetFileName(), WxStrToStr(path),
-          (iso->GetPlatform() == DiscIO::Platform::WII_DISC) ? 1 : 0, 16384, &CompressCB, &dialog);
+      all_good = DiscIO::CompressFileToBlob(iso->GetFileName(), WxStrToStr(path), 1, 16384,
+                                            &CompressCB, &dialog);
   }
 
   if (!all_good)
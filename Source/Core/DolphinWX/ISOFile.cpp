@@ -3,7 +3,6 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
-#include <cinttypes>
 #include <cstdio>
 #include <cstring>
 #include <memory>
@@ -17,11 +16,9 @@
 #include <wx/image.h>
 #include <wx/toplevel.h>
 
-#include "Common/ChunkFile.h"
 #include "Common/CommonPaths.h"
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
-#include "Common/Hash.h"
 #include "Common/IniFile.h"
 #include "Common/StringUtil.h"
 
@@ -36,7 +33,7 @@
 #include "DolphinWX/ISOFile.h"
 #include "DolphinWX/WxUtils.h"
 
-static const u32 CACHE_REVISION = 0x128;  // Last changed in PR 4542
+#include "UICommon/GameScanner.h"
 
 static std::string GetLanguageString(DiscIO::Language language,
                                      std::map<DiscIO::Language, std::string> strings)
@@ -61,63 +58,22 @@ static std::string GetLanguageString(DiscIO::Language language,
   return "";
 }
 
-GameListItem::GameListItem(const std::string& _rFileName,
+GameListItem::GameListItem(const UICommon::GameMetadata& metadata,
                            const std::unordered_map<std::string, std::string>& custom_titles)
-    : m_FileName(_rFileName), m_title_id(0), m_emu_state(0), m_FileSize(0),
-      m_region(DiscIO::Region::UNKNOWN_REGION), m_Country(DiscIO::Country::COUNTRY_UNKNOWN),
-      m_Revision(0), m_Valid(false), m_ImageWidth(0), m_ImageHeight(0), m_disc_number(0),
+    : m_FileName(metadata.path), m_names(metadata.long_names),
+      m_descriptions(metadata.descriptions), m_game_id(metadata.game_id),
+      m_title_id(metadata.title_id), m_emu_state(0), m_FileSize(metadata.raw_size),
+      m_VolumeSize(metadata.volume_size), m_region(metadata.region), m_Country(metadata.country),
+      m_Platform(metadata.platform), m_blob_type(metadata.blob_type), m_Revision(metadata.revision),
+      m_Valid(metadata.valid), m_pImage(metadata.banner), m_ImageWidth(metadata.banner_width),
+      m_ImageHeight(metadata.banner_height), m_disc_number(metadata.disc_number),
       m_has_custom_name(false)
 {
-  if (LoadFromCache())
-  {
-    m_Valid = true;
-
-    // Wii banners can only be read if there is a savefile,
-    // so sometimes caches don't contain banners. Let's check
-    // if a banner has become available after the cache was made.
-    if (m_pImage.empty())
-    {
-      std::vector<u32> buffer =
-          DiscIO::IVolume::GetWiiBanner(&m_ImageWidth, &m_ImageHeight, m_title_id);
-      ReadVolumeBanner(buffer, m_ImageWidth, m_ImageHeight);
-      if (!m_pImage.empty())
-        SaveToCache();
-    }
-  }
-  else
-  {
-    std::unique_ptr<DiscIO::IVolume> volume(DiscIO::CreateVolumeFromFilename(_rFileName));
-
-    if (volume != nullptr)
-    {
-      m_Platform = volume->GetVolumeType();
-
-      m_descriptions = volume->GetDescriptions();
-      m_names = volume->GetLongNames();
-      if (m_names.empty())
-        m_names = volume->GetShortNames();
-      m_company = GetLanguageString(DiscIO::Language::LANGUAGE_ENGLISH, volume->GetLongMakers());
-      if (m_company.empty())
-        m_company = GetLanguageString(DiscIO::Language::LANGUAGE_ENGLISH, volume->GetShortMakers());
-
-      m_region = volume->GetRegion();
-      m_Country = volume->GetCountry();
-      m_blob_type = volume->GetBlobType();
-      m_FileSize = volume->GetRawSize();
-      m_VolumeSize = volume->GetSize();
-
-      m_game_id = volume->GetGameID();
-      volume->GetTitleID(&m_title_id);
-      m_disc_number = volume->GetDiscNumber();
-      m_Revision = volume->GetRevision();
-
-      std::vector<u32> buffer = volume->GetBanner(&m_ImageWidth, &m_ImageHeight);
-      ReadVolumeBanner(buffer, m_ImageWidth, m_ImageHeight);
-
-      m_Valid = true;
-      SaveToCache();
-    }
-  }
+  if (m_names.empty())
+    m_names = metadata.short_names;
+  m_company = GetLanguageString(DiscIO::Language::LANGUAGE_ENGLISH, metadata.long_makers);
+  if (m_company.empty())
+    m_company = GetLanguageString(DiscIO::Language::LANGUAGE_ENGLISH, metadata.short_makers);
 
   if (m_company.empty() && m_game_id.size() >= 6)
     m_company = DiscIO::GetCompanyFromID(m_game_id.substr(4, 2));
@@ -139,14 +95,6 @@ GameListItem::GameListItem(const std::string& _rFileName,
     ReloadINI();
   }
 
-  if (!IsValid() && IsElfOrDol())
-  {
-    m_Valid = true;
-    m_FileSize = File::GetSize(_rFileName);
-    m_Platform = DiscIO::Platform::ELF_DOL;
-    m_blob_type = DiscIO::BlobType::DIRECTORY;
-  }
-
   std::string path, name;
   SplitPath(m_FileName, &path, &name, nullptr);
 
@@ -194,81 +142,6 @@ void GameListItem::ReloadINI()
   }
 }
 
-bool GameListItem::LoadFromCache()
-{
-  return CChunkFileReader::Load<GameListItem>(CreateCacheFilename(), CACHE_REVISION, *this);
-}
-
-void GameListItem::SaveToCache()
-{
-  if (!File::IsDirectory(File::GetUserPath(D_CACHE_IDX)))
-    File::CreateDir(File::GetUserPath(D_CACHE_IDX));
-
-  CChunkFileReader::Save<GameListItem>(CreateCacheFilename(), CACHE_REVISION, *this);
-}
-
-void GameListItem::DoState(PointerWrap& p)
-{
-  p.Do(m_names);
-  p.Do(m_descriptions);
-  p.Do(m_company);
-  p.Do(m_game_id);
-  p.Do(m_title_id);
-  p.Do(m_FileSize);
-  p.Do(m_VolumeSize);
-  p.Do(m_region);
-  p.Do(m_Country);
-  p.Do(m_blob_type);
-  p.Do(m_pImage);
-  p.Do(m_ImageWidth);
-  p.Do(m_ImageHeight);
-  p.Do(m_Platform);
-  p.Do(m_disc_number);
-  p.Do(m_Revision);
-}
-
-bool GameListItem::IsElfOrDol() const
-{
-  if (m_FileName.size() < 4)
-    return false;
-
-  std::string name_end = m_FileName.substr(m_FileName.size() - 4);
-  std::transform(name_end.begin(), name_end.end(), name_end.begin(), ::tolower);
-  return name_end == ".elf" || name_end == ".dol";
-}
-
-std::string GameListItem::CreateCacheFilename() const
-{
-  std::string Filename, LegalPathname, extension;
-  SplitPath(m_FileName, &LegalPathname, &Filename, &extension);
-
-  if (Filename.empty())
-    return Filename;  // Disc Drive
-
-  // Filename.extension_HashOfFolderPath_Size.cache
-  // Append hash to prevent ISO name-clashing in different folders.
-  Filename.append(
-      StringFromFormat("%s_%x_%" PRIx64 ".cache", extension.c_str(),
-                       HashFletcher((const u8*)LegalPathname.c_str(), LegalPathname.size()),
-                       File::GetSize(m_FileName)));
-
-  std::string fullname(File::GetUserPath(D_CACHE_IDX));
-  fullname += Filename;
-  return fullname;
-}
-
-// Outputs to m_pImage
-void GameListItem::ReadVolumeBanner(const std::vector<u32>& buffer, int width, int height)
-{
-  m_pImage.resize(width * height * 3);
-  for (int i = 0; i < width * height; i++)
-  {
-    m_pImage[i * 3 + 0] = (buffer[i] & 0xFF0000) >> 16;
-    m_pImage[i * 3 + 1] = (buffer[i] & 0x00FF00) >> 8;
-    m_pImage[i * 3 + 2] = (buffer[i] & 0x0000FF) >> 0;
-  }
-}
-
 // Outputs to m_Bitmap
 bool GameListItem::ReadPNGBanner(const std::string& path)
 {
@@ -390,5 +263,5 @@ const std::string GameListItem::GetWiiFSPath() const
 bool GameListItem::IsCompressed() const
 {
   return m_blob_type == DiscIO::BlobType::GCZ || m_blob_type == DiscIO::BlobType::CISO ||
-         m_blob_type == DiscIO::BlobType::WBFS;
+         m_blob_type == DiscIO::BlobType::WBFS || m_blob_type == DiscIO::BlobType::WCZ;
 }
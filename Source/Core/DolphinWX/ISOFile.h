@@ -23,12 +23,15 @@ enum class Region;
 enum class Platform;
 }
 
-class PointerWrap;
+namespace UICommon
+{
+struct GameMetadata;
+}
 
 class GameListItem
 {
 public:
-  GameListItem(const std::string& _rFileName,
+  GameListItem(const UICommon::GameMetadata& metadata,
                const std::unordered_map<std::string, std::string>& custom_titles);
   ~GameListItem();
 
@@ -61,7 +64,6 @@ public:
   // NOTE: Banner image is at the original resolution, use WxUtils::ScaleImageToBitmap
   //   to display it
   const wxImage& GetBannerImage() const { return m_image; }
-  void DoState(PointerWrap& p);
 
 private:
   std::string m_FileName;
@@ -95,14 +97,6 @@ private:
   std::string m_custom_name;             // Custom title from INI or titles.txt
   bool m_has_custom_name;
 
-  bool LoadFromCache();
-  void SaveToCache();
-
-  bool IsElfOrDol() const;
-  std::string CreateCacheFilename() const;
-
-  // Outputs to m_pImage
-  void ReadVolumeBanner(const std::vector<u32>& buffer, int width, int height);
   // Outputs to m_Bitmap
   bool ReadPNGBanner(const std::string& path);
 };
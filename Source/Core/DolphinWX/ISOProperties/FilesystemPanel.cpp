@@ -43,24 +43,6 @@ public:
   std::unique_ptr<DiscIO::IFileSystem> filesystem;
 };
 
-class IntegrityCheckThread final : public wxThread
-{
-public:
-  explicit IntegrityCheckThread(const WiiPartition& partition)
-      : wxThread{wxTHREAD_JOINABLE}, m_partition{partition}
-  {
-    Create();
-  }
-
-  ExitCode Entry() override
-  {
-    return reinterpret_cast<ExitCode>(m_partition.volume->CheckIntegrity());
-  }
-
-private:
-  const WiiPartition& m_partition;
-};
-
 enum : int
 {
   ICON_DISC,
@@ -379,31 +361,40 @@ void FilesystemPanel::OnCheckPartitionIntegrity(wxCommandEvent& WXUNUSED(event))
     return;
 
   wxProgressDialog dialog(_("Checking integrity..."), _("Working..."), 1000, this,
-                          wxPD_APP_MODAL | wxPD_ELAPSED_TIME | wxPD_SMOOTH);
+                          wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME |
+                              wxPD_REMAINING_TIME | wxPD_SMOOTH);
 
   const auto selection = m_tree_ctrl->GetSelection();
+  const auto* const partition = static_cast<WiiPartition*>(m_tree_ctrl->GetItemData(selection));
 
-  IntegrityCheckThread thread(*static_cast<WiiPartition*>(m_tree_ctrl->GetItemData(selection)));
-  thread.Run();
-
-  while (thread.IsAlive())
-  {
-    dialog.Pulse();
-    wxThread::Sleep(50);
-  }
+  // The disc is read on this thread and verified on worker threads, so the dialog stays
+  // responsive through the progress callback.
+  const DiscIO::IntegrityCheckResult result =
+      partition->volume->CheckIntegrity([&dialog](u64 bytes_checked, u64 total_bytes) {
+        const int progress = total_bytes ? static_cast<int>(bytes_checked * 1000 / total_bytes) : 0;
+        return dialog.Update(progress);
+      });
 
   dialog.Destroy();
 
-  if (thread.Wait())
+  if (result.cancelled)
+    return;
+
+  if (result.success)
   {
-    wxMessageBox(_("Integrity check completed. No errors have been found."),
+    wxMessageBox(wxString::Format(_("Integrity check completed. No errors have been found.\n\n"
+                                    "Checked %.1f MiB at %.1f MiB/s."),
+                                  result.bytes_checked / (1024.0 * 1024.0),
+                                  result.GetMegabytesPerSecond()),
                  _("Integrity check completed"), wxOK | wxICON_INFORMATION, this);
   }
   else
   {
-    wxMessageBox(wxString::Format(_("Integrity check for %s failed. The disc image is most "
-                                    "likely corrupted or has been patched incorrectly."),
-                                  m_tree_ctrl->GetItemText(selection)),
+    wxMessageBox(wxString::Format(_("Integrity check for %s failed at cluster %llu. The disc "
+                                    "image is most likely corrupted or has been patched "
+                                    "incorrectly."),
+                                  m_tree_ctrl->GetItemText(selection),
+                                  static_cast<unsigned long long>(result.first_bad_cluster)),
                  _("Integrity Check Error"), wxOK | wxICON_ERROR, this);
   }
 }
@@ -6,13 +6,16 @@
 #include <cstdio>
 #include <cstring>
 #include <getopt.h>
+#include <memory>
 #include <signal.h>
 #include <string>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/Event.h"
+#include "Common/FileSearch.h"
 #include "Common/Flag.h"
 #include "Common/Logging/LogManager.h"
 #include "Common/MsgHandler.h"
@@ -29,6 +32,11 @@
 #include "Core/IOS/USB/Bluetooth/WiimoteDevice.h"
 #include "Core/State.h"
 
+#include "DiscIO/Filesystem.h"
+#include "DiscIO/Volume.h"
+#include "DiscIO/VolumeCreator.h"
+
+#include "UICommon/GameScanner.h"
 #include "UICommon/UICommon.h"
 
 #include "VideoCommon/RenderBase.h"
@@ -374,20 +382,101 @@ static Platform* GetPlatform()
   return nullptr;
 }
 
+static int CheckIntegrity(const char* filename)
+{
+  std::unique_ptr<DiscIO::IVolume> disc = DiscIO::CreateVolumeFromFilename(filename);
+  if (!disc || !disc->SupportsIntegrityCheck())
+  {
+    fprintf(stderr, "%s is not an encrypted Wii disc image\n", filename);
+    return 1;
+  }
+
+  bool all_passed = true;
+  for (u32 group = 0; group < 4; group++)
+  {
+    for (u32 i = 0; i < 0xFFFFFFFF; i++)
+    {
+      std::unique_ptr<DiscIO::IVolume> volume =
+          DiscIO::CreateVolumeFromFilename(filename, group, i);
+      if (!volume)
+        break;
+      if (!DiscIO::CreateFileSystem(volume.get()))
+        continue;
+
+      const DiscIO::IntegrityCheckResult result =
+          volume->CheckIntegrity([group, i](u64 bytes_checked, u64 total_bytes) {
+            fprintf(stderr, "\rPartition %u.%u: %3u%%", group, i,
+                    total_bytes ? static_cast<u32>(bytes_checked * 100 / total_bytes) : 0);
+            return true;
+          });
+
+      if (result.success)
+      {
+        printf("\rPartition %u.%u: OK, %.1f MiB at %.1f MiB/s\n", group, i,
+               result.bytes_checked / (1024.0 * 1024.0), result.GetMegabytesPerSecond());
+      }
+      else
+      {
+        printf("\rPartition %u.%u: FAILED at cluster %llu\n", group, i,
+               static_cast<unsigned long long>(result.first_bad_cluster));
+        all_passed = false;
+      }
+    }
+  }
+
+  return all_passed ? 0 : 1;
+}
+
+static int ListGames()
+{
+  UICommon::SetUserDirectory("");  // Auto-detect user folder
+  UICommon::Init();
+
+  const std::vector<std::string> files =
+      DoFileSearch({".gcm", ".tgc", ".iso", ".ciso", ".gcz", ".wbfs", ".wcz", ".wad", ".dol",
+                    ".elf"},
+                   SConfig::GetInstance().m_ISOFolder, SConfig::GetInstance().m_RecursiveISOFolder);
+
+  {
+    UICommon::GameScanner scanner;
+    for (const auto& game : scanner.Scan(files))
+    {
+      if (game->valid)
+        printf("%-6s  %s\n", game->game_id.c_str(), game->path.c_str());
+    }
+    scanner.RetainOnly(files);
+
+    const UICommon::GameScanner::Stats& stats = scanner.GetLastScanStats();
+    fprintf(stderr, "Scanned %zu files in %.3f s (%zu probed, %zu from the index)\n", files.size(),
+            stats.seconds, stats.probed, stats.reused);
+  }
+
+  UICommon::Shutdown();
+  return 0;
+}
+
 int main(int argc, char* argv[])
 {
-  int ch, help = 0;
+  int ch, help = 0, check_integrity = 0, list_games = 0;
   struct option longopts[] = {{"exec", no_argument, nullptr, 'e'},
+                              {"check-integrity", no_argument, nullptr, 'c'},
+                              {"list-games", no_argument, nullptr, 'l'},
                               {"help", no_argument, nullptr, 'h'},
                               {"version", no_argument, nullptr, 'v'},
                               {nullptr, 0, nullptr, 0}};
 
-  while ((ch = getopt_long(argc, argv, "eh?v", longopts, 0)) != -1)
+  while ((ch = getopt_long(argc, argv, "eclh?v", longopts, 0)) != -1)
   {
     switch (ch)
     {
     case 'e':
       break;
+    case 'c':
+      check_integrity = 1;
+      break;
+    case 'l':
+      list_games = 1;
+      break;
     case 'h':
     case '?':
       help = 1;
@@ -398,17 +487,25 @@ int main(int argc, char* argv[])
     }
   }
 
+  if (list_games)
+    return ListGames();
+
   if (help == 1 || argc == optind)
   {
     fprintf(stderr, "%s\n\n", scm_rev_str.c_str());
     fprintf(stderr, "A multi-platform GameCube/Wii emulator\n\n");
-    fprintf(stderr, "Usage: %s [-e <file>] [-h] [-v]\n", argv[0]);
-    fprintf(stderr, "  -e, --exec     Load the specified file\n");
-    fprintf(stderr, "  -h, --help     Show this help message\n");
-    fprintf(stderr, "  -v, --version  Print version and exit\n");
+    fprintf(stderr, "Usage: %s [-e <file>] [-c <file>] [-l] [-h] [-v]\n", argv[0]);
+    fprintf(stderr, "  -e, --exec             Load the specified file\n");
+    fprintf(stderr, "  -c, --check-integrity  Verify the hashes of a Wii disc image and exit\n");
+    fprintf(stderr, "  -l, --list-games       List the games in the configured folders and exit\n");
+    fprintf(stderr, "  -h, --help             Show this help message\n");
+    fprintf(stderr, "  -v, --version          Print version and exit\n");
     return 1;
   }
 
+  if (check_integrity)
+    return CheckIntegrity(argv[optind]);
+
   platform = GetPlatform();
   if (!platform)
   {
@@ -0,0 +1,350 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+
+#include "Common/ChunkFile.h"
+#include "Common/CommonPaths.h"
+#include "Common/FileUtil.h"
+#include "Common/StringUtil.h"
+
+#include "DiscIO/Blob.h"
+#include "DiscIO/Enums.h"
+#include "DiscIO/Volume.h"
+#include "DiscIO/VolumeCreator.h"
+
+#include "UICommon/GameScanner.h"
+
+namespace UICommon
+{
+static const u32 INDEX_REVISION = 1;
+
+// Probing is mostly waiting for the disk (or network share), so use a few threads even on
+// machines with fewer cores.
+static const unsigned int MIN_PROBE_THREADS = 4;
+
+static bool IsElfOrDol(const std::string& path)
+{
+  std::string extension;
+  SplitPath(path, nullptr, nullptr, &extension);
+  std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+  return extension == ".elf" || extension == ".dol";
+}
+
+static std::vector<u8> ConvertBanner(const std::vector<u32>& buffer, int width, int height)
+{
+  std::vector<u8> rgb(width * height * 3);
+  for (int i = 0; i < width * height; i++)
+  {
+    rgb[i * 3 + 0] = (buffer[i] & 0xFF0000) >> 16;
+    rgb[i * 3 + 1] = (buffer[i] & 0x00FF00) >> 8;
+    rgb[i * 3 + 2] = (buffer[i] & 0x0000FF) >> 0;
+  }
+  return rgb;
+}
+
+// Wii banners are read from the save file, so a game that hasn't been played yet has none.
+static bool MayGainWiiBanner(const GameMetadata& metadata)
+{
+  return metadata.valid && metadata.banner.empty() && metadata.title_id != 0 &&
+         metadata.platform != DiscIO::Platform::GAMECUBE_DISC;
+}
+
+GameMetadata::GameMetadata()
+    : platform(DiscIO::Platform::GAMECUBE_DISC), blob_type(DiscIO::BlobType::PLAIN),
+      region(DiscIO::Region::UNKNOWN_REGION), country(DiscIO::Country::COUNTRY_UNKNOWN)
+{
+}
+
+void GameMetadata::DoState(PointerWrap& p)
+{
+  p.Do(path);
+  p.Do(file_size);
+  p.Do(last_modified);
+  p.Do(valid);
+  p.Do(platform);
+  p.Do(blob_type);
+  p.Do(region);
+  p.Do(country);
+  p.Do(game_id);
+  p.Do(maker_id);
+  p.Do(title_id);
+  p.Do(revision);
+  p.Do(disc_number);
+  p.Do(raw_size);
+  p.Do(volume_size);
+  p.Do(internal_name);
+  p.Do(apploader_date);
+  p.Do(short_names);
+  p.Do(long_names);
+  p.Do(short_makers);
+  p.Do(long_makers);
+  p.Do(descriptions);
+  p.Do(banner);
+  p.Do(banner_width);
+  p.Do(banner_height);
+}
+
+GameMetadata ProbeGame(const std::string& path)
+{
+  GameMetadata metadata;
+  metadata.path = path;
+  File::FileInfo info;
+  if (File::GetFileInfo(path, &info))
+  {
+    metadata.last_modified = info.modified_time;
+    metadata.file_size = info.size;
+  }
+
+  std::unique_ptr<DiscIO::IVolume> volume = DiscIO::CreateVolumeFromFilename(path);
+  if (volume)
+  {
+    metadata.valid = true;
+    metadata.platform = volume->GetVolumeType();
+    metadata.blob_type = volume->GetBlobType();
+    metadata.region = volume->GetRegion();
+    metadata.country = volume->GetCountry();
+
+    metadata.game_id = volume->GetGameID();
+    metadata.maker_id = volume->GetMakerID();
+    volume->GetTitleID(&metadata.title_id);
+    metadata.revision = volume->GetRevision();
+    metadata.disc_number = volume->GetDiscNumber();
+    metadata.raw_size = volume->GetRawSize();
+    metadata.volume_size = volume->GetSize();
+    metadata.internal_name = volume->GetInternalName();
+    metadata.apploader_date = volume->GetApploaderDate();
+
+    metadata.short_names = volume->GetShortNames();
+    metadata.long_names = volume->GetLongNames();
+    metadata.short_makers = volume->GetShortMakers();
+    metadata.long_makers = volume->GetLongMakers();
+    metadata.descriptions = volume->GetDescriptions();
+
+    const std::vector<u32> buffer =
+        volume->GetBanner(&metadata.banner_width, &metadata.banner_height);
+    metadata.banner = ConvertBanner(buffer, metadata.banner_width, metadata.banner_height);
+  }
+  else if (IsElfOrDol(path))
+  {
+    metadata.valid = true;
+    metadata.platform = DiscIO::Platform::ELF_DOL;
+    metadata.blob_type = DiscIO::BlobType::DIRECTORY;
+    metadata.raw_size = metadata.file_size;
+  }
+
+  return metadata;
+}
+
+GameScanner::GameScanner(const std::string& index_path)
+    : m_index_path(index_path.empty() ? File::GetUserPath(D_CACHE_IDX) + "gamelist.cache" :
+                                        index_path)
+{
+  if (!CChunkFileReader::Load<GameScanner>(m_index_path, INDEX_REVISION, *this))
+    m_index.clear();
+}
+
+GameScanner::~GameScanner()
+{
+  SaveIndex();
+}
+
+std::vector<std::shared_ptr<const GameMetadata>>
+GameScanner::Scan(const std::vector<std::string>& paths, const ProgressCallback& progress)
+{
+  const auto start_time = std::chrono::steady_clock::now();
+  std::vector<std::shared_ptr<const GameMetadata>> results(paths.size());
+
+  // Reuse what the index has for files that look unchanged. Checking that only takes a stat,
+  // which is what makes rescanning a big collection fast. Files that need to be opened get
+  // queued, followed by Wii games whose banner might have shown up since they were indexed.
+  std::vector<size_t> jobs;
+  std::vector<size_t> banner_jobs;
+  for (size_t i = 0; i < paths.size(); ++i)
+  {
+    const auto it = m_index.find(paths[i]);
+    File::FileInfo info;
+    if (it != m_index.end() && File::GetFileInfo(paths[i], &info) &&
+        it->second->last_modified == info.modified_time && it->second->file_size == info.size)
+    {
+      results[i] = it->second;
+      if (MayGainWiiBanner(*it->second))
+        banner_jobs.push_back(i);
+    }
+    else
+    {
+      jobs.push_back(i);
+    }
+  }
+  const size_t probe_jobs = jobs.size();
+  jobs.insert(jobs.end(), banner_jobs.begin(), banner_jobs.end());
+  std::vector<std::shared_ptr<GameMetadata>> updated(paths.size());
+
+  std::mutex mutex;
+  std::condition_variable jobs_done_changed;
+  size_t next_job = 0;
+  size_t jobs_done = 0;
+  // The file that was most recently picked up, for the progress report.
+  const std::string* current_path = nullptr;
+  bool cancelled = false;
+
+  const auto run_jobs = [&] {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!cancelled && next_job < jobs.size())
+    {
+      const size_t job = next_job++;
+      const size_t index = jobs[job];
+      current_path = &paths[index];
+      lock.unlock();
+
+      if (job < probe_jobs)
+      {
+        updated[index] = std::make_shared<GameMetadata>(ProbeGame(paths[index]));
+      }
+      else
+      {
+        GameMetadata metadata = *results[index];
+        const std::vector<u32> buffer = DiscIO::IVolume::GetWiiBanner(
+            &metadata.banner_width, &metadata.banner_height, metadata.title_id);
+        metadata.banner = ConvertBanner(buffer, metadata.banner_width, metadata.banner_height);
+        if (!metadata.banner.empty())
+          updated[index] = std::make_shared<GameMetadata>(std::move(metadata));
+      }
+
+      lock.lock();
+      ++jobs_done;
+      jobs_done_changed.notify_one();
+    }
+  };
+
+  // Report progress from this thread, so that callers can drive their UI from the callback.
+  // The first report comes before any file is opened, so that a dialog shows up immediately.
+  const size_t skipped = paths.size() - jobs.size();
+  const std::string no_path;
+  if (progress && !progress(skipped, paths.size(), jobs.empty() ? no_path : paths[jobs[0]]))
+    cancelled = true;
+
+  const size_t num_threads = std::min<size_t>(
+      jobs.size(), std::max(MIN_PROBE_THREADS, std::thread::hardware_concurrency()));
+  std::vector<std::thread> threads;
+  for (size_t i = progress ? 0 : 1; i < num_threads; ++i)
+    threads.emplace_back(run_jobs);
+
+  if (progress)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    size_t reported = 0;
+    while (!cancelled && reported != jobs.size())
+    {
+      jobs_done_changed.wait_for(lock, std::chrono::milliseconds(100),
+                                 [&] { return jobs_done != reported; });
+      reported = jobs_done;
+      const std::string path = current_path ? *current_path : no_path;
+      lock.unlock();
+      const bool keep_going = progress(skipped + reported, paths.size(), path);
+      lock.lock();
+      if (!keep_going)
+        cancelled = true;
+    }
+  }
+  else if (num_threads != 0)
+  {
+    run_jobs();
+  }
+
+  for (std::thread& thread : threads)
+    thread.join();
+
+  m_last_scan_stats = {};
+  m_last_scan_stats.reused = paths.size() - probe_jobs;
+  for (size_t job = 0; job < jobs.size(); ++job)
+  {
+    const size_t index = jobs[job];
+    if (!updated[index])
+      continue;
+    if (job < probe_jobs)
+      ++m_last_scan_stats.probed;
+
+    results[index] = updated[index];
+    m_index[paths[index]] = std::move(updated[index]);
+    m_index_changed = true;
+  }
+
+  // Drop files that a cancelled scan didn't get to
+  results.erase(std::remove(results.begin(), results.end(), nullptr), results.end());
+
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+  m_last_scan_stats.seconds = elapsed.count();
+  return results;
+}
+
+void GameScanner::Remove(const std::string& path)
+{
+  if (m_index.erase(path) != 0)
+    m_index_changed = true;
+}
+
+void GameScanner::RetainOnly(const std::vector<std::string>& paths)
+{
+  const std::unordered_set<std::string> retained(paths.begin(), paths.end());
+  for (auto it = m_index.begin(); it != m_index.end();)
+  {
+    if (retained.count(it->first) == 0)
+    {
+      it = m_index.erase(it);
+      m_index_changed = true;
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+bool GameScanner::SaveIndex()
+{
+  if (!m_index_changed)
+    return true;
+
+  // Write to a temporary file first, so that a crash can't leave a truncated index behind.
+  const std::string temp_path = m_index_path + ".tmp";
+  File::CreateFullPath(m_index_path);
+  if (!CChunkFileReader::Save<GameScanner>(temp_path, INDEX_REVISION, *this) ||
+      !File::Rename(temp_path, m_index_path))
+  {
+    return false;
+  }
+
+  m_index_changed = false;
+  return true;
+}
+
+void GameScanner::DoState(PointerWrap& p)
+{
+  u32 count = static_cast<u32>(m_index.size());
+  p.Do(count);
+
+  if (p.GetMode() == PointerWrap::MODE_READ)
+  {
+    m_index.clear();
+    for (u32 i = 0; i < count; ++i)
+    {
+      auto metadata = std::make_shared<GameMetadata>();
+      metadata->DoState(p);
+      m_index.emplace(metadata->path, std::move(metadata));
+    }
+  }
+  else
+  {
+    for (auto& entry : m_index)
+      entry.second->DoState(p);
+  }
+}
+}  // namespace UICommon
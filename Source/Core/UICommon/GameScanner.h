@@ -0,0 +1,120 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace DiscIO
+{
+enum class BlobType;
+enum class Country;
+enum class Language;
+enum class Region;
+enum class Platform;
+}
+
+class PointerWrap;
+
+namespace UICommon
+{
+// Everything the game lists show about a file, so that they don't need to open it.
+struct GameMetadata
+{
+  std::string path;
+  u64 file_size = 0;
+  u64 last_modified = 0;
+  // False for files that aren't games. Those are indexed too so that they aren't probed again.
+  bool valid = false;
+
+  DiscIO::Platform platform;
+  DiscIO::BlobType blob_type;
+  DiscIO::Region region;
+  DiscIO::Country country;
+
+  std::string game_id;
+  std::string maker_id;
+  u64 title_id = 0;
+  u16 revision = 0;
+  u8 disc_number = 0;
+  u64 raw_size = 0;
+  u64 volume_size = 0;
+  std::string internal_name;
+  std::string apploader_date;
+
+  std::map<DiscIO::Language, std::string> short_names;
+  std::map<DiscIO::Language, std::string> long_names;
+  std::map<DiscIO::Language, std::string> short_makers;
+  std::map<DiscIO::Language, std::string> long_makers;
+  std::map<DiscIO::Language, std::string> descriptions;
+
+  // 24-bit RGB
+  std::vector<u8> banner;
+  int banner_width = 0;
+  int banner_height = 0;
+
+  GameMetadata();
+  void DoState(PointerWrap& p);
+};
+
+// Opens a file and reads its metadata. ELFs and DOLs are valid, but only have their size and
+// platform filled in.
+GameMetadata ProbeGame(const std::string& path);
+
+// Keeps the metadata of every game that has been scanned in a single index file, and only opens
+// files that are new or have changed since they were indexed. Files that do need to be opened
+// are probed on several threads, which is what makes the first scan of a big collection on a
+// slow drive bearable.
+//
+// A scanner is not thread-safe; use it from one thread at a time.
+class GameScanner final
+{
+public:
+  // Called on the thread that called Scan with the number of files handled so far and the file
+  // that is being opened, so that it can update a progress dialog. Return false to cancel the
+  // scan.
+  using ProgressCallback =
+      std::function<bool(size_t done, size_t total, const std::string& current_path)>;
+
+  struct Stats
+  {
+    size_t probed = 0;
+    size_t reused = 0;
+    double seconds = 0;
+  };
+
+  // Loads the index, from the cache folder if index_path is empty.
+  explicit GameScanner(const std::string& index_path = "");
+  ~GameScanner();
+
+  // Returns the metadata of each of the given files, including invalid ones. A cancelled scan
+  // only returns the files that had been handled by then.
+  std::vector<std::shared_ptr<const GameMetadata>>
+  Scan(const std::vector<std::string>& paths, const ProgressCallback& progress = nullptr);
+
+  // Forgets files, so that the index doesn't keep growing as games are moved or deleted.
+  void Remove(const std::string& path);
+  void RetainOnly(const std::vector<std::string>& paths);
+
+  // Writes the index back if anything has changed. Done automatically on destruction.
+  bool SaveIndex();
+
+  const Stats& GetLastScanStats() const { return m_last_scan_stats; }
+  void DoState(PointerWrap& p);
+
+private:
+  std::string m_index_path;
+  std::unordered_map<std::string, std::shared_ptr<GameMetadata>> m_index;
+  bool m_index_changed = false;
+  Stats m_last_scan_stats;
+};
+}  // namespace UICommon
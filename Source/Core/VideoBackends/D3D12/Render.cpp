@@ -792,7 +792,6 @@ void Renderer::SwapImpl(u32 xfb_addr, u32 fb_width, u32 fb_stride, u32 fb_height
     AVIDump::Frame state = AVIDump::FetchState(ticks);
     DumpFrameData(reinterpret_cast<const u8*>(screenshot_texture_map), source_width, source_height,
                   dst_location.PlacedFootprint.Footprint.RowPitch, state);
-    FinishFrameData();
 
     D3D12_RANGE write_range = {};
     s_screenshot_texture->Unmap(0, &write_range);
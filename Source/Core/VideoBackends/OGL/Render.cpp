@@ -1573,7 +1573,6 @@ void Renderer::FlushFrameDump()
   if (!m_last_frame_exported)
     return;
 
-  FinishFrameData();
   glBindBuffer(GL_PIXEL_PACK_BUFFER, m_frame_dumping_pbo[0]);
   m_frame_pbo_is_mapped[0] = true;
   void* data = glMapBufferRange(
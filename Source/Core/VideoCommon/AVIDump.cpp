@@ -6,7 +6,16 @@
 #define __STDC_CONSTANT_MACROS 1
 #endif
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -15,11 +24,17 @@ extern "C" {
 #include <libswscale/swscale.h>
 }
 
+#include "AudioCommon/Mixer.h"
+
+#include "Common/CommonFuncs.h"
 #include "Common/FileUtil.h"
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
+#include "Common/Thread.h"
 
 #include "Core/ConfigManager.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/AudioInterface.h"
 #include "Core/HW/SystemTimers.h"
 #include "Core/HW/VideoInterface.h"  //for TargetRefreshRate
 #include "Core/Movie.h"
@@ -49,6 +64,42 @@ static int s_file_index = 0;
 static int s_savestate_index = 0;
 static int s_last_savestate_index = 0;
 
+// Encoded packets are handed to a separate thread for muxing, so file I/O never holds up the
+// encoder or the CPU thread pushing audio.
+static std::thread s_mux_thread;
+static std::mutex s_mux_lock;
+static std::condition_variable s_mux_cv;
+static std::deque<AVPacket> s_mux_queue;
+static bool s_mux_stop = false;
+static size_t s_mux_max_queue_depth = 0;
+
+// Audio is written as uncompressed PCM alongside the video. AVI has no per-packet timestamps for
+// audio, so each track is kept contiguous: gaps are filled with silence and samples that would
+// overlap already written audio are dropped.
+constexpr unsigned int AUDIO_PACKET_FRAMES = 1024;
+
+struct AudioTrackState
+{
+  AVStream* stream = nullptr;
+  unsigned int sample_rate = 0;
+  // Little-endian, interleaved L/R samples waiting to be packetized.
+  std::vector<s16> pending;
+  u64 pending_ticks = 0;
+  s64 next_pts = 0;
+};
+
+static std::mutex s_audio_lock;
+static std::array<AudioTrackState, 2> s_audio_tracks;
+// Only changed with s_audio_lock held; the atomic lets the CPU thread skip the lock when idle.
+static std::atomic<bool> s_audio_enabled{false};
+// A stream's sample rate can't change within an AVI, so a change starts a new file from the dump
+// thread, using the rate the mixer reported instead of the one from the audio interface.
+static std::array<unsigned int, 2> s_next_sample_rates{};
+static std::atomic<bool> s_audio_rate_changed{false};
+// Emulated ticks minus this offset give the position on the video timeline, in ticks.
+static std::atomic<s64> s_ticks_offset{0};
+static std::atomic<u32> s_ticks_per_second{0};
+
 static void InitAVCodec()
 {
   static bool first_run = true;
@@ -59,6 +110,230 @@ static void InitAVCodec()
   }
 }
 
+static void QueuePacket(AVPacket* pkt)
+{
+  // Encoders may return packets pointing into their own buffers, which get reused by the next
+  // call; the muxer thread needs a reference it owns.
+  AVPacket owned;
+  const int error = av_packet_ref(&owned, pkt);
+  av_packet_unref(pkt);
+  if (error < 0)
+  {
+    ERROR_LOG(VIDEO, "Could not copy packet for muxing");
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(s_mux_lock);
+    s_mux_queue.push_back(owned);
+    s_mux_max_queue_depth = std::max(s_mux_max_queue_depth, s_mux_queue.size());
+  }
+  s_mux_cv.notify_one();
+}
+
+void AVIDump::MuxThread()
+{
+  Common::SetCurrentThreadName("AVIDump muxer");
+
+  while (true)
+  {
+    AVPacket pkt;
+    {
+      std::unique_lock<std::mutex> lk(s_mux_lock);
+      s_mux_cv.wait(lk, [] { return !s_mux_queue.empty() || s_mux_stop; });
+      if (s_mux_queue.empty())
+        break;
+
+      pkt = s_mux_queue.front();
+      s_mux_queue.pop_front();
+    }
+
+    // Takes ownership of the packet's data.
+    const int error = av_interleaved_write_frame(s_format_context, &pkt);
+    if (error < 0)
+      ERROR_LOG(VIDEO, "Error while writing packet: %d", error);
+  }
+}
+
+void AVIDump::StartMuxThread()
+{
+  {
+    // Packets that arrived while no file was open belong to neither file.
+    std::lock_guard<std::mutex> lk(s_mux_lock);
+    for (AVPacket& pkt : s_mux_queue)
+      av_packet_unref(&pkt);
+    s_mux_queue.clear();
+  }
+  s_mux_stop = false;
+  s_mux_max_queue_depth = 0;
+  s_mux_thread = std::thread(MuxThread);
+}
+
+void AVIDump::StopMuxThread()
+{
+  if (!s_mux_thread.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lk(s_mux_lock);
+    s_mux_stop = true;
+  }
+  s_mux_cv.notify_one();
+  s_mux_thread.join();
+  NOTICE_LOG(VIDEO, "Muxer stopped, max queue depth %zu packets", s_mux_max_queue_depth);
+}
+
+static AVStream* AddAudioStream(unsigned int sample_rate)
+{
+  AVStream* stream = avformat_new_stream(s_format_context, nullptr);
+  if (!stream)
+    return nullptr;
+
+  stream->codec->codec_id = AV_CODEC_ID_PCM_S16LE;
+  stream->codec->codec_type = AVMEDIA_TYPE_AUDIO;
+  stream->codec->sample_fmt = AV_SAMPLE_FMT_S16;
+  stream->codec->sample_rate = sample_rate;
+  stream->codec->channels = 2;
+  stream->codec->channel_layout = AV_CH_LAYOUT_STEREO;
+  stream->codec->block_align = 2 * sizeof(s16);
+  stream->codec->bit_rate = sample_rate * 2 * 16;
+  stream->codec->time_base.num = 1;
+  stream->codec->time_base.den = sample_rate;
+  return stream;
+}
+
+static void WriteAudioPacket(AudioTrackState* track, const s16* samples, unsigned int num_frames)
+{
+  AVPacket pkt;
+  if (av_new_packet(&pkt, num_frames * 2 * sizeof(s16)) < 0)
+    return;
+
+  if (samples)
+    memcpy(pkt.data, samples, num_frames * 2 * sizeof(s16));
+  else
+    memset(pkt.data, 0, num_frames * 2 * sizeof(s16));
+
+  const AVRational sample_time_base = {1, static_cast<int>(track->sample_rate)};
+  pkt.pts = av_rescale_q(track->next_pts, sample_time_base, track->stream->time_base);
+  pkt.dts = pkt.pts;
+  pkt.duration =
+      static_cast<int>(av_rescale_q(num_frames, sample_time_base, track->stream->time_base));
+  pkt.flags |= AV_PKT_FLAG_KEY;
+  pkt.stream_index = track->stream->index;
+  QueuePacket(&pkt);
+
+  track->next_pts += num_frames;
+}
+
+// Pads the track with silence up to pts. Returns false if the track is already past pts.
+static bool PadAudioTrack(AudioTrackState* track, s64 pts)
+{
+  // Timing jitter between the DSP and the video timeline is absorbed instead of being padded.
+  const s64 tolerance = track->sample_rate / 20;
+  if (pts < track->next_pts - tolerance)
+    return false;
+  if (pts <= track->next_pts + tolerance)
+    return true;
+
+  // Such a gap means the timeline jumped (e.g. a savestate was loaded); don't write minutes of
+  // silence to the file.
+  if (pts - track->next_pts > static_cast<s64>(track->sample_rate) * 60)
+  {
+    WARN_LOG(VIDEO, "Audio timeline jumped by %lld samples, resynchronizing",
+             static_cast<long long>(pts - track->next_pts));
+    track->next_pts = pts;
+    return true;
+  }
+
+  while (track->next_pts < pts)
+  {
+    const s64 frames = std::min<s64>(pts - track->next_pts, AUDIO_PACKET_FRAMES);
+    WriteAudioPacket(track, nullptr, static_cast<unsigned int>(frames));
+  }
+  return true;
+}
+
+static s64 TicksToAudioPts(u64 ticks, unsigned int sample_rate)
+{
+  const s64 timeline_ticks = static_cast<s64>(ticks) - s_ticks_offset.load();
+  return av_rescale(std::max<s64>(timeline_ticks, 0), sample_rate, s_ticks_per_second.load());
+}
+
+static void FlushAudioTrack(AudioTrackState* track)
+{
+  if (track->pending.empty())
+    return;
+
+  if (PadAudioTrack(track, TicksToAudioPts(track->pending_ticks, track->sample_rate)))
+  {
+    WriteAudioPacket(track, track->pending.data(),
+                     static_cast<unsigned int>(track->pending.size() / 2));
+  }
+  track->pending.clear();
+}
+
+// Keeps tracks that receive no samples (e.g. DTK when no disc stream is playing) filled with
+// silence, so the muxer can keep interleaving instead of buffering the other streams.
+static void PadIdleAudioTracks(u64 timeline_ticks)
+{
+  std::lock_guard<std::mutex> lk(s_audio_lock);
+  for (AudioTrackState& track : s_audio_tracks)
+  {
+    if (!track.stream || !track.pending.empty())
+      continue;
+
+    // Stay a second behind the video, well clear of any samples still on their way.
+    const s64 pts = av_rescale(timeline_ticks, track.sample_rate, s_ticks_per_second.load()) -
+                    track.sample_rate;
+    if (pts > track.next_pts)
+      PadAudioTrack(&track, pts);
+  }
+}
+
+static void AddAudio(CMixer::SampleSource source, const short* samples, unsigned int num_samples,
+                     unsigned int sample_rate)
+{
+  const size_t track_index = source == CMixer::SampleSource::DSP ? 0 : 1;
+
+  // Nothing to synchronize against until the first video frame has been written.
+  if (!s_audio_enabled.load() || !s_ticks_per_second.load())
+    return;
+
+  const u64 ticks = CoreTiming::GetTicks();
+  std::lock_guard<std::mutex> lk(s_audio_lock);
+  // Stop may have flushed the tracks since the check above.
+  if (!s_audio_enabled.load())
+    return;
+
+  AudioTrackState& track = s_audio_tracks[track_index];
+  if (!track.stream)
+    return;
+
+  if (sample_rate != track.sample_rate)
+  {
+    s_next_sample_rates[track_index] = sample_rate;
+    if (!s_audio_rate_changed.exchange(true))
+    {
+      NOTICE_LOG(VIDEO, "Audio sample rate changed from %u to %u Hz, starting a new file",
+                 track.sample_rate, sample_rate);
+    }
+    return;
+  }
+
+  if (track.pending.empty())
+    track.pending_ticks = ticks;
+
+  // Mixer input is big-endian R/L; the PCM track wants little-endian L/R.
+  for (unsigned int i = 0; i < num_samples; ++i)
+  {
+    track.pending.push_back(Common::swap16(samples[i * 2 + 1]));
+    track.pending.push_back(Common::swap16(samples[i * 2]));
+  }
+
+  if (track.pending.size() >= AUDIO_PACKET_FRAMES * 2)
+    FlushAudioTrack(&track);
+}
+
 bool AVIDump::Start(int w, int h)
 {
   s_pix_fmt = AV_PIX_FMT_RGBA;
@@ -68,6 +343,8 @@ bool AVIDump::Start(int w, int h)
 
   s_last_frame_is_valid = false;
   s_last_pts = 0;
+  s_ticks_offset.store(0);
+  s_ticks_per_second.store(0);
 
   InitAVCodec();
   bool success = CreateVideoFile();
@@ -75,8 +352,16 @@ bool AVIDump::Start(int w, int h)
   {
     CloseVideoFile();
     OSD::AddMessage("AVIDump Start failed");
+    return false;
   }
-  return success;
+
+  StartMuxThread();
+  {
+    std::lock_guard<std::mutex> lk(s_audio_lock);
+    s_audio_enabled.store(true);
+  }
+  CMixer::SetSampleHook(AddAudio);
+  return true;
 }
 
 bool AVIDump::CreateVideoFile()
@@ -132,6 +417,22 @@ bool AVIDump::CreateVideoFile()
     return false;
   }
 
+  {
+    std::lock_guard<std::mutex> lk(s_audio_lock);
+    const unsigned int rates[] = {AudioInterface::GetAIDSampleRate(),
+                                  AudioInterface::GetAISSampleRate()};
+    for (size_t i = 0; i < s_audio_tracks.size(); ++i)
+    {
+      const unsigned int rate = s_next_sample_rates[i] ? s_next_sample_rates[i] : rates[i];
+      s_next_sample_rates[i] = 0;
+      s_audio_tracks[i] = AudioTrackState();
+      s_audio_tracks[i].sample_rate = rate;
+      if (!(s_audio_tracks[i].stream = AddAudioStream(rate)))
+        return false;
+    }
+    s_audio_rate_changed.store(false);
+  }
+
   s_src_frame = av_frame_alloc();
   s_scaled_frame = av_frame_alloc();
 
@@ -179,6 +480,8 @@ void AVIDump::AddFrame(const u8* data, int width, int height, int stride, const
   }
 
   CheckResolution(width, height);
+  if (s_audio_rate_changed.exchange(false))
+    StartNewFile(s_width, s_height);
   s_src_frame->data[0] = const_cast<u8*>(data);
   s_src_frame->linesize[0] = stride;
   s_src_frame->format = s_pix_fmt;
@@ -226,6 +529,9 @@ void AVIDump::AddFrame(const u8* data, int width, int height, int stride, const
   {
     s_last_frame = state.ticks;
     s_last_pts = pts_in_ticks;
+    s_ticks_offset.store(static_cast<s64>(state.ticks - pts_in_ticks));
+    s_ticks_per_second.store(state.ticks_per_second);
+    PadIdleAudioTracks(pts_in_ticks);
     error = avcodec_encode_video2(s_stream->codec, &pkt, s_scaled_frame, &got_packet);
   }
   while (!error && got_packet)
@@ -244,7 +550,7 @@ void AVIDump::AddFrame(const u8* data, int width, int height, int stride, const
       pkt.flags |= AV_PKT_FLAG_KEY;
 #endif
     pkt.stream_index = s_stream->index;
-    av_interleaved_write_frame(s_format_context, &pkt);
+    QueuePacket(&pkt);
 
     // Handle delayed frames.
     PreparePacket(&pkt);
@@ -256,6 +562,19 @@ void AVIDump::AddFrame(const u8* data, int width, int height, int stride, const
 
 void AVIDump::Stop()
 {
+  CMixer::SetSampleHook(nullptr);
+  {
+    // Clearing the flag under the lock keeps AddAudio from queueing packets after the flush.
+    std::lock_guard<std::mutex> lk(s_audio_lock);
+    s_audio_enabled.store(false);
+    for (AudioTrackState& track : s_audio_tracks)
+    {
+      if (track.stream)
+        FlushAudioTrack(&track);
+    }
+  }
+
+  StopMuxThread();
   av_write_trailer(s_format_context);
   CloseVideoFile();
   s_file_index = 0;
@@ -277,6 +596,16 @@ void AVIDump::CloseVideoFile()
     av_freep(&s_stream);
   }
 
+  {
+    std::lock_guard<std::mutex> lk(s_audio_lock);
+    for (AudioTrackState& track : s_audio_tracks)
+    {
+      if (track.stream)
+        avcodec_close(track.stream->codec);
+      track = AudioTrackState();
+    }
+  }
+
   av_frame_free(&s_src_frame);
   av_frame_free(&s_scaled_frame);
 
@@ -307,12 +636,15 @@ void AVIDump::CheckResolution(int width, int height)
   // VI is able to be set to a zero value for height/width to disable output. If this is the case,
   // simply keep the last known resolution of the video for the added frame.
   if ((width != s_width || height != s_height) && (width > 0 && height > 0))
-  {
-    int temp_file_index = s_file_index;
-    Stop();
-    s_file_index = temp_file_index + 1;
-    Start(width, height);
-  }
+    StartNewFile(width, height);
+}
+
+void AVIDump::StartNewFile(int width, int height)
+{
+  int temp_file_index = s_file_index;
+  Stop();
+  s_file_index = temp_file_index + 1;
+  Start(width, height);
 }
 
 AVIDump::Frame AVIDump::FetchState(u64 ticks)
@@ -12,6 +12,10 @@ private:
   static bool CreateVideoFile();
   static void CloseVideoFile();
   static void CheckResolution(int width, int height);
+  static void StartNewFile(int width, int height);
+  static void StartMuxThread();
+  static void StopMuxThread();
+  static void MuxThread();
 
 public:
   struct Frame
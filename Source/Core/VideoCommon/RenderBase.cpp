@@ -12,8 +12,10 @@
 // Next frame, that one is scanned out and the other one gets the copy. = double buffering.
 // ---------------------------------------------------------------------------------------------
 
+#include <algorithm>
 #include <cinttypes>
 #include <cmath>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -762,17 +764,16 @@ void Renderer::ShutdownFrameDumping()
     return;
 
   FinishFrameData();
-  m_frame_dump_thread_running.Clear();
-  m_frame_dump_start.Set();
+  {
+    std::lock_guard<std::mutex> lk(m_frame_dump_lock);
+    m_frame_dump_thread_running.Clear();
+  }
+  m_frame_dump_cv.notify_all();
 }
 
 void Renderer::DumpFrameData(const u8* data, int w, int h, int stride, const AVIDump::Frame& state,
                              bool swap_upside_down)
 {
-  FinishFrameData();
-
-  m_frame_dump_config = FrameDumpConfig{data, w, h, stride, swap_upside_down, state};
-
   if (!m_frame_dump_thread_running.IsSet())
   {
     if (m_frame_dump_thread.joinable())
@@ -781,17 +782,50 @@ void Renderer::DumpFrameData(const u8* data, int w, int h, int stride, const AVI
     m_frame_dump_thread = std::thread(&Renderer::RunFrameDumps, this);
   }
 
-  m_frame_dump_start.Set();
-  m_frame_dump_frame_running = true;
+  std::unique_ptr<QueuedFrameDump> frame;
+  {
+    std::lock_guard<std::mutex> lk(m_frame_dump_lock);
+    if (m_frame_dump_queue.size() >= MAX_QUEUED_FRAME_DUMPS)
+    {
+      if (m_frame_dump_frames_dropped++ == 0)
+        WARN_LOG(VIDEO, "Frame dump queue is full, dropping frames");
+      return;
+    }
+    if (!m_frame_dump_free_list.empty())
+    {
+      frame = std::move(m_frame_dump_free_list.back());
+      m_frame_dump_free_list.pop_back();
+    }
+  }
+  if (!frame)
+    frame = std::make_unique<QueuedFrameDump>();
+
+  // Take a tightly packed, top-down copy so the backend can reuse its readback buffer right away.
+  const size_t row_size = static_cast<size_t>(w) * 4;
+  frame->data.resize(row_size * h);
+  for (int y = 0; y < h; ++y)
+  {
+    const u8* src = data + static_cast<ptrdiff_t>(swap_upside_down ? h - 1 - y : y) * stride;
+    memcpy(&frame->data[row_size * y], src, row_size);
+  }
+  frame->width = w;
+  frame->height = h;
+  frame->state = state;
+
+  {
+    std::lock_guard<std::mutex> lk(m_frame_dump_lock);
+    m_frame_dump_queue.push_back(std::move(frame));
+    m_frame_dump_frames_queued++;
+    m_frame_dump_max_queue_depth =
+        std::max(m_frame_dump_max_queue_depth, m_frame_dump_queue.size());
+  }
+  m_frame_dump_cv.notify_all();
 }
 
 void Renderer::FinishFrameData()
 {
-  if (!m_frame_dump_frame_running)
-    return;
-
-  m_frame_dump_done.Wait();
-  m_frame_dump_frame_running = false;
+  std::unique_lock<std::mutex> lk(m_frame_dump_lock);
+  m_frame_dump_cv.wait(lk, [this] { return m_frame_dump_queue.empty() && !m_frame_dump_busy; });
 }
 
 void Renderer::RunFrameDumps()
@@ -812,18 +846,23 @@ void Renderer::RunFrameDumps()
 
   while (true)
   {
-    m_frame_dump_start.Wait();
-    if (!m_frame_dump_thread_running.IsSet())
-      break;
-
-    auto config = m_frame_dump_config;
-
-    if (config.upside_down)
+    std::unique_ptr<QueuedFrameDump> frame;
     {
-      config.data = config.data + (config.height - 1) * config.stride;
-      config.stride = -config.stride;
+      std::unique_lock<std::mutex> lk(m_frame_dump_lock);
+      m_frame_dump_cv.wait(lk, [this] {
+        return !m_frame_dump_queue.empty() || !m_frame_dump_thread_running.IsSet();
+      });
+      if (m_frame_dump_queue.empty())
+        break;
+
+      frame = std::move(m_frame_dump_queue.front());
+      m_frame_dump_queue.pop_front();
+      m_frame_dump_busy = true;
     }
 
+    const FrameDumpConfig config{frame->data.data(), frame->width, frame->height,
+                                 frame->width * 4, frame->state};
+
     // Save screenshot
     if (s_screenshot.TestAndClear())
     {
@@ -862,7 +901,12 @@ void Renderer::RunFrameDumps()
       }
     }
 
-    m_frame_dump_done.Set();
+    {
+      std::lock_guard<std::mutex> lk(m_frame_dump_lock);
+      m_frame_dump_free_list.push_back(std::move(frame));
+      m_frame_dump_busy = false;
+    }
+    m_frame_dump_cv.notify_all();
   }
 
   if (frame_dump_started)
@@ -871,6 +915,26 @@ void Renderer::RunFrameDumps()
     if (dump_to_avi)
       StopFrameDumpToAVI();
   }
+
+  std::lock_guard<std::mutex> lk(m_frame_dump_lock);
+  const u64 total_frames = m_frame_dump_frames_queued + m_frame_dump_frames_dropped;
+  if (total_frames)
+  {
+    NOTICE_LOG(VIDEO, "Frame dump finished: %llu frames, %llu dropped, max queue depth %zu",
+               static_cast<unsigned long long>(m_frame_dump_frames_queued),
+               static_cast<unsigned long long>(m_frame_dump_frames_dropped),
+               m_frame_dump_max_queue_depth);
+    if (m_frame_dump_frames_dropped)
+    {
+      OSD::AddMessage(StringFromFormat("Frame dump dropped %llu of %llu frames",
+                                       static_cast<unsigned long long>(m_frame_dump_frames_dropped),
+                                       static_cast<unsigned long long>(total_frames)));
+    }
+  }
+  m_frame_dump_frames_queued = 0;
+  m_frame_dump_frames_dropped = 0;
+  m_frame_dump_max_queue_depth = 0;
+  m_frame_dump_free_list.clear();
 }
 
 #if defined(HAVE_LIBAV) || defined(_WIN32)
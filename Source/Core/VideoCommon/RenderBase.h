@@ -15,6 +15,7 @@
 #pragma once
 
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -155,6 +156,7 @@ protected:
   bool IsFrameDumping();
   void DumpFrameData(const u8* data, int w, int h, int stride, const AVIDump::Frame& state,
                      bool swap_upside_down = false);
+  // Blocks until every queued frame has been written out.
   void FinishFrameData();
 
   static Common::Flag s_screenshot;
@@ -197,21 +199,36 @@ private:
   static unsigned int efb_scale_denominatorY;
 
   // frame dumping
-  std::thread m_frame_dump_thread;
-  Common::Event m_frame_dump_start;
-  Common::Event m_frame_dump_done;
-  Common::Flag m_frame_dump_thread_running;
-  u32 m_frame_dump_image_counter = 0;
-  bool m_frame_dump_frame_running = false;
+  // Frames are copied into a bounded queue by the video thread and converted, encoded and written
+  // out on the frame dump thread. When the queue is full, new frames are dropped rather than
+  // stalling emulation.
+  static constexpr size_t MAX_QUEUED_FRAME_DUMPS = 8;
   struct FrameDumpConfig
   {
     const u8* data;
     int width;
     int height;
     int stride;
-    bool upside_down;
     AVIDump::Frame state;
-  } m_frame_dump_config;
+  };
+  struct QueuedFrameDump
+  {
+    std::vector<u8> data;
+    int width;
+    int height;
+    AVIDump::Frame state;
+  };
+  std::thread m_frame_dump_thread;
+  Common::Flag m_frame_dump_thread_running;
+  std::mutex m_frame_dump_lock;
+  std::condition_variable m_frame_dump_cv;
+  std::deque<std::unique_ptr<QueuedFrameDump>> m_frame_dump_queue;
+  std::vector<std::unique_ptr<QueuedFrameDump>> m_frame_dump_free_list;
+  bool m_frame_dump_busy = false;
+  u64 m_frame_dump_frames_queued = 0;
+  u64 m_frame_dump_frames_dropped = 0;
+  size_t m_frame_dump_max_queue_depth = 0;
+  u32 m_frame_dump_image_counter = 0;
 
   // NOTE: The methods below are called on the framedumping thread.
   bool StartFrameDumpToAVI(const FrameDumpConfig& config);
@@ -0,0 +1,143 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "AudioCommon/DPL2Decoder.h"
+
+namespace
+{
+constexpr int SAMPLE_RATE = 48000;
+constexpr double PI = 3.14159265358979323846;
+
+std::vector<float> StereoSine(double frequency, int frames)
+{
+  std::vector<float> samples(frames * 2);
+  for (int i = 0; i < frames; ++i)
+  {
+    const float value = static_cast<float>(0.5 * std::sin(2 * PI * frequency * i / SAMPLE_RATE));
+    samples[i * 2] = value;
+    samples[i * 2 + 1] = value;
+  }
+  return samples;
+}
+
+std::vector<float> Decode(std::vector<float> samples, int block_size)
+{
+  const int frames = static_cast<int>(samples.size() / 2);
+  std::vector<float> out(frames * 6);
+  DPL2Reset();
+  for (int i = 0; i < frames; i += block_size)
+  {
+    const int count = std::min(block_size, frames - i);
+    DPL2Decode(&samples[i * 2], count, &out[i * 6]);
+  }
+  return out;
+}
+
+// The 125 Hz lowpass the decoder designs for the LFE channel, scaled by -3 dB.
+std::array<float, 256> LFECoefficients()
+{
+  constexpr int N = 256;
+  const float fc = 125.0f / (SAMPLE_RATE / 2) / 2;
+  std::array<float, N> w;
+  for (int i = 0; i < N; ++i)
+    w[i] = static_cast<float>(0.54 - 0.46 * std::cos(static_cast<float>(2 * PI / (N - 1)) * i));
+
+  float gain = 0.0f;
+  for (int i = 0; i < N / 2; ++i)
+  {
+    const float t = i + 0.5f;
+    w[N / 2 - i - 1] = w[N / 2 + i] =
+        static_cast<float>(w[N / 2 - i - 1] * std::sin(2 * static_cast<float>(PI) * fc * t) /
+                           (PI * t));
+    gain += 2 * w[N / 2 - i - 1];
+  }
+  for (float& coefficient : w)
+    coefficient *= 1 / gain * 0.7071067812f;
+  return w;
+}
+
+// The LFE filter as the decoder used to run it: once per sample, over a ring buffer that holds
+// the newest input at pos.
+std::vector<float> PerSampleLFE(const std::vector<float>& lfe_in)
+{
+  const std::array<float, 256> coefficients = LFECoefficients();
+  std::array<float, 256> ring{};
+  size_t pos = 0;
+  std::vector<float> lfe_out;
+  for (float sample : lfe_in)
+  {
+    ring[pos] = sample;
+    float sum = 0.0f;
+    for (size_t i = 0; i < ring.size(); ++i)
+      sum += ring[(pos + i) % ring.size()] * coefficients[i];
+    lfe_out.push_back(sum);
+    pos = (pos + 1) % ring.size();
+  }
+  return lfe_out;
+}
+
+// RMS of one output channel over the second half of the signal, after the filters settled.
+double ChannelRMS(const std::vector<float>& out, int channel)
+{
+  const size_t frames = out.size() / 6;
+  double sum = 0.0;
+  for (size_t i = frames / 2; i < frames; ++i)
+    sum += out[i * 6 + channel] * out[i * 6 + channel];
+  return std::sqrt(sum / (frames - frames / 2));
+}
+}
+
+TEST(DPL2Decoder, OutputDoesNotDependOnBlockSize)
+{
+  std::vector<float> samples = StereoSine(440.0, 4800);
+  // Give the rear channels something to decode as well.
+  for (size_t i = 0; i < samples.size(); i += 2)
+    samples[i] *= 0.25f;
+
+  const std::vector<float> whole = Decode(samples, 4800);
+  const std::vector<float> chunked = Decode(samples, 37);
+  for (size_t i = 0; i < whole.size(); ++i)
+    EXPECT_FLOAT_EQ(whole[i], chunked[i]);
+}
+
+TEST(DPL2Decoder, LFEIsLowpassed)
+{
+  const double bass = ChannelRMS(Decode(StereoSine(50.0, SAMPLE_RATE), 512), 3);
+  const double treble = ChannelRMS(Decode(StereoSine(4000.0, SAMPLE_RATE), 512), 3);
+
+  EXPECT_GT(bass, 0.1);
+  EXPECT_LT(20.0 * std::log10(treble / bass), -40.0);
+}
+
+TEST(DPL2Decoder, LFEMatchesPerSampleFilter)
+{
+  std::mt19937 rng(29);
+  std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+  std::vector<float> samples(4800 * 2);
+  for (float& sample : samples)
+    sample = noise(rng);
+
+  const std::vector<float> out = Decode(samples, 512);
+
+  // The LFE input is a mix of the other decoded channels, so it can be rebuilt from them.
+  const size_t frames = out.size() / 6;
+  std::vector<float> lfe_in(frames);
+  for (size_t i = 0; i < frames; ++i)
+  {
+    const float* frame = &out[i * 6];
+    lfe_in[i] = (frame[0] + frame[1] + 2.0f * frame[2] + frame[4] + frame[5]) / 2.0f;
+  }
+
+  const std::vector<float> expected = PerSampleLFE(lfe_in);
+  for (size_t i = 0; i < frames; ++i)
+    ASSERT_NEAR(expected[i], out[i * 6 + 3], 1e-6f) << "frame " << i;
+}
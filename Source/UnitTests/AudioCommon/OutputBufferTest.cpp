@@ -0,0 +1,94 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <array>
+
+#include "AudioCommon/NullSoundStream.h"
+#include "AudioCommon/OutputBuffer.h"
+#include "Core/ConfigManager.h"
+
+namespace
+{
+// Synthetic clock in microseconds; every tick pushes one millisecond of 32 kHz DMA audio.
+constexpr u64 TICKS_PER_SECOND = 1000000;
+constexpr u32 DMA_FRAMES_PER_MS = 32;
+
+class OutputBufferTest : public testing::Test
+{
+protected:
+  OutputBufferTest()
+  {
+    SConfig::Init();
+    SConfig::GetInstance().m_EmulationSpeed = 1.0f;
+  }
+  ~OutputBufferTest() override { SConfig::Shutdown(); }
+
+  // Emulates elapsed_ms of gameplay, rendering in chunks of render_us of device time.
+  void Run(NullSound* sound, u32 elapsed_ms, u64 render_us)
+  {
+    std::array<s16, DMA_FRAMES_PER_MS * 2> dma{};
+    u64 pending_us = 0;
+    for (u32 ms = 0; ms < elapsed_ms; ++ms)
+    {
+      sound->GetMixer()->PushSamples(dma.data(), DMA_FRAMES_PER_MS);
+      pending_us += 1000;
+      while (pending_us >= render_us)
+      {
+        sound->AdvanceTime(render_us, TICKS_PER_SECOND);
+        pending_us -= render_us;
+      }
+    }
+  }
+};
+}
+
+TEST_F(OutputBufferTest, HoldsTargetLatency)
+{
+  NullSound sound;
+  AudioCommon::OutputBuffer& output = sound.GetOutputBuffer();
+  output.SetTargetLatency(20);
+
+  Run(&sound, 1000, 1000);
+
+  const AudioCommon::OutputBuffer::Stats stats = output.GetStats();
+  EXPECT_EQ(0u, stats.underruns);
+  EXPECT_EQ(0u, stats.overruns);
+  EXPECT_EQ(48000u * 20 / 1000, stats.target_frames);
+  // The ring is topped up to the target before every 1 ms (48 frame) read.
+  EXPECT_EQ(stats.target_frames - 48, stats.buffered_frames);
+}
+
+TEST_F(OutputBufferTest, AdaptsToUnderruns)
+{
+  NullSound sound;
+  AudioCommon::OutputBuffer& output = sound.GetOutputBuffer();
+  output.SetTargetLatency(2);
+  const u32 base_target = output.GetStats().target_frames;
+
+  // A device pulling 10 ms at a time drains more than the target holds.
+  Run(&sound, 20, 10000);
+  const AudioCommon::OutputBuffer::Stats starved = output.GetStats();
+  EXPECT_EQ(1u, starved.underruns);
+  EXPECT_GT(starved.target_frames, base_target);
+
+  // After a while of clean playback the target decays back to the configured latency.
+  Run(&sound, 5000, 1000);
+  const AudioCommon::OutputBuffer::Stats recovered = output.GetStats();
+  EXPECT_EQ(starved.underruns, recovered.underruns);
+  EXPECT_EQ(base_target, recovered.target_frames);
+}
+
+TEST_F(OutputBufferTest, CountsInputOverruns)
+{
+  NullSound sound;
+
+  // Nothing drains the mixer, so its DMA FIFO eventually fills up and drops pushes.
+  std::array<s16, DMA_FRAMES_PER_MS * 2> dma{};
+  for (int i = 0; i < 1000; ++i)
+    sound.GetMixer()->PushSamples(dma.data(), DMA_FRAMES_PER_MS);
+
+  EXPECT_GT(sound.GetOutputBuffer().GetStats().overruns, 0u);
+}
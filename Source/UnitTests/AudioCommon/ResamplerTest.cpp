@@ -0,0 +1,254 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AudioCommon/Resampler.h"
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+
+using AudioCommon::Resampler;
+using AudioCommon::ResamplerKernel;
+
+namespace
+{
+constexpr u32 RING_SIZE = 0x10000;
+constexpr u32 RING_MASK = RING_SIZE - 1;
+constexpr double PI = 3.14159265358979323846;
+
+// Fills a mixer-style ring with a big-endian stereo sine and returns the write index.
+u32 FillSine(std::vector<s16>* ring, double frequency, double sample_rate, double amplitude)
+{
+  const u32 frames = RING_SIZE / 2 - 1;
+  for (u32 i = 0; i < frames; ++i)
+  {
+    const double phase = 2 * PI * frequency * i / sample_rate;
+    const s16 value = static_cast<s16>(std::lround(amplitude * std::sin(phase)));
+    (*ring)[i * 2] = Common::swap16(value);
+    (*ring)[i * 2 + 1] = Common::swap16(value);
+  }
+  return frames * 2;
+}
+
+// Total harmonic distortion plus noise of a sine of known frequency, in dB. The fundamental is
+// removed with a least-squares fit so the result does not depend on whole periods being analyzed.
+double MeasureTHDN(const std::vector<s16>& samples, size_t first, size_t count, double omega)
+{
+  double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0;
+  for (size_t i = first; i < first + count; ++i)
+  {
+    const double s = std::sin(omega * i);
+    const double c = std::cos(omega * i);
+    ss += s * s;
+    sc += s * c;
+    cc += c * c;
+    ys += samples[i] * s;
+    yc += samples[i] * c;
+  }
+  const double det = ss * cc - sc * sc;
+  const double a = (ys * cc - yc * sc) / det;
+  const double b = (yc * ss - ys * sc) / det;
+
+  double signal = 0, residual = 0;
+  for (size_t i = first; i < first + count; ++i)
+  {
+    const double fit = a * std::sin(omega * i) + b * std::cos(omega * i);
+    signal += fit * fit;
+    residual += (samples[i] - fit) * (samples[i] - fit);
+  }
+  return 10.0 * std::log10(residual / signal);
+}
+
+double ResampleSineTHDN(ResamplerKernel kernel, double frequency, u32 in_rate, u32 out_rate)
+{
+  std::vector<s16> ring(RING_SIZE);
+  const u32 index_w = FillSine(&ring, frequency, in_rate, 16000.0);
+  const u32 ratio = static_cast<u32>(65536.0 * in_rate / out_rate);
+
+  Resampler resampler(kernel);
+  std::vector<s16> out(out_rate * 2);
+  u32 index_r = 0;
+  const u32 produced = resampler.Mix(out.data(), out_rate, ring.data(), RING_MASK, &index_r,
+                                     index_w, ratio, 256, 256);
+  EXPECT_GT(produced, out_rate / 2);
+
+  // Only look at the left channel, skipping the filter warm-up.
+  std::vector<s16> left(produced);
+  for (u32 i = 0; i < produced; ++i)
+    left[i] = out[i * 2 + 1];
+  const double omega = 2 * PI * frequency / in_rate * ratio / 65536.0;
+  return MeasureTHDN(left, 64, produced - 128, omega);
+}
+}
+
+TEST(Resampler, LinearMatchesFixedPointInterpolation)
+{
+  std::vector<s16> ring(RING_SIZE);
+  const u32 index_w = FillSine(&ring, 997.0, 32000, 30000.0);
+  const u32 ratio = static_cast<u32>(65536.0 * 32000 / 48000);
+
+  Resampler resampler(ResamplerKernel::Linear);
+  std::vector<s16> out(4096 * 2);
+  u32 index_r = 0;
+  const u32 produced = resampler.Mix(out.data(), 4096, ring.data(), RING_MASK, &index_r, index_w,
+                                     ratio, 256, 256);
+  ASSERT_EQ(4096u, produced);
+
+  // The interpolation the mixer used before it had selectable kernels.
+  u32 expected_r = 0;
+  u32 frac = 0;
+  for (u32 i = 0; i < produced; ++i)
+  {
+    const s16 l1 = Common::swap16(ring[expected_r & RING_MASK]);
+    const s16 l2 = Common::swap16(ring[(expected_r + 2) & RING_MASK]);
+    const int expected = ((l1 << 16) + (l2 - l1) * static_cast<u16>(frac)) >> 16;
+    EXPECT_NEAR(expected, out[i * 2 + 1], 1);
+
+    frac += ratio;
+    expected_r += 2 * (frac >> 16);
+    frac &= 0xffff;
+  }
+  EXPECT_EQ(expected_r, index_r);
+}
+
+TEST(Resampler, LinearKeepsEveryStepAtHighRatios)
+{
+  std::vector<s16> ring(RING_SIZE);
+  const u32 index_w = FillSine(&ring, 997.0, 96000, 30000.0);
+  // More than two input frames per output frame, so steps regularly cross block boundaries.
+  const u32 ratio = 0x38000;
+
+  Resampler resampler(ResamplerKernel::Linear);
+  std::vector<s16> out(4096 * 2);
+  u32 index_r = 0;
+  const u32 produced = resampler.Mix(out.data(), 4096, ring.data(), RING_MASK, &index_r, index_w,
+                                     ratio, 256, 256);
+  ASSERT_EQ(4096u, produced);
+
+  u32 expected_r = 0;
+  u32 frac = 0;
+  for (u32 i = 0; i < produced; ++i)
+  {
+    const s16 l1 = Common::swap16(ring[expected_r & RING_MASK]);
+    const s16 l2 = Common::swap16(ring[(expected_r + 2) & RING_MASK]);
+    const int expected = ((l1 << 16) + (l2 - l1) * static_cast<u16>(frac)) >> 16;
+    ASSERT_NEAR(expected, out[i * 2 + 1], 1) << "frame " << i;
+
+    frac += ratio;
+    expected_r += 2 * (frac >> 16);
+    frac &= 0xffff;
+  }
+  EXPECT_EQ(expected_r, index_r);
+}
+
+TEST(Resampler, StepPastWriteIndexIsSkippedLater)
+{
+  std::vector<s16> ring(RING_SIZE);
+  Resampler resampler(ResamplerKernel::Linear);
+  std::vector<s16> out(64 * 2);
+
+  // 10 frames at a ratio of 4 produce outputs at 0, 4 and 8; the last step lands on frame 12.
+  u32 index_r = 0;
+  resampler.Mix(out.data(), 64, ring.data(), RING_MASK, &index_r, 10 * 2, 0x40000, 256, 256);
+  EXPECT_EQ(10u * 2, index_r);
+
+  // The two frames that were not written yet are skipped once they arrive.
+  resampler.Mix(out.data(), 0, ring.data(), RING_MASK, &index_r, 20 * 2, 0x40000, 256, 256);
+  EXPECT_EQ(10u * 2, index_r);
+  resampler.Mix(out.data(), 64, ring.data(), RING_MASK, &index_r, 20 * 2, 0x40000, 256, 256);
+  EXPECT_EQ(20u * 2, index_r);
+}
+
+TEST(Resampler, SetKernelResetsFraction)
+{
+  std::vector<s16> ring(RING_SIZE);
+  const u32 index_w = FillSine(&ring, 997.0, 32000, 30000.0);
+
+  Resampler resampler(ResamplerKernel::Cubic);
+  std::vector<s16> out(100 * 2);
+  u32 index_r = 0;
+  // Leave the resampler halfway between two input frames.
+  resampler.Mix(out.data(), 1, ring.data(), RING_MASK, &index_r, index_w, 0x8000, 256, 256);
+
+  resampler.SetKernel(ResamplerKernel::Linear);
+  std::fill(out.begin(), out.end(), 0);
+  const u32 start = index_r;
+  ASSERT_EQ(100u, resampler.Mix(out.data(), 100, ring.data(), RING_MASK, &index_r, index_w,
+                                0x10000, 256, 256));
+  for (u32 i = 0; i < 100; ++i)
+    EXPECT_EQ(static_cast<s16>(Common::swap16(ring[(start + i * 2) & RING_MASK])), out[i * 2 + 1]);
+}
+
+TEST(Resampler, KeepsLookaheadInRing)
+{
+  for (ResamplerKernel kernel :
+       {ResamplerKernel::Linear, ResamplerKernel::Cubic, ResamplerKernel::WindowedSinc})
+  {
+    std::vector<s16> ring(RING_SIZE);
+    Resampler resampler(kernel);
+    std::vector<s16> out(2048 * 2);
+
+    // Start close to the end of the ring so reads wrap around.
+    const u32 start = RING_SIZE - 20;
+    u32 index_r = start;
+    const u32 index_w = start + 100 * 2;
+    resampler.Mix(out.data(), 2048, ring.data(), RING_MASK, &index_r, index_w, 0x10000, 256, 256);
+
+    EXPECT_EQ(index_w - resampler.GetLookahead() * 2, index_r);
+  }
+}
+
+TEST(Resampler, DistortionImprovesWithKernelQuality)
+{
+  const double linear = ResampleSineTHDN(ResamplerKernel::Linear, 5000.0, 32000, 48000);
+  const double cubic = ResampleSineTHDN(ResamplerKernel::Cubic, 5000.0, 32000, 48000);
+  const double sinc = ResampleSineTHDN(ResamplerKernel::WindowedSinc, 5000.0, 32000, 48000);
+
+  EXPECT_LT(cubic, linear);
+  EXPECT_LT(sinc, cubic);
+  EXPECT_LT(sinc, -70.0);
+}
+
+// Not run by default. Reports the cost of each kernel per output frame and its distortion.
+TEST(Resampler, DISABLED_Benchmark)
+{
+  constexpr u32 FRAMES = 4096;
+  constexpr int ITERATIONS = 2000;
+
+  std::vector<s16> ring(RING_SIZE);
+  const u32 index_w = FillSine(&ring, 997.0, 32000, 30000.0);
+  const u32 ratio = static_cast<u32>(65536.0 * 32000 / 48000);
+
+  const std::pair<ResamplerKernel, std::string> kernels[] = {
+      {ResamplerKernel::Linear, "Linear"},
+      {ResamplerKernel::Cubic, "Cubic"},
+      {ResamplerKernel::WindowedSinc, "WindowedSinc"}};
+  for (const auto& kernel : kernels)
+  {
+    Resampler resampler(kernel.first);
+    std::vector<s16> out(FRAMES * 2);
+    u64 frames = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+      u32 index_r = 0;
+      frames += resampler.Mix(out.data(), FRAMES, ring.data(), RING_MASK, &index_r, index_w, ratio,
+                              256, 256);
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    ASSERT_EQ(static_cast<u64>(FRAMES) * ITERATIONS, frames);
+
+    RecordProperty(kernel.second + "NsPerFrame", std::to_string(elapsed.count() / frames));
+    RecordProperty(kernel.second + "THDN",
+                   std::to_string(ResampleSineTHDN(kernel.first, 5000.0, 32000, 48000)));
+  }
+}
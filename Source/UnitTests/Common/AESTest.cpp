@@ -0,0 +1,80 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstring>
+#include <mbedtls/aes.h>
+#include <random>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+
+namespace
+{
+// FIPS-197 appendix C.1.
+constexpr std::array<u8, 16> FIPS_KEY = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                                         0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+constexpr std::array<u8, 16> FIPS_PLAINTEXT = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                               0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+constexpr std::array<u8, 16> FIPS_CIPHERTEXT = {0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+                                                0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a};
+
+std::vector<u8> RandomBytes(std::mt19937* rng, size_t size)
+{
+  std::vector<u8> bytes(size);
+  for (u8& byte : bytes)
+    byte = static_cast<u8>((*rng)());
+  return bytes;
+}
+}
+
+TEST(AES, DecryptsKnownAnswer)
+{
+  Common::AES::DecryptionContext context(FIPS_KEY.data());
+  std::array<u8, 16> iv{};
+  std::array<u8, 16> plaintext;
+  context.DecryptCBC(iv.data(), FIPS_CIPHERTEXT.data(), plaintext.data(), plaintext.size());
+
+  EXPECT_EQ(FIPS_PLAINTEXT, plaintext);
+  EXPECT_EQ(FIPS_CIPHERTEXT, iv);
+}
+
+TEST(AES, MatchesMbedTLS)
+{
+  std::mt19937 rng(1234);
+  Common::AES::DecryptionContext context;
+  mbedtls_aes_context reference;
+  mbedtls_aes_init(&reference);
+
+  // Cover the parallel path, the single block tail and the Wii cluster size.
+  for (size_t size : {16, 48, 64, 80, 0x3f0, 0x7c00})
+  {
+    const std::vector<u8> key = RandomBytes(&rng, 16);
+    const std::vector<u8> ciphertext = RandomBytes(&rng, size);
+    const std::vector<u8> iv = RandomBytes(&rng, 16);
+    context.SetKey(key.data());
+    mbedtls_aes_setkey_dec(&reference, key.data(), 128);
+
+    std::vector<u8> expected(size);
+    std::vector<u8> expected_iv = iv;
+    mbedtls_aes_crypt_cbc(&reference, MBEDTLS_AES_DECRYPT, size, expected_iv.data(),
+                          ciphertext.data(), expected.data());
+
+    std::vector<u8> actual(size);
+    std::vector<u8> actual_iv = iv;
+    context.DecryptCBC(actual_iv.data(), ciphertext.data(), actual.data(), size);
+    EXPECT_EQ(expected, actual) << "size " << size;
+    EXPECT_EQ(expected_iv, actual_iv) << "size " << size;
+
+    std::vector<u8> in_place = ciphertext;
+    std::vector<u8> in_place_iv = iv;
+    context.DecryptCBC(in_place_iv.data(), in_place.data(), in_place.data(), size);
+    EXPECT_EQ(expected, in_place) << "size " << size;
+  }
+
+  mbedtls_aes_free(&reference);
+}
@@ -0,0 +1,56 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <mbedtls/sha1.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/SHA1.h"
+
+namespace
+{
+Common::SHA1::Digest DigestOf(const std::string& message)
+{
+  return Common::SHA1::CalculateDigest(reinterpret_cast<const u8*>(message.data()),
+                                       message.size());
+}
+}
+
+TEST(SHA1, KnownAnswers)
+{
+  // FIPS 180-2 appendix A.
+  const Common::SHA1::Digest abc = {0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+                                    0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d};
+  EXPECT_EQ(abc, DigestOf("abc"));
+
+  const Common::SHA1::Digest two_blocks = {0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2,
+                                           0x6e, 0xba, 0xae, 0x4a, 0xa1, 0xf9, 0x51,
+                                           0x29, 0xe5, 0xe5, 0x46, 0x70, 0xf1};
+  EXPECT_EQ(two_blocks, DigestOf("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"));
+}
+
+TEST(SHA1, MatchesMbedTLS)
+{
+  std::mt19937 rng(5678);
+  std::vector<u8> data(0x400);
+  for (u8& byte : data)
+    byte = static_cast<u8>(rng());
+
+  // Every padding case around the block boundaries, plus the sizes the Wii hash tree uses.
+  std::vector<size_t> sizes = {0xA0, 0x26C, 0x400};
+  for (size_t size = 0; size <= 192; ++size)
+    sizes.push_back(size);
+
+  for (size_t size : sizes)
+  {
+    Common::SHA1::Digest expected;
+    mbedtls_sha1(data.data(), size, expected.data());
+    EXPECT_EQ(expected, Common::SHA1::CalculateDigest(data.data(), size)) << "size " << size;
+  }
+}
@@ -0,0 +1,607 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Runs random instruction sequences, and a few fixed ones that other cores handle specially, on the
+// interpreter and on each of the other CPU cores, starting from the same state, and checks that
+// they end up with the same registers and memory.
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/GekkoDisassembler.h"
+#include "Common/StringUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/Memmap.h"
+#include "Core/MemTools.h"
+#include "Core/PowerPC/Gekko.h"
+#include "Core/PowerPC/Interpreter/Interpreter_FPUtils.h"
+#include "Core/PowerPC/PPCTables.h"
+#include "Core/PowerPC/PowerPC.h"
+
+namespace
+{
+// Each test case gets its own code, so that the cores which cache compiled code don't have to be
+// flushed in between.
+constexpr u32 CODE_ADDRESS = 0x80010000;
+constexpr u32 CODE_STRIDE = 0x400;
+constexpr u32 MAX_INSTRUCTIONS = CODE_STRIDE / 4 - 1;
+// Loads and stores only ever access this, with r1 as the base and r2 as the index.
+constexpr u32 SCRATCH_ADDRESS = 0x80400000;
+constexpr u32 SCRATCH_SIZE = 0x1000;
+constexpr u32 BASE_REGISTER = 1;
+constexpr u32 INDEX_REGISTER = 2;
+
+// The JITs don't keep track of the FPSCR exception bits, so only the rounding mode, the exception
+// enables and FPRF are compared.
+constexpr u32 FPSCR_COMPARED_BITS = FPRF_MASK | 0xFF;
+// Neither do they keep track of summary overflow in the CR fields they set, so it isn't compared,
+// and the tests start out without it.
+constexpr u32 CR_COMPARED_BITS = ~0x11111111U;
+
+enum class OpClass
+{
+  Integer,
+  LoadStore,
+  FloatingPoint,
+  All,
+};
+
+struct CPUState
+{
+  std::array<u32, 32> gpr;
+  std::array<std::array<u64, 2>, 32> ps;
+  std::array<u32, 8> gqr;
+  u32 cr;
+  u32 xer;
+  u32 fpscr;
+  u32 lr;
+  u32 ctr;
+  std::vector<u8> scratch;
+};
+
+struct TestCase
+{
+  std::vector<u32> code;
+  CPUState initial;
+};
+
+bool IsMemoryAccess(const GekkoOPInfo* info)
+{
+  switch (info->type)
+  {
+  case OPTYPE_LOAD:
+  case OPTYPE_STORE:
+  case OPTYPE_LOADFP:
+  case OPTYPE_STOREFP:
+  case OPTYPE_LOADPS:
+  case OPTYPE_STOREPS:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool IsInClass(const GekkoOPInfo* info, OpClass op_class)
+{
+  const bool integer = info->type == OPTYPE_INTEGER || info->type == OPTYPE_CR;
+  const bool floating_point = info->type == OPTYPE_DOUBLEFP || info->type == OPTYPE_SINGLEFP ||
+                              info->type == OPTYPE_PS;
+  switch (op_class)
+  {
+  case OpClass::Integer:
+    return integer;
+  case OpClass::LoadStore:
+    return integer || IsMemoryAccess(info);
+  case OpClass::FloatingPoint:
+    return floating_point;
+  case OpClass::All:
+    return integer || floating_point || IsMemoryAccess(info);
+  }
+  return false;
+}
+
+bool IsExcluded(const GekkoOPInfo* info)
+{
+  // Instructions that access more memory than a single location, or that depend on state which
+  // the test doesn't set up (reservations, the external access register)
+  static const char* const excluded[] = {"lmw",   "stmw",   "lswx",  "lswi",  "stswx",
+                                         "stswi", "lwarx",  "stwcxd", "eciwx", "ecowx"};
+  for (const char* name : excluded)
+  {
+    if (!std::strcmp(info->opname, name))
+      return true;
+  }
+#if _M_ARM_64
+  // Instructions that JitArm64 knowingly implements differently from the interpreter:
+  // - stfs, stfsx, psq_st and psq_stx round doubles that don't fit in a single with FCVT, where
+  //   the interpreter picks the bits like the hardware does, and psq_st keeps denormals
+  // - the negated multiply-subtracts are computed as b - a * c, which gives +0 where the
+  //   interpreter gives -0
+  // - fctiwz doesn't mark negative numbers that round to zero like the interpreter does
+  // Jit64 matches the interpreter for all of these.
+  static const char* const divergent[] = {"stfs",    "stfsx",    "psq_st",   "psq_stx",
+                                          "fnmsubx", "fnmsubsx", "ps_nmsub", "fctiwzx"};
+  for (const char* name : divergent)
+  {
+    if (!std::strcmp(info->opname, name))
+      return true;
+  }
+#endif
+  return (info->flags & FL_ENDBLOCK) != 0;
+}
+
+// Returns a random instruction of the given class whose operands keep it from writing r1 and r2,
+// and from accessing memory outside of the scratch area.
+UGeckoInstruction RandomInstruction(std::mt19937& rng, OpClass op_class)
+{
+  while (true)
+  {
+    UGeckoInstruction inst(rng());
+    if (!PPCTables::IsValidInstruction(inst))
+      continue;
+    const GekkoOPInfo* info = GetOpInfo(inst);
+    if (!IsInClass(info, op_class) || IsExcluded(info))
+      continue;
+    // The interpreter doesn't implement overflow for all of the instructions that can set it
+    if ((info->flags & FL_SET_OE) && inst.OE)
+      continue;
+    // CR1 is a copy of the FPSCR exception bits, which the JITs don't keep track of
+    if (info->flags & FL_RC_BIT_F)
+      inst.Rc = 0;
+
+    if (IsMemoryAccess(info))
+    {
+      // Forms with update write back to the base register
+      if (info->flags & FL_OUT_A)
+        continue;
+      inst.RA = BASE_REGISTER;
+      if (inst.OPCD == 31 || inst.OPCD == 4)
+        inst.RB = INDEX_REGISTER;
+      else if (info->type == OPTYPE_LOADPS || info->type == OPTYPE_STOREPS)
+        inst.SIMM_12 = rng() % 0x800 & ~7;
+      else
+        inst.SIMM_16 = rng() % (SCRATCH_SIZE - 8) & ~7;
+    }
+
+    if ((info->flags & FL_OUT_D) && (inst.RD == BASE_REGISTER || inst.RD == INDEX_REGISTER))
+      continue;
+    if ((info->flags & FL_OUT_A) && (inst.RA == BASE_REGISTER || inst.RA == INDEX_REGISTER))
+      continue;
+    return inst;
+  }
+}
+
+// Values that paired singles can hold, including zeroes, infinities, NaNs and denormals.
+u64 RandomFloatingPoint(std::mt19937& rng)
+{
+  double value;
+  switch (rng() % 16)
+  {
+  case 0:
+    value = (rng() & 1) ? -0.0 : 0.0;
+    break;
+  case 1:
+    value = (rng() & 1) ? -HUGE_VAL : HUGE_VAL;
+    break;
+  case 2:
+    // Any single precision bit pattern, including signaling NaNs and denormals
+    return ConvertToDouble(rng());
+  case 3:
+    value = static_cast<double>(std::numeric_limits<float>::denorm_min()) * (rng() % 0x7FFFFF);
+    break;
+  default:
+    value = std::uniform_real_distribution<float>(-1000.0f, 1000.0f)(rng);
+    break;
+  }
+  u64 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+TestCase RandomTestCase(std::mt19937& rng, OpClass op_class, size_t length)
+{
+  TestCase test;
+  for (size_t i = 0; i < length; ++i)
+    test.code.push_back(RandomInstruction(rng, op_class).hex);
+  // b . ends the sequence by idling
+  test.code.push_back(0x48000000);
+
+  CPUState& state = test.initial;
+  for (u32& gpr : state.gpr)
+  {
+    // Small values make carries, overflows and equal compares more likely
+    gpr = (rng() % 4 == 0) ? rng() % 8 - 4 : rng();
+  }
+  state.gpr[BASE_REGISTER] = SCRATCH_ADDRESS;
+  state.gpr[INDEX_REGISTER] = rng() % (SCRATCH_SIZE - 8) & ~7;
+  for (auto& ps : state.ps)
+  {
+    ps[0] = RandomFloatingPoint(rng);
+    ps[1] = RandomFloatingPoint(rng);
+  }
+  // Quantization types 1-3 are undefined
+  static const u32 valid_types[] = {0, 4, 5, 6, 7};
+  for (u32& gqr : state.gqr)
+  {
+    gqr = (rng() & 0x3F00) | valid_types[rng() % 5];
+    gqr |= ((rng() & 0x3F00) | valid_types[rng() % 5]) << 16;
+  }
+  state.cr = rng();
+  // Summary overflow is left clear, see CR_COMPARED_BITS
+  state.xer = rng() & 0x6000007F;
+  state.fpscr = 0;
+  state.lr = rng();
+  state.ctr = rng();
+  state.scratch.resize(SCRATCH_SIZE);
+  for (u8& byte : state.scratch)
+    byte = static_cast<u8>(rng());
+  return test;
+}
+
+void LoadState(const CPUState& state)
+{
+  std::copy(state.gpr.begin(), state.gpr.end(), PowerPC::ppcState.gpr);
+  for (size_t i = 0; i < state.ps.size(); ++i)
+  {
+    PowerPC::ppcState.ps[i][0] = state.ps[i][0];
+    PowerPC::ppcState.ps[i][1] = state.ps[i][1];
+  }
+  for (size_t i = 0; i < state.gqr.size(); ++i)
+    PowerPC::ppcState.spr[SPR_GQR0 + i] = state.gqr[i];
+  SetCR(state.cr);
+  SetXER(UReg_XER(state.xer));
+  PowerPC::ppcState.fpscr = state.fpscr;
+  LR = state.lr;
+  CTR = state.ctr;
+  Memory::CopyToEmu(SCRATCH_ADDRESS, state.scratch.data(), state.scratch.size());
+}
+
+CPUState SaveState()
+{
+  CPUState state;
+  std::copy(PowerPC::ppcState.gpr, PowerPC::ppcState.gpr + 32, state.gpr.begin());
+  for (size_t i = 0; i < state.ps.size(); ++i)
+    state.ps[i] = {{PowerPC::ppcState.ps[i][0], PowerPC::ppcState.ps[i][1]}};
+  for (size_t i = 0; i < state.gqr.size(); ++i)
+    state.gqr[i] = PowerPC::ppcState.spr[SPR_GQR0 + i];
+  state.cr = GetCR();
+  state.xer = GetXER().Hex;
+  state.fpscr = PowerPC::ppcState.fpscr;
+  state.lr = LR;
+  state.ctr = CTR;
+  state.scratch.resize(SCRATCH_SIZE);
+  Memory::CopyFromEmu(state.scratch.data(), SCRATCH_ADDRESS, state.scratch.size());
+  return state;
+}
+
+// Lists everything that differs, or returns an empty string if nothing does.
+std::string DiffStates(const CPUState& expected, const CPUState& actual)
+{
+  std::string diff;
+  for (size_t i = 0; i < expected.gpr.size(); ++i)
+  {
+    if (expected.gpr[i] != actual.gpr[i])
+      diff += StringFromFormat("  r%zu: %08x != %08x\n", i, expected.gpr[i], actual.gpr[i]);
+  }
+  for (size_t i = 0; i < expected.ps.size(); ++i)
+  {
+    for (size_t j = 0; j < 2; ++j)
+    {
+      if (expected.ps[i][j] != actual.ps[i][j])
+      {
+        diff += StringFromFormat("  f%zu ps%zu: %016llx != %016llx\n", i, j,
+                                 static_cast<unsigned long long>(expected.ps[i][j]),
+                                 static_cast<unsigned long long>(actual.ps[i][j]));
+      }
+    }
+  }
+  if ((expected.cr ^ actual.cr) & CR_COMPARED_BITS)
+    diff += StringFromFormat("  cr: %08x != %08x\n", expected.cr, actual.cr);
+  if (expected.xer != actual.xer)
+    diff += StringFromFormat("  xer: %08x != %08x\n", expected.xer, actual.xer);
+  if ((expected.fpscr ^ actual.fpscr) & FPSCR_COMPARED_BITS)
+    diff += StringFromFormat("  fpscr: %08x != %08x\n", expected.fpscr, actual.fpscr);
+  if (expected.lr != actual.lr)
+    diff += StringFromFormat("  lr: %08x != %08x\n", expected.lr, actual.lr);
+  if (expected.ctr != actual.ctr)
+    diff += StringFromFormat("  ctr: %08x != %08x\n", expected.ctr, actual.ctr);
+  for (size_t i = 0; i < expected.scratch.size(); ++i)
+  {
+    if (expected.scratch[i] != actual.scratch[i])
+    {
+      diff += StringFromFormat("  memory %08x: %02x != %02x\n", SCRATCH_ADDRESS + u32(i),
+                               expected.scratch[i], actual.scratch[i]);
+    }
+  }
+  return diff;
+}
+
+std::string Disassemble(const TestCase& test, u32 address)
+{
+  std::string text;
+  for (u32 inst : test.code)
+  {
+    text += StringFromFormat("  %08x  %08x  %s\n", address, inst,
+                             GekkoDisassembler::Disassemble(inst, address).c_str());
+    address += 4;
+  }
+  return text;
+}
+
+const char* CoreName(int core)
+{
+  switch (core)
+  {
+  case PowerPC::CORE_INTERPRETER:
+    return "Interpreter";
+  case PowerPC::CORE_JIT64:
+    return "JIT64";
+  case PowerPC::CORE_JITIL64:
+    return "JITIL64";
+  case PowerPC::CORE_JITARM64:
+    return "JITARM64";
+  case PowerPC::CORE_CACHEDINTERPRETER:
+    return "CachedInterpreter";
+  default:
+    return "?";
+  }
+}
+
+// Sets up a CPU core with address translation through a BAT like the IPL leaves it, so that
+// 0x80000000 maps to physical address 0.
+class CPUCoreScope final
+{
+public:
+  explicit CPUCoreScope(int core)
+  {
+    PowerPC::Init(core);
+    CoreTiming::Init();
+
+    for (u32 spr : {SPR_IBAT0U, SPR_DBAT0U})
+    {
+      PowerPC::ppcState.spr[spr] = 0x80001FFF;
+      PowerPC::ppcState.spr[spr + 1] = 0x00000002;
+    }
+    PowerPC::IBATUpdated();
+    PowerPC::DBATUpdated();
+    // FP, IR and DR
+    MSR = 0x00002030;
+  }
+  ~CPUCoreScope()
+  {
+    CoreTiming::Shutdown();
+    PowerPC::Shutdown();
+  }
+};
+
+// Runs every test case on one core, the given number of times, and returns the states they end in.
+std::vector<CPUState> RunAll(int core, const std::vector<TestCase>& tests, int passes = 1)
+{
+  CPUCoreScope scope(core);
+  std::vector<CPUState> results;
+  for (int pass = 0; pass < passes; ++pass)
+  {
+    results.clear();
+    for (size_t i = 0; i < tests.size(); ++i)
+    {
+      const u32 address = CODE_ADDRESS + CODE_STRIDE * static_cast<u32>(i);
+      const u32 end_address = address + 4 * static_cast<u32>(tests[i].code.size() - 1);
+      LoadState(tests[i].initial);
+      PC = address;
+      NPC = address + 4;
+
+      // The interpreter does one instruction per step. The other cores keep going until the
+      // branch at the end idles.
+      for (size_t steps = 0; PC != end_address && steps <= MAX_INSTRUCTIONS; ++steps)
+        PowerPC::SingleStep();
+      EXPECT_EQ(end_address, PC) << CoreName(core) << " didn't reach the end of test " << i;
+
+      results.push_back(SaveState());
+    }
+  }
+  return results;
+}
+
+class CPUCoreFuzzTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    Core::DeclareAsCPUThread();
+    SConfig::Init();
+    SConfig::GetInstance().bFPRF = true;
+    // Makes the JITs generate positive NaNs like the interpreter
+    SConfig::GetInstance().bAccurateNaNs = true;
+    SConfig::GetInstance().bSyncGPUOnSkipIdleHack = false;
+    // Keeps Jit64 from using FMA, which rounds once where the interpreter rounds twice
+    Core::g_want_determinism = true;
+    EMM::InstallExceptionHandler();
+    Memory::Init();
+    // The random instructions are looked up before any of the cores sets the tables up
+    PPCTables::InitTables(PowerPC::CORE_INTERPRETER);
+  }
+
+  void TearDown() override
+  {
+    Memory::Shutdown();
+    EMM::UninstallExceptionHandler();
+    Core::g_want_determinism = false;
+    SConfig::Shutdown();
+    Core::UndeclareAsCPUThread();
+  }
+
+  static std::vector<int> CoresToCompare()
+  {
+    // JITIL isn't maintained anymore and is known to differ, so it's only compared by the
+    // disabled JitIL test
+    std::vector<int> cores = {PowerPC::CORE_CACHEDINTERPRETER};
+#if _M_X86_64
+    cores.push_back(PowerPC::CORE_JIT64);
+#elif _M_ARM_64
+    cores.push_back(PowerPC::CORE_JITARM64);
+#endif
+    return cores;
+  }
+
+  std::vector<TestCase> MakeTests(u32 seed, OpClass op_class, size_t count, size_t length)
+  {
+    std::mt19937 rng(seed);
+    std::vector<TestCase> tests;
+    for (size_t i = 0; i < count; ++i)
+    {
+      tests.push_back(RandomTestCase(rng, op_class, length));
+      const u32 address = CODE_ADDRESS + CODE_STRIDE * static_cast<u32>(i);
+      for (size_t j = 0; j < tests[i].code.size(); ++j)
+        Memory::Write_U32(tests[i].code[j], address + 4 * static_cast<u32>(j));
+    }
+    return tests;
+  }
+
+  // Test cases for the given code, each starting from a random state
+  std::vector<TestCase> MakeTests(u32 seed, const std::vector<std::vector<u32>>& sequences)
+  {
+    std::mt19937 rng(seed);
+    std::vector<TestCase> tests;
+    for (size_t i = 0; i < sequences.size(); ++i)
+    {
+      tests.push_back(RandomTestCase(rng, OpClass::Integer, 0));
+      tests[i].code.insert(tests[i].code.begin(), sequences[i].begin(), sequences[i].end());
+      const u32 address = CODE_ADDRESS + CODE_STRIDE * static_cast<u32>(i);
+      for (size_t j = 0; j < tests[i].code.size(); ++j)
+        Memory::Write_U32(tests[i].code[j], address + 4 * static_cast<u32>(j));
+    }
+    return tests;
+  }
+
+  // Reports the first few test cases where a core doesn't do what the interpreter does.
+  void CompareCores(const std::vector<TestCase>& tests,
+                    const std::vector<int>& cores = CoresToCompare())
+  {
+    const std::vector<CPUState> expected = RunAll(PowerPC::CORE_INTERPRETER, tests);
+    for (int core : cores)
+    {
+      const std::vector<CPUState> actual = RunAll(core, tests);
+      int failures = 0;
+      for (size_t i = 0; i < tests.size() && failures < 5; ++i)
+      {
+        const std::string diff = DiffStates(expected[i], actual[i]);
+        if (diff.empty())
+          continue;
+        ++failures;
+        const u32 address = CODE_ADDRESS + CODE_STRIDE * static_cast<u32>(i);
+        ADD_FAILURE() << CoreName(core) << " differs from the interpreter (expected != actual):\n"
+                      << diff << "after running:\n"
+                      << Disassemble(tests[i], address);
+      }
+    }
+  }
+};
+}
+
+TEST_F(CPUCoreFuzzTest, Integer)
+{
+  CompareCores(MakeTests(46, OpClass::Integer, 200, 32));
+}
+
+TEST_F(CPUCoreFuzzTest, LoadStore)
+{
+  CompareCores(MakeTests(47, OpClass::LoadStore, 200, 32));
+}
+
+TEST_F(CPUCoreFuzzTest, FloatingPoint)
+{
+  CompareCores(MakeTests(48, OpClass::FloatingPoint, 200, 32));
+}
+
+TEST_F(CPUCoreFuzzTest, LongMixedSequences)
+{
+  // Long enough that the JITs run out of host registers and have to spill
+  CompareCores(MakeTests(49, OpClass::All, 100, MAX_INSTRUCTIONS));
+}
+
+// The cached interpreter turns these into a single instruction
+TEST_F(CPUCoreFuzzTest, LoadImmediatePairs)
+{
+  CompareCores(MakeTests(50, {
+                                 // lis r3, 0x1234; addi r3, r3, -0x8000
+                                 {0x3C601234, 0x38638000},
+                                 // lis r4, 0xFFFF; ori r4, r4, 0xFFFF
+                                 {0x3C80FFFF, 0x6084FFFF},
+                                 // lis r0, 0x1234; li r0, 5
+                                 {0x3C001234, 0x38000005},
+                                 // lis r0, 0x4321; ori r0, r0, 0x10
+                                 {0x3C004321, 0x60000010},
+                                 // lis r5, 0x8000; addi r6, r5, 1
+                                 {0x3CA08000, 0x38C50001},
+                                 // lis r7, 1; ori r8, r7, 0x8000
+                                 {0x3CE00001, 0x61078000},
+                                 // lis r9, 2; addi r9, r10, 3
+                                 {0x3D200002, 0x392A0003},
+                             }));
+}
+
+// The cached interpreter follows these into the block instead of ending it
+TEST_F(CPUCoreFuzzTest, FollowedBranches)
+{
+  CompareCores(MakeTests(51, {
+                                 // li r3, 1; bl 1f; addi r3, r3, 2; b 2f
+                                 // 1: mflr r4; addi r3, r3, 4; blr
+                                 // 2:
+                                 {0x38600001, 0x4800000D, 0x38630002, 0x48000010, 0x7C8802A6,
+                                  0x38630004, 0x4E800020},
+                                 // bl 1f; li r3, 1; 1: mflr r4
+                                 {0x48000009, 0x38600001, 0x7C8802A6},
+                                 // b 1f; li r3, 1; 1: li r4, 2
+                                 {0x48000008, 0x38600001, 0x38800002},
+                                 // bl 1f; 1: bl 2f; 2: mflr r5
+                                 {0x48000005, 0x48000005, 0x7CA802A6},
+                             }));
+}
+
+// Not a pass/fail check; reports how many instructions per second each core gets through on long
+// sequences of all kinds of instructions. Each sequence is run several times, so that the JITs
+// mostly run code they've already compiled, but setting up the state for each run is counted too,
+// so the numbers are only good for comparing cores and changes. Run it with
+// --gtest_also_run_disabled_tests.
+TEST_F(CPUCoreFuzzTest, DISABLED_Throughput)
+{
+  constexpr int PASSES = 20;
+  const std::vector<TestCase> tests = MakeTests(52, OpClass::All, 1000, MAX_INSTRUCTIONS);
+  std::vector<int> cores = CoresToCompare();
+  cores.insert(cores.begin(), PowerPC::CORE_INTERPRETER);
+  for (int core : cores)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    RunAll(core, tests, PASSES);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double instructions = static_cast<double>(tests.size()) * MAX_INSTRUCTIONS * PASSES;
+    RecordProperty(std::string(CoreName(core)) + "InstructionsPerSecond",
+                   std::to_string(instructions / elapsed.count()));
+  }
+}
+
+// JITIL is compared on request only, since it's known to differ from the interpreter: it rounds
+// some single precision results and the doubles it stores with stfs and psq_st differently, and
+// sets FPRF differently.
+TEST_F(CPUCoreFuzzTest, DISABLED_JitILMatchesInterpreter)
+{
+#if _M_X86_64
+  const std::vector<int> jitil = {PowerPC::CORE_JITIL64};
+  CompareCores(MakeTests(46, OpClass::Integer, 200, 32), jitil);
+  CompareCores(MakeTests(47, OpClass::LoadStore, 200, 32), jitil);
+  CompareCores(MakeTests(48, OpClass::FloatingPoint, 200, 32), jitil);
+  CompareCores(MakeTests(49, OpClass::All, 100, MAX_INSTRUCTIONS), jitil);
+#endif
+}
@@ -0,0 +1,202 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <random>
+
+#include "Common/CommonTypes.h"
+#include "Common/MathUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/CoreTiming.h"
+#include "Core/DSP/DSPAccelerator.h"
+#include "Core/DSP/DSPCore.h"
+#include "Core/HW/DSP.h"
+
+namespace
+{
+// Nibble addresses, like the accelerator registers.
+constexpr u32 START_ADDRESS = 0x2000;
+constexpr u32 END_ADDRESS = 0x2000 + 16 * 40 + 9;
+constexpr u32 DATA_BYTES = 16 * 48 / 2;
+
+// A straightforward sample-at-a-time model of the accelerator in ADPCM mode.
+struct ReferenceAccelerator
+{
+  std::array<s16, 16> coefs;
+  u32 address;
+  u16 pred_scale;
+  u16 yn1;
+  u16 yn2;
+
+  u16 Read(bool* loop)
+  {
+    if ((address & 15) == 0)
+    {
+      pred_scale = DSP::ReadARAM(address >> 1);
+      address += 2;
+    }
+    const int scale = 1 << (pred_scale & 0xF);
+    const int coef_idx = (pred_scale >> 4) & 0x7;
+    const u8 byte = DSP::ReadARAM(address >> 1);
+    int nibble = (address & 1) ? (byte & 0xF) : (byte >> 4);
+    if (nibble >= 8)
+      nibble -= 16;
+
+    int val = scale * nibble + ((0x400 + coefs[coef_idx * 2] * static_cast<s16>(yn1) +
+                                 coefs[coef_idx * 2 + 1] * static_cast<s16>(yn2)) >>
+                                11);
+    val = MathUtil::Clamp(val, -0x7FFF, 0x7FFF);
+    yn2 = yn1;
+    yn1 = static_cast<u16>(val);
+    address++;
+
+    // END_ADDRESS & 15 is neither 0 nor 1, so the step size is 2.
+    *loop = address == END_ADDRESS + 1;
+    if (*loop)
+      address = START_ADDRESS;
+    return static_cast<u16>(val);
+  }
+};
+
+class DSPAcceleratorTest : public testing::Test
+{
+protected:
+  DSPAcceleratorTest()
+  {
+    SConfig::Init();
+    CoreTiming::Init();
+    DSP::Init(true);
+    DSP::g_dsp.ifx_regs.fill(0);
+    DSP::g_dsp.exceptions = 0;
+    DSP::dsp_reset_accelerator_prefetch();
+  }
+  ~DSPAcceleratorTest() override
+  {
+    DSP::Shutdown();
+    CoreTiming::Shutdown();
+    SConfig::Shutdown();
+  }
+
+  void Setup(std::mt19937* rng)
+  {
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (u32 i = 0; i < DATA_BYTES; ++i)
+    {
+      // Headers use a valid scale and predictor.
+      const bool header = (i % 8) == 0;
+      DSP::WriteARAM(header ? byte(*rng) & 0x7B : byte(*rng), START_ADDRESS / 2 + i);
+    }
+
+    std::uniform_int_distribution<int> coef(-0x1000, 0x1000);
+    for (size_t i = 0; i < m_reference.coefs.size(); ++i)
+    {
+      m_reference.coefs[i] = coef(*rng);
+      DSP::g_dsp.ifx_regs[DSP::DSP_COEF_A1_0 + i] = m_reference.coefs[i];
+    }
+    DSP::g_dsp.ifx_regs[DSP::DSP_FORMAT] = 0;
+    DSP::g_dsp.ifx_regs[DSP::DSP_ACSAH] = START_ADDRESS >> 16;
+    DSP::g_dsp.ifx_regs[DSP::DSP_ACSAL] = START_ADDRESS & 0xFFFF;
+    DSP::g_dsp.ifx_regs[DSP::DSP_ACEAH] = END_ADDRESS >> 16;
+    DSP::g_dsp.ifx_regs[DSP::DSP_ACEAL] = END_ADDRESS & 0xFFFF;
+    SetAddress(START_ADDRESS);
+    m_reference.pred_scale = m_reference.yn1 = m_reference.yn2 = 0;
+    DSP::dsp_reset_accelerator_prefetch();
+  }
+
+  void SetAddress(u32 address)
+  {
+    m_reference.address = address;
+    DSP::g_dsp.ifx_regs[DSP::DSP_ACCAH] = address >> 16;
+    DSP::g_dsp.ifx_regs[DSP::DSP_ACCAL] = address & 0xFFFF;
+  }
+
+  void ReadAndCompare()
+  {
+    bool loop;
+    const u16 expected = m_reference.Read(&loop);
+    ASSERT_EQ(expected, DSP::dsp_read_accelerator());
+
+    const u32 address =
+        (DSP::g_dsp.ifx_regs[DSP::DSP_ACCAH] << 16) | DSP::g_dsp.ifx_regs[DSP::DSP_ACCAL];
+    ASSERT_EQ(m_reference.address, address);
+    ASSERT_EQ(m_reference.pred_scale, DSP::g_dsp.ifx_regs[DSP::DSP_PRED_SCALE]);
+    ASSERT_EQ(m_reference.yn1, DSP::g_dsp.ifx_regs[DSP::DSP_YN1]);
+    ASSERT_EQ(m_reference.yn2, DSP::g_dsp.ifx_regs[DSP::DSP_YN2]);
+    ASSERT_EQ(loop, (DSP::g_dsp.exceptions & (1 << DSP::EXP_ACCOV)) != 0);
+    DSP::g_dsp.exceptions = 0;
+  }
+
+  ReferenceAccelerator m_reference;
+};
+}
+
+TEST_F(DSPAcceleratorTest, SequentialADPCMMatchesScalarDecode)
+{
+  std::mt19937 rng(1234);
+  Setup(&rng);
+
+  // Several passes through the loop, which ends in the middle of a frame.
+  for (int i = 0; i < 2000; ++i)
+    ASSERT_NO_FATAL_FAILURE(ReadAndCompare());
+}
+
+TEST_F(DSPAcceleratorTest, RegisterChangesBetweenReadsAreHonored)
+{
+  std::mt19937 rng(5678);
+  Setup(&rng);
+
+  std::uniform_int_distribution<int> action(0, 9);
+  std::uniform_int_distribution<int> value(0, 0xFFFF);
+  std::uniform_int_distribution<u32> position(START_ADDRESS, END_ADDRESS - 1);
+  for (int i = 0; i < 5000; ++i)
+  {
+    // Registers poked directly, the way the ucode's own writes land, without telling the
+    // accelerator.
+    switch (action(rng))
+    {
+    case 0:
+      m_reference.yn1 = value(rng);
+      DSP::g_dsp.ifx_regs[DSP::DSP_YN1] = m_reference.yn1;
+      break;
+    case 1:
+      m_reference.yn2 = value(rng);
+      DSP::g_dsp.ifx_regs[DSP::DSP_YN2] = m_reference.yn2;
+      break;
+    case 2:
+      m_reference.pred_scale = value(rng) & 0x7F;
+      DSP::g_dsp.ifx_regs[DSP::DSP_PRED_SCALE] = m_reference.pred_scale;
+      break;
+    case 3:
+    {
+      // Skip header nibbles; real ucodes never point the accelerator at them.
+      u32 address = position(rng);
+      if ((address & 15) < 2)
+        address = (address & ~15) + 2;
+      SetAddress(address);
+      break;
+    }
+    default:
+      break;
+    }
+    ASSERT_NO_FATAL_FAILURE(ReadAndCompare());
+  }
+}
+
+TEST_F(DSPAcceleratorTest, ARAMWritesNeedReset)
+{
+  std::mt19937 rng(42);
+  Setup(&rng);
+  ReadAndCompare();
+
+  // Overwrite the rest of the current frame. Leaving DSPCore_RunCycles resets the prefetch, which
+  // is when the CPU gets a chance to write ARAM.
+  for (u32 i = 2; i < 8; ++i)
+    DSP::WriteARAM(0x77, START_ADDRESS / 2 + i);
+  DSP::dsp_reset_accelerator_prefetch();
+
+  for (int i = 0; i < 20; ++i)
+    ASSERT_NO_FATAL_FAILURE(ReadAndCompare());
+}
@@ -0,0 +1,315 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Checks that the pages which the page table mirrors into the logical view hold the same data as
+// what the slow path translates the address to, as the MMU state changes.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/Memmap.h"
+#include "Core/MemTools.h"
+#include "Core/PowerPC/PowerPC.h"
+
+namespace
+{
+// A table of the smallest size, which every hash lands in
+constexpr u32 PAGE_TABLE_ADDRESS = 0x00800000;
+constexpr u32 PAGE_SIZE = 0x1000;
+
+constexpr u32 PTE1_V = 0x80000000;
+constexpr u32 PTE2_R = 0x100;
+constexpr u32 PTE2_C = 0x80;
+constexpr u32 PTE2_PP_READ_WRITE = 2;
+
+constexpr u32 VSID_A = 0x123;
+constexpr u32 VSID_B = 0x456;
+
+bool PageTableMappingsSupported()
+{
+#if defined(_WIN32) || defined(_ARCH_32)
+  return false;
+#else
+  return sysconf(_SC_PAGESIZE) == PAGE_SIZE;
+#endif
+}
+
+// Fills a physical page with words that tell it apart from every other page.
+void FillPage(u32 physical_address)
+{
+  for (u32 offset = 0; offset < PAGE_SIZE; offset += 4)
+    Memory::Write_U32(physical_address | offset, physical_address + offset);
+}
+
+// Adds an entry to the primary PTEG of a page and returns its address.
+u32 AddPTE(u32 effective_address, u32 vsid, u32 physical_address, bool referenced, bool changed)
+{
+  const u32 page_index = (effective_address >> 12) & 0xFFFF;
+  u32 pte_address = PAGE_TABLE_ADDRESS | (((vsid ^ page_index) & 0x3FF) << 6);
+  while (Memory::Read_U32(pte_address) & PTE1_V)
+    pte_address += 8;
+
+  const u32 pte1 = PTE1_V | (vsid << 7) | (page_index >> 10);
+  const u32 pte2 = (physical_address & ~(PAGE_SIZE - 1)) | (referenced ? PTE2_R : 0) |
+                   (changed ? PTE2_C : 0) | PTE2_PP_READ_WRITE;
+  Memory::Write_U32(pte1, pte_address);
+  Memory::Write_U32(pte2, pte_address + 4);
+  return pte_address;
+}
+
+u32 FastmemRead(u32 effective_address)
+{
+  return Common::swap32(*reinterpret_cast<u32*>(Memory::logical_base + effective_address));
+}
+
+void FastmemWrite(u32 value, u32 effective_address)
+{
+  *reinterpret_cast<u32*>(Memory::logical_base + effective_address) = Common::swap32(value);
+}
+
+// Checks that reads and writes through the mirror of a page agree with the slow path.
+void ExpectMirrorMatchesSlowPath(u32 effective_address)
+{
+  ASSERT_TRUE(Memory::IsPageTableMapped(effective_address));
+  for (u32 offset : {0u, 0x800u, PAGE_SIZE - 4})
+  {
+    const u32 address = effective_address | offset;
+    EXPECT_EQ(PowerPC::HostRead_U32(address), FastmemRead(address));
+
+    FastmemWrite(~address, address);
+    EXPECT_EQ(~address, PowerPC::HostRead_U32(address));
+    PowerPC::HostWrite_U32(address, address);
+    EXPECT_EQ(address, FastmemRead(address));
+  }
+}
+}  // namespace
+
+class MMUTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    Core::DeclareAsCPUThread();
+    SConfig::Init();
+    SConfig::GetInstance().bMMU = true;
+    EMM::InstallExceptionHandler();
+    Memory::Init();
+    PowerPC::Init(PowerPC::CORE_INTERPRETER);
+    CoreTiming::Init();
+
+    for (u32 page = 0x00900000; page < 0x00940000; page += PAGE_SIZE)
+      FillPage(page);
+
+    PowerPC::ppcState.spr[SPR_SDR] = PAGE_TABLE_ADDRESS;
+    PowerPC::SDRUpdated();
+    SetSR(4, VSID_A);
+    SetSR(5, VSID_B);
+    // IR and DR
+    MSR = 0x00000030;
+  }
+
+  void TearDown() override
+  {
+    CoreTiming::Shutdown();
+    PowerPC::Shutdown();
+    Memory::Shutdown();
+    EMM::UninstallExceptionHandler();
+    SConfig::Shutdown();
+    Core::UndeclareAsCPUThread();
+  }
+
+  static void SetSR(int index, u32 value)
+  {
+    PowerPC::ppcState.sr[index] = value;
+    PowerPC::SRUpdated(index);
+  }
+};
+
+TEST_F(MMUTest, MirrorsReferencedAndChangedPages)
+{
+  if (!PageTableMappingsSupported())
+    return;
+
+  AddPTE(0x40000000, VSID_A, 0x00900000, true, true);
+  AddPTE(0x40001000, VSID_A, 0x00901000, true, false);
+  AddPTE(0x5ABCD000, VSID_B, 0x00902000, true, true);
+  EXPECT_FALSE(Memory::IsPageTableMapped(0x40000000));
+
+  PowerPC::CheckExceptions();
+  ExpectMirrorMatchesSlowPath(0x40000000);
+  ExpectMirrorMatchesSlowPath(0x5ABCD000);
+  EXPECT_FALSE(Memory::IsPageTableMapped(0x40001000));
+
+  // A write through the slow path sets the C bit, after which the page can be mirrored
+  PowerPC::Write_U32(0x12345678, 0x40001004);
+  ExpectMirrorMatchesSlowPath(0x40001000);
+  EXPECT_EQ(0x12345678U, FastmemRead(0x40001004));
+}
+
+TEST_F(MMUTest, SegmentRegisterChangeOnlyAffectsItsSegment)
+{
+  if (!PageTableMappingsSupported())
+    return;
+
+  AddPTE(0x40000000, VSID_A, 0x00900000, true, true);
+  AddPTE(0x50000000, VSID_B, 0x00901000, true, true);
+  PowerPC::CheckExceptions();
+  ASSERT_TRUE(Memory::IsPageTableMapped(0x40000000));
+  ASSERT_TRUE(Memory::IsPageTableMapped(0x50000000));
+
+  // Segment 4 now uses the VSID of segment 5
+  SetSR(4, VSID_B);
+  EXPECT_FALSE(Memory::IsPageTableMapped(0x40000000));
+  EXPECT_TRUE(Memory::IsPageTableMapped(0x50000000));
+
+  PowerPC::CheckExceptions();
+  ExpectMirrorMatchesSlowPath(0x40000000);
+  ExpectMirrorMatchesSlowPath(0x50000000);
+  EXPECT_EQ(FastmemRead(0x50000000), FastmemRead(0x40000000));
+
+  // Direct store segments aren't translated through the page table
+  SetSR(4, 0x80000000);
+  PowerPC::CheckExceptions();
+  EXPECT_FALSE(Memory::IsPageTableMapped(0x40000000));
+  EXPECT_TRUE(Memory::IsPageTableMapped(0x50000000));
+}
+
+TEST_F(MMUTest, TLBInvalidationUpdatesChangedEntry)
+{
+  if (!PageTableMappingsSupported())
+    return;
+
+  const u32 pte_address = AddPTE(0x40003000, VSID_A, 0x00900000, true, true);
+  PowerPC::CheckExceptions();
+  ExpectMirrorMatchesSlowPath(0x40003000);
+
+  // Point the entry at another page
+  const u32 pte2 = Memory::Read_U32(pte_address + 4);
+  Memory::Write_U32((pte2 & (PAGE_SIZE - 1)) | 0x00903000, pte_address + 4);
+  PowerPC::InvalidateTLBEntry(0x40003000);
+  ASSERT_TRUE(Memory::IsPageTableMapped(0x40003000));
+  EXPECT_EQ(0x00903000U, FastmemRead(0x40003000));
+  ExpectMirrorMatchesSlowPath(0x40003000);
+
+  // And remove it
+  Memory::Write_U32(0, pte_address);
+  PowerPC::InvalidateTLBEntry(0x40003000);
+  EXPECT_FALSE(Memory::IsPageTableMapped(0x40003000));
+}
+
+TEST_F(MMUTest, BATsTakePrecedence)
+{
+  if (!PageTableMappingsSupported())
+    return;
+
+  AddPTE(0x40000000, VSID_A, 0x00900000, true, true);
+  AddPTE(0x50000000, VSID_B, 0x00901000, true, true);
+  PowerPC::CheckExceptions();
+  ASSERT_TRUE(Memory::IsPageTableMapped(0x40000000));
+
+  // 128 KiB at 0x40000000, backed by different memory than the page table entry
+  PowerPC::ppcState.spr[SPR_DBAT0U] = 0x40000002;
+  PowerPC::ppcState.spr[SPR_DBAT0L] = 0x00920002;
+  PowerPC::DBATUpdated();
+  EXPECT_FALSE(Memory::IsPageTableMapped(0x40000000));
+  EXPECT_TRUE(Memory::IsPageTableMapped(0x50000000));
+
+  PowerPC::CheckExceptions();
+  EXPECT_FALSE(Memory::IsPageTableMapped(0x40000000));
+  EXPECT_EQ(PowerPC::HostRead_U32(0x40000000), FastmemRead(0x40000000));
+  EXPECT_EQ(0x00920000U, PowerPC::HostRead_U32(0x40000000));
+
+  // Once the BAT is gone, the page table applies again
+  PowerPC::ppcState.spr[SPR_DBAT0U] = 0;
+  PowerPC::DBATUpdated();
+  PowerPC::CheckExceptions();
+  ASSERT_TRUE(Memory::IsPageTableMapped(0x40000000));
+  EXPECT_EQ(0x00900000U, FastmemRead(0x40000000));
+  ExpectMirrorMatchesSlowPath(0x40000000);
+}
+
+TEST_F(MMUTest, RemovedPagesStayReserved)
+{
+  if (!PageTableMappingsSupported())
+    return;
+
+  const u32 pte_address = AddPTE(0x40003000, VSID_A, 0x00900000, true, true);
+  PowerPC::CheckExceptions();
+  ASSERT_TRUE(Memory::IsPageTableMapped(0x40003000));
+  Memory::Write_U32(0, pte_address);
+  PowerPC::InvalidateTLBEntry(0x40003000);
+  ASSERT_FALSE(Memory::IsPageTableMapped(0x40003000));
+
+#ifndef _WIN32
+  // The kernel only uses the hint if nothing is mapped there
+  u8* const page = Memory::logical_base + 0x40003000;
+  void* const other = mmap(page, PAGE_SIZE, PROT_READ, MAP_PRIVATE | MAP_ANON, -1, 0);
+  ASSERT_NE(MAP_FAILED, other);
+  EXPECT_NE(page, other);
+  munmap(other, PAGE_SIZE);
+#endif
+}
+
+// Not run by default. Compares reads of page table mapped memory through the slow path with
+// reads through the mirror, and times how long updating the mirror of a page takes.
+TEST_F(MMUTest, DISABLED_Benchmark)
+{
+  if (!PageTableMappingsSupported())
+    return;
+
+  constexpr u32 NUM_PAGES = 64;
+  constexpr u32 NUM_READS = 1 << 22;
+  constexpr u32 NUM_REMAPS = 1 << 14;
+  std::vector<u32> pte_addresses;
+  for (u32 i = 0; i < NUM_PAGES; ++i)
+  {
+    pte_addresses.push_back(
+        AddPTE(0x40000000 + i * PAGE_SIZE, VSID_A, 0x00900000 + i * PAGE_SIZE, true, true));
+  }
+  PowerPC::CheckExceptions();
+  ASSERT_TRUE(Memory::IsPageTableMapped(0x40000000 + (NUM_PAGES - 1) * PAGE_SIZE));
+
+  u32 slow_sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (u32 i = 0; i < NUM_READS; ++i)
+    slow_sum += PowerPC::Read_U32(0x40000000 + i * 4 % (NUM_PAGES * PAGE_SIZE));
+  const std::chrono::duration<double, std::nano> slow = std::chrono::steady_clock::now() - start;
+
+  u32 fastmem_sum = 0;
+  start = std::chrono::steady_clock::now();
+  for (u32 i = 0; i < NUM_READS; ++i)
+    fastmem_sum += FastmemRead(0x40000000 + i * 4 % (NUM_PAGES * PAGE_SIZE));
+  const std::chrono::duration<double, std::nano> fastmem =
+      std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(slow_sum, fastmem_sum);
+
+  // Every update releases the old view of the page and creates a new one
+  start = std::chrono::steady_clock::now();
+  for (u32 i = 0; i < NUM_REMAPS; ++i)
+  {
+    const u32 page = i % NUM_PAGES;
+    const u32 pte2 = Memory::Read_U32(pte_addresses[page] + 4);
+    Memory::Write_U32(pte2 ^ PAGE_SIZE, pte_addresses[page] + 4);
+    PowerPC::InvalidateTLBEntry(0x40000000 + page * PAGE_SIZE);
+  }
+  const std::chrono::duration<double, std::nano> remap = std::chrono::steady_clock::now() - start;
+  EXPECT_TRUE(Memory::IsPageTableMapped(0x40000000));
+
+  RecordProperty("SlowPathNsPerRead", std::to_string(slow.count() / NUM_READS));
+  RecordProperty("FastmemNsPerRead", std::to_string(fastmem.count() / NUM_READS));
+  RecordProperty("RemapNsPerPage", std::to_string(remap.count() / NUM_REMAPS));
+}
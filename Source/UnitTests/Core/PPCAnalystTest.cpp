@@ -0,0 +1,142 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "Common/BitSet.h"
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/PPCAnalyst.h"
+#include "Core/PowerPC/PowerPC.h"
+
+namespace
+{
+constexpr u32 CODE_ADDRESS = 0x00003000;
+constexpr u32 BLOCK_SIZE = 100;
+
+using Options = std::vector<PPCAnalyst::PPCAnalyzer::AnalystOption>;
+
+// What Jit64::EnableOptimization, JitArm64::Init and CachedInterpreter::Init set
+const Options JIT64_OPTIONS = {PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE,
+                               PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_MERGE,
+                               PPCAnalyst::PPCAnalyzer::OPTION_CROR_MERGE,
+                               PPCAnalyst::PPCAnalyzer::OPTION_CARRY_MERGE,
+                               PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW};
+const Options JITARM64_OPTIONS = {PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE,
+                                  PPCAnalyst::PPCAnalyzer::OPTION_CARRY_MERGE,
+                                  PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW};
+const Options CACHEDINTERPRETER_OPTIONS = {PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW};
+}  // namespace
+
+class PPCAnalystTest : public testing::Test
+{
+protected:
+  PPCAnalystTest() : m_buffer(BLOCK_SIZE)
+  {
+    m_block.m_stats = &m_stats;
+    m_block.m_gpa = &m_gpa;
+    m_block.m_fpa = &m_fpa;
+  }
+
+  void SetUp() override
+  {
+    Core::DeclareAsCPUThread();
+    SConfig::Init();
+    Memory::Init();
+    PowerPC::Init(PowerPC::CORE_INTERPRETER);
+    CoreTiming::Init();
+    // Untranslated, so that the code is read from its physical address
+    MSR = 0;
+  }
+
+  void TearDown() override
+  {
+    CoreTiming::Shutdown();
+    PowerPC::Shutdown();
+    Memory::Shutdown();
+    SConfig::Shutdown();
+    Core::UndeclareAsCPUThread();
+  }
+
+  // Analyzes the code like a core that sets the given options would, and returns the indices of
+  // the instructions that got marked as the branch of an idle loop.
+  std::vector<u32> FindIdleLoopBranches(const Options& options, const std::vector<u32>& code)
+  {
+    for (size_t i = 0; i < code.size(); ++i)
+      Memory::Write_U32(code[i], CODE_ADDRESS + 4 * static_cast<u32>(i));
+
+    PPCAnalyst::PPCAnalyzer analyzer;
+    for (PPCAnalyst::PPCAnalyzer::AnalystOption option : options)
+      analyzer.SetOption(option);
+    analyzer.Analyze(CODE_ADDRESS, &m_block, &m_buffer, BLOCK_SIZE);
+
+    std::vector<u32> branches;
+    for (u32 i = 0; i < m_block.m_num_instructions; ++i)
+    {
+      if (m_buffer.codebuffer[i].branchIsIdleLoop)
+        branches.push_back(i);
+    }
+    return branches;
+  }
+
+  const PPCAnalyst::CodeOp& AnalyzeOne(u32 inst)
+  {
+    FindIdleLoopBranches({}, {inst, 0x4E800020});
+    return m_buffer.codebuffer[0];
+  }
+
+  PPCAnalyst::CodeBlock m_block;
+  PPCAnalyst::CodeBuffer m_buffer;
+  PPCAnalyst::BlockStats m_stats;
+  PPCAnalyst::BlockRegStats m_gpa;
+  PPCAnalyst::BlockRegStats m_fpa;
+};
+
+TEST_F(PPCAnalystTest, FindsIdleLoopWithEveryCoresOptions)
+{
+  // lwz r0, -0x5000(r13); cmpwi r0, 0; beq -8; blr
+  const std::vector<u32> code = {0x800DB000, 0x2C000000, 0x4182FFF8, 0x4E800020};
+  for (const Options& options : {JIT64_OPTIONS, JITARM64_OPTIONS, CACHEDINTERPRETER_OPTIONS})
+    EXPECT_EQ(std::vector<u32>{2}, FindIdleLoopBranches(options, code));
+
+  // A loop that ends the block with an unconditional branch back to the start
+  // lwz r3, 0(r4); rlwinm r5, r3, 0, 24, 31; b -8
+  EXPECT_EQ(std::vector<u32>{2},
+            FindIdleLoopBranches(JIT64_OPTIONS, {0x80640000, 0x5465063E, 0x4BFFFFF8}));
+}
+
+TEST_F(PPCAnalystTest, IgnoresLoopsThatChangeState)
+{
+  for (const Options& options : {JIT64_OPTIONS, JITARM64_OPTIONS, CACHEDINTERPRETER_OPTIONS})
+  {
+    // lwz r0, -0x5000(r13); stw r0, 4(r13); cmpwi r0, 0; beq -12; blr
+    EXPECT_EQ(std::vector<u32>{},
+              FindIdleLoopBranches(options, {0x800DB000, 0x900D0004, 0x2C000000, 0x4182FFF4,
+                                             0x4E800020}));
+    // addi r3, r3, 1; cmpwi r3, 100; blt -8; blr
+    EXPECT_EQ(std::vector<u32>{},
+              FindIdleLoopBranches(options, {0x38630001, 0x2C030064, 0x4180FFF8, 0x4E800020}));
+    // lwzu r0, 4(r3); cmpwi r0, 0; beq -8; blr
+    EXPECT_EQ(std::vector<u32>{},
+              FindIdleLoopBranches(options, {0x84030004, 0x2C000000, 0x4182FFF8, 0x4E800020}));
+    // lwz r0, -0x5000(r13); cmpwi r0, 0; bdnz -8; blr
+    EXPECT_EQ(std::vector<u32>{},
+              FindIdleLoopBranches(options, {0x800DB000, 0x2C000000, 0x4200FFF8, 0x4E800020}));
+  }
+}
+
+TEST_F(PPCAnalystTest, StringLoadsWriteEveryLoadedRegister)
+{
+  // lswi r30, r3, 12 loads r30, r31 and r0
+  EXPECT_EQ(BitSet32({30, 31, 0}), AnalyzeOne(0x7FC364AA).regsOut);
+  // lswi r5, r3, 0 loads 32 bytes
+  EXPECT_EQ(BitSet32({5, 6, 7, 8, 9, 10, 11, 12}), AnalyzeOne(0x7CA304AA).regsOut);
+  // lswx r5, r3, r4 loads as many bytes as XER says
+  EXPECT_EQ(BitSet32::AllTrue(32), AnalyzeOne(0x7CA3242A).regsOut);
+}
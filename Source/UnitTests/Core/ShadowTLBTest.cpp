@@ -0,0 +1,164 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+// gtest's TEST macro conflicts with the TEST method in the x64Emitter, and only TEST_F is used
+// here.
+#undef TEST
+
+#include "Common/CommonTypes.h"
+#include "Common/x64ABI.h"
+#include "Core/ConfigManager.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/Jit64Common/EmuCodeBlock.h"
+#include "Core/PowerPC/PowerPC.h"
+
+using namespace Gen;
+
+namespace
+{
+constexpr u32 PAGE_ADDRESS = 0x40005000;
+constexpr u32 PHYSICAL_PAGE_ADDRESS = 0x00123000;
+// An address that uses the same shadow TLB entry as PAGE_ADDRESS
+constexpr u32 ALIASED_PAGE_ADDRESS = PAGE_ADDRESS + (PowerPC::SHADOW_TLB_SIZE << 12);
+
+// A function that returns where the code that the JIT emits for an access of the given size to
+// its argument goes on a shadow TLB hit, or null on a miss.
+class ShadowTLBLookupFunction final : public EmuCodeBlock
+{
+public:
+  ShadowTLBLookupFunction(int access_size, bool write)
+  {
+    AllocCodeSpace(4096);
+    m_function = reinterpret_cast<u8* (*)(u32)>(const_cast<u8*>(GetCodePtr()));
+
+    OpArg host_address;
+    FixupBranch miss;
+    EXPECT_TRUE(ShadowTLBLookup(ABI_PARAM1, access_size, write, BitSet32{}, INVALID_REG,
+                                &host_address, &miss));
+    LEA(64, ABI_RETURN, host_address);
+    RET();
+    SetJumpTarget(miss);
+    XOR(32, R(ABI_RETURN), R(ABI_RETURN));
+    RET();
+  }
+
+  ~ShadowTLBLookupFunction() { FreeCodeSpace(); }
+
+  u8* operator()(u32 address) const { return m_function(address); }
+
+private:
+  u8* (*m_function)(u32);
+};
+
+u8* HostAddress(u32 physical_address)
+{
+  return Memory::physical_base + physical_address;
+}
+}  // namespace
+
+class ShadowTLBTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    SConfig::Init();
+    SConfig::GetInstance().bMMU = true;
+    Memory::Init();
+    PowerPC::ppcState = {};
+    PowerPC::shadow_dtlb = {};
+    PowerPC::shadow_itlb = {};
+  }
+
+  void TearDown() override
+  {
+    PowerPC::shadow_dtlb = {};
+    Memory::Shutdown();
+    SConfig::Shutdown();
+  }
+
+  static PowerPC::ShadowTLBEntry& EntryFor(u32 address)
+  {
+    return PowerPC::shadow_dtlb[(address >> 12) & (PowerPC::SHADOW_TLB_SIZE - 1)];
+  }
+
+  // Like the MMU does after translating an access to a page whose C bit is set or not
+  static void AddEntry(u32 address, u32 physical_address, bool changed)
+  {
+    PowerPC::ShadowTLBEntry& entry = EntryFor(address);
+    entry.read_tag = address;
+    entry.write_tag = changed ? address : PowerPC::SHADOW_TLB_TAG_INVALID;
+    entry.paddr = physical_address;
+  }
+};
+
+TEST_F(ShadowTLBTest, Hit)
+{
+  AddEntry(PAGE_ADDRESS, PHYSICAL_PAGE_ADDRESS, true);
+
+  for (int access_size : {8, 16, 32, 64})
+  {
+    const ShadowTLBLookupFunction read(access_size, false);
+    const ShadowTLBLookupFunction write(access_size, true);
+    for (u32 offset : {0x000u, 0x008u, 0xFF8u})
+    {
+      EXPECT_EQ(HostAddress(PHYSICAL_PAGE_ADDRESS + offset), read(PAGE_ADDRESS + offset));
+      EXPECT_EQ(HostAddress(PHYSICAL_PAGE_ADDRESS + offset), write(PAGE_ADDRESS + offset));
+    }
+  }
+
+  // Byte accesses can't cross into the next page
+  EXPECT_EQ(HostAddress(PHYSICAL_PAGE_ADDRESS + 0xFFF),
+            ShadowTLBLookupFunction(8, false)(PAGE_ADDRESS + 0xFFF));
+}
+
+TEST_F(ShadowTLBTest, Miss)
+{
+  const ShadowTLBLookupFunction read(32, false);
+  const ShadowTLBLookupFunction write(32, true);
+
+  // Nothing has been added yet
+  EXPECT_EQ(nullptr, read(PAGE_ADDRESS));
+  EXPECT_EQ(nullptr, write(PAGE_ADDRESS));
+
+  // Writes have to wait for the C bit
+  AddEntry(PAGE_ADDRESS, PHYSICAL_PAGE_ADDRESS, false);
+  EXPECT_EQ(HostAddress(PHYSICAL_PAGE_ADDRESS), read(PAGE_ADDRESS));
+  EXPECT_EQ(nullptr, write(PAGE_ADDRESS));
+
+  // Another page with the same index only differs in the tag
+  EXPECT_EQ(nullptr, read(ALIASED_PAGE_ADDRESS));
+
+  // Misaligned accesses might cross into the next page, so they always miss
+  EXPECT_EQ(nullptr, read(PAGE_ADDRESS + 0x2));
+  EXPECT_EQ(nullptr, read(PAGE_ADDRESS + 0xFFE));
+  EXPECT_EQ(nullptr, ShadowTLBLookupFunction(16, false)(PAGE_ADDRESS + 0xFFF));
+  EXPECT_EQ(nullptr, ShadowTLBLookupFunction(64, false)(PAGE_ADDRESS + 0xFFC));
+}
+
+TEST_F(ShadowTLBTest, Invalidate)
+{
+  const ShadowTLBLookupFunction read(32, false);
+  const ShadowTLBLookupFunction write(32, true);
+
+  AddEntry(PAGE_ADDRESS, PHYSICAL_PAGE_ADDRESS, true);
+  PowerPC::InvalidateTLBEntry(PAGE_ADDRESS);
+  EXPECT_EQ(nullptr, read(PAGE_ADDRESS));
+  EXPECT_EQ(nullptr, write(PAGE_ADDRESS));
+
+  // tlbie doesn't take the segment into account, so it also drops other pages with the same index
+  AddEntry(ALIASED_PAGE_ADDRESS, PHYSICAL_PAGE_ADDRESS, true);
+  PowerPC::InvalidateTLBEntry(PAGE_ADDRESS);
+  EXPECT_EQ(nullptr, read(ALIASED_PAGE_ADDRESS));
+
+  AddEntry(PAGE_ADDRESS, PHYSICAL_PAGE_ADDRESS, true);
+  PowerPC::ppcState.sr[7] = 0x123;
+  PowerPC::SRUpdated(7);
+  EXPECT_EQ(nullptr, read(PAGE_ADDRESS));
+
+  AddEntry(PAGE_ADDRESS, PHYSICAL_PAGE_ADDRESS, true);
+  PowerPC::DBATUpdated();
+  EXPECT_EQ(nullptr, write(PAGE_ADDRESS));
+}
@@ -0,0 +1,142 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/CompressedBlob.h"
+
+namespace
+{
+constexpr int BLOCK_SIZE = 0x4000;
+constexpr u64 NUM_BLOCKS = 100;
+
+class CompressedBlobTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // Alternate between compressible runs and random data, so that the image has both
+    // compressed blocks and blocks that are stored as-is.
+    std::mt19937 rng(99);
+    m_data.resize(NUM_BLOCKS * BLOCK_SIZE);
+    for (u64 block = 0; block < NUM_BLOCKS; ++block)
+    {
+      for (u64 i = 0; i < BLOCK_SIZE; ++i)
+      {
+        const u64 offset = block * BLOCK_SIZE + i;
+        m_data[offset] = block % 3 == 0 ? static_cast<u8>(rng()) : static_cast<u8>(offset / 100);
+      }
+    }
+
+    m_temp_dir = File::CreateTempDir();
+    ASSERT_FALSE(m_temp_dir.empty());
+    const std::string iso_path = m_temp_dir + DIR_SEP "image.iso";
+    const std::string gcz_path = m_temp_dir + DIR_SEP "image.gcz";
+    ASSERT_TRUE(File::IOFile(iso_path, "wb").WriteBytes(m_data.data(), m_data.size()));
+    ASSERT_TRUE(DiscIO::CompressFileToBlob(iso_path, gcz_path, 0, BLOCK_SIZE,
+                                           [](const std::string&, float, void*) { return true; }));
+
+    m_reader = DiscIO::CreateBlobReader(gcz_path);
+    ASSERT_NE(nullptr, m_reader);
+    ASSERT_EQ(DiscIO::BlobType::GCZ, m_reader->GetBlobType());
+  }
+
+  void TearDown() override
+  {
+    m_reader.reset();
+    File::DeleteDirRecursively(m_temp_dir);
+  }
+
+  void ExpectRead(u64 offset, u64 size)
+  {
+    std::vector<u8> buffer(size);
+    ASSERT_TRUE(m_reader->Read(offset, size, buffer.data()));
+    EXPECT_EQ(0, memcmp(&m_data[offset], buffer.data(), size)) << offset << " " << size;
+  }
+
+  std::vector<u8> m_data;
+  std::string m_temp_dir;
+  std::unique_ptr<DiscIO::IBlobReader> m_reader;
+};
+}
+
+TEST_F(CompressedBlobTest, ReadsWholeImage)
+{
+  ExpectRead(0, m_data.size());
+}
+
+TEST_F(CompressedBlobTest, ReadsMatchOriginal)
+{
+  std::mt19937 rng(3);
+  for (int i = 0; i < 500; ++i)
+  {
+    // Mix small reads with ones large enough to be decompressed in parallel, some of which
+    // start or end in blocks that earlier reads left in the cache.
+    const u64 max_size = i % 4 == 0 ? 40 * BLOCK_SIZE : 0x2000;
+    const u64 size = 1 + rng() % max_size;
+    const u64 offset = rng() % (m_data.size() - size);
+    ExpectRead(offset, size);
+  }
+}
+
+TEST_F(CompressedBlobTest, FailsPastEnd)
+{
+  std::vector<u8> buffer(8 * BLOCK_SIZE);
+  EXPECT_FALSE(m_reader->Read(m_data.size() - 4 * BLOCK_SIZE, buffer.size(), buffer.data()));
+  EXPECT_FALSE(m_reader->Read(m_data.size(), BLOCK_SIZE, buffer.data()));
+}
+
+TEST_F(CompressedBlobTest, CacheKeepsWorkingSet)
+{
+  constexpr u64 READ_SIZE = 0x800;
+  constexpr u64 READS_PER_BLOCK = BLOCK_SIZE / READ_SIZE;
+  constexpr u64 NUM_READS = 4 * NUM_BLOCKS * READS_PER_BLOCK;
+  std::vector<u8> buffer(READ_SIZE);
+
+  const auto open_with_capacity = [this](u32 capacity) {
+    std::unique_ptr<DiscIO::IBlobReader> reader =
+        DiscIO::CreateBlobReader(m_temp_dir + DIR_SEP "image.gcz");
+    static_cast<DiscIO::SectorReader*>(reader.get())->SetCacheCapacity(capacity);
+    return reader;
+  };
+  const auto stats_of = [](const std::unique_ptr<DiscIO::IBlobReader>& reader) {
+    return static_cast<DiscIO::SectorReader*>(reader.get())->GetCacheStats();
+  };
+
+  // Streaming through an image larger than the cache reads every block exactly once per pass.
+  std::unique_ptr<DiscIO::IBlobReader> reader = open_with_capacity(32);
+  for (u64 i = 0; i < NUM_READS; ++i)
+  {
+    const u64 offset = i % (NUM_BLOCKS * READS_PER_BLOCK) * READ_SIZE;
+    ASSERT_TRUE(reader->Read(offset, READ_SIZE, buffer.data()));
+    EXPECT_EQ(0, memcmp(&m_data[offset], buffer.data(), READ_SIZE)) << offset;
+  }
+  DiscIO::SectorReader::CacheStats stats = stats_of(reader);
+  EXPECT_EQ(NUM_READS / READS_PER_BLOCK, stats.misses);
+  EXPECT_EQ(NUM_READS - NUM_READS / READS_PER_BLOCK, stats.hits);
+
+  // Once the whole image fits, random reads only miss the first time a block is seen.
+  reader = open_with_capacity(128);
+  std::mt19937 rng(5);
+  for (u64 i = 0; i < NUM_READS; ++i)
+  {
+    const u64 offset = rng() % (m_data.size() / READ_SIZE) * READ_SIZE;
+    ASSERT_TRUE(reader->Read(offset, READ_SIZE, buffer.data()));
+    EXPECT_EQ(0, memcmp(&m_data[offset], buffer.data(), READ_SIZE)) << offset;
+  }
+  stats = stats_of(reader);
+  EXPECT_LE(stats.misses, NUM_BLOCKS);
+  EXPECT_EQ(0u, stats.evictions);
+  EXPECT_EQ(NUM_READS, stats.hits + stats.misses);
+}
@@ -0,0 +1,342 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/CompressedBlob.h"
+#include "DiscIO/DiscScrubber.h"
+
+namespace
+{
+constexpr u64 CLUSTER_SIZE = DiscIO::DiscScrubber::CLUSTER_SIZE;
+constexpr u64 DISC_SIZE = 256 * CLUSTER_SIZE;
+constexpr u32 DOL_OFFSET = 0x10000;
+constexpr u32 FST_OFFSET = 0x20000;
+
+struct FakeFile
+{
+  const char* name;
+  u32 offset;
+  u32 size;
+};
+
+// Random data that doesn't compress, and something that compresses well
+constexpr FakeFile FILES[] = {
+    {"movie.thp", 0x100000, 0x120000},
+    {"small.bin", 0x308000, 0x100},
+    {"text.txt", 0x500000, 0x40000},
+};
+
+// An unused cluster that holds random data instead of junk, which must be kept as it is
+constexpr u64 GARBAGE_OFFSET = 0x600000;
+
+// Generates junk the way it's described rather than with DiscIO::LaggedFibonacciGenerator, so
+// that the test doesn't depend on the code it checks: the 17 seed words are expanded to 521,
+// every word after that is x[n - 521] ^ x[n - 32], and output starts at word 4 * 521. Every
+// word is written big endian with bits 16-23 replaced by bits 18-25.
+void GenerateReferenceJunk(const std::array<u32, 17>& seed, u8* out, size_t size)
+{
+  constexpr size_t K = 521;
+  constexpr size_t J = 32;
+  constexpr size_t FIRST_OUTPUT_WORD = 4 * K;
+
+  std::vector<u32> x(FIRST_OUTPUT_WORD + (size + 3) / 4);
+  std::copy(seed.begin(), seed.end(), x.begin());
+  for (size_t n = seed.size(); n < K; ++n)
+    x[n] = (x[n - 17] << 23) ^ (x[n - 16] >> 9) ^ x[n - 1];
+  for (size_t n = K; n < x.size(); ++n)
+    x[n] = x[n - K] ^ x[n - J];
+
+  for (size_t i = 0; i < size; ++i)
+  {
+    const u32 word = x[FIRST_OUTPUT_WORD + i / 4];
+    const u32 output = (word & 0xFF00FFFF) | ((word >> 2) & 0x00FF0000);
+    out[i] = static_cast<u8>(output >> (24 - 8 * (i % 4)));
+  }
+}
+
+struct RawJunkTable
+{
+  u32 header_magic = 0;
+  u32 magic = 0;
+  // Where the regions start in the file
+  u64 regions_offset = 0;
+  std::vector<DiscIO::DiscScrubber::JunkRegion> regions;
+};
+
+u32 ReadLE32(const u8* data)
+{
+  return data[0] | data[1] << 8 | data[2] << 16 | static_cast<u32>(data[3]) << 24;
+}
+
+// Reads the junk table straight from the file, like a reader that doesn't use DiscIO would.
+RawJunkTable ReadJunkTable(const std::string& gcz_path)
+{
+  RawJunkTable table;
+  File::IOFile file(gcz_path, "rb");
+  DiscIO::CompressedBlobHeader header;
+  if (!file.ReadArray(&header, 1))
+    return table;
+  table.header_magic = header.magic_cookie;
+
+  u8 table_header[8];
+  file.Seek(sizeof(header) + (sizeof(u64) + sizeof(u32)) * header.num_blocks +
+                header.compressed_data_size,
+            SEEK_SET);
+  if (!file.ReadBytes(table_header, sizeof(table_header)))
+    return table;
+  table.magic = ReadLE32(table_header);
+  table.regions_offset = file.Tell();
+
+  // u64 offset, u32 size and 17 seed words, all little endian
+  std::array<u8, 80> raw;
+  for (u32 i = 0; i < ReadLE32(table_header + 4) && file.ReadBytes(raw.data(), raw.size()); ++i)
+  {
+    DiscIO::DiscScrubber::JunkRegion region;
+    region.offset = ReadLE32(&raw[0]) | u64{ReadLE32(&raw[4])} << 32;
+    region.size = ReadLE32(&raw[8]);
+    for (size_t j = 0; j < region.seed.size(); ++j)
+      region.seed[j] = ReadLE32(&raw[12 + j * 4]);
+    table.regions.push_back(region);
+  }
+  return table;
+}
+
+class DiscScrubberTest : public testing::Test
+{
+protected:
+  // Builds a GameCube disc that is padded like a real one: every cluster starts a new stretch
+  // of junk, which shows up after the header, the DOL, the FST and the ends of files as well as
+  // in the clusters that nothing uses.
+  void SetUp() override
+  {
+    std::mt19937 rng(37);
+    m_data.resize(DISC_SIZE);
+    for (u64 offset = 0; offset < DISC_SIZE; offset += CLUSTER_SIZE)
+    {
+      std::array<u32, 17> seed;
+      for (u32& word : seed)
+        word = rng();
+      GenerateReferenceJunk(seed, &m_data[offset], CLUSTER_SIZE);
+    }
+    for (u64 i = 0; i < CLUSTER_SIZE; ++i)
+      m_data[GARBAGE_OFFSET + i] = static_cast<u8>(rng());
+
+    std::fill(m_data.begin(), m_data.begin() + 0x2460, 0);
+    std::memcpy(m_data.data(), "GSCR01", 6);
+    WriteU32(0x1C, 0xC2339F3D);
+    WriteU32(0x420, DOL_OFFSET);
+    WriteU32(0x424, FST_OFFSET);
+    WriteU32(0x2454, 0x1000);
+
+    // A DOL with a single text section
+    std::fill(m_data.begin() + DOL_OFFSET, m_data.begin() + DOL_OFFSET + 0x100, 0);
+    std::fill(m_data.begin() + DOL_OFFSET + 0x100, m_data.begin() + DOL_OFFSET + 0x3100, 0x60);
+    WriteU32(DOL_OFFSET, 0x100);
+    WriteU32(DOL_OFFSET + 0x90, 0x3000);
+
+    const u32 num_entries = static_cast<u32>(1 + sizeof(FILES) / sizeof(FILES[0]));
+    u32 name_offset = 0;
+    WriteU32(FST_OFFSET, 0x01000000);
+    WriteU32(FST_OFFSET + 8, num_entries);
+    for (u32 i = 1; i < num_entries; ++i)
+    {
+      const FakeFile& file = FILES[i - 1];
+      WriteU32(FST_OFFSET + i * 12, name_offset);
+      WriteU32(FST_OFFSET + i * 12 + 4, file.offset);
+      WriteU32(FST_OFFSET + i * 12 + 8, file.size);
+      std::strcpy(reinterpret_cast<char*>(&m_data[FST_OFFSET + num_entries * 12 + name_offset]),
+                  file.name);
+      name_offset += static_cast<u32>(std::strlen(file.name) + 1);
+
+      for (u32 j = 0; j < file.size; ++j)
+        m_data[file.offset + j] = i == 3 ? static_cast<u8>('a' + j % 26) : static_cast<u8>(rng());
+    }
+    WriteU32(0x428, num_entries * 12 + name_offset);
+
+    m_temp_dir = File::CreateTempDir();
+    ASSERT_FALSE(m_temp_dir.empty());
+    m_iso_path = m_temp_dir + DIR_SEP "disc.iso";
+    WriteIso();
+  }
+
+  void TearDown() override { File::DeleteDirRecursively(m_temp_dir); }
+
+  void WriteU32(u64 offset, u32 value)
+  {
+    const u32 swapped = Common::swap32(value);
+    std::memcpy(&m_data[offset], &swapped, sizeof(swapped));
+  }
+
+  void WriteIso()
+  {
+    ASSERT_TRUE(File::IOFile(m_iso_path, "wb").WriteBytes(m_data.data(), m_data.size()));
+  }
+
+  // Returns the size of the compressed image
+  u64 Compress(const std::string& gcz_path, bool scrub)
+  {
+    EXPECT_TRUE(DiscIO::CompressFileToBlob(m_iso_path, gcz_path, scrub ? 1 : 0, 0x4000,
+                                           [](const std::string&, float, void*) { return true; }));
+    return File::GetSize(gcz_path);
+  }
+
+  void ExpectReadsMatch(const std::string& gcz_path)
+  {
+    std::unique_ptr<DiscIO::IBlobReader> reader = DiscIO::CreateBlobReader(gcz_path);
+    ASSERT_NE(nullptr, reader);
+    std::vector<u8> buffer(m_data.size());
+    ASSERT_TRUE(reader->Read(0, buffer.size(), buffer.data()));
+    EXPECT_TRUE(buffer == m_data);
+  }
+
+  // Whether a cluster holds junk that the scrubber is expected to take out
+  bool IsJunkCluster(u64 cluster) const
+  {
+    if (cluster == 0 || cluster == DOL_OFFSET / CLUSTER_SIZE ||
+        cluster == FST_OFFSET / CLUSTER_SIZE || cluster == GARBAGE_OFFSET / CLUSTER_SIZE)
+    {
+      return false;
+    }
+    return std::none_of(std::begin(FILES), std::end(FILES), [cluster](const FakeFile& file) {
+      return cluster >= file.offset / CLUSTER_SIZE &&
+             cluster <= (file.offset + file.size - 1) / CLUSTER_SIZE;
+    });
+  }
+
+  std::vector<u8> m_data;
+  std::string m_temp_dir;
+  std::string m_iso_path;
+};
+}
+
+TEST_F(DiscScrubberTest, FindsUsedClusters)
+{
+  DiscIO::DiscScrubber scrubber;
+  ASSERT_TRUE(scrubber.SetupScrub(m_iso_path));
+  ASSERT_EQ(DISC_SIZE / CLUSTER_SIZE, scrubber.GetUsedClusters().size());
+
+  // The header and apploader, DOL, FST and files
+  std::vector<bool> expected(DISC_SIZE / CLUSTER_SIZE);
+  expected[0] = expected[DOL_OFFSET / CLUSTER_SIZE] = expected[FST_OFFSET / CLUSTER_SIZE] = true;
+  for (const FakeFile& file : FILES)
+  {
+    for (u64 offset = file.offset; offset < file.offset + file.size; offset += CLUSTER_SIZE)
+      expected[offset / CLUSTER_SIZE] = true;
+  }
+  EXPECT_EQ(expected, scrubber.GetUsedClusters());
+}
+
+TEST_F(DiscScrubberTest, RegeneratesJunk)
+{
+  const std::string plain_path = m_temp_dir + DIR_SEP "plain.gcz";
+  const std::string scrubbed_path = m_temp_dir + DIR_SEP "scrubbed.gcz";
+  const u64 plain_size = Compress(plain_path, false);
+  const u64 scrubbed_size = Compress(scrubbed_path, true);
+
+  // Junk doesn't compress at all without scrubbing
+  EXPECT_GT(plain_size, DISC_SIZE * 9 / 10);
+  EXPECT_EQ(DiscIO::GCZ_MAGIC, ReadJunkTable(plain_path).header_magic);
+  EXPECT_TRUE(ReadJunkTable(plain_path).regions.empty());
+
+  // Every unused cluster of junk is listed, and nothing else is
+  const RawJunkTable table = ReadJunkTable(scrubbed_path);
+  EXPECT_EQ(DiscIO::GCZ_MAGIC_WITH_JUNK, table.header_magic);
+  EXPECT_EQ(DiscIO::GCZ_JUNK_MAGIC, table.magic);
+  std::vector<bool> listed(DISC_SIZE / CLUSTER_SIZE);
+  for (const DiscIO::DiscScrubber::JunkRegion& region : table.regions)
+  {
+    ASSERT_GT(region.size, 0u);
+    for (u64 offset = region.offset; offset < region.offset + region.size; ++offset)
+      listed[offset / CLUSTER_SIZE] = true;
+    EXPECT_TRUE(IsJunkCluster(region.offset / CLUSTER_SIZE)) << region.offset;
+  }
+  for (u64 cluster = 0; cluster < listed.size(); ++cluster)
+    EXPECT_EQ(IsJunkCluster(cluster), listed[cluster]) << cluster;
+
+  // Only the random file, the random cluster and the junk after the header, DOL, FST and the
+  // end of small.bin are left, which is 0x148000 bytes that can't be compressed.
+  EXPECT_GE(scrubbed_size, 0x148000u);
+  EXPECT_LT(scrubbed_size, 0x150000u);
+
+  // Junk is put back when reading, so the image is still a 1:1 copy
+  ExpectReadsMatch(scrubbed_path);
+  std::unique_ptr<DiscIO::IBlobReader> reader = DiscIO::CreateBlobReader(scrubbed_path);
+  ASSERT_NE(nullptr, reader);
+  std::vector<u8> buffer(m_data.size());
+
+  std::mt19937 rng(8);
+  for (int i = 0; i < 200; ++i)
+  {
+    const u64 size = 1 + rng() % 0x9000;
+    const u64 offset = rng() % (m_data.size() - size);
+    ASSERT_TRUE(reader->Read(offset, size, buffer.data()));
+    EXPECT_EQ(0, std::memcmp(&m_data[offset], buffer.data(), size)) << offset << " " << size;
+  }
+  reader.reset();
+
+  const std::string iso_path = m_temp_dir + DIR_SEP "decompressed.iso";
+  ASSERT_TRUE(DiscIO::DecompressBlobToFile(scrubbed_path, iso_path,
+                                           [](const std::string&, float, void*) { return true; }));
+  std::string decompressed;
+  ASSERT_TRUE(File::ReadFileToString(iso_path, decompressed));
+  EXPECT_TRUE(std::vector<u8>(decompressed.begin(), decompressed.end()) == m_data);
+}
+
+TEST_F(DiscScrubberTest, CompressesUnscrubbableGameCubeDiscs)
+{
+  // The disc can be opened, but not parsed without a boot DOL
+  WriteU32(0x420, 0);
+  WriteIso();
+  DiscIO::DiscScrubber scrubber;
+  ASSERT_FALSE(scrubber.SetupScrub(m_iso_path));
+
+  // Compressing with scrubbing still works, it just doesn't scrub anything
+  const std::string gcz_path = m_temp_dir + DIR_SEP "unscrubbed.gcz";
+  EXPECT_GT(Compress(gcz_path, true), DISC_SIZE * 9 / 10);
+  EXPECT_EQ(DiscIO::GCZ_MAGIC, ReadJunkTable(gcz_path).header_magic);
+  EXPECT_NE(DiscIO::GCZ_JUNK_MAGIC, ReadJunkTable(gcz_path).magic);
+  ExpectReadsMatch(gcz_path);
+}
+
+TEST_F(DiscScrubberTest, RejectsInvalidJunkTables)
+{
+  const std::string gcz_path = m_temp_dir + DIR_SEP "scrubbed.gcz";
+  Compress(gcz_path, true);
+  const RawJunkTable table = ReadJunkTable(gcz_path);
+  ASSERT_GE(table.regions.size(), 2u);
+  std::string original;
+  ASSERT_TRUE(File::ReadFileToString(gcz_path, original));
+
+  const auto opens_with = [&](s64 offset_in_table, u64 value, size_t size) {
+    std::string patched = original;
+    for (size_t i = 0; i < size; ++i)
+      patched[table.regions_offset + offset_in_table + i] = static_cast<char>(value >> (i * 8));
+    const std::string patched_path = m_temp_dir + DIR_SEP "patched.gcz";
+    EXPECT_TRUE(File::WriteStringToFile(patched, patched_path));
+    return DiscIO::CreateBlobReader(patched_path) != nullptr;
+  };
+
+  EXPECT_TRUE(opens_with(0, table.regions[0].offset, 8));
+  // An empty region, overlapping regions, regions past the end of the disc (also by
+  // overflowing), and more regions than the file holds
+  EXPECT_FALSE(opens_with(8, 0, 4));
+  EXPECT_FALSE(opens_with(80, table.regions[0].offset, 8));
+  EXPECT_FALSE(opens_with(8, DISC_SIZE, 4));
+  EXPECT_FALSE(opens_with(0, ~0ULL - 0xFF, 8));
+  EXPECT_FALSE(opens_with(-4, table.regions.size() + 1, 4));
+}
@@ -0,0 +1,81 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Blob.h"
+
+class FileBlobTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_data.resize(0x12345);
+    for (size_t i = 0; i < m_data.size(); ++i)
+      m_data[i] = static_cast<u8>(i * 7 + i / 256);
+
+    m_temp_dir = File::CreateTempDir();
+    ASSERT_FALSE(m_temp_dir.empty());
+    m_path = m_temp_dir + DIR_SEP "image.iso";
+    ASSERT_TRUE(File::IOFile(m_path, "wb").WriteBytes(m_data.data(), m_data.size()));
+
+    m_reader = DiscIO::CreateBlobReader(m_path);
+    ASSERT_NE(nullptr, m_reader);
+    ASSERT_EQ(DiscIO::BlobType::PLAIN, m_reader->GetBlobType());
+  }
+
+  void TearDown() override
+  {
+    m_reader.reset();
+    File::DeleteDirRecursively(m_temp_dir);
+  }
+
+  std::vector<u8> m_data;
+  std::string m_temp_dir;
+  std::string m_path;
+  std::unique_ptr<DiscIO::IBlobReader> m_reader;
+};
+
+TEST_F(FileBlobTest, Reads)
+{
+  std::vector<u8> buffer(0x1000);
+  ASSERT_TRUE(m_reader->Read(0x2001, buffer.size(), buffer.data()));
+  EXPECT_EQ(0, memcmp(&m_data[0x2001], buffer.data(), buffer.size()));
+
+  ASSERT_TRUE(m_reader->Read(m_data.size() - buffer.size(), buffer.size(), buffer.data()));
+  EXPECT_EQ(0, memcmp(&m_data[m_data.size() - buffer.size()], buffer.data(), buffer.size()));
+
+  EXPECT_FALSE(m_reader->Read(m_data.size() - 0x10, 0x20, buffer.data()));
+  EXPECT_FALSE(m_reader->Read(UINT64_MAX - 0x10, 0x20, buffer.data()));
+}
+
+TEST_F(FileBlobTest, FailsReadsAfterFileShrinks)
+{
+  // Simulates the image becoming unreadable while it is open, e.g. on a removable drive. This has
+  // to be reported as a failed read so that the user gets an error instead of a crash.
+  ASSERT_TRUE(File::IOFile(m_path, "wb"));
+
+  std::vector<u8> buffer(0x1000);
+  EXPECT_FALSE(m_reader->Read(0x2001, buffer.size(), buffer.data()));
+}
+
+TEST_F(FileBlobTest, Prefetch)
+{
+  EXPECT_FALSE(m_reader->Prefetch(m_data.size() + 1, 0x1000));
+#if defined(__linux__) || defined(__FreeBSD__)
+  EXPECT_TRUE(m_reader->Prefetch(0x1000, 0x100000));
+#endif
+
+  std::vector<u8> buffer(0x1000);
+  ASSERT_TRUE(m_reader->Read(0x1000, buffer.size(), buffer.data()));
+  EXPECT_EQ(0, memcmp(&m_data[0x1000], buffer.data(), buffer.size()));
+}
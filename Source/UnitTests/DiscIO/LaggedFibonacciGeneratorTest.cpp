@@ -0,0 +1,78 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "DiscIO/LaggedFibonacciGenerator.h"
+
+using DiscIO::LaggedFibonacciGenerator;
+
+namespace
+{
+std::vector<u8> GenerateJunk(const LaggedFibonacciGenerator::Seed& seed, size_t size)
+{
+  LaggedFibonacciGenerator lfg;
+  lfg.SetSeed(seed);
+  std::vector<u8> junk(size);
+  lfg.GetBytes(junk.size(), junk.data());
+  return junk;
+}
+
+LaggedFibonacciGenerator::Seed RandomSeed(std::mt19937* rng)
+{
+  LaggedFibonacciGenerator::Seed seed;
+  for (u32& word : seed)
+    word = (*rng)();
+  return seed;
+}
+}
+
+TEST(LaggedFibonacciGenerator, ReconstructsSeed)
+{
+  std::mt19937 rng(17);
+  for (int i = 0; i < 100; ++i)
+  {
+    const std::vector<u8> junk = GenerateJunk(RandomSeed(&rng), 0x8000);
+
+    // Start anywhere in the stream, including in the middle of a word
+    const size_t offset = i == 0 ? 0 : rng() % 0x6000;
+    LaggedFibonacciGenerator::Seed seed;
+    ASSERT_EQ(junk.size() - offset, LaggedFibonacciGenerator::GetSeed(
+                                        &junk[offset], junk.size() - offset, offset, &seed))
+        << offset;
+
+    // The reconstructed seed regenerates everything, even what came before the data
+    EXPECT_EQ(junk, GenerateJunk(seed, junk.size()));
+  }
+}
+
+TEST(LaggedFibonacciGenerator, StopsAtEndOfJunk)
+{
+  std::mt19937 rng(3);
+  std::vector<u8> data = GenerateJunk(RandomSeed(&rng), 0x4000);
+  for (size_t i = 0x3000; i < data.size(); ++i)
+    data[i] = static_cast<u8>(i);
+
+  LaggedFibonacciGenerator::Seed seed;
+  EXPECT_EQ(0x3000u, LaggedFibonacciGenerator::GetSeed(data.data(), data.size(), 0, &seed));
+}
+
+TEST(LaggedFibonacciGenerator, RejectsOtherData)
+{
+  std::mt19937 rng(5);
+  std::vector<u8> data(0x4000);
+  for (u8& byte : data)
+    byte = static_cast<u8>(rng());
+
+  LaggedFibonacciGenerator::Seed seed;
+  EXPECT_EQ(0u, LaggedFibonacciGenerator::GetSeed(data.data(), data.size(), 0, &seed));
+
+  // Too short to say
+  const std::vector<u8> junk = GenerateJunk(RandomSeed(&rng), 0x400);
+  EXPECT_EQ(0u, LaggedFibonacciGenerator::GetSeed(junk.data(), junk.size(), 0, &seed));
+}
@@ -0,0 +1,167 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "DiscIO/Blob.h"
+
+namespace
+{
+constexpr u32 BLOCK_SIZE = 0x800;
+constexpr u32 CHUNK_BLOCKS = 4;
+constexpr u32 CHUNK_SIZE = BLOCK_SIZE * CHUNK_BLOCKS;
+constexpr u64 NUM_BLOCKS = 1001;
+
+// Serves blocks from memory, and checks that it's never called from two threads at once.
+class MemorySectorReader final : public DiscIO::SectorReader
+{
+public:
+  MemorySectorReader() : m_data(NUM_BLOCKS * BLOCK_SIZE)
+  {
+    for (size_t i = 0; i < m_data.size(); ++i)
+      m_data[i] = static_cast<u8>(i ^ (i >> 11));
+    SetSectorSize(BLOCK_SIZE);
+    SetChunkSize(CHUNK_BLOCKS);
+  }
+
+  DiscIO::BlobType GetBlobType() const override { return DiscIO::BlobType::PLAIN; }
+  u64 GetRawSize() const override { return m_data.size(); }
+  u64 GetDataSize() const override { return m_data.size(); }
+
+  bool GetBlock(u64 block_num, u8* out) override
+  {
+    return ReadMultipleAlignedBlocks(block_num, 1, out);
+  }
+
+  bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr) override
+  {
+    EXPECT_FALSE(m_busy.exchange(true));
+    const bool success = block_num + num_blocks <= NUM_BLOCKS;
+    if (success)
+      memcpy(out_ptr, &m_data[block_num * BLOCK_SIZE], num_blocks * BLOCK_SIZE);
+    m_busy = false;
+    return success;
+  }
+
+  const std::vector<u8>& GetData() const { return m_data; }
+
+private:
+  std::vector<u8> m_data;
+  std::atomic<bool> m_busy{false};
+};
+
+void ExpectRead(MemorySectorReader* reader, u64 offset, u64 size)
+{
+  std::vector<u8> buffer(size);
+  ASSERT_TRUE(reader->Read(offset, size, buffer.data()));
+  EXPECT_EQ(0, memcmp(&reader->GetData()[offset], buffer.data(), size)) << offset << " " << size;
+}
+}
+
+TEST(SectorReader, ReadsMatch)
+{
+  MemorySectorReader reader;
+  std::mt19937 rng(11);
+  for (int i = 0; i < 2000; ++i)
+  {
+    const u64 size = 1 + rng() % (i % 8 == 0 ? 20 * CHUNK_SIZE : 0x1000);
+    const u64 offset = rng() % (reader.GetData().size() - size);
+    ExpectRead(&reader, offset, size);
+  }
+
+  // The last chunk only has one block.
+  ExpectRead(&reader, reader.GetData().size() - 0x100, 0x100);
+  std::vector<u8> buffer(0x200);
+  EXPECT_FALSE(reader.Read(reader.GetData().size() - 0x100, buffer.size(), buffer.data()));
+  EXPECT_FALSE(reader.Read(reader.GetData().size() + CHUNK_SIZE, 0x10, buffer.data()));
+}
+
+TEST(SectorReader, ConcurrentReads)
+{
+  MemorySectorReader reader;
+  std::vector<std::thread> threads;
+  for (u32 t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&reader, t] {
+      std::mt19937 rng(t);
+      for (int i = 0; i < 3000; ++i)
+      {
+        // Stay within a small area so that threads hit the same chunks.
+        const u64 size = 1 + rng() % 0x3000;
+        const u64 offset = rng() % (64 * CHUNK_SIZE);
+        ExpectRead(&reader, offset, size);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+TEST(SectorReader, CacheStats)
+{
+  MemorySectorReader reader;
+  ExpectRead(&reader, 0x10, 0x10);
+  ExpectRead(&reader, 0x100, 0x10);
+  ExpectRead(&reader, CHUNK_SIZE - 0x10, 0x20);
+  DiscIO::SectorReader::CacheStats stats = reader.GetCacheStats();
+  EXPECT_EQ(2u, stats.misses);
+  EXPECT_EQ(2u, stats.hits);
+  EXPECT_EQ(0u, stats.evictions);
+}
+
+TEST(SectorReader, CacheCapacity)
+{
+  // Cycling through more chunks than the default capacity keeps missing...
+  MemorySectorReader reader;
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    for (u64 chunk = 0; chunk < 48; ++chunk)
+      ExpectRead(&reader, chunk * CHUNK_SIZE + 0x20, 0x20);
+  }
+  EXPECT_EQ(96u, reader.GetCacheStats().misses);
+
+  // ...but fits once the cache is big enough.
+  MemorySectorReader big_reader;
+  big_reader.SetCacheCapacity(64);
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    for (u64 chunk = 0; chunk < 48; ++chunk)
+      ExpectRead(&big_reader, chunk * CHUNK_SIZE + 0x20, 0x20);
+  }
+  EXPECT_EQ(48u, big_reader.GetCacheStats().misses);
+  EXPECT_EQ(48u, big_reader.GetCacheStats().hits);
+}
+
+TEST(SectorReader, KeepsHotChunks)
+{
+  // A chunk that keeps getting read survives a long run of chunks that are only read once.
+  MemorySectorReader reader;
+  for (u64 chunk = 1; chunk < 200; ++chunk)
+  {
+    ExpectRead(&reader, 0x40, 0x40);
+    ExpectRead(&reader, chunk * CHUNK_SIZE + 0x40, 0x40);
+  }
+  EXPECT_EQ(200u, reader.GetCacheStats().misses);
+}
+
+TEST(SectorReader, SmallWorkingSetFitsDefaultCache)
+{
+  // Chunks that are a multiple of MAX_CACHE_SHARDS apart would all be in one shard of a cache
+  // that is split as much as possible.
+  MemorySectorReader reader;
+  for (int pass = 0; pass < 4; ++pass)
+  {
+    for (u64 chunk = 0; chunk < 8; ++chunk)
+      ExpectRead(&reader, chunk * 8 * CHUNK_SIZE, BLOCK_SIZE);
+  }
+  EXPECT_EQ(8u, reader.GetCacheStats().misses);
+  EXPECT_EQ(24u, reader.GetCacheStats().hits);
+}
@@ -0,0 +1,195 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/StringUtil.h"
+#include "DiscIO/Filesystem.h"
+#include "DiscIO/Volume.h"
+#include "DiscIO/VolumeCreator.h"
+#include "DiscIO/VolumeDirectory.h"
+
+namespace
+{
+constexpr int NUM_DIRECTORIES = 8;
+constexpr int FILES_PER_DIRECTORY = 40;
+
+class VolumeDirectoryTest : public testing::Test
+{
+protected:
+  // Extracts a GameCube disc with a few hundred files, from empty ones to a few hundred KiB,
+  // spread over several directories.
+  void SetUp() override
+  {
+    m_temp_dir = File::CreateTempDir();
+    ASSERT_FALSE(m_temp_dir.empty());
+    File::SetUserPath(D_USER_IDX, m_temp_dir + DIR_SEP "User" DIR_SEP);
+    m_root = m_temp_dir + DIR_SEP "disc" DIR_SEP;
+
+    std::mt19937 rng(39);
+    for (int d = 0; d < NUM_DIRECTORIES; ++d)
+    {
+      const std::string directory = StringFromFormat("dir%d", d);
+      ASSERT_TRUE(File::CreateFullPath(m_root + directory + DIR_SEP));
+      for (int f = 0; f < FILES_PER_DIRECTORY; ++f)
+      {
+        const std::string name = directory + StringFromFormat("/file%d.bin", f);
+        std::vector<u8>& data = m_files[name];
+        data.resize(f % 10 == 0 ? rng() % 0x40 : rng() % 0x60000);
+        for (u8& byte : data)
+          byte = static_cast<u8>(rng());
+        ASSERT_TRUE(File::IOFile(m_root + directory + DIR_SEP + StringFromFormat("file%d.bin", f),
+                                 "wb")
+                        .WriteBytes(data.data(), data.size()));
+      }
+    }
+  }
+
+  void TearDown() override { File::DeleteDirRecursively(m_temp_dir); }
+
+  // Makes the extracted directories look like they haven't been touched for a while, since
+  // directories that were just changed aren't cached
+  void AgeDirectories()
+  {
+    const u64 time = static_cast<u64>(std::time(nullptr)) - 60;
+    ASSERT_TRUE(File::SetModifiedTime(m_root, time));
+    for (int d = 0; d < NUM_DIRECTORIES; ++d)
+      ASSERT_TRUE(File::SetModifiedTime(m_root + StringFromFormat("dir%d", d), time));
+  }
+
+  // Lays out what the disc should look like past the FST, according to the FST itself
+  void BuildExpectedImage(DiscIO::IVolume* volume)
+  {
+    std::unique_ptr<DiscIO::IFileSystem> filesystem = DiscIO::CreateFileSystem(volume);
+    ASSERT_NE(nullptr, filesystem);
+
+    size_t num_files = 0;
+    m_data_start = UINT64_MAX;
+    m_image.clear();
+    for (const DiscIO::SFileInfo& file : filesystem->GetFileList())
+    {
+      if (file.IsDirectory())
+        continue;
+
+      const auto it = m_files.find(file.m_FullPath);
+      ASSERT_NE(m_files.end(), it) << file.m_FullPath;
+      ASSERT_EQ(it->second.size(), file.m_FileSize);
+      ++num_files;
+
+      m_data_start = std::min(m_data_start, file.m_Offset);
+      if (m_image.size() < file.m_Offset + file.m_FileSize)
+        m_image.resize(file.m_Offset + file.m_FileSize);
+      std::copy(it->second.begin(), it->second.end(), m_image.begin() + file.m_Offset);
+    }
+    ASSERT_EQ(m_files.size(), num_files);
+  }
+
+  void ExpectRead(DiscIO::IVolume* volume, u64 offset, u64 size) const
+  {
+    std::vector<u8> buffer(size);
+    ASSERT_TRUE(volume->Read(offset, size, buffer.data(), false));
+    EXPECT_EQ(0, std::memcmp(&m_image[offset], buffer.data(), size)) << offset << " " << size;
+  }
+
+  std::string m_temp_dir;
+  std::string m_root;
+  std::map<std::string, std::vector<u8>> m_files;
+  std::vector<u8> m_image;
+  u64 m_data_start = 0;
+};
+}
+
+TEST_F(VolumeDirectoryTest, ReadsFiles)
+{
+  DiscIO::CVolumeDirectory volume(m_root, false);
+  BuildExpectedImage(&volume);
+
+  // Whole files, and reads that span the padding between files
+  ExpectRead(&volume, m_data_start, m_image.size() - m_data_start);
+  std::mt19937 rng(7);
+  for (int i = 0; i < 1000; ++i)
+  {
+    const u64 size = 1 + rng() % 0x48000;
+    const u64 offset = m_data_start + rng() % (m_image.size() - m_data_start - size);
+    ExpectRead(&volume, offset, size);
+  }
+}
+
+TEST_F(VolumeDirectoryTest, ConcurrentReads)
+{
+  DiscIO::CVolumeDirectory volume(m_root, false);
+  BuildExpectedImage(&volume);
+
+  // There are more files than are kept open, so they get closed and reopened along the way
+  std::vector<std::thread> threads;
+  for (u32 t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([this, &volume, t] {
+      std::mt19937 rng(t);
+      for (int i = 0; i < 500; ++i)
+      {
+        const u64 size = 1 + rng() % 0x10000;
+        const u64 offset = m_data_start + rng() % (m_image.size() - m_data_start - size);
+        ExpectRead(&volume, offset, size);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+TEST_F(VolumeDirectoryTest, CachesFST)
+{
+  // Directories that were just modified aren't cached
+  DiscIO::CVolumeDirectory first_run(m_root, false);
+  File::FSTEntry cache_directory = File::ScanDirectoryTree(File::GetUserPath(D_CACHE_IDX), false);
+  EXPECT_EQ(0u, cache_directory.size);
+
+  AgeDirectories();
+  auto cold = std::make_unique<DiscIO::CVolumeDirectory>(m_root, false);
+  cache_directory = File::ScanDirectoryTree(File::GetUserPath(D_CACHE_IDX), false);
+  EXPECT_EQ(1u, cache_directory.size);
+
+  auto warm = std::make_unique<DiscIO::CVolumeDirectory>(m_root, false);
+
+  // The cached volume is the same disc
+  BuildExpectedImage(warm.get());
+  std::vector<u8> cold_data(m_image.size());
+  std::vector<u8> warm_data(m_image.size());
+  ASSERT_TRUE(cold->Read(0, cold_data.size(), cold_data.data(), false));
+  ASSERT_TRUE(warm->Read(0, warm_data.size(), warm_data.data(), false));
+  EXPECT_TRUE(cold_data == warm_data);
+
+  // Rewriting a file with a different size leaves its directory alone, but the size is checked
+  std::vector<u8>& resized = m_files["dir5/file7.bin"];
+  resized.resize(resized.size() + 0x9000, 0x37);
+  ASSERT_TRUE(File::IOFile(m_root + "dir5" DIR_SEP "file7.bin", "wb")
+                  .WriteBytes(resized.data(), resized.size()));
+  AgeDirectories();
+  DiscIO::CVolumeDirectory resized_run(m_root, false);
+  BuildExpectedImage(&resized_run);
+  ExpectRead(&resized_run, m_data_start, m_image.size() - m_data_start);
+
+  // Adding a file changes the time of its directory, so the cache isn't used
+  std::vector<u8>& data = m_files["dir3/new.bin"];
+  data.assign(0x1234, 0x56);
+  ASSERT_TRUE(File::IOFile(m_root + "dir3" DIR_SEP "new.bin", "wb").WriteBytes(data.data(),
+                                                                              data.size()));
+  DiscIO::CVolumeDirectory rescanned(m_root, false);
+  BuildExpectedImage(&rescanned);
+  ExpectRead(&rescanned, m_data_start, m_image.size() - m_data_start);
+}
@@ -0,0 +1,245 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mbedtls/aes.h>
+#include <mbedtls/sha1.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/VolumeWiiCrypted.h"
+
+namespace
+{
+constexpr u64 PARTITION_OFFSET = 0x50000;
+constexpr u64 DATA_OFFSET = PARTITION_OFFSET + 0x20000;
+constexpr u64 CLUSTER_SIZE = 0x8000;
+constexpr u64 CLUSTER_DATA_SIZE = 0x7C00;
+constexpr u64 NUM_CLUSTERS = 256;
+constexpr std::array<u8, 16> KEY = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                                    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+
+// Serves a disc image from memory and counts the reads that reach it.
+class MemoryBlobReader final : public DiscIO::IBlobReader
+{
+public:
+  explicit MemoryBlobReader(std::vector<u8> data) : m_data(std::move(data)) {}
+
+  DiscIO::BlobType GetBlobType() const override { return DiscIO::BlobType::PLAIN; }
+  u64 GetRawSize() const override { return m_data.size(); }
+  u64 GetDataSize() const override { return m_data.size(); }
+  bool Read(u64 offset, u64 size, u8* out_ptr) override
+  {
+    if (offset <= m_bad_offset && m_bad_offset < offset + size)
+      return false;
+    if (offset + size > m_data.size())
+      return false;
+    memcpy(out_ptr, &m_data[offset], size);
+    ++m_read_count;
+    return true;
+  }
+
+  u32 GetReadCount() const { return m_read_count; }
+  std::vector<u8>& GetData() { return m_data; }
+  // Makes reads covering this offset fail.
+  void SetBadOffset(u64 offset) { m_bad_offset = offset; }
+
+private:
+  std::vector<u8> m_data;
+  u64 m_bad_offset = UINT64_MAX;
+  u32 m_read_count = 0;
+};
+
+class VolumeWiiCryptedTest : public testing::Test
+{
+protected:
+  VolumeWiiCryptedTest() : m_plaintext(NUM_CLUSTERS * CLUSTER_DATA_SIZE)
+  {
+    std::mt19937 rng(42);
+    for (u8& byte : m_plaintext)
+      byte = static_cast<u8>(rng());
+
+    // Build the hash tree: H0 covers 0x400 bytes of data, H1 a cluster's H0 table and H2 the H1
+    // table shared by a subgroup of 8 clusters. Every cluster in a group of 64 carries the same
+    // H2 table, and every cluster in a subgroup the same H1 table.
+    std::vector<std::array<u8, 0x400>> hash_blocks(NUM_CLUSTERS);
+    for (u64 cluster = 0; cluster < NUM_CLUSTERS; ++cluster)
+    {
+      for (u64 i = 0; i < 31; ++i)
+      {
+        mbedtls_sha1(&m_plaintext[cluster * CLUSTER_DATA_SIZE + i * 0x400], 0x400,
+                     &hash_blocks[cluster][i * 20]);
+      }
+    }
+    for (u64 cluster = 0; cluster < NUM_CLUSTERS; ++cluster)
+    {
+      const u64 subgroup = cluster / 8;
+      for (u64 member = subgroup * 8; member < subgroup * 8 + 8; ++member)
+      {
+        mbedtls_sha1(&hash_blocks[cluster][0], 0x26C,
+                     &hash_blocks[member][0x280 + cluster % 8 * 20]);
+      }
+    }
+    for (u64 subgroup = 0; subgroup < NUM_CLUSTERS / 8; ++subgroup)
+    {
+      const u64 group = subgroup / 8;
+      for (u64 member = group * 64; member < group * 64 + 64; ++member)
+      {
+        mbedtls_sha1(&hash_blocks[subgroup * 8][0x280], 0xA0,
+                     &hash_blocks[member][0x340 + subgroup % 8 * 20]);
+      }
+    }
+
+    // Encrypt the hash blocks with a zero IV, and the data with the IV that ends up at 0x3D0.
+    std::vector<u8> image(DATA_OFFSET + NUM_CLUSTERS * CLUSTER_SIZE);
+    const u32 data_size = Common::swap32(static_cast<u32>(NUM_CLUSTERS * CLUSTER_SIZE / 4));
+    memcpy(&image[PARTITION_OFFSET + 0x2BC], &data_size, sizeof(data_size));
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, KEY.data(), 128);
+    for (u64 cluster = 0; cluster < NUM_CLUSTERS; ++cluster)
+    {
+      u8* raw = &image[DATA_OFFSET + cluster * CLUSTER_SIZE];
+      u8 iv[16] = {};
+      mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, 0x400, iv, hash_blocks[cluster].data(), raw);
+      memcpy(iv, &raw[0x3D0], sizeof(iv));
+      mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, CLUSTER_DATA_SIZE, iv,
+                            &m_plaintext[cluster * CLUSTER_DATA_SIZE], &raw[0x400]);
+    }
+    mbedtls_aes_free(&aes);
+
+    auto reader = std::make_unique<MemoryBlobReader>(std::move(image));
+    m_reader = reader.get();
+    m_volume = std::make_unique<DiscIO::CVolumeWiiCrypted>(std::move(reader), PARTITION_OFFSET,
+                                                           KEY.data());
+  }
+
+  void ExpectRead(u64 offset, u64 size)
+  {
+    std::vector<u8> buffer(size);
+    ASSERT_TRUE(m_volume->Read(offset, size, buffer.data(), true));
+    EXPECT_EQ(0, memcmp(&m_plaintext[offset], buffer.data(), size)) << offset << " " << size;
+  }
+
+  std::vector<u8> m_plaintext;
+  MemoryBlobReader* m_reader;
+  std::unique_ptr<DiscIO::CVolumeWiiCrypted> m_volume;
+};
+}
+
+TEST_F(VolumeWiiCryptedTest, ReadsMatchPlaintext)
+{
+  std::mt19937 rng(7);
+  for (int i = 0; i < 2000; ++i)
+  {
+    // Mostly small reads, with the occasional one spanning many clusters.
+    const u64 max_size = i % 16 == 0 ? 40 * CLUSTER_DATA_SIZE : 0x1000;
+    const u64 size = 1 + rng() % max_size;
+    const u64 offset = rng() % (m_plaintext.size() - size);
+    ExpectRead(offset, size);
+  }
+}
+
+TEST_F(VolumeWiiCryptedTest, CachesPartialClusters)
+{
+  ExpectRead(0x100, 0x20);
+  const u32 reads = m_reader->GetReadCount();
+
+  // Neighbouring small reads in the same cluster are served from the cache.
+  ExpectRead(0x200, 0x40);
+  ExpectRead(0x7B00, 0x100);
+  EXPECT_EQ(reads, m_reader->GetReadCount());
+
+  // Interleaving with another cluster does not evict the first one.
+  ExpectRead(100 * CLUSTER_DATA_SIZE + 0x10, 0x10);
+  ExpectRead(0x300, 0x10);
+  EXPECT_EQ(reads + 1, m_reader->GetReadCount());
+}
+
+TEST_F(VolumeWiiCryptedTest, BatchesClusterReads)
+{
+  // 40 uncached clusters are fetched 16 at a time.
+  ExpectRead(CLUSTER_DATA_SIZE * 10 + 0x20, CLUSTER_DATA_SIZE * 39);
+  EXPECT_EQ(3u, m_reader->GetReadCount());
+
+  // The partial clusters at either end were cached; the ones read in full were not.
+  ExpectRead(CLUSTER_DATA_SIZE * 10 + 0x100, 0x10);
+  ExpectRead(CLUSTER_DATA_SIZE * 49 + 0x10, 0x10);
+  EXPECT_EQ(3u, m_reader->GetReadCount());
+  ExpectRead(CLUSTER_DATA_SIZE * 20, 0x10);
+  EXPECT_EQ(4u, m_reader->GetReadCount());
+}
+
+// Not run by default. Reports the decrypted read speed, for comparing crypto back-ends.
+TEST_F(VolumeWiiCryptedTest, DISABLED_StreamingThroughput)
+{
+  constexpr u64 CHUNK_SIZE = 0x20000;
+  constexpr int PASSES = 8;
+  std::vector<u8> buffer(CHUNK_SIZE);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < PASSES; ++pass)
+  {
+    for (u64 offset = 0; offset + CHUNK_SIZE <= m_plaintext.size(); offset += CHUNK_SIZE)
+      ASSERT_TRUE(m_volume->Read(offset, CHUNK_SIZE, buffer.data(), true));
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  const double megabytes = PASSES * static_cast<double>(m_plaintext.size()) / (1024 * 1024);
+  RecordProperty("MiBPerSecond", std::to_string(megabytes / elapsed.count()));
+}
+
+TEST_F(VolumeWiiCryptedTest, IntegrityCheckPasses)
+{
+  std::atomic<u64> last_progress{0};
+  const DiscIO::IntegrityCheckResult result =
+      m_volume->CheckIntegrity([&last_progress](u64 bytes_checked, u64 total_bytes) {
+        EXPECT_EQ(NUM_CLUSTERS * CLUSTER_DATA_SIZE, total_bytes);
+        EXPECT_GE(bytes_checked, last_progress.load());
+        last_progress = bytes_checked;
+        return true;
+      });
+
+  EXPECT_TRUE(result.success);
+  EXPECT_EQ(NUM_CLUSTERS * CLUSTER_DATA_SIZE, result.bytes_checked);
+}
+
+TEST_F(VolumeWiiCryptedTest, IntegrityCheckFindsFirstBadCluster)
+{
+  // Corrupt data in one cluster and, later on, the hash block of another.
+  m_reader->GetData()[DATA_OFFSET + 150 * CLUSTER_SIZE + 0x5000] ^= 1;
+  m_reader->GetData()[DATA_OFFSET + 200 * CLUSTER_SIZE + 0x10] ^= 1;
+
+  const DiscIO::IntegrityCheckResult result = m_volume->CheckIntegrity(nullptr);
+  EXPECT_FALSE(result.success);
+  EXPECT_FALSE(result.cancelled);
+  EXPECT_EQ(150u, result.first_bad_cluster);
+}
+
+TEST_F(VolumeWiiCryptedTest, IntegrityCheckReportsReadErrors)
+{
+  m_reader->SetBadOffset(DATA_OFFSET + 70 * CLUSTER_SIZE + 0x100);
+
+  const DiscIO::IntegrityCheckResult result = m_volume->CheckIntegrity(nullptr);
+  EXPECT_FALSE(result.success);
+  EXPECT_EQ(70u, result.first_bad_cluster);
+}
+
+TEST_F(VolumeWiiCryptedTest, IntegrityCheckCanBeCancelled)
+{
+  const DiscIO::IntegrityCheckResult result =
+      m_volume->CheckIntegrity([](u64, u64) { return false; });
+  EXPECT_FALSE(result.success);
+  EXPECT_TRUE(result.cancelled);
+}
@@ -0,0 +1,287 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <mbedtls/aes.h>
+#include <mbedtls/sha1.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/Volume.h"
+#include "DiscIO/VolumeCreator.h"
+#include "DiscIO/WCZBlob.h"
+
+namespace
+{
+constexpr u64 PARTITION_OFFSET = 0x50000;
+constexpr u64 DATA_OFFSET = PARTITION_OFFSET + 0x20000;
+constexpr u64 CLUSTER_SIZE = 0x8000;
+constexpr u64 CLUSTER_DATA_SIZE = 0x7C00;
+// Two and a half groups, ending in the middle of a subgroup
+constexpr u64 NUM_CLUSTERS = 2 * 64 + 37;
+// Some unencrypted data after the partition
+constexpr u64 DISC_SIZE = DATA_OFFSET + NUM_CLUSTERS * CLUSTER_SIZE + 0x48000;
+
+bool IgnoreProgress(const std::string&, float, void*)
+{
+  return true;
+}
+
+// Serves a disc image from memory, so that the partition key can be worked out the same way the
+// volume code does it.
+class MemoryBlobReader final : public DiscIO::IBlobReader
+{
+public:
+  explicit MemoryBlobReader(const std::vector<u8>& data) : m_data(data) {}
+
+  DiscIO::BlobType GetBlobType() const override { return DiscIO::BlobType::PLAIN; }
+  u64 GetRawSize() const override { return m_data.size(); }
+  u64 GetDataSize() const override { return m_data.size(); }
+  bool Read(u64 offset, u64 size, u8* out_ptr) override
+  {
+    if (offset + size > m_data.size())
+      return false;
+    std::memcpy(out_ptr, &m_data[offset], size);
+    return true;
+  }
+
+private:
+  const std::vector<u8>& m_data;
+};
+
+class WCZBlobTest : public testing::Test
+{
+protected:
+  // Builds an encrypted Wii disc with one partition, half of which compresses well and half of
+  // which doesn't, and with padding in a few hash blocks that isn't zero like it should be.
+  void SetUp() override
+  {
+    std::mt19937 rng(40);
+    m_plaintext.resize(NUM_CLUSTERS * CLUSTER_DATA_SIZE);
+    for (size_t i = 0; i < m_plaintext.size(); ++i)
+    {
+      m_plaintext[i] = static_cast<u8>(i < m_plaintext.size() / 2 ? "ABCDEFGH"[i / 0x300 % 8] :
+                                                                    rng());
+    }
+
+    m_image.resize(DISC_SIZE);
+    std::memcpy(m_image.data(), "RWCE01", 6);
+    WriteU32(0x18, 0x5D1C9EA3);
+    WriteU32(0x40000, 1);
+    WriteU32(0x40004, 0x40020 >> 2);
+    WriteU32(0x40020, PARTITION_OFFSET >> 2);
+    WriteU32(PARTITION_OFFSET + 0x2B8, (DATA_OFFSET - PARTITION_OFFSET) >> 2);
+    WriteU32(PARTITION_OFFSET + 0x2BC, NUM_CLUSTERS * CLUSTER_SIZE >> 2);
+    for (u64 i = 0; i < 16; ++i)
+      m_image[PARTITION_OFFSET + 0x1BF + i] = static_cast<u8>(rng());
+    for (u64 i = DATA_OFFSET + NUM_CLUSTERS * CLUSTER_SIZE; i < DISC_SIZE; ++i)
+      m_image[i] = static_cast<u8>(i % 7 == 0 ? rng() : 0);
+
+    // H0 covers 0x400 bytes of data, H1 a cluster's H0 table and H2 the H1 table of a subgroup
+    m_hash_blocks.resize(NUM_CLUSTERS);
+    for (u64 cluster = 0; cluster < NUM_CLUSTERS; ++cluster)
+    {
+      for (u64 i = 0; i < 31; ++i)
+      {
+        mbedtls_sha1(&m_plaintext[cluster * CLUSTER_DATA_SIZE + i * 0x400], 0x400,
+                     &m_hash_blocks[cluster][i * 20]);
+      }
+    }
+    for (u64 cluster = 0; cluster < NUM_CLUSTERS; ++cluster)
+    {
+      const u64 subgroup = cluster / 8;
+      for (u64 member = subgroup * 8; member < std::min(subgroup * 8 + 8, NUM_CLUSTERS); ++member)
+      {
+        mbedtls_sha1(&m_hash_blocks[cluster][0], 0x26C,
+                     &m_hash_blocks[member][0x280 + cluster % 8 * 20]);
+      }
+    }
+    for (u64 subgroup = 0; subgroup * 8 < NUM_CLUSTERS; ++subgroup)
+    {
+      const u64 group = subgroup / 8;
+      for (u64 member = group * 64; member < std::min(group * 64 + 64, NUM_CLUSTERS); ++member)
+      {
+        mbedtls_sha1(&m_hash_blocks[subgroup * 8][0x280], 0xA0,
+                     &m_hash_blocks[member][0x340 + subgroup % 8 * 20]);
+      }
+    }
+    m_calculated_hash_blocks = m_hash_blocks;
+    m_hash_blocks[5][0x26C] = 0xAB;
+    m_hash_blocks[70][0x3FF] = 0x01;
+
+    // Encrypt the hash blocks with a zero IV, and the data with the IV that ends up at 0x3D0.
+    std::array<u8, 16> key;
+    MemoryBlobReader header_reader(m_image);
+    DiscIO::VolumeKeyForPartition(header_reader, PARTITION_OFFSET, key.data());
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, key.data(), 128);
+    for (u64 cluster = 0; cluster < NUM_CLUSTERS; ++cluster)
+    {
+      u8* raw = &m_image[DATA_OFFSET + cluster * CLUSTER_SIZE];
+      u8 iv[16] = {};
+      mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, 0x400, iv, m_hash_blocks[cluster].data(),
+                            raw);
+      std::memcpy(iv, &raw[0x3D0], sizeof(iv));
+      mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, CLUSTER_DATA_SIZE, iv,
+                            &m_plaintext[cluster * CLUSTER_DATA_SIZE], &raw[0x400]);
+    }
+    mbedtls_aes_free(&aes);
+
+    m_temp_dir = File::CreateTempDir();
+    ASSERT_FALSE(m_temp_dir.empty());
+    m_iso_path = m_temp_dir + DIR_SEP "disc.iso";
+    m_wcz_path = m_temp_dir + DIR_SEP "disc.wcz";
+    ASSERT_TRUE(File::IOFile(m_iso_path, "wb").WriteBytes(m_image.data(), m_image.size()));
+  }
+
+  void TearDown() override { File::DeleteDirRecursively(m_temp_dir); }
+
+  void WriteU32(u64 offset, u64 value)
+  {
+    const u32 swapped = Common::swap32(static_cast<u32>(value));
+    std::memcpy(&m_image[offset], &swapped, sizeof(swapped));
+  }
+
+  void ExpectRawRead(DiscIO::IBlobReader* reader, u64 offset, u64 size) const
+  {
+    std::vector<u8> buffer(size);
+    ASSERT_TRUE(reader->Read(offset, size, buffer.data()));
+    EXPECT_EQ(0, std::memcmp(&m_image[offset], buffer.data(), size)) << offset << " " << size;
+  }
+
+  void ExpectDecryptedRead(DiscIO::IVolume* volume, u64 offset, u64 size) const
+  {
+    std::vector<u8> buffer(size);
+    ASSERT_TRUE(volume->Read(offset, size, buffer.data(), true));
+    EXPECT_EQ(0, std::memcmp(&m_plaintext[offset], buffer.data(), size)) << offset << " " << size;
+  }
+
+  std::vector<u8> m_plaintext;
+  std::vector<std::array<u8, 0x400>> m_hash_blocks;
+  std::vector<std::array<u8, 0x400>> m_calculated_hash_blocks;
+  std::vector<u8> m_image;
+  std::string m_temp_dir;
+  std::string m_iso_path;
+  std::string m_wcz_path;
+};
+}
+
+TEST_F(WCZBlobTest, CalculatesHashes)
+{
+  for (u64 group = 0; group * 64 < NUM_CLUSTERS; ++group)
+  {
+    const u64 num_clusters = std::min<u64>(64, NUM_CLUSTERS - group * 64);
+    std::vector<u8> hash_blocks(num_clusters * 0x400);
+    DiscIO::CalculateWiiHashBlocks(&m_plaintext[group * 64 * CLUSTER_DATA_SIZE], num_clusters,
+                                   hash_blocks.data());
+    for (u64 i = 0; i < num_clusters; ++i)
+    {
+      EXPECT_EQ(0, std::memcmp(m_calculated_hash_blocks[group * 64 + i].data(),
+                               &hash_blocks[i * 0x400], 0x400))
+          << group * 64 + i;
+    }
+  }
+}
+
+TEST_F(WCZBlobTest, RoundTrip)
+{
+  ASSERT_TRUE(DiscIO::ConvertToWCZ(m_iso_path, m_wcz_path, IgnoreProgress));
+
+  std::unique_ptr<DiscIO::IBlobReader> reader = DiscIO::CreateBlobReader(m_wcz_path);
+  ASSERT_NE(nullptr, reader);
+  EXPECT_EQ(DiscIO::BlobType::WCZ, reader->GetBlobType());
+  EXPECT_EQ(DISC_SIZE, reader->GetDataSize());
+  EXPECT_LT(reader->GetRawSize(), DISC_SIZE * 2 / 3);
+
+  // The encrypted clusters come back bit for bit, including the odd padding
+  ExpectRawRead(reader.get(), 0, DISC_SIZE);
+  std::mt19937 rng(5);
+  for (int i = 0; i < 300; ++i)
+  {
+    const u64 size = 1 + rng() % 0x30000;
+    const u64 offset = rng() % (DISC_SIZE - size);
+    ExpectRawRead(reader.get(), offset, size);
+  }
+  reader.reset();
+
+  std::unique_ptr<DiscIO::IVolume> volume = DiscIO::CreateVolumeFromFilename(m_wcz_path);
+  ASSERT_NE(nullptr, volume);
+  ExpectDecryptedRead(volume.get(), 0, m_plaintext.size());
+  for (int i = 0; i < 300; ++i)
+  {
+    const u64 size = 1 + rng() % 0x30000;
+    const u64 offset = rng() % (m_plaintext.size() - size);
+    ExpectDecryptedRead(volume.get(), offset, size);
+  }
+  std::vector<u8> buffer(0x100);
+  EXPECT_FALSE(volume->Read(m_plaintext.size() - 0x80, buffer.size(), buffer.data(), true));
+}
+
+TEST_F(WCZBlobTest, ConcurrentReads)
+{
+  ASSERT_TRUE(DiscIO::ConvertToWCZ(m_iso_path, m_wcz_path, IgnoreProgress));
+  std::unique_ptr<DiscIO::IBlobReader> reader = DiscIO::CreateBlobReader(m_wcz_path);
+  ASSERT_NE(nullptr, reader);
+
+  std::vector<std::thread> threads;
+  for (u32 t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([this, &reader, t] {
+      std::mt19937 rng(t);
+      for (int i = 0; i < 100; ++i)
+      {
+        const u64 size = 1 + rng() % 0x20000;
+        const u64 offset = rng() % (DISC_SIZE - size);
+        ExpectRawRead(reader.get(), offset, size);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+TEST_F(WCZBlobTest, DecompressesToIso)
+{
+  ASSERT_TRUE(DiscIO::ConvertToWCZ(m_iso_path, m_wcz_path, IgnoreProgress));
+
+  const std::string iso_path = m_temp_dir + DIR_SEP "decompressed.iso";
+  ASSERT_TRUE(DiscIO::DecompressBlobToFile(m_wcz_path, iso_path, IgnoreProgress));
+  std::string decompressed;
+  ASSERT_TRUE(File::ReadFileToString(iso_path, decompressed));
+  EXPECT_TRUE(std::vector<u8>(decompressed.begin(), decompressed.end()) == m_image);
+}
+
+TEST_F(WCZBlobTest, SmallerThanGCZ)
+{
+  const std::string gcz_path = m_temp_dir + DIR_SEP "disc.gcz";
+  ASSERT_TRUE(DiscIO::CompressFileToBlob(m_iso_path, gcz_path, 0, 0x4000, IgnoreProgress));
+  ASSERT_TRUE(DiscIO::ConvertToWCZ(m_iso_path, m_wcz_path, IgnoreProgress));
+
+  // Encrypted data doesn't compress, but half of the decrypted data does
+  const u64 gcz_size = File::GetSize(gcz_path);
+  const u64 wcz_size = File::GetSize(m_wcz_path);
+  EXPECT_GT(gcz_size, DISC_SIZE * 4 / 5);
+  EXPECT_LT(wcz_size, gcz_size * 2 / 3);
+
+  // Both give back the same game data
+  for (const std::string& path : {gcz_path, m_wcz_path})
+  {
+    std::unique_ptr<DiscIO::IVolume> volume = DiscIO::CreateVolumeFromFilename(path);
+    ASSERT_NE(nullptr, volume) << path;
+    ExpectDecryptedRead(volume.get(), 0, m_plaintext.size());
+  }
+}
@@ -0,0 +1,124 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Blob.h"
+
+namespace
+{
+constexpr u8 HD_SECTOR_SHIFT = 9;
+constexpr u8 WBFS_SECTOR_SHIFT = 16;
+constexpr u64 WBFS_SECTOR_SIZE = 1 << WBFS_SECTOR_SHIFT;
+// The block table of a disc with 64 KiB blocks takes up the first few sectors
+constexpr u16 FIRST_DATA_SECTOR = 5;
+constexpr u16 NUM_DISC_BLOCKS = 96;
+// Not a multiple of the WBFS sector size, like the 4 GiB - 32 KiB that tools split at
+constexpr u64 SPLIT_SIZE = 0x2A1200;
+
+class WbfsBlobTest : public testing::Test
+{
+protected:
+  // Writes a disc as a WBFS file that is split in two. Most blocks are stored in order, but
+  // some are stored backwards, so that not everything can be read in one go.
+  void SetUp() override
+  {
+    m_data.resize(NUM_DISC_BLOCKS * WBFS_SECTOR_SIZE);
+    for (size_t i = 0; i < m_data.size(); ++i)
+      m_data[i] = static_cast<u8>((i * 2654435761u) >> 24);
+
+    const u64 num_sectors = FIRST_DATA_SECTOR + NUM_DISC_BLOCKS;
+    std::vector<u8> image(num_sectors * WBFS_SECTOR_SIZE);
+    std::memcpy(image.data(), "WBFS", 4);
+    const u32 hd_sector_count = Common::swap32(static_cast<u32>(image.size() >> HD_SECTOR_SHIFT));
+    std::memcpy(&image[4], &hd_sector_count, sizeof(hd_sector_count));
+    image[8] = HD_SECTOR_SHIFT;
+    image[9] = WBFS_SECTOR_SHIFT;
+    image[12] = 1;
+
+    for (u16 block = 0; block < NUM_DISC_BLOCKS; ++block)
+    {
+      const u16 sector =
+          block >= 32 && block < 64 ? FIRST_DATA_SECTOR + 95 - block : FIRST_DATA_SECTOR + block;
+      const u16 table_entry = Common::swap16(sector);
+      std::memcpy(&image[(1 << HD_SECTOR_SHIFT) + 0x100 + block * 2], &table_entry, 2);
+      std::memcpy(&image[sector * WBFS_SECTOR_SIZE], &m_data[block * WBFS_SECTOR_SIZE],
+                  WBFS_SECTOR_SIZE);
+    }
+
+    m_temp_dir = File::CreateTempDir();
+    ASSERT_FALSE(m_temp_dir.empty());
+    m_path = m_temp_dir + DIR_SEP "disc.wbfs";
+    ASSERT_TRUE(File::IOFile(m_path, "wb").WriteBytes(image.data(), SPLIT_SIZE));
+    ASSERT_TRUE(File::IOFile(m_temp_dir + DIR_SEP "disc.wbf1", "wb")
+                    .WriteBytes(&image[SPLIT_SIZE], image.size() - SPLIT_SIZE));
+
+    m_reader = DiscIO::CreateBlobReader(m_path);
+    ASSERT_NE(nullptr, m_reader);
+    ASSERT_EQ(DiscIO::BlobType::WBFS, m_reader->GetBlobType());
+    ASSERT_EQ(image.size(), m_reader->GetRawSize());
+  }
+
+  void TearDown() override
+  {
+    m_reader.reset();
+    File::DeleteDirRecursively(m_temp_dir);
+  }
+
+  void ExpectRead(DiscIO::IBlobReader* reader, u64 offset, u64 size) const
+  {
+    std::vector<u8> buffer(size);
+    ASSERT_TRUE(reader->Read(offset, size, buffer.data()));
+    EXPECT_EQ(0, std::memcmp(&m_data[offset], buffer.data(), size)) << offset << " " << size;
+  }
+
+  std::vector<u8> m_data;
+  std::string m_temp_dir;
+  std::string m_path;
+  std::unique_ptr<DiscIO::IBlobReader> m_reader;
+};
+}
+
+TEST_F(WbfsBlobTest, ReadsMatch)
+{
+  ExpectRead(m_reader.get(), 0, m_data.size());
+
+  std::mt19937 rng(21);
+  for (int i = 0; i < 1000; ++i)
+  {
+    const u64 size = 1 + rng() % (i % 4 == 0 ? 8 * WBFS_SECTOR_SIZE : 0x8000);
+    const u64 offset = rng() % (m_data.size() - size);
+    ExpectRead(m_reader.get(), offset, size);
+  }
+}
+
+TEST_F(WbfsBlobTest, ConcurrentReads)
+{
+  std::vector<std::thread> threads;
+  for (u32 t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([this, t] {
+      std::mt19937 rng(t);
+      for (int i = 0; i < 500; ++i)
+      {
+        const u64 size = 1 + rng() % 0x20000;
+        const u64 offset = rng() % (m_data.size() - size);
+        ExpectRead(m_reader.get(), offset, size);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+}
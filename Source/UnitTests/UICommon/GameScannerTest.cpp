@@ -0,0 +1,168 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Enums.h"
+#include "UICommon/GameScanner.h"
+
+namespace
+{
+constexpr size_t NUM_GAMES = 60;
+constexpr u32 FST_OFFSET = 0x3000;
+
+// Writes the smallest file that opens as a GameCube disc: a header with the magic word and an
+// FST with only a root directory.
+bool WriteFakeDisc(const std::string& path, const std::string& game_id, size_t size = 0x4000)
+{
+  std::vector<u8> image(size);
+  std::copy(game_id.begin(), game_id.end(), image.begin());
+  const std::string name = "Game " + game_id;
+  std::copy(name.begin(), name.end(), image.begin() + 0x20);
+
+  const u32 words[][2] = {{0x1C, 0xC2339F3D}, {0x424, FST_OFFSET}, {0x428, 0xC},
+                          {FST_OFFSET, 0x01000000}, {FST_OFFSET + 8, 1}};
+  for (const auto& word : words)
+  {
+    const u32 value = Common::swap32(word[1]);
+    std::memcpy(&image[word[0]], &value, sizeof(value));
+  }
+
+  return File::IOFile(path, "wb").WriteBytes(image.data(), image.size());
+}
+
+class GameScannerTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_temp_dir = File::CreateTempDir();
+    ASSERT_FALSE(m_temp_dir.empty());
+    m_index_path = m_temp_dir + DIR_SEP "index.cache";
+
+    for (size_t i = 0; i < NUM_GAMES; ++i)
+    {
+      char game_id[7];
+      std::snprintf(game_id, sizeof(game_id), "G%03zuE8", i);
+      m_paths.push_back(m_temp_dir + DIR_SEP + game_id + ".iso");
+      ASSERT_TRUE(WriteFakeDisc(m_paths.back(), game_id));
+    }
+
+    // Something that isn't a game, and a DOL, which is listed without being opened as a disc.
+    m_paths.push_back(m_temp_dir + DIR_SEP "notagame.iso");
+    ASSERT_TRUE(File::WriteStringToFile(std::string(0x1000, 'x'), m_paths.back()));
+    m_paths.push_back(m_temp_dir + DIR_SEP "homebrew.dol");
+    ASSERT_TRUE(File::WriteStringToFile(std::string(0x100, 'd'), m_paths.back()));
+  }
+
+  void TearDown() override { File::DeleteDirRecursively(m_temp_dir); }
+
+  std::string m_temp_dir;
+  std::string m_index_path;
+  std::vector<std::string> m_paths;
+};
+}
+
+TEST_F(GameScannerTest, ProbesFiles)
+{
+  UICommon::GameScanner scanner(m_index_path);
+  const auto games = scanner.Scan(m_paths);
+  ASSERT_EQ(m_paths.size(), games.size());
+  EXPECT_EQ(m_paths.size(), scanner.GetLastScanStats().probed);
+
+  for (size_t i = 0; i < NUM_GAMES; ++i)
+  {
+    EXPECT_TRUE(games[i]->valid);
+    EXPECT_EQ(m_paths[i], games[i]->path);
+    EXPECT_EQ(DiscIO::Platform::GAMECUBE_DISC, games[i]->platform);
+    EXPECT_EQ("Game " + games[i]->game_id, games[i]->internal_name);
+    EXPECT_EQ(0x4000u, games[i]->file_size);
+  }
+  EXPECT_FALSE(games[NUM_GAMES]->valid);
+  EXPECT_TRUE(games[NUM_GAMES + 1]->valid);
+  EXPECT_EQ(DiscIO::Platform::ELF_DOL, games[NUM_GAMES + 1]->platform);
+}
+
+TEST_F(GameScannerTest, WarmScanReusesIndex)
+{
+  std::vector<std::shared_ptr<const UICommon::GameMetadata>> cold_games;
+  {
+    UICommon::GameScanner scanner(m_index_path);
+    cold_games = scanner.Scan(m_paths);
+  }
+
+  // A new scanner picks up the index that the first one saved, and doesn't open anything.
+  UICommon::GameScanner scanner(m_index_path);
+  const auto warm_games = scanner.Scan(m_paths);
+  EXPECT_EQ(0u, scanner.GetLastScanStats().probed);
+  EXPECT_EQ(m_paths.size(), scanner.GetLastScanStats().reused);
+
+  ASSERT_EQ(cold_games.size(), warm_games.size());
+  for (size_t i = 0; i < cold_games.size(); ++i)
+  {
+    EXPECT_EQ(cold_games[i]->path, warm_games[i]->path);
+    EXPECT_EQ(cold_games[i]->valid, warm_games[i]->valid);
+    EXPECT_EQ(cold_games[i]->game_id, warm_games[i]->game_id);
+    EXPECT_EQ(cold_games[i]->internal_name, warm_games[i]->internal_name);
+  }
+}
+
+TEST_F(GameScannerTest, RescansChangedFiles)
+{
+  UICommon::GameScanner scanner(m_index_path);
+  scanner.Scan(m_paths);
+
+  ASSERT_TRUE(WriteFakeDisc(m_paths[3], "GNEWP8", 0x8000));
+  const auto games = scanner.Scan(m_paths);
+  EXPECT_EQ(1u, scanner.GetLastScanStats().probed);
+  EXPECT_EQ("GNEWP8", games[3]->game_id);
+
+  // Forgotten files get opened again.
+  scanner.Remove(m_paths[5]);
+  scanner.RetainOnly({m_paths.begin(), m_paths.begin() + 10});
+  scanner.Scan(m_paths);
+  EXPECT_EQ(m_paths.size() - 9, scanner.GetLastScanStats().probed);
+}
+
+TEST_F(GameScannerTest, CanBeCancelled)
+{
+  UICommon::GameScanner scanner(m_index_path);
+  size_t calls = 0;
+  const auto games = scanner.Scan(m_paths, [&calls](size_t, size_t, const std::string&) {
+    ++calls;
+    return false;
+  });
+  // Cancelling from the first report happens before any file is opened.
+  EXPECT_EQ(1u, calls);
+  EXPECT_TRUE(games.empty());
+
+  size_t last_done = 0;
+  std::vector<std::string> reported_paths;
+  const auto all_games =
+      scanner.Scan(m_paths, [&](size_t done, size_t total, const std::string& path) {
+        EXPECT_GE(done, last_done);
+        EXPECT_EQ(m_paths.size(), total);
+        last_done = done;
+        reported_paths.push_back(path);
+        return true;
+      });
+  EXPECT_EQ(m_paths.size(), all_games.size());
+  EXPECT_EQ(m_paths.size(), last_done);
+  // Every report names one of the files being scanned.
+  ASSERT_FALSE(reported_paths.empty());
+  for (const std::string& path : reported_paths)
+    EXPECT_NE(m_paths.end(), std::find(m_paths.begin(), m_paths.end(), path)) << path;
+  EXPECT_EQ(m_paths.size(), scanner.GetLastScanStats().probed);
+}